@@ -22,6 +22,7 @@
 #include "finch.h"
 
 #include "account.h"
+#include "accounts.h"
 #include "core.h"
 #include "connection.h"
 #include "debug.h"
@@ -30,13 +31,9 @@
 #include "gntaccount.h"
 #include "gntconn.h"
 
-#define INITIAL_RECON_DELAY_MIN  8000
-#define INITIAL_RECON_DELAY_MAX 60000
-
-#define MAX_RECON_DELAY 600000
 
 typedef struct {
-	int delay;
+	guint delay;
 	guint timeout;
 } FinchAutoRecon;
 
@@ -76,9 +73,8 @@ do_signon(gpointer data)
 	status = purple_account_get_active_status(account);
 	if (purple_status_is_online(status))
 	{
-		purple_debug_info("autorecon", "calling purple_account_connect\n");
-		purple_account_connect(account);
-		purple_debug_info("autorecon", "done calling purple_account_connect\n");
+		purple_debug_info("autorecon", "scheduling reconnect\n");
+		purple_accounts_schedule_connect(account);
 	}
 
 	return FALSE;
@@ -109,9 +105,9 @@ finch_connection_report_disconnect(PurpleConnection *gc, PurpleConnectionError r
 		if (info == NULL) {
 			info = g_new0(FinchAutoRecon, 1);
 			g_hash_table_insert(hash, account, info);
-			info->delay = g_random_int_range(INITIAL_RECON_DELAY_MIN, INITIAL_RECON_DELAY_MAX);
+			info->delay = purple_accounts_get_reconnect_delay(0);
 		} else {
-			info->delay = MIN(2 * info->delay, MAX_RECON_DELAY);
+			info->delay = purple_accounts_get_reconnect_delay(info->delay);
 			if (info->timeout != 0)
 				g_source_remove(info->timeout);
 		}
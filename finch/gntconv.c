@@ -894,6 +894,8 @@ finch_create_conversation(PurpleConversation *conv)
 	gnt_widget_set_name(ggc->tv, "conversation-window-textview");
 	gnt_widget_set_size(ggc->tv, purple_prefs_get_int(PREF_ROOT "/size/width"),
 			purple_prefs_get_int(PREF_ROOT "/size/height"));
+	gnt_text_view_set_scrollback(GNT_TEXT_VIEW(ggc->tv),
+			purple_prefs_get_int(PREF_ROOT "/scrollback_lines"));
 
 	if (PURPLE_IS_CHAT_CONVERSATION(conv)) {
 		GntWidget *hbox, *tree;
@@ -1193,6 +1195,37 @@ finch_chat_update_user(PurpleChatUser *cb)
 			chat_flag_text(purple_chat_user_get_flags(cb)));
 }
 
+static void
+finch_chat_update_users(PurpleChatConversation *chat, const PurpleChatUsersDelta *delta)
+{
+	FinchConv *ggc = FINCH_CONV(PURPLE_CONVERSATION(chat));
+	GntWidget *tree = ggc->u.chat->userlist;
+	gboolean mapped = GNT_WIDGET_IS_FLAG_SET(tree, GNT_WIDGET_MAPPED);
+	GList *l;
+
+	/* Don't redraw the whole list for every row that changes. */
+	if (mapped)
+		GNT_WIDGET_UNSET_FLAGS(tree, GNT_WIDGET_MAPPED);
+
+	if (delta->removed)
+		finch_chat_remove_users(chat, delta->removed);
+	for (l = delta->renamed; l; l = l->next) {
+		PurpleChatUserRename *rename = l->data;
+		finch_chat_rename_user(chat, rename->old_name, rename->new_name, rename->new_alias);
+	}
+	if (delta->added)
+		finch_chat_add_users(chat, delta->added, FALSE);
+	if (delta->arrived)
+		finch_chat_add_users(chat, delta->arrived, TRUE);
+	for (l = delta->updated; l; l = l->next)
+		finch_chat_update_user(l->data);
+
+	if (mapped) {
+		GNT_WIDGET_SET_FLAGS(tree, GNT_WIDGET_MAPPED);
+		gnt_widget_draw(tree);
+	}
+}
+
 static void
 finch_conv_present(PurpleConversation *conv)
 {
@@ -1224,7 +1257,7 @@ static PurpleConversationUiOps conv_ui_ops =
 	finch_conv_present, /* present */
 	finch_conv_has_focus, /* has_focus */
 	NULL, /* send_confirm */
-	NULL,
+	finch_chat_update_users,
 	NULL,
 	NULL,
 	NULL
@@ -1444,6 +1477,7 @@ void finch_conversation_init()
 	purple_prefs_add_none(PREF_ROOT "/position");
 	purple_prefs_add_int(PREF_ROOT "/position/x", 0);
 	purple_prefs_add_int(PREF_ROOT "/position/y", 0);
+	purple_prefs_add_int(PREF_ROOT "/scrollback_lines", 4000);
 	purple_prefs_add_none(PREF_CHAT);
 	purple_prefs_add_bool(PREF_USERLIST, FALSE);
 
@@ -30,9 +30,12 @@
 #include <gntlabel.h>
 #include <gntline.h>
 #include <gnttextview.h>
+#include <gntwm.h>
 
 #include "gntdebug.h"
 #include "finch.h"
+#include "eventloop.h"
+#include "memstat.h"
 #include "notify.h"
 #include "util.h"
 
@@ -193,6 +196,31 @@ toggle_pause(GntWidget *w, gpointer n)
 	debug.paused = !debug.paused;
 }
 
+static void
+toggle_profile(GntWidget *w, gpointer n)
+{
+	purple_prefs_set_bool("/purple/eventloop/profile",
+			gnt_check_box_get_checked(GNT_CHECK_BOX(w)));
+}
+
+static void
+print_statistics(GntWidget *w, gpointer n)
+{
+	guint64 repaints, avoided;
+	char *report = purple_eventloop_get_profile_report();
+	purple_debug_info("eventloop", "%s", report);
+	g_free(report);
+
+	report = purple_memstat_get_report();
+	purple_debug_info("memstat", "%s", report);
+	g_free(report);
+
+	gnt_wm_get_repaint_stats(&repaints, &avoided);
+	purple_debug_info("gnt", "Screen updates: %" G_GUINT64_FORMAT
+			" repaints, %" G_GUINT64_FORMAT " merged into another\n",
+			repaints, avoided);
+}
+
 /* Xerox */
 static void
 purple_glib_log_handler(const gchar *domain, GLogLevelFlags flags,
@@ -352,6 +380,17 @@ void finch_debug_window_show()
 	GNT_WIDGET_SET_FLAGS(wid, GNT_WIDGET_GROW_Y);
 	gnt_box_add_widget(GNT_BOX(box), wid);
 
+	wid = gnt_check_box_new(_("Profile"));
+	gnt_check_box_set_checked(GNT_CHECK_BOX(wid), purple_eventloop_get_profiling());
+	g_signal_connect(G_OBJECT(wid), "toggled", G_CALLBACK(toggle_profile), NULL);
+	GNT_WIDGET_SET_FLAGS(wid, GNT_WIDGET_GROW_Y);
+	gnt_box_add_widget(GNT_BOX(box), wid);
+
+	wid = gnt_button_new(_("Statistics"));
+	g_signal_connect(G_OBJECT(wid), "activate", G_CALLBACK(print_statistics), NULL);
+	GNT_WIDGET_SET_FLAGS(wid, GNT_WIDGET_GROW_Y);
+	gnt_box_add_widget(GNT_BOX(box), wid);
+
 	gnt_box_add_widget(GNT_BOX(debug.window), box);
 	GNT_WIDGET_SET_FLAGS(box, GNT_WIDGET_GROW_Y);
 
@@ -39,6 +39,9 @@
 
 #include "gntlog.h"
 
+/* How many messages of a log to show at once */
+#define LOG_PAGE_SIZE 500
+
 static GHashTable *log_viewers = NULL;
 static void populate_log_tree(FinchLogViewer *lv);
 static FinchLogViewer *syslog_viewer = NULL;
@@ -127,6 +130,10 @@ static void search_cb(GntWidget *button, FinchLogViewer *lv)
 
 	gnt_tree_remove_all(GNT_TREE(lv->tree));
 	gnt_text_view_clear(GNT_TEXT_VIEW(lv->text));
+	if (lv->reader != NULL) {
+		purple_log_reader_free(lv->reader);
+		lv->reader = NULL;
+	}
 
 	for (logs = lv->logs; logs != NULL; logs = logs->next) {
 		char *read = purple_log_read((PurpleLog*)logs->data, NULL);
@@ -158,6 +165,11 @@ static void destroy_cb(GntWidget *w, struct log_viewer_hash_t *ht)
 
 	purple_request_close_with_handle(lv);
 
+	if (lv->load_source)
+		g_source_remove(lv->load_source);
+	if (lv->reader != NULL)
+		purple_log_reader_free(lv->reader);
+
 	g_list_foreach(lv->logs, (GFunc)purple_log_free, NULL);
 	g_list_free(lv->logs);
 
@@ -167,12 +179,62 @@ static void destroy_cb(GntWidget *w, struct log_viewer_hash_t *ht)
 	gnt_widget_destroy(w);
 }
 
+/* Appends the next page of the log being viewed, or all of the rest of it
+ * when searching. */
+static void log_append_page(FinchLogViewer *viewer)
+{
+	char *read, *strip, *newline;
+
+	read = purple_log_reader_read(viewer->reader, viewer->read_count,
+			viewer->search ? G_MAXSIZE : LOG_PAGE_SIZE, &viewer->flags);
+	if (read == NULL)
+		return;
+
+	if (viewer->search)
+		viewer->read_count = purple_log_reader_get_count(viewer->reader);
+	else
+		viewer->read_count += LOG_PAGE_SIZE;
+
+	if (viewer->flags != PURPLE_LOG_READ_NO_NEWLINE) {
+		newline = purple_strdup_withhtml(read);
+		strip = purple_markup_strip_html(newline);
+		g_free(newline);
+	} else {
+		strip = purple_markup_strip_html(read);
+	}
+
+	gnt_text_view_append_text_with_flags(GNT_TEXT_VIEW(viewer->text), strip, GNT_TEXT_FLAG_NORMAL);
+	g_free(read);
+	g_free(strip);
+}
+
+static gboolean log_load_cb(gpointer data)
+{
+	FinchLogViewer *viewer = data;
+
+	viewer->load_source = 0;
+	if (viewer->reader != NULL)
+		log_append_page(viewer);
+
+	return FALSE;
+}
+
+/* Shows more of the log when the user scrolls near the end of it.  The text
+ * view can't be changed while it is being drawn. */
+static void log_draw_cb(GntWidget *w, FinchLogViewer *viewer)
+{
+	if (viewer->reader == NULL || viewer->load_source ||
+			viewer->read_count >= purple_log_reader_get_count(viewer->reader))
+		return;
+
+	if (gnt_text_view_get_lines_below(GNT_TEXT_VIEW(w)) < 2 * w->priv.height)
+		viewer->load_source = g_idle_add(log_load_cb, viewer);
+}
+
 static void log_select_cb(GntWidget *w, gpointer old, gpointer new, FinchLogViewer *viewer)
 {
 	GntTree *tree = GNT_TREE(w);
 	PurpleLog *log = NULL;
-	PurpleLogReadFlags flags;
-	char *read = NULL, *strip, *newline;
 
 	if (!viewer->search && !gnt_tree_get_parent_key(tree, new))
 		return;
@@ -195,22 +257,15 @@ static void log_select_cb(GntWidget *w, gpointer old, gpointer new, FinchLogView
 		g_free(title);
 	}
 
-	read = purple_log_read(log, &flags);
-	if (flags != PURPLE_LOG_READ_NO_NEWLINE) {
-		newline = purple_strdup_withhtml(read);
-		strip = purple_markup_strip_html(newline);
-		g_free(newline);
-	} else {
-		strip = purple_markup_strip_html(read);
-	}
-	viewer->flags = flags;
+	if (viewer->reader != NULL)
+		purple_log_reader_free(viewer->reader);
+	viewer->reader = purple_log_reader_new(log);
+	viewer->read_count = 0;
 
 	purple_signal_emit(finch_log_get_handle(), "log-displaying", viewer, log);
 
 	gnt_text_view_clear(GNT_TEXT_VIEW(viewer->text));
-	gnt_text_view_append_text_with_flags(GNT_TEXT_VIEW(viewer->text), strip, GNT_TEXT_FLAG_NORMAL);
-	g_free(read);
-	g_free(strip);
+	log_append_page(viewer);
 }
 
 /* I want to make this smarter, but haven't come up with a cool algorithm to do so, yet.
@@ -325,6 +380,7 @@ static FinchLogViewer *display_log_viewer(struct log_viewer_hash_t *ht, GList *l
 	lv->text = gnt_text_view_new();
 	gnt_box_add_widget(GNT_BOX(hbox), lv->text);
 	gnt_text_view_set_flag(GNT_TEXT_VIEW(lv->text), GNT_TEXT_VIEW_TOP_ALIGN);
+	g_signal_connect_after(G_OBJECT(lv->text), "draw", G_CALLBACK(log_draw_cb), lv);
 
 	hbox = gnt_hbox_new(FALSE);
 	gnt_box_add_widget(GNT_BOX(vbox), hbox);
@@ -43,6 +43,9 @@ typedef struct _FinchLogViewer FinchLogViewer;
  * @entry:  The search entry, in which search terms are entered
  * @flags:  The most recently used log flags
  * @search: The string currently being searched for
+ * @reader: The reader of the log being viewed
+ * @read_count: How many messages of that log are shown
+ * @load_source: The source showing more of that log
  *
  * A GNT Log Viewer.  You can look at logs with it.
  */
@@ -56,6 +59,10 @@ struct _FinchLogViewer {
 	GntWidget	*label;
 	PurpleLogReadFlags flags;
 	char		*search;
+
+	PurpleLogReader *reader;
+	gsize		read_count;
+	guint		load_source;
 };
 
 
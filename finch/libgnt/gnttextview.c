@@ -37,6 +37,16 @@ enum
 	SIGS = 1,
 };
 
+/* The scrollback is trimmed a chunk of lines at a time, so that the text does
+ * not need to be moved around for every new line. */
+#define SCROLLBACK_CHUNK(lines)  ((lines) / 4 + 1)
+
+struct _GntTextViewPriv
+{
+	int scrollback;     /* The maximum number of lines to keep, 0 for no limit */
+	int lines;          /* The number of lines (not counting the wrapped ones) */
+};
+
 typedef struct
 {
 	GntTextFormatFlags tvflag;
@@ -50,6 +60,7 @@ typedef struct
 	GList *segments;         /* A list of GntTextSegments */
 	int length;              /* The current length of the line so far (ie. onscreen width) */
 	gboolean soft;           /* TRUE if it's an overflow from prev. line */
+	int width;               /* The width of the textview when the line was wrapped */
 } GntTextLine;
 
 typedef struct
@@ -66,6 +77,8 @@ static gchar *select_end;
 static gboolean double_click;
 
 static void reset_text_view(GntTextView *view);
+static void free_text_line(gpointer data, gpointer null);
+static void free_tag(gpointer data, gpointer null);
 
 static gboolean
 text_view_contains(GntTextView *view, const char *str)
@@ -73,6 +86,278 @@ text_view_contains(GntTextView *view, const char *str)
 	return (str >= view->string->str && str < view->string->str + view->string->len);
 }
 
+static GntTextLine *
+new_text_line(GntTextView *view, gboolean soft)
+{
+	GntTextLine *line = g_new0(GntTextLine, 1);
+	line->soft = soft;
+	line->width = GNT_WIDGET(view)->priv.width;
+	return line;
+}
+
+static const char *
+find_line_break(const char *start, const char *limit)
+{
+	for (; start < limit; start++) {
+		if (*start == '\r' || *start == '\n')
+			return start;
+	}
+	return NULL;
+}
+
+/* Wraps the text between start and limit, which must already be in
+ * view->string, into the list of lines. The text is added to the end of the
+ * first line in the list, and new lines are prepended as needed. Returns the
+ * new start of the list. */
+static GList *
+wrap_text(GntTextView *view, GList *lines, const char *start, const char *limit,
+		GntTextFormatFlags flags, chtype fl)
+{
+	GntWidget *widget = GNT_WIDGET(view);
+	const char *end;
+	GntTextLine *line;
+	int len;
+	gboolean has_scroll = !(view->flags & GNT_TEXT_VIEW_NO_SCROLL);
+	gboolean wrap_word = !(view->flags & GNT_TEXT_VIEW_WRAP_CHAR);
+
+	while (start < limit) {
+		GntTextLine *oldl;
+		GntTextSegment *seg = NULL;
+
+		if (*start == '\n' || *start == '\r') {
+			if (!strncmp(start, "\r\n", 2))
+				start++;
+			start++;
+			lines = g_list_prepend(lines, new_text_line(view, FALSE));
+			view->priv->lines++;
+			continue;
+		}
+
+		line = lines->data;
+		if (line->length == widget->priv.width - has_scroll) {
+			/* The last added line was exactly the same width as the widget */
+			line = new_text_line(view, TRUE);
+			lines = g_list_prepend(lines, line);
+		}
+
+		if ((end = find_line_break(start, limit)) != NULL) {
+			len = gnt_util_onscreen_width(start, end);
+			if (widget->priv.width > 0 &&
+					len > widget->priv.width - line->length - has_scroll) {
+				end = NULL;
+			}
+		}
+
+		if (end == NULL) {
+			end = gnt_util_onscreen_width_to_pointer(start,
+					widget->priv.width - line->length - has_scroll, &len);
+			if (end > limit) {
+				end = limit;
+				len = gnt_util_onscreen_width(start, end);
+			}
+		}
+
+		/* Try to append to the previous segment if possible */
+		if (line->segments) {
+			seg = g_list_last(line->segments)->data;
+			if (seg->flags != fl || view->string->str + seg->end != start)
+				seg = NULL;
+		}
+
+		if (seg == NULL) {
+			seg = g_new0(GntTextSegment, 1);
+			seg->start = start - view->string->str;
+			seg->tvflag = flags;
+			seg->flags = fl;
+			line->segments = g_list_append(line->segments, seg);
+		}
+
+		oldl = line;
+		if (wrap_word && end < limit && *end != '\n' && *end != '\r') {
+			const char *tmp = end;
+			while (end && *end != '\n' && *end != '\r' && !g_ascii_isspace(*end)) {
+				end = g_utf8_find_prev_char(seg->start + view->string->str, end);
+			}
+			if (!end || !g_ascii_isspace(*end))
+				end = tmp;
+			else
+				end++; /* Remove the space */
+
+			line = new_text_line(view, TRUE);
+			lines = g_list_prepend(lines, line);
+		}
+		seg->end = end - view->string->str;
+		oldl->length += len;
+		start = end;
+	}
+
+	return lines;
+}
+
+static gboolean
+text_line_is_stale(GntTextView *view, GList *link)
+{
+	GntTextLine *line = link->data;
+	return (line->width != GNT_WIDGET(view)->priv.width);
+}
+
+/* Rewraps the line that link is a part of for the current width of the
+ * textview, and keeps view->list on the same text if it was on that line. */
+static void
+reflow_line(GntTextView *view, GList *link)
+{
+	GList *first, *last, *before, *after, *iter, *lines, *lastnew;
+	gboolean in_view = FALSE;
+	int anchor = -1;
+
+	/* The lines are kept newest-first, so the line starts at 'last' */
+	for (last = link; ((GntTextLine *)last->data)->soft && last->next; last = last->next)
+		;
+	for (first = link; first->prev && ((GntTextLine *)first->prev->data)->soft; first = first->prev)
+		;
+	before = first->prev;
+	after = last->next;
+
+	for (iter = first; iter != after; iter = iter->next) {
+		if (iter == view->list) {
+			GntTextLine *line = iter->data;
+			in_view = TRUE;
+			if (line->segments)
+				anchor = ((GntTextSegment *)line->segments->data)->start;
+			break;
+		}
+	}
+
+	lines = g_list_prepend(NULL, new_text_line(view, ((GntTextLine *)last->data)->soft));
+	for (iter = last; iter != before; iter = iter->prev) {
+		GList *segs;
+		for (segs = ((GntTextLine *)iter->data)->segments; segs; segs = segs->next) {
+			GntTextSegment *seg = segs->data;
+			lines = wrap_text(view, lines, view->string->str + seg->start,
+					view->string->str + seg->end, seg->tvflag, seg->flags);
+		}
+	}
+
+	/* Replace the old lines with the new ones */
+	first->prev = NULL;
+	last->next = NULL;
+	lastnew = g_list_last(lines);
+	lines->prev = before;
+	if (before)
+		before->next = lines;
+	lastnew->next = after;
+	if (after)
+		after->prev = lastnew;
+
+	if (in_view) {
+		if (view->list == first) {
+			view->list = lines;
+		} else {
+			view->list = lastnew;
+			for (iter = lastnew; anchor >= 0 && iter != before; iter = iter->prev) {
+				GntTextLine *line = iter->data;
+				if (line->segments &&
+						((GntTextSegment *)line->segments->data)->start <= anchor)
+					view->list = iter;
+			}
+		}
+	}
+
+	g_list_foreach(first, free_text_line, NULL);
+	g_list_free(first);
+}
+
+/* Rewraps the lines in view that were wrapped for a different width. The
+ * rest are left alone until they are scrolled into view. */
+static void
+reflow_visible(GntTextView *view)
+{
+	GList *iter;
+	int i;
+	gboolean changed = TRUE;
+
+	while (changed) {
+		changed = FALSE;
+		for (i = 0, iter = view->list; iter && i < GNT_WIDGET(view)->priv.height;
+				i++, iter = iter->next) {
+			if (text_line_is_stale(view, iter)) {
+				reflow_line(view, iter);
+				changed = TRUE;
+				break;
+			}
+		}
+	}
+}
+
+/* Drops the oldest lines once there are more than the scrollback allows */
+static void
+trim_scrollback(GntTextView *view)
+{
+	GntTextViewPriv *priv = view->priv;
+	GList *oldest, *iter, *next;
+	int drop, cut = -1;
+
+	if (priv->scrollback <= 0 ||
+			priv->lines <= priv->scrollback + SCROLLBACK_CHUNK(priv->scrollback))
+		return;
+
+	drop = priv->lines - priv->scrollback;
+	oldest = g_list_last(view->list);
+	while (drop > 0 && oldest->prev) {
+		GList *newer = oldest->prev;
+
+		if (view->list == oldest)
+			view->list = newer;
+		newer->next = NULL;
+		free_text_line(oldest->data, NULL);
+		g_list_free_1(oldest);
+
+		if (!((GntTextLine *)newer->data)->soft) {
+			drop--;
+			priv->lines--;
+		}
+		oldest = newer;
+	}
+
+	for (iter = oldest; iter; iter = iter->prev) {
+		GntTextLine *line = iter->data;
+		if (line->segments) {
+			cut = ((GntTextSegment *)line->segments->data)->start;
+			break;
+		}
+	}
+	if (cut < 0)
+		cut = view->string->len;
+	if (cut == 0)
+		return;
+
+	if (text_view_contains(view, select_start) || text_view_contains(view, select_end))
+		select_start = select_end = NULL;
+
+	g_string_erase(view->string, 0, cut);
+
+	for (iter = oldest; iter; iter = iter->prev) {
+		GList *segs;
+		for (segs = ((GntTextLine *)iter->data)->segments; segs; segs = segs->next) {
+			GntTextSegment *seg = segs->data;
+			seg->start -= cut;
+			seg->end -= cut;
+		}
+	}
+
+	for (iter = view->tags; iter; iter = next) {
+		GntTextTag *tag = iter->data;
+		next = iter->next;
+		if (tag->start < cut) {
+			view->tags = g_list_delete_link(view->tags, iter);
+			free_tag(tag, NULL);
+		} else {
+			tag->start -= cut;
+			tag->end -= cut;
+		}
+	}
+}
+
 static void
 gnt_text_view_draw(GntWidget *widget)
 {
@@ -87,6 +372,8 @@ gnt_text_view_draw(GntWidget *widget)
 	wbkgd(widget->window, gnt_color_pair(GNT_COLOR_NORMAL));
 	werase(widget->window);
 
+	reflow_visible(view);
+
 	n = g_list_length(view->list);
 	if ((view->flags & GNT_TEXT_VIEW_TOP_ALIGN) &&
 			n < widget->priv.height) {
@@ -99,6 +386,7 @@ gnt_text_view_draw(GntWidget *widget)
 		} else {
 			comp = 0;
 		}
+		reflow_visible(view);
 	}
 
 	for (i = 0, lines = view->list; i < widget->priv.height && lines; i++, lines = lines->next)
@@ -243,6 +531,8 @@ gnt_text_view_destroy(GntWidget *widget)
 	g_list_foreach(view->tags, free_tag, NULL);
 	g_list_free(view->tags);
 	g_string_free(view->string, TRUE);
+	g_free(view->priv);
+	view->priv = NULL;
 }
 
 static char *
@@ -371,72 +661,13 @@ gnt_text_view_clicked(GntWidget *widget, GntMouseEvent event, int x, int y)
 	return TRUE;
 }
 
-static void
-gnt_text_view_reflow(GntTextView *view)
-{
-	/* This is pretty ugly, and inefficient. Someone do something about it. */
-	GntTextLine *line;
-	GList *back, *iter, *list;
-	GString *string;
-	int pos = 0;    /* no. of 'real' lines */
-
-	list = view->list;
-	while (list->prev) {
-		line = list->data;
-		if (!line->soft)
-			pos++;
-		list = list->prev;
-	}
-
-	back = g_list_last(view->list);
-	view->list = NULL;
-
-	string = view->string;
-	view->string = NULL;
-	reset_text_view(view);
-
-	view->string = g_string_set_size(view->string, string->len);
-	view->string->len = 0;
-	GNT_WIDGET_SET_FLAGS(GNT_WIDGET(view), GNT_WIDGET_DRAWING);
-
-	for (; back; back = back->prev) {
-		line = back->data;
-		if (back->next && !line->soft) {
-			gnt_text_view_append_text_with_flags(view, "\n", GNT_TEXT_FLAG_NORMAL);
-		}
-
-		for (iter = line->segments; iter; iter = iter->next) {
-			GntTextSegment *seg = iter->data;
-			char *start = string->str + seg->start;
-			char *end = string->str + seg->end;
-			char back = *end;
-			*end = '\0';
-			gnt_text_view_append_text_with_flags(view, start, seg->tvflag);
-			*end = back;
-		}
-		free_text_line(line, NULL);
-	}
-	g_list_free(list);
-
-	list = view->list = g_list_first(view->list);
-	/* Go back to the line that was in view before resizing started */
-	while (pos--) {
-		while (((GntTextLine*)list->data)->soft)
-			list = list->next;
-		list = list->next;
-	}
-	view->list = list;
-	GNT_WIDGET_UNSET_FLAGS(GNT_WIDGET(view), GNT_WIDGET_DRAWING);
-	if (GNT_WIDGET(view)->window)
-		gnt_widget_draw(GNT_WIDGET(view));
-	g_string_free(string, TRUE);
-}
-
 static void
 gnt_text_view_size_changed(GntWidget *widget, int w, int h)
 {
-	if (w != widget->priv.width && GNT_WIDGET_IS_FLAG_SET(widget, GNT_WIDGET_MAPPED)) {
-		gnt_text_view_reflow(GNT_TEXT_VIEW(widget));
+	/* The lines are rewrapped as they are drawn */
+	if (w != widget->priv.width && GNT_WIDGET_IS_FLAG_SET(widget, GNT_WIDGET_MAPPED) &&
+			widget->window) {
+		gnt_widget_draw(widget);
 	}
 }
 
@@ -460,7 +691,7 @@ gnt_text_view_init(GTypeInstance *instance, gpointer class)
 {
 	GntWidget *widget = GNT_WIDGET(instance);
 	GntTextView *view = GNT_TEXT_VIEW(widget);
-	GntTextLine *line = g_new0(GntTextLine, 1);
+	GntTextLine *line = new_text_line(view, FALSE);
 
 	GNT_WIDGET_SET_FLAGS(widget, GNT_WIDGET_NO_BORDER | GNT_WIDGET_NO_SHADOW |
             GNT_WIDGET_GROW_Y | GNT_WIDGET_GROW_X);
@@ -468,6 +699,8 @@ gnt_text_view_init(GTypeInstance *instance, gpointer class)
 	widget->priv.minh = 2;
 	view->string = g_string_new(NULL);
 	view->list = g_list_append(view->list, line);
+	view->priv = g_new0(GntTextViewPriv, 1);
+	view->priv->lines = 1;
 
 	GNTDEBUG;
 }
@@ -518,20 +751,22 @@ void gnt_text_view_append_text_with_flags(GntTextView *view, const char *text, G
 void gnt_text_view_append_text_with_tag(GntTextView *view, const char *text,
 			GntTextFormatFlags flags, const char *tagname)
 {
-	GntWidget *widget = GNT_WIDGET(view);
 	chtype fl = 0;
-	const char *start, *end;
-	GList *list = view->list;
-	GntTextLine *line;
+	GList *list, *lines;
 	int len;
-	gboolean has_scroll = !(view->flags & GNT_TEXT_VIEW_NO_SCROLL);
-	gboolean wrap_word = !(view->flags & GNT_TEXT_VIEW_WRAP_CHAR);
 
 	if (text == NULL || *text == '\0')
 		return;
 
 	fl = gnt_text_format_flag_to_chtype(flags);
 
+	/* The new text continues the last line, so that needs to be wrapped for
+	 * the current width first. */
+	lines = g_list_first(view->list);
+	if (text_line_is_stale(view, lines))
+		reflow_line(view, lines);
+	list = view->list;
+
 	len = view->string->len;
 	view->string = g_string_append(view->string, text);
 
@@ -543,83 +778,13 @@ void gnt_text_view_append_text_with_tag(GntTextView *view, const char *text,
 		view->tags = g_list_append(view->tags, tag);
 	}
 
-	view->list = g_list_first(view->list);
-
-	start = end = view->string->str + len;
-
-	while (*start) {
-		GntTextLine *oldl;
-		GntTextSegment *seg = NULL;
-
-		if (*end == '\n' || *end == '\r') {
-			if (!strncmp(end, "\r\n", 2))
-				end++;
-			end++;
-			start = end;
-			gnt_text_view_next_line(view);
-			view->list = g_list_first(view->list);
-			continue;
-		}
-
-		line = view->list->data;
-		if (line->length == widget->priv.width - has_scroll) {
-			/* The last added line was exactly the same width as the widget */
-			line = g_new0(GntTextLine, 1);
-			line->soft = TRUE;
-			view->list = g_list_prepend(view->list, line);
-		}
-
-		if ((end = strchr(start, '\r')) != NULL ||
-			(end = strchr(start, '\n')) != NULL) {
-			len = gnt_util_onscreen_width(start, end - has_scroll);
-			if (widget->priv.width > 0 &&
-					len >= widget->priv.width - line->length - has_scroll) {
-				end = NULL;
-			}
-		}
-
-		if (end == NULL)
-			end = gnt_util_onscreen_width_to_pointer(start,
-					widget->priv.width - line->length - has_scroll, &len);
-
-		/* Try to append to the previous segment if possible */
-		if (line->segments) {
-			seg = g_list_last(line->segments)->data;
-			if (seg->flags != fl)
-				seg = NULL;
-		}
-
-		if (seg == NULL) {
-			seg = g_new0(GntTextSegment, 1);
-			seg->start = start - view->string->str;
-			seg->tvflag = flags;
-			seg->flags = fl;
-			line->segments = g_list_append(line->segments, seg);
-		}
-
-		oldl = line;
-		if (wrap_word && *end && *end != '\n' && *end != '\r') {
-			const char *tmp = end;
-			while (end && *end != '\n' && *end != '\r' && !g_ascii_isspace(*end)) {
-				end = g_utf8_find_prev_char(seg->start + view->string->str, end);
-			}
-			if (!end || !g_ascii_isspace(*end))
-				end = tmp;
-			else
-				end++; /* Remove the space */
-
-			line = g_new0(GntTextLine, 1);
-			line->soft = TRUE;
-			view->list = g_list_prepend(view->list, line);
-		}
-		seg->end = end - view->string->str;
-		oldl->length += len;
-		start = end;
-	}
+	wrap_text(view, g_list_first(list), view->string->str + len,
+			view->string->str + view->string->len, flags, fl);
 
 	view->list = list;
+	trim_scrollback(view);
 
-	gnt_widget_draw(widget);
+	gnt_widget_draw(GNT_WIDGET(view));
 }
 
 void gnt_text_view_scroll(GntTextView *view, int scroll)
@@ -648,11 +813,13 @@ void gnt_text_view_scroll(GntTextView *view, int scroll)
 
 void gnt_text_view_next_line(GntTextView *view)
 {
-	GntTextLine *line = g_new0(GntTextLine, 1);
+	GntTextLine *line = new_text_line(view, FALSE);
 	GList *list = view->list;
 
 	view->list = g_list_prepend(g_list_first(view->list), line);
 	view->list = list;
+	view->priv->lines++;
+	trim_scrollback(view);
 	gnt_widget_draw(GNT_WIDGET(view));
 }
 
@@ -687,8 +854,9 @@ static void reset_text_view(GntTextView *view)
 	g_list_free(view->list);
 	view->list = NULL;
 
-	line = g_new0(GntTextLine, 1);
+	line = new_text_line(view, FALSE);
 	view->list = g_list_append(view->list, line);
+	view->priv->lines = 1;
 	if (view->string)
 		g_string_free(view->string, TRUE);
 	view->string = g_string_new(NULL);
@@ -859,6 +1027,12 @@ void gnt_text_view_set_flag(GntTextView *view, GntTextViewFlag flag)
 	view->flags |= flag;
 }
 
+void gnt_text_view_set_scrollback(GntTextView *view, int lines)
+{
+	view->priv->scrollback = MAX(lines, 0);
+	trim_scrollback(view);
+}
+
 /* Pager and editor setups */
 struct
 {
@@ -65,6 +65,8 @@ struct _GntTextView
 
 	GList *tags;       /* A list of tags */
 	GntTextViewFlag flags;
+
+	GntTextViewPriv *priv;
 };
 
 typedef enum
@@ -258,6 +260,18 @@ void gnt_text_view_attach_editor_widget(GntTextView *view, GntWidget *widget);
  */
 void gnt_text_view_set_flag(GntTextView *view, GntTextViewFlag flag);
 
+/**
+ * gnt_text_view_set_scrollback:
+ * @view:   The textview widget
+ * @lines:  The maximum number of lines to keep, or 0 to keep everything
+ *
+ * Limit the number of lines the textview keeps. The oldest lines are dropped
+ * a chunk at a time, so the textview can hold a few more lines than @lines.
+ *
+ * Since: 2.9.0
+ */
+void gnt_text_view_set_scrollback(GntTextView *view, int lines);
+
 G_END_DECLS
 
 #endif /* GNT_TEXT_VIEW_H */
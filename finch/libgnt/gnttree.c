@@ -62,6 +62,9 @@ struct _GntTreePriv
 	GCompareFunc compare;
 	int lastvisible;
 	int expander_level;
+
+	GntTreeRow *index;      /* Root of the row index (see below) */
+	GSequence *top_rows;    /* The top-level rows, in order */
 };
 
 #define	TAB_SIZE 3
@@ -89,6 +92,21 @@ struct _GntTreeRow
 
 	GList *columns;
 	GntTree *tree;
+
+	GList *link;                /* This row's link in tree->list */
+	GSequence *children;        /* The children, in order, for sorted inserts */
+	GSequenceIter *sibling;     /* This row's position in its parent's sequence */
+
+	/* The row index is a treap holding every row of the tree in display
+	 * order, where each node counts the visible rows under it.  This makes
+	 * finding the position of a row, or the n-th visible row, logarithmic
+	 * in the number of rows. */
+	GntTreeRow *iparent;
+	GntTreeRow *ileft;
+	GntTreeRow *iright;
+	guint32 priority;
+	int count;                  /* Visible rows in this treap subtree */
+	gboolean visible;           /* Not filtered out or under a collapsed row */
 };
 
 struct _GntTreeCol
@@ -137,18 +155,6 @@ readjust_columns(GntTree *tree)
 	}
 }
 
-/* Move the item at position old to position new */
-static GList *
-g_list_reposition_child(GList *list, int old, int new)
-{
-	gpointer item = g_list_nth_data(list, old);
-	list = g_list_remove(list, item);
-	if (old < new)
-		new--;   /* because the positions would have shifted after removing the item */
-	list = g_list_insert(list, item, new);
-	return list;
-}
-
 static GntTreeRow *
 _get_next(GntTreeRow *row, gboolean godeep)
 {
@@ -181,100 +187,352 @@ row_matches_search(GntTreeRow *row)
 	return TRUE;
 }
 
+/******************************************************************************
+ * The row index
+ *****************************************************************************/
+#define INDEX_COUNT(row)  ((row) ? (row)->count : 0)
+
+static void
+index_update_count(GntTreeRow *row)
+{
+	row->count = INDEX_COUNT(row->ileft) + INDEX_COUNT(row->iright) + (row->visible ? 1 : 0);
+}
+
+static void
+index_rotate_up(GntTree *tree, GntTreeRow *row)
+{
+	GntTreeRow *parent = row->iparent;
+	GntTreeRow *grand = parent->iparent;
+
+	if (parent->ileft == row) {
+		parent->ileft = row->iright;
+		if (row->iright)
+			row->iright->iparent = parent;
+		row->iright = parent;
+	} else {
+		parent->iright = row->ileft;
+		if (row->ileft)
+			row->ileft->iparent = parent;
+		row->ileft = parent;
+	}
+	parent->iparent = row;
+	row->iparent = grand;
+
+	if (grand == NULL)
+		tree->priv->index = row;
+	else if (grand->ileft == parent)
+		grand->ileft = row;
+	else
+		grand->iright = row;
+
+	index_update_count(parent);
+	index_update_count(row);
+}
+
+/* Inserts row right before 'before' in display order, or at the end if
+ * 'before' is NULL.  row->visible must already be set. */
+static void
+index_insert(GntTree *tree, GntTreeRow *row, GntTreeRow *before)
+{
+	GntTreeRow *parent;
+
+	row->ileft = row->iright = NULL;
+	row->priority = g_random_int();
+	row->count = row->visible ? 1 : 0;
+
+	if (tree->priv->index == NULL) {
+		row->iparent = NULL;
+		tree->priv->index = row;
+		return;
+	}
+
+	if (before == NULL) {
+		parent = tree->priv->index;
+		while (parent->iright)
+			parent = parent->iright;
+		parent->iright = row;
+	} else if (before->ileft == NULL) {
+		parent = before;
+		parent->ileft = row;
+	} else {
+		parent = before->ileft;
+		while (parent->iright)
+			parent = parent->iright;
+		parent->iright = row;
+	}
+	row->iparent = parent;
+
+	for (; parent; parent = parent->iparent)
+		parent->count += row->count;
+
+	while (row->iparent && row->iparent->priority < row->priority)
+		index_rotate_up(tree, row);
+}
+
+static void
+index_remove(GntTree *tree, GntTreeRow *row)
+{
+	GntTreeRow *child, *parent;
+
+	while (row->ileft && row->iright) {
+		child = (row->ileft->priority > row->iright->priority) ? row->ileft : row->iright;
+		index_rotate_up(tree, child);
+	}
+
+	child = row->ileft ? row->ileft : row->iright;
+	parent = row->iparent;
+	if (child)
+		child->iparent = parent;
+	if (parent == NULL)
+		tree->priv->index = child;
+	else if (parent->ileft == row)
+		parent->ileft = child;
+	else
+		parent->iright = child;
+
+	for (; parent; parent = parent->iparent)
+		parent->count -= row->visible ? 1 : 0;
+
+	row->iparent = row->ileft = row->iright = NULL;
+	row->count = 0;
+}
+
+static void
+index_set_visible(GntTreeRow *row, gboolean visible)
+{
+	int delta;
+
+	visible = !!visible;
+	if (row->visible == visible)
+		return;
+
+	row->visible = visible;
+	delta = visible ? 1 : -1;
+	for (; row; row = row->iparent)
+		row->count += delta;
+}
+
+/* The number of visible rows before row */
+static int
+index_rank(GntTreeRow *row)
+{
+	int rank = INDEX_COUNT(row->ileft);
+
+	for (; row->iparent; row = row->iparent) {
+		if (row->iparent->iright == row)
+			rank += INDEX_COUNT(row->iparent->ileft) + (row->iparent->visible ? 1 : 0);
+	}
+	return rank;
+}
+
+/* The n-th visible row, counting from 0 */
 static GntTreeRow *
-get_next(GntTreeRow *row)
+index_nth(GntTree *tree, int n)
 {
-	if (row == NULL)
+	GntTreeRow *row = tree->priv->index;
+
+	if (n < 0)
 		return NULL;
-	while ((row = _get_next(row, !row->collapsed)) != NULL) {
-		if (row_matches_search(row))
-			break;
+
+	while (row) {
+		int left = INDEX_COUNT(row->ileft);
+		if (n < left) {
+			row = row->ileft;
+			continue;
+		}
+		n -= left;
+		if (row->visible) {
+			if (n == 0)
+				return row;
+			n--;
+		}
+		row = row->iright;
 	}
-	return row;
+	return NULL;
 }
 
-/* Returns the n-th next row. If it doesn't exist, returns NULL */
 static GntTreeRow *
-get_next_n(GntTreeRow *row, int n)
+index_first_visible(GntTreeRow *row)
 {
-	while (row && n--)
-		row = get_next(row);
-	return row;
+	while (row) {
+		if (INDEX_COUNT(row->ileft) > 0)
+			row = row->ileft;
+		else if (row->visible)
+			return row;
+		else
+			row = row->iright;
+	}
+	return NULL;
 }
 
-/* Returns the n-th next row. If it doesn't exist, then the last non-NULL node */
 static GntTreeRow *
-get_next_n_opt(GntTreeRow *row, int n, int *pos)
+index_last_visible(GntTreeRow *row)
 {
-	GntTreeRow *next = row;
-	int r = 0;
+	while (row) {
+		if (INDEX_COUNT(row->iright) > 0)
+			row = row->iright;
+		else if (row->visible)
+			return row;
+		else
+			row = row->ileft;
+	}
+	return NULL;
+}
+
+static int
+index_visible_count(GntTree *tree)
+{
+	return INDEX_COUNT(tree->priv->index);
+}
 
+/* Recount every node after changing the visibility of many rows at once */
+static int
+index_recount(GntTreeRow *row)
+{
 	if (row == NULL)
-		return NULL;
+		return 0;
+	row->count = index_recount(row->ileft) + index_recount(row->iright) +
+			(row->visible ? 1 : 0);
+	return row->count;
+}
 
-	while (row && n--)
-	{
-		row = get_next(row);
-		if (row)
-		{
-			next = row;
-			r++;
-		}
+static gboolean
+row_is_expanded_to(GntTreeRow *row)
+{
+	GntTreeRow *parent;
+
+	for (parent = row->parent; parent; parent = parent->parent)
+		if (parent->collapsed)
+			return FALSE;
+	return TRUE;
+}
+
+static gboolean
+row_is_visible(GntTreeRow *row)
+{
+	return row_is_expanded_to(row) && row_matches_search(row);
+}
+
+/* Refreshes the visibility of a list of siblings and everything under them.
+ * 'shown' is whether their parent is expanded all the way up. */
+static void
+index_refresh_rows(GntTreeRow *row, gboolean shown)
+{
+	for (; row; row = row->next) {
+		index_set_visible(row, shown && row_matches_search(row));
+		if (!row->collapsed)
+			index_refresh_rows(row->child, shown);
 	}
+}
 
-	if (pos)
-		*pos = r;
+/* Called after row is collapsed or expanded */
+static void
+index_refresh_children(GntTreeRow *row)
+{
+	index_refresh_rows(row->child, !row->collapsed && row_is_expanded_to(row));
+}
+
+/* Called after the search text changes */
+static void
+index_refresh_all(GntTree *tree)
+{
+	GntTreeRow *row = tree->root;
 
-	return next;
+	/* Every row may change, so set the flags first and recount once. */
+	while (row) {
+		row->visible = row_is_visible(row);
+		row = _get_next(row, TRUE);
+	}
+	index_recount(tree->priv->index);
 }
 
 static GntTreeRow *
-get_last_child(GntTreeRow *row)
+get_next(GntTreeRow *row)
 {
+	GntTreeRow *parent;
+
 	if (row == NULL)
 		return NULL;
-	if (!row->collapsed && row->child)
-		row = row->child;
-	else
-		return row;
-
-	while(row->next)
-		row = row->next;
-	return get_last_child(row);
+	if (INDEX_COUNT(row->iright) > 0)
+		return index_first_visible(row->iright);
+	for (; (parent = row->iparent) != NULL; row = parent) {
+		if (parent->ileft != row)
+			continue;
+		if (parent->visible)
+			return parent;
+		if (INDEX_COUNT(parent->iright) > 0)
+			return index_first_visible(parent->iright);
+	}
+	return NULL;
 }
 
 static GntTreeRow *
 get_prev(GntTreeRow *row)
 {
+	GntTreeRow *parent;
+
 	if (row == NULL)
 		return NULL;
-	while (row) {
-		if (row->prev)
-			row = get_last_child(row->prev);
-		else
-			row = row->parent;
-		if (!row || row_matches_search(row))
-			break;
+	if (INDEX_COUNT(row->ileft) > 0)
+		return index_last_visible(row->ileft);
+	for (; (parent = row->iparent) != NULL; row = parent) {
+		if (parent->iright != row)
+			continue;
+		if (parent->visible)
+			return parent;
+		if (INDEX_COUNT(parent->ileft) > 0)
+			return index_last_visible(parent->ileft);
 	}
-	return row;
+	return NULL;
+}
+
+/* Returns the n-th next row. If it doesn't exist, returns NULL */
+static GntTreeRow *
+get_next_n(GntTreeRow *row, int n)
+{
+	if (row == NULL || n == 0)
+		return row;
+	if (n == 1)
+		return get_next(row);
+	return index_nth(row->tree, index_rank(row) + (row->visible ? 1 : 0) + n - 1);
+}
+
+/* Returns the n-th next row. If it doesn't exist, then the last non-NULL node */
+static GntTreeRow *
+get_next_n_opt(GntTreeRow *row, int n, int *pos)
+{
+	int first, after;
+
+	if (row == NULL)
+		return NULL;
+
+	first = index_rank(row) + (row->visible ? 1 : 0);
+	after = index_visible_count(row->tree) - first;
+	n = MIN(MAX(n, 0), after);
+
+	if (pos)
+		*pos = n;
+
+	return n ? index_nth(row->tree, first + n - 1) : row;
 }
 
 static GntTreeRow *
 get_prev_n(GntTreeRow *row, int n)
 {
-	while (row && n--)
-		row = get_prev(row);
-	return row;
+	if (row == NULL || n == 0)
+		return row;
+	if (n == 1)
+		return get_prev(row);
+	return index_nth(row->tree, index_rank(row) - n);
 }
 
 /* Distance of row from the root */
-/* XXX: This is uber-inefficient */
 static int
 get_root_distance(GntTreeRow *row)
 {
 	if (row == NULL)
 		return -1;
-	return get_root_distance(get_prev(row)) + 1;
+	return index_rank(row);
 }
 
 /* Returns the distance between a and b.
@@ -282,10 +540,6 @@ get_root_distance(GntTreeRow *row)
 static int
 get_distance(GntTreeRow *a, GntTreeRow *b)
 {
-	/* First get the distance from a to the root.
-	 * Then the distance from b to the root.
-	 * Subtract.
-	 * It's not that good, but it works. */
 	int ha = get_root_distance(a);
 	int hb = get_root_distance(b);
 
@@ -577,7 +831,8 @@ redraw_tree(GntTree *tree)
 		int total = 0;
 		int showing, position;
 
-		get_next_n_opt(tree->root, g_list_length(tree->list), &total);
+		if (tree->root)
+			total = index_visible_count(tree) - (tree->root->visible ? 1 : 0);
 		showing = rows * rows / MAX(total, 1) + 1;
 		showing = MIN(rows, showing);
 
@@ -793,6 +1048,7 @@ end_search(GntTree *tree)
 		tree->priv->search = NULL;
 		tree->priv->search_timeout = 0;
 		GNT_WIDGET_UNSET_FLAGS(GNT_WIDGET(tree), GNT_WIDGET_DISABLE_ACTIONS);
+		index_refresh_all(tree);
 	}
 }
 
@@ -826,6 +1082,7 @@ gnt_tree_key_pressed(GntWidget *widget, const char *text)
 		} else
 			changed = FALSE;
 		if (changed) {
+			index_refresh_all(tree);
 			redraw_tree(tree);
 		} else {
 			gnt_bindable_perform_action_key(GNT_BINDABLE(tree), text);
@@ -839,6 +1096,7 @@ gnt_tree_key_pressed(GntWidget *widget, const char *text)
 		if (row && row->child)
 		{
 			row->collapsed = !row->collapsed;
+			index_refresh_children(row);
 			redraw_tree(tree);
 			g_signal_emit(tree, signals[SIG_COLLAPSED], 0, row->key, row->collapsed);
 		}
@@ -879,6 +1137,7 @@ gnt_tree_destroy(GntWidget *widget)
 	if (tree->hash)
 		g_hash_table_destroy(tree->hash);
 	g_list_free(tree->list);
+	g_sequence_free(tree->priv->top_rows);
 	gnt_tree_free_columns(tree);
 	g_free(tree->priv);
 }
@@ -982,11 +1241,11 @@ move_last_action(GntBindable *bind, GList *null)
 {
 	GntTree *tree = GNT_TREE(bind);
 	GntTreeRow *old = tree->current;
-	GntTreeRow *row = tree->bottom;
-	GntTreeRow *next;
+	GntTreeRow *row;
 
-	while ((next = get_next(row)))
-		row = next;
+	row = index_nth(tree, index_visible_count(tree) - 1);
+	if (row == NULL)
+		row = tree->bottom;
 
 	if (row) {
 		tree->current = row;
@@ -1132,6 +1391,7 @@ gnt_tree_init(GTypeInstance *instance, gpointer class)
 	GntTree *tree = GNT_TREE(widget);
 	tree->show_separator = TRUE;
 	tree->priv = g_new0(GntTreePriv, 1);
+	tree->priv->top_rows = g_sequence_new(NULL);
 	GNT_WIDGET_SET_FLAGS(widget, GNT_WIDGET_GROW_X | GNT_WIDGET_GROW_Y |
 			GNT_WIDGET_CAN_TAKE_FOCUS | GNT_WIDGET_NO_SHADOW);
 	gnt_widget_set_take_focus(widget, TRUE);
@@ -1190,6 +1450,8 @@ free_tree_row(gpointer data)
 
 	g_list_foreach(row->columns, (GFunc)free_tree_col, NULL);
 	g_list_free(row->columns);
+	if (row->children)
+		g_sequence_free(row->children);
 	g_free(row);
 }
 
@@ -1243,41 +1505,132 @@ void gnt_tree_scroll(GntTree *tree, int count)
 	g_signal_emit(tree, signals[SIG_SCROLLED], 0, count);
 }
 
+static GSequence *
+get_sibling_sequence(GntTree *tree, GntTreeRow *parent)
+{
+	if (parent == NULL)
+		return tree->priv->top_rows;
+	if (parent->children == NULL)
+		parent->children = g_sequence_new(NULL);
+	return parent->children;
+}
+
+/* Returns the first of the sorted siblings that sorts after key, or NULL if
+ * there's none.  The siblings are binary searched, so they need to be sorted,
+ * except for 'skip', which is left out of the search (that's the row being
+ * re-sorted, if any). */
+static GntTreeRow *
+find_sorted_sibling(GntTree *tree, GSequence *siblings, gpointer key, GntTreeRow *skip)
+{
+	int lo = 0, hi = g_sequence_get_length(siblings);
+	int skippos = hi;
+
+	if (skip) {
+		skippos = g_sequence_iter_get_position(skip->sibling);
+		hi--;
+	}
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		GntTreeRow *row = g_sequence_get(g_sequence_get_iter_at_pos(siblings,
+					mid < skippos ? mid : mid + 1));
+		if (tree->priv->compare(key, row->key) < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	if (skip && lo >= skippos)
+		lo++;
+	if (lo >= g_sequence_get_length(siblings))
+		return NULL;
+	return g_sequence_get(g_sequence_get_iter_at_pos(siblings, lo));
+}
+
 static gpointer
 find_position(GntTree *tree, gpointer key, gpointer parent)
 {
-	GntTreeRow *row;
+	GntTreeRow *row = NULL;
+	GSequence *siblings;
 
 	if (tree->priv->compare == NULL)
 		return NULL;
 
-	if (parent == NULL)
-		row = tree->root;
-	else
+	if (parent) {
 		row = g_hash_table_lookup(tree->hash, parent);
+		if (!row)
+			return NULL;
+	}
 
-	if (!row)
+	siblings = get_sibling_sequence(tree, row);
+	if (g_sequence_get_length(siblings) == 0)
 		return NULL;
 
-	if (parent)
-		row = row->child;
+	row = find_sorted_sibling(tree, siblings, key, NULL);
+	if (row)
+		return (row->prev ? row->prev->key : NULL);
 
-	while (row)
-	{
-		if (tree->priv->compare(key, row->key) < 0)
-			return (row->prev ? row->prev->key : NULL);
-		if (row->next)
-			row = row->next;
-		else
-			return row->key;
-	}
-	return NULL;
+	row = g_sequence_get(g_sequence_iter_prev(g_sequence_get_end_iter(siblings)));
+	return row->key;
+}
+
+/* The row that comes right after row and all its children in display order */
+static GntTreeRow *
+get_next_after_children(GntTreeRow *row)
+{
+	return _get_next(row, FALSE);
+}
+
+static void
+index_remove_subtree(GntTree *tree, GntTreeRow *row)
+{
+	GntTreeRow *child;
+
+	index_remove(tree, row);
+	for (child = row->child; child; child = child->next)
+		index_remove_subtree(tree, child);
+}
+
+static void
+index_insert_subtree(GntTree *tree, GntTreeRow *row, GntTreeRow *before)
+{
+	GntTreeRow *child;
+
+	index_insert(tree, row, before);
+	for (child = row->child; child; child = child->next)
+		index_insert_subtree(tree, child, before);
+}
+
+/* Inserts a new link for key right after 'link' in tree->list */
+static GList *
+list_insert_after(GntTree *tree, GList *link, gpointer key)
+{
+	GList *new = g_list_alloc();
+
+	new->data = key;
+	new->prev = link;
+	new->next = link->next;
+	if (link->next)
+		link->next->prev = new;
+	link->next = new;
+
+	return new;
+}
+
+static GList *
+list_insert_before(GntTree *tree, GList *link, gpointer key)
+{
+	if (link->prev)
+		return list_insert_after(tree, link->prev, key);
+
+	tree->list = g_list_prepend(tree->list, key);
+	return tree->list;
 }
 
 void gnt_tree_sort_row(GntTree *tree, gpointer key)
 {
 	GntTreeRow *row, *q, *s;
-	int current, newp;
+	GSequence *siblings;
 
 	if (!tree->priv->compare)
 		return;
@@ -1285,25 +1638,20 @@ void gnt_tree_sort_row(GntTree *tree, gpointer key)
 	row = g_hash_table_lookup(tree->hash, key);
 	g_return_if_fail(row != NULL);
 
-	current = g_list_index(tree->list, key);
-
-	if (row->parent)
-		s = row->parent->child;
+	siblings = get_sibling_sequence(tree, row->parent);
+	s = find_sorted_sibling(tree, siblings, row->key, row);
+	if (s)
+		q = s->prev;
 	else
-		s = tree->root;
-
-	q = NULL;
-	while (s) {
-		if (tree->priv->compare(row->key, s->key) < 0)
-			break;
-		q = s;
-		s = s->next;
-	}
+		q = g_sequence_get(g_sequence_iter_prev(g_sequence_get_end_iter(siblings)));
 
 	/* Move row between q and s */
 	if (row == q || row == s)
 		return;
 
+	index_remove_subtree(tree, row);
+	tree->list = g_list_delete_link(tree->list, row->link);
+
 	if (q == NULL) {
 		/* row becomes the first child of its parent */
 		row->prev->next = row->next;  /* row->prev cannot be NULL at this point */
@@ -1317,7 +1665,7 @@ void gnt_tree_sort_row(GntTree *tree, gpointer key)
 		g_return_if_fail(s != NULL); /* s cannot be NULL */
 		s->prev = row;
 		row->prev = NULL;
-		newp = g_list_index(tree->list, s) - 1;
+		row->link = list_insert_before(tree, s->link, row->key);
 	} else {
 		if (row->prev) {
 			row->prev->next = row->next;
@@ -1326,7 +1674,7 @@ void gnt_tree_sort_row(GntTree *tree, gpointer key)
 			if (row->parent)
 				row->parent->child = row->next;
 			else
-				tree->top = row->next;
+				tree->root = row->next;
 		}
 
 		if (row->next)
@@ -1337,9 +1685,11 @@ void gnt_tree_sort_row(GntTree *tree, gpointer key)
 		if (s)
 			s->prev = row;
 		row->next = s;
-		newp = g_list_index(tree->list, q) + 1;
+		row->link = list_insert_after(tree, q->link, row->key);
 	}
-	tree->list = g_list_reposition_child(tree->list, current, newp);
+
+	g_sequence_move(row->sibling, s ? s->sibling : g_sequence_get_end_iter(siblings));
+	index_insert_subtree(tree, row, get_next_after_children(row));
 
 	redraw_tree(tree);
 }
@@ -1366,11 +1716,11 @@ GntTreeRow *gnt_tree_add_row_after(GntTree *tree, void *key, GntTreeRow *row, vo
 	{
 		tree->root = row;
 		tree->list = g_list_prepend(tree->list, key);
+		row->link = tree->list;
+		row->sibling = g_sequence_prepend(tree->priv->top_rows, row);
 	}
 	else
 	{
-		int position = 0;
-
 		if (bigbro)
 		{
 			pr = g_hash_table_lookup(tree->hash, bigbro);
@@ -1382,7 +1732,9 @@ GntTreeRow *gnt_tree_add_row_after(GntTree *tree, void *key, GntTreeRow *row, vo
 				pr->next = row;
 				row->parent = pr->parent;
 
-				position = g_list_index(tree->list, bigbro);
+				row->link = list_insert_after(tree, pr->link, key);
+				row->sibling = g_sequence_insert_before(
+						g_sequence_iter_next(pr->sibling), row);
 			}
 		}
 
@@ -1396,7 +1748,8 @@ GntTreeRow *gnt_tree_add_row_after(GntTree *tree, void *key, GntTreeRow *row, vo
 				pr->child = row;
 				row->parent = pr;
 
-				position = g_list_index(tree->list, parent);
+				row->link = list_insert_after(tree, pr->link, key);
+				row->sibling = g_sequence_prepend(get_sibling_sequence(tree, pr), row);
 			}
 		}
 
@@ -1409,12 +1762,14 @@ GntTreeRow *gnt_tree_add_row_after(GntTree *tree, void *key, GntTreeRow *row, vo
 				tree->current = row;
 			tree->root = row;
 			tree->list = g_list_prepend(tree->list, key);
-		}
-		else
-		{
-			tree->list = g_list_insert(tree->list, key, position + 1);
+			row->link = tree->list;
+			row->sibling = g_sequence_prepend(tree->priv->top_rows, row);
 		}
 	}
+
+	row->visible = row_is_visible(row);
+	index_insert(tree, row, get_next_after_children(row));
+
 	redraw_tree(tree);
 
 	return row;
@@ -1423,20 +1778,14 @@ GntTreeRow *gnt_tree_add_row_after(GntTree *tree, void *key, GntTreeRow *row, vo
 GntTreeRow *gnt_tree_add_row_last(GntTree *tree, void *key, GntTreeRow *row, void *parent)
 {
 	GntTreeRow *pr = NULL, *br = NULL;
+	GSequence *siblings;
 
 	if (parent)
 		pr = g_hash_table_lookup(tree->hash, parent);
 
-	if (pr)
-		br = pr->child;
-	else
-		br = tree->root;
-
-	if (br)
-	{
-		while (br->next)
-			br = br->next;
-	}
+	siblings = get_sibling_sequence(tree, pr);
+	if (g_sequence_get_length(siblings) > 0)
+		br = g_sequence_get(g_sequence_iter_prev(g_sequence_get_end_iter(siblings)));
 
 	return gnt_tree_add_row_after(tree, key, row, parent, br ? br->key : NULL);
 }
@@ -1500,7 +1849,7 @@ void gnt_tree_remove(GntTree *tree, gpointer key)
 
 		/* Update root/top/current/bottom if necessary */
 		if (tree->root == row)
-			tree->root = get_next(row);
+			tree->root = row->next;
 		if (tree->top == row)
 		{
 			if (tree->top != tree->root)
@@ -1529,8 +1878,10 @@ void gnt_tree_remove(GntTree *tree, gpointer key)
 		if (row->prev)
 			row->prev->next = row->next;
 
+		g_sequence_remove(row->sibling);
+		index_remove(tree, row);
+		tree->list = g_list_delete_link(tree->list, row->link);
 		g_hash_table_remove(tree->hash, key);
-		tree->list = g_list_remove(tree->list, key);
 
 		if (redraw && depth == 0)
 		{
@@ -1552,6 +1903,9 @@ void gnt_tree_remove_all(GntTree *tree)
 	g_list_free(tree->list);
 	tree->list = NULL;
 	tree->current = tree->top = tree->bottom = NULL;
+	tree->priv->index = NULL;
+	g_sequence_free(tree->priv->top_rows);
+	tree->priv->top_rows = g_sequence_new(NULL);
 }
 
 int gnt_tree_get_selection_visible_line(GntTree *tree)
@@ -1578,6 +1932,9 @@ void gnt_tree_change_text(GntTree *tree, gpointer key, int colno, const char *te
 			col->text = g_strdup(text ? text : "");
 		}
 
+		if (SEARCHING(tree))
+			index_set_visible(row, row_is_visible(row));
+
 		if (GNT_WIDGET_IS_FLAG_SET(GNT_WIDGET(tree), GNT_WIDGET_MAPPED) &&
 			get_distance(tree->top, row) >= 0 && get_distance(row, tree->bottom) >= 0)
 			redraw_tree(tree);
@@ -1793,6 +2150,7 @@ void gnt_tree_set_expanded(GntTree *tree, void *key, gboolean expanded)
 	GntTreeRow *row = g_hash_table_lookup(tree->hash, key);
 	if (row) {
 		row->collapsed = !expanded;
+		index_refresh_children(row);
 		if (GNT_WIDGET(tree)->window)
 			gnt_widget_draw(GNT_WIDGET(tree));
 		g_signal_emit(tree, signals[SIG_COLLAPSED], 0, key, row->collapsed);
@@ -1847,6 +2205,9 @@ void gnt_tree_set_hash_fns(GntTree *tree, gpointer hash, gpointer eq, gpointer k
 	g_hash_table_foreach_remove(tree->hash, return_true, NULL);
 	g_hash_table_destroy(tree->hash);
 	tree->hash = g_hash_table_new_full(hash, eq, kd, free_tree_row);
+	tree->priv->index = NULL;
+	g_sequence_free(tree->priv->top_rows);
+	tree->priv->top_rows = g_sequence_new(NULL);
 }
 
 static void
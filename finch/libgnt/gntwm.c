@@ -64,6 +64,7 @@
 #include "gntwindow.h"
 
 #define IDLE_CHECK_INTERVAL 5 /* 5 seconds */
+#define FRAME_INTERVAL 33     /* milliseconds between screen updates */
 
 enum
 {
@@ -103,6 +104,15 @@ static time_t last_active_time;
 static gboolean idle_update;
 static GList *act = NULL; /* list of WS with unseen activitiy */
 static gboolean ignore_keys = FALSE;
+
+/* Screen updates are batched, and flushed at most once every frame_interval */
+static int frame_interval = FRAME_INTERVAL;
+static guint flush_source;
+static gint64 last_flush;
+static GHashTable *damaged;   /* toplevel widgets that need to be copied to the screen */
+static gboolean taskbar_damaged;
+static guint64 repaints;
+static guint64 repaints_avoided;
 #ifdef USE_PYTHON
 static gboolean started_python = FALSE;
 #endif
@@ -232,11 +242,32 @@ update_act_msg(void)
 	g_string_free(text, TRUE);
 }
 
-static gboolean
-update_screen(GntWM *wm)
+static void
+flush_screen(GntWM *wm)
 {
-	if (wm->mode == GNT_KP_MODE_WAIT_ON_CHILD)
-		return TRUE;
+	GHashTableIter iter;
+	gpointer widget;
+
+	if (flush_source) {
+		g_source_remove(flush_source);
+		flush_source = 0;
+	}
+
+	g_hash_table_iter_init(&iter, damaged);
+	while (g_hash_table_iter_next(&iter, &widget, NULL)) {
+		GntNode *node = g_hash_table_lookup(wm->nodes, widget);
+		if (node == NULL)
+			continue;
+		if (!GNT_IS_MENU(widget))
+			gnt_box_sync_children(GNT_BOX(widget));
+		gnt_wm_copy_win(widget, node);
+	}
+	g_hash_table_remove_all(damaged);
+
+	if (taskbar_damaged) {
+		gnt_ws_draw_taskbar(wm->cws, FALSE);
+		taskbar_damaged = FALSE;
+	}
 
 	if (wm->menu) {
 		GntMenu *top = wm->menu;
@@ -250,6 +281,43 @@ update_screen(GntWM *wm)
 	work_around_for_ncurses_bug();
 	update_panels();
 	doupdate();
+
+	repaints++;
+	last_flush = g_get_monotonic_time();
+}
+
+static gboolean
+flush_screen_cb(gpointer data)
+{
+	GntWM *wm = data;
+
+	flush_source = 0;
+	if (wm->mode != GNT_KP_MODE_WAIT_ON_CHILD)
+		flush_screen(wm);
+	return FALSE;
+}
+
+static gboolean
+update_screen(GntWM *wm)
+{
+	gint64 wait;
+
+	if (wm->mode == GNT_KP_MODE_WAIT_ON_CHILD)
+		return TRUE;
+
+	if (frame_interval <= 0) {
+		flush_screen(wm);
+		return TRUE;
+	}
+
+	if (flush_source) {
+		/* This will be taken care of by the next flush */
+		repaints_avoided++;
+		return TRUE;
+	}
+
+	wait = frame_interval - (g_get_monotonic_time() - last_flush) / 1000;
+	flush_source = g_timeout_add(CLAMP(wait, 0, frame_interval), flush_screen_cb, wm);
 	return TRUE;
 }
 
@@ -386,6 +454,8 @@ static void
 gnt_wm_init(GTypeInstance *instance, gpointer class)
 {
 	GntWM *wm = GNT_WM(instance);
+	char *str;
+
 	wm->workspaces = NULL;
 	wm->name_places = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
 	wm->title_places = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
@@ -404,6 +474,11 @@ gnt_wm_init(GTypeInstance *instance, gpointer class)
 	wm->positions = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
 	if (gnt_style_get_bool(GNT_STYLE_REMPOS, TRUE))
 		read_window_positions(wm);
+	damaged = g_hash_table_new(g_direct_hash, g_direct_equal);
+	if ((str = gnt_style_get_from_name(NULL, "frame-interval")) != NULL) {
+		frame_interval = atoi(str);
+		g_free(str);
+	}
 	g_timeout_add_seconds(IDLE_CHECK_INTERVAL, check_idle, NULL);
 	time(&last_active_time);
 	gnt_wm_switch_workspace(wm, 0);
@@ -896,8 +971,7 @@ shift_window(GntWM *wm, GntWidget *widget, int dir)
 		GntWidget *w = wm->cws->ordered->data;
 		GntNode *node = g_hash_table_lookup(wm->nodes, w);
 		top_panel(node->panel);
-		update_panels();
-		doupdate();
+		update_screen(wm);
 	}
 }
 
@@ -1377,6 +1451,7 @@ gnt_wm_destroy(GObject *obj)
 {
 	GntWM *wm = GNT_WM(obj);
 	GList *list = NULL;
+
 	g_hash_table_foreach(wm->nodes, accumulate_windows, &list);
 	g_list_foreach(list, (GFunc)gnt_widget_destroy, NULL);
 	g_list_free(list);
@@ -1387,6 +1462,15 @@ gnt_wm_destroy(GObject *obj)
 		g_object_unref(wm->workspaces->data);
 		wm->workspaces = g_list_delete_link(wm->workspaces, wm->workspaces);
 	}
+
+	/* Closing the windows above damages the screen and schedules a flush,
+	 * so this has to go after them. */
+	if (flush_source) {
+		g_source_remove(flush_source);
+		flush_source = 0;
+	}
+	g_hash_table_destroy(damaged);
+	damaged = NULL;
 #ifdef USE_PYTHON
 	if (started_python) {
 		Py_Finalize();
@@ -1917,6 +2001,7 @@ void gnt_wm_window_close(GntWM *wm, GntWidget *widget)
 
 	g_signal_emit(wm, signals[SIG_CLOSE_WIN], 0, widget);
 	g_hash_table_remove(wm->nodes, widget);
+	g_hash_table_remove(damaged, widget);
 
 	if (wm->windows) {
 		gnt_tree_remove(GNT_TREE(wm->windows->tree), widget);
@@ -2218,22 +2303,23 @@ void gnt_wm_update_window(GntWM *wm, GntWidget *widget)
 
 	while (widget->parent)
 		widget = widget->parent;
-	if (!GNT_IS_MENU(widget)) {
-		if (!GNT_IS_BOX(widget))
-			return;
-		gnt_box_sync_children(GNT_BOX(widget));
-	}
+	if (!GNT_IS_MENU(widget) && !GNT_IS_BOX(widget))
+		return;
 
 	ws = gnt_wm_widget_find_workspace(wm, widget);
 	node = g_hash_table_lookup(wm->nodes, widget);
 	if (node == NULL) {
+		if (!GNT_IS_MENU(widget))
+			gnt_box_sync_children(GNT_BOX(widget));
 		gnt_wm_new_window(wm, widget);
-	} else
+	} else {
 		g_signal_emit(wm, signals[SIG_UPDATE_WIN], 0, node);
+		/* The children are synced and the window is copied with the next flush */
+		g_hash_table_add(damaged, widget);
+	}
 
 	if (ws == wm->cws || GNT_WIDGET_IS_FLAG_SET(widget, GNT_WIDGET_TRANSIENT)) {
-		gnt_wm_copy_win(widget, node);
-		gnt_ws_draw_taskbar(wm->cws, FALSE);
+		taskbar_damaged = TRUE;
 		update_screen(wm);
 	} else if (ws && ws != wm->cws && GNT_WIDGET_IS_FLAG_SET(widget, GNT_WIDGET_URGENT)) {
 		if (!act || (act && !g_list_find(act, ws)))
@@ -2277,4 +2363,12 @@ void gnt_wm_set_event_stack(GntWM *wm, gboolean set)
 	wm->event_stack = set;
 }
 
+void gnt_wm_get_repaint_stats(guint64 *r, guint64 *avoided)
+{
+	if (r)
+		*r = repaints;
+	if (avoided)
+		*avoided = repaints_avoided;
+}
+
 
@@ -379,6 +379,19 @@ void gnt_wm_copy_win(GntWidget *widget, GntNode *node);
  */
 time_t gnt_wm_get_idle_time(void);
 
+/**
+ * gnt_wm_get_repaint_stats:
+ * @repaints:  (out) (optional): Return location for the number of times the
+ *             screen was updated, or %NULL.
+ * @avoided:   (out) (optional): Return location for the number of screen
+ *             updates that were merged into another update, or %NULL.
+ *
+ * Get statistics about how the screen updates were batched.
+ *
+ * Since: 2.9.0
+ */
+void gnt_wm_get_repaint_stats(guint64 *repaints, guint64 *avoided);
+
 G_END_DECLS
 
 #endif
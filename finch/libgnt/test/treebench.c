@@ -0,0 +1,87 @@
+#include "gnt.h"
+#include "gntbindable.h"
+#include "gntbox.h"
+#include "gnttree.h"
+
+#define GROUPS    100
+#define PER_GROUP 1000   /* 100k rows in all */
+#define REPEAT    1000
+
+static gint64
+elapsed(gint64 start)
+{
+	return g_get_monotonic_time() - start;
+}
+
+static gint64
+repeat_action(GntTree *tree, const char *action)
+{
+	gint64 start = g_get_monotonic_time();
+	int i;
+
+	for (i = 0; i < REPEAT; i++)
+		gnt_bindable_perform_action_named(GNT_BINDABLE(tree), action, NULL);
+	return elapsed(start);
+}
+
+int main()
+{
+	GntWidget *win, *tree;
+	gint64 start, populate, pagedown, pageup, last, select;
+	int g, i;
+
+#ifdef STANDALONE
+	freopen(".error", "w", stderr);
+	gnt_init();
+#endif
+
+	win = gnt_box_new(FALSE, TRUE);
+	gnt_box_set_toplevel(GNT_BOX(win), TRUE);
+	gnt_box_set_title(GNT_BOX(win), "Tree benchmark");
+
+	tree = gnt_tree_new();
+	gnt_tree_set_hash_fns(GNT_TREE(tree), g_str_hash, g_str_equal, g_free);
+	gnt_tree_set_compare_func(GNT_TREE(tree), (GCompareFunc)g_utf8_collate);
+	gnt_widget_set_size(tree, 40, 30);
+	gnt_box_add_widget(GNT_BOX(win), tree);
+	gnt_widget_show(win);
+
+	start = g_get_monotonic_time();
+	for (g = 0; g < GROUPS; g++) {
+		char *group = g_strdup_printf("group %03d", g);
+		gnt_tree_add_row_after(GNT_TREE(tree), group,
+				gnt_tree_create_row(GNT_TREE(tree), group), NULL, NULL);
+		for (i = 0; i < PER_GROUP; i++) {
+			/* Keys in an order that needs the sorted insert to work for it */
+			char *key = g_strdup_printf("%s/buddy %05d", group, (i * 7919) % PER_GROUP);
+			gnt_tree_add_row_after(GNT_TREE(tree), key,
+					gnt_tree_create_row(GNT_TREE(tree), key), group, NULL);
+		}
+	}
+	populate = elapsed(start);
+
+	pagedown = repeat_action(GNT_TREE(tree), "page-down");
+	pageup = repeat_action(GNT_TREE(tree), "page-up");
+	last = repeat_action(GNT_TREE(tree), "move-last");
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < REPEAT; i++) {
+		char *key = g_strdup_printf("group %03d/buddy %05d",
+				(i * 31) % GROUPS, (i * 17) % PER_GROUP);
+		gnt_tree_set_selected(GNT_TREE(tree), key);
+		g_free(key);
+	}
+	select = elapsed(start);
+
+#ifdef STANDALONE
+	gnt_quit();
+#endif
+
+	printf("populate %d rows: %" G_GINT64_FORMAT " us\n", GROUPS * (PER_GROUP + 1), populate);
+	printf("%d x page-down: %" G_GINT64_FORMAT " us\n", REPEAT, pagedown);
+	printf("%d x page-up: %" G_GINT64_FORMAT " us\n", REPEAT, pageup);
+	printf("%d x move-last: %" G_GINT64_FORMAT " us\n", REPEAT, last);
+	printf("%d x set-selected: %" G_GINT64_FORMAT " us\n", REPEAT, select);
+
+	return 0;
+}
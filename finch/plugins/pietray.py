@@ -191,6 +191,10 @@ bus.add_signal_receiver(savedstatus_changed,
   dbus_interface="im.pidgin.purple.PurpleInterface",
   signal_name="SavedstatusChanged")
 
+# Purple only puts the signals somebody subscribed to on the bus.
+purple.PurpleDbusSubscribeSignal("ConversationUpdated")
+purple.PurpleDbusSubscribeSignal("SavedstatusChanged")
+
 t = gtk.StatusIcon()
 t.connect("popup-menu", popup_menu, None)
 
@@ -26,6 +26,41 @@
 #include "enums.h"
 #include "network.h"
 #include "pounce.h"
+#include "prefs.h"
+
+/* How many accounts may be signing on at once by default */
+#define MAX_CONCURRENT_SIGNONS 4
+
+/* Milliseconds between starting one queued sign-on and the next */
+#define SIGNON_STAGGER 250
+
+/*
+ * Seconds after which a sign-on that hasn't finished stops counting
+ * against the limit, so an account waiting on a password prompt or a
+ * dead server doesn't hold up the rest.
+ */
+#define SIGNON_TIMEOUT 30
+
+#define INITIAL_RECON_DELAY_MIN  8000
+#define INITIAL_RECON_DELAY_MAX 60000
+#define MAX_RECON_DELAY 600000
+
+typedef struct
+{
+	PurpleAccount *account;
+	gint64 queued;          /* When the sign-on was requested. */
+	gint64 started;         /* When we called purple_account_connect(),
+	                           or 0 while still queued. */
+	gboolean holds_slot;    /* Counted in signons_active. */
+	guint timeout;
+
+} PurpleAccountSignon;
+
+typedef struct
+{
+	gint64 total;           /* From being queued to being signed on. */
+	gint64 queued;          /* Spent waiting in the queue. */
+} PurpleAccountSignonTime;
 
 static PurpleAccountUiOps *account_ui_ops = NULL;
 
@@ -33,6 +68,12 @@ static GList   *accounts = NULL;
 static guint    save_timer = 0;
 static gboolean accounts_loaded = FALSE;
 
+static GHashTable *signons = NULL;       /* account -> PurpleAccountSignon */
+static GList      *signon_queue = NULL;  /* Not started yet, in order. */
+static guint       signons_active = 0;
+static guint       signon_timer = 0;
+static GHashTable *signon_times = NULL;  /* account -> PurpleAccountSignonTime */
+
 /*********************************************************************
  * Writing to disk                                                   *
  *********************************************************************/
@@ -781,9 +822,229 @@ purple_accounts_restore_current_statuses()
 		if (purple_account_get_enabled(account, purple_core_get_ui()) &&
 			(purple_presence_is_online(purple_account_get_presence(account))))
 		{
-			purple_account_connect(account);
+			purple_accounts_schedule_connect(account);
+		}
+	}
+}
+
+/*********************************************************************
+ * Sign-on scheduling                                                *
+ *********************************************************************/
+
+static void signon_queue_schedule(guint delay);
+
+static void
+free_signon(gpointer data)
+{
+	PurpleAccountSignon *signon = data;
+
+	if (signon->timeout != 0)
+		purple_timeout_remove(signon->timeout);
+
+	g_free(signon);
+}
+
+static void
+signon_release_slot(PurpleAccountSignon *signon)
+{
+	if (!signon->holds_slot)
+		return;
+
+	signon->holds_slot = FALSE;
+	signons_active--;
+
+	if (signon->timeout != 0)
+	{
+		purple_timeout_remove(signon->timeout);
+		signon->timeout = 0;
+	}
+
+	if (signon_queue != NULL)
+		signon_queue_schedule(0);
+}
+
+static void signon_finish(PurpleAccount *account, gboolean signed_on);
+
+static gboolean
+signon_timeout_cb(gpointer data)
+{
+	PurpleAccountSignon *signon = data;
+	PurpleAccount *account = signon->account;
+
+	signon->timeout = 0;
+
+	purple_debug_warning("accounts", "%s is taking more than %d seconds to "
+			"sign on; letting other accounts go ahead\n",
+			purple_account_get_username(account), SIGNON_TIMEOUT);
+
+	/* purple_account_connect() can give up without ever creating a
+	 * connection, for example when the protocol is missing, and then none
+	 * of the signals that end a sign-on will come.  Forget about it so the
+	 * account can be queued again. */
+	if (purple_account_get_connection(account) == NULL)
+		signon_finish(account, FALSE);
+	else
+		signon_release_slot(signon);
+
+	return FALSE;
+}
+
+/*
+ * Forget about a sign-on, because the account connected, failed to, or
+ * went away.
+ */
+static void
+signon_finish(PurpleAccount *account, gboolean signed_on)
+{
+	PurpleAccountSignon *signon;
+
+	if (signons == NULL)
+		return;
+
+	signon = g_hash_table_lookup(signons, account);
+	if (signon == NULL)
+		return;
+
+	if (signed_on && signon->started != 0)
+	{
+		PurpleAccountSignonTime *elapsed = g_new(PurpleAccountSignonTime, 1);
+
+		elapsed->total = g_get_monotonic_time() - signon->queued;
+		elapsed->queued = signon->started - signon->queued;
+		g_hash_table_replace(signon_times, account, elapsed);
+
+		purple_debug_info("accounts", "%s (%s) signed on in %.2f seconds "
+				"(%.2f seconds queued)\n",
+				purple_account_get_username(account),
+				purple_account_get_protocol_id(account),
+				elapsed->total / (double)G_USEC_PER_SEC,
+				elapsed->queued / (double)G_USEC_PER_SEC);
+	}
+
+	if (signon->started == 0)
+		signon_queue = g_list_remove(signon_queue, signon);
+
+	signon_release_slot(signon);
+	g_hash_table_remove(signons, account);
+}
+
+static gboolean
+signon_queue_run(gpointer data)
+{
+	int max = purple_prefs_get_int("/purple/accounts/max_concurrent_signons");
+
+	signon_timer = 0;
+
+	while (signon_queue != NULL && (max <= 0 || signons_active < (guint)max))
+	{
+		PurpleAccountSignon *signon = signon_queue->data;
+		PurpleAccount *account = signon->account;
+
+		signon_queue = g_list_delete_link(signon_queue, signon_queue);
+
+		if (!purple_account_get_enabled(account, purple_core_get_ui()) ||
+			!purple_account_is_disconnected(account) ||
+			!purple_presence_is_online(purple_account_get_presence(account)))
+		{
+			g_hash_table_remove(signons, account);
+			continue;
+		}
+
+		signon->started = g_get_monotonic_time();
+		signon->holds_slot = TRUE;
+		signons_active++;
+		signon->timeout = purple_timeout_add_seconds(SIGNON_TIMEOUT,
+				signon_timeout_cb, signon);
+
+		/* This may fail right away and free signon. */
+		purple_account_connect(account);
+
+		/* Give this sign-on a head start on the next one. */
+		if (signon_queue != NULL)
+		{
+			signon_queue_schedule(SIGNON_STAGGER);
+			break;
 		}
 	}
+
+	return FALSE;
+}
+
+static void
+signon_queue_schedule(guint delay)
+{
+	if (signon_timer != 0)
+		return;
+
+	signon_timer = purple_timeout_add(delay, signon_queue_run, NULL);
+}
+
+void
+purple_accounts_schedule_connect(PurpleAccount *account)
+{
+	PurpleAccountSignon *signon;
+	GList *l;
+	int priority;
+
+	g_return_if_fail(PURPLE_IS_ACCOUNT(account));
+
+	if (g_hash_table_lookup(signons, account) != NULL)
+		return;
+
+	signon = g_new0(PurpleAccountSignon, 1);
+	signon->account = account;
+	signon->queued = g_get_monotonic_time();
+	g_hash_table_insert(signons, account, signon);
+
+	/* Keep the queue in priority order, first come first served. */
+	priority = purple_account_get_int(account, "signon-priority", 0);
+	for (l = signon_queue; l != NULL; l = l->next)
+	{
+		PurpleAccountSignon *queued = l->data;
+
+		if (purple_account_get_int(queued->account, "signon-priority", 0) < priority)
+			break;
+	}
+	signon_queue = g_list_insert_before(signon_queue, l, signon);
+
+	signon_queue_schedule(0);
+}
+
+gboolean
+purple_accounts_get_signon_time(PurpleAccount *account, gint64 *total,
+                                gint64 *queued)
+{
+	PurpleAccountSignonTime *elapsed;
+
+	g_return_val_if_fail(PURPLE_IS_ACCOUNT(account), FALSE);
+
+	elapsed = g_hash_table_lookup(signon_times, account);
+	if (elapsed == NULL)
+		return FALSE;
+
+	if (total != NULL)
+		*total = elapsed->total;
+	if (queued != NULL)
+		*queued = elapsed->queued;
+
+	return TRUE;
+}
+
+guint
+purple_accounts_get_reconnect_delay(guint previous)
+{
+	guint cap;
+
+	if (previous == 0)
+		return g_random_int_range(INITIAL_RECON_DELAY_MIN, INITIAL_RECON_DELAY_MAX);
+
+	/*
+	 * Double the delay, but pick somewhere in the upper half of it at
+	 * random so accounts that dropped together drift apart.
+	 */
+	cap = MIN((guint64)previous * 2, MAX_RECON_DELAY);
+
+	return g_random_int_range(cap / 2, cap + 1);
 }
 
 static PurpleAccountUiOps *
@@ -840,6 +1101,8 @@ signed_on_cb(PurpleConnection *gc,
 	PurpleAccount *account = purple_connection_get_account(gc);
 	purple_account_clear_current_error(account);
 
+	signon_finish(account, TRUE);
+
 	purple_signal_emit(purple_accounts_get_handle(), "account-signed-on",
 	                   account);
 }
@@ -850,6 +1113,8 @@ signed_off_cb(PurpleConnection *gc,
 {
 	PurpleAccount *account = purple_connection_get_account(gc);
 
+	signon_finish(account, FALSE);
+
 	purple_signal_emit(purple_accounts_get_handle(), "account-signed-off",
 	                   account);
 }
@@ -875,10 +1140,25 @@ connection_error_cb(PurpleConnection *gc,
 
 	_purple_account_set_current_error(account, err);
 
+	signon_finish(account, FALSE);
+
 	purple_signal_emit(purple_accounts_get_handle(), "account-connection-error",
 	                   account, type, description);
 }
 
+static void
+account_gone_cb(PurpleAccount *account, gpointer unused)
+{
+	signon_finish(account, FALSE);
+}
+
+static void
+account_destroying_cb(PurpleAccount *account, gpointer unused)
+{
+	signon_finish(account, FALSE);
+	g_hash_table_remove(signon_times, account);
+}
+
 static void
 password_migration_cb(PurpleAccount *account)
 {
@@ -893,6 +1173,15 @@ purple_accounts_init(void)
 	void *handle = purple_accounts_get_handle();
 	void *conn_handle = purple_connections_get_handle();
 
+	purple_prefs_add_none("/purple/accounts");
+	purple_prefs_add_int("/purple/accounts/max_concurrent_signons",
+	                     MAX_CONCURRENT_SIGNONS);
+
+	signons = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+	                                NULL, free_signon);
+	signon_times = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+	                                     NULL, g_free);
+
 	purple_signal_register(handle, "account-connecting",
 						 purple_marshal_VOID__POINTER, G_TYPE_NONE, 1,
 						 PURPLE_TYPE_ACCOUNT);
@@ -987,6 +1276,10 @@ purple_accounts_init(void)
 	                      PURPLE_CALLBACK(connection_error_cb), NULL);
 	purple_signal_connect(purple_keyring_get_handle(), "password-migration", handle,
 	                      PURPLE_CALLBACK(password_migration_cb), NULL);
+	purple_signal_connect(handle, "account-disabled", handle,
+	                      PURPLE_CALLBACK(account_gone_cb), NULL);
+	purple_signal_connect(handle, "account-destroying", handle,
+	                      PURPLE_CALLBACK(account_destroying_cb), NULL);
 
 	load_accounts();
 
@@ -1003,6 +1296,19 @@ purple_accounts_uninit(void)
 		sync_accounts();
 	}
 
+	if (signon_timer != 0)
+	{
+		purple_timeout_remove(signon_timer);
+		signon_timer = 0;
+	}
+	g_list_free(signon_queue);
+	signon_queue = NULL;
+	g_hash_table_destroy(signons);
+	signons = NULL;
+	signons_active = 0;
+	g_hash_table_destroy(signon_times);
+	signon_times = NULL;
+
 	for (; accounts; accounts = g_list_delete_link(accounts, accounts))
 		g_object_unref(G_OBJECT(accounts->data));
 
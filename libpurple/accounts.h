@@ -185,6 +185,53 @@ PurpleAccount *purple_accounts_find(const char *name, const char *protocol);
  */
 void purple_accounts_restore_current_statuses(void);
 
+/**
+ * purple_accounts_schedule_connect:
+ * @account: The account to connect.
+ *
+ * Queues an account to be connected.  Rather than connecting every account
+ * at once, which floods the network with DNS lookups and TLS handshakes and
+ * can trip servers' connection rate limits, accounts are signed on a few at
+ * a time.  The number of sign-ons in progress at once is set by the
+ * <literal>/purple/accounts/max_concurrent_signons</literal> preference
+ * (0 means no limit).  Accounts with a higher
+ * <literal>signon-priority</literal> integer setting are connected first.
+ *
+ * The account is skipped if, by the time its turn comes, it has been
+ * disabled, set to an offline status or connected some other way.
+ */
+void purple_accounts_schedule_connect(PurpleAccount *account);
+
+/**
+ * purple_accounts_get_signon_time:
+ * @account: The account.
+ * @total:   (out) (optional): Return location for the time, in microseconds,
+ *           from when the account was queued by
+ *           purple_accounts_schedule_connect() until it signed on, or %NULL.
+ * @queued:  (out) (optional): Return location for how much of that time, in
+ *           microseconds, it spent waiting in the queue, or %NULL.
+ *
+ * Gets how long the last queued sign-on of an account took.
+ *
+ * Returns: %TRUE if the account has signed on through the queue, otherwise
+ *          %FALSE and the return locations are left alone.
+ */
+gboolean purple_accounts_get_signon_time(PurpleAccount *account,
+                                         gint64 *total, gint64 *queued);
+
+/**
+ * purple_accounts_get_reconnect_delay:
+ * @previous: The previous delay, in milliseconds, or 0 for the first attempt.
+ *
+ * Picks how long to wait before automatically reconnecting an account that
+ * was disconnected by a non-fatal error.  The delay roughly doubles with
+ * every attempt, up to ten minutes, and is randomized so that accounts
+ * which were disconnected together don't all reconnect at the same moment.
+ *
+ * Returns: The delay in milliseconds.
+ */
+guint purple_accounts_get_reconnect_delay(guint previous);
+
 
 /**************************************************************************/
 /* UI Registration Functions                                              */
@@ -383,6 +383,9 @@ purple_blist_node_init(GTypeInstance *instance, gpointer klass)
 
 	priv->settings = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
 			(GDestroyNotify)purple_value_free);
+
+	PURPLE_MEMSTAT_ALLOC(PURPLE_MEMSTAT_BLIST_NODES,
+			_purple_memstat_type_size(G_TYPE_FROM_CLASS(klass)));
 }
 
 /* GObject finalize function */
@@ -393,6 +396,9 @@ purple_blist_node_finalize(GObject *object)
 
 	g_hash_table_destroy(priv->settings);
 
+	PURPLE_MEMSTAT_FREE(PURPLE_MEMSTAT_BLIST_NODES,
+			_purple_memstat_type_size(G_OBJECT_TYPE(object)));
+
 	parent_class->finalize(object);
 }
 
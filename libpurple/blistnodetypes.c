@@ -451,6 +451,9 @@ purple_buddy_update_status(PurpleBuddy *buddy, PurpleStatus *old_status)
 
 	g_return_if_fail(priv != NULL);
 
+	if (_purple_statuses_coalesce_buddy_status(buddy, old_status))
+		return;
+
 	status = purple_presence_get_active_status(priv->presence);
 
 	purple_debug_info("blistnodetypes", "Updating buddy status for %s (%s)\n",
@@ -648,6 +651,8 @@ purple_buddy_dispose(GObject *object)
 {
 	PurpleBuddyPrivate *priv = PURPLE_BUDDY_GET_PRIVATE(object);
 
+	_purple_statuses_forget_buddy(PURPLE_BUDDY(object));
+
 	if (priv->icon) {
 		purple_buddy_icon_unref(priv->icon);
 		priv->icon = NULL;
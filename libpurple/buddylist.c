@@ -977,6 +977,9 @@ void purple_blist_add_buddy(PurpleBuddy *buddy, PurpleContact *contact, PurpleGr
 
 	cnode = PURPLE_BLIST_NODE(c);
 
+	/* The counts below assume the buddy list has seen every change. */
+	_purple_statuses_flush_buddy(buddy);
+
 	if (bnode->parent) {
 		contact_counter = PURPLE_COUNTING_NODE(bnode->parent);
 		group_counter = PURPLE_COUNTING_NODE(bnode->parent->parent);
@@ -1371,6 +1374,9 @@ void purple_blist_remove_buddy(PurpleBuddy *buddy)
 
 	g_return_if_fail(PURPLE_IS_BUDDY(buddy));
 
+	/* The counts below assume the buddy list has seen every change. */
+	_purple_statuses_flush_buddy(buddy);
+
 	account = purple_buddy_get_account(buddy);
 	node = PURPLE_BLIST_NODE(buddy);
 	cnode = node->parent;
@@ -1775,6 +1781,9 @@ void purple_blist_remove_account(PurpleAccount *account)
 
 	g_return_if_fail(PURPLE_IS_BUDDY_LIST(purplebuddylist));
 
+	/* The counts below assume the buddy list has seen every change. */
+	_purple_statuses_flush_account(account);
+
 	for (gnode = purplebuddylist->root; gnode; gnode = gnode->next) {
 		if (!PURPLE_IS_GROUP(gnode))
 			continue;
@@ -94,6 +94,12 @@ purple_circular_buffer_real_grow(PurpleCircularBuffer *buffer, gsize len) {
 
 	priv->buffer = g_realloc(priv->buffer, priv->buflen);
 
+	if (start_buflen == 0)
+		PURPLE_MEMSTAT_ALLOC(PURPLE_MEMSTAT_CIRCULAR_BUFFERS, priv->buflen);
+	else
+		PURPLE_MEMSTAT_RESIZE(PURPLE_MEMSTAT_CIRCULAR_BUFFERS,
+				priv->buflen - start_buflen);
+
 	/* adjust the fill and remove pointer locations */
 	if(priv->input == NULL) {
 		priv->input = priv->output = priv->buffer;
@@ -246,6 +252,8 @@ purple_circular_buffer_finalize(GObject *obj) {
 	PurpleCircularBufferPrivate *priv =
 			PURPLE_CIRCULAR_BUFFER_GET_PRIVATE(obj);
 
+	if (priv->buflen > 0)
+		PURPLE_MEMSTAT_FREE(PURPLE_MEMSTAT_CIRCULAR_BUFFERS, priv->buflen);
 	g_free(priv->buffer);
 
 	G_OBJECT_CLASS(parent_class)->finalize(obj);
@@ -57,6 +57,9 @@ struct _PurpleConversationPrivate
 
 	PurpleConnectionFlags features;   /* The supported features            */
 	GList *message_history; /* Message history, as a GList of PurpleMessages */
+#ifdef ENABLE_MEMSTAT
+	gsize message_history_size; /* Bytes accounted for message_history */
+#endif
 
 	PurpleE2eeState *e2ee_state;      /* End-to-end encryption state.      */
 
@@ -217,6 +220,18 @@ add_message_to_history(PurpleConversation *conv, PurpleMessage *msg)
 
 	g_object_ref(msg);
 	priv->message_history = g_list_prepend(priv->message_history, msg);
+
+#ifdef ENABLE_MEMSTAT
+	{
+		/* Contents are what grows; the rest is roughly fixed. */
+		const gchar *contents = purple_message_get_contents(msg);
+		gsize size = _purple_memstat_type_size(G_OBJECT_TYPE(msg)) +
+				sizeof(GList) + (contents ? strlen(contents) + 1 : 0);
+
+		priv->message_history_size += size;
+		PURPLE_MEMSTAT_ALLOC(PURPLE_MEMSTAT_MESSAGE_HISTORY, size);
+	}
+#endif
 }
 
 /**************************************************************************
@@ -781,6 +796,12 @@ void purple_conversation_clear_message_history(PurpleConversation *conv)
 	g_return_if_fail(priv != NULL);
 
 	list = priv->message_history;
+#ifdef ENABLE_MEMSTAT
+	PURPLE_MEMSTAT_ADD(PURPLE_MEMSTAT_MESSAGE_HISTORY,
+			-(gssize)g_list_length(list),
+			-(gssize)priv->message_history_size);
+	priv->message_history_size = 0;
+#endif
 	g_list_free_full(list, g_object_unref);
 	priv->message_history = NULL;
 
@@ -988,6 +1009,9 @@ purple_conversation_constructed(GObject *object)
 	/* add the conversation to the appropriate lists */
 	purple_conversations_add(conv);
 
+	PURPLE_MEMSTAT_ALLOC(PURPLE_MEMSTAT_CONVERSATIONS,
+			_purple_memstat_type_size(G_OBJECT_TYPE(object)));
+
 	/* Auto-set the title. */
 	purple_conversation_autoset_title(conv);
 
@@ -1043,6 +1067,9 @@ purple_conversation_finalize(GObject *object)
 	priv->name = NULL;
 	priv->title = NULL;
 
+	PURPLE_MEMSTAT_FREE(PURPLE_MEMSTAT_CONVERSATIONS,
+			_purple_memstat_type_size(G_OBJECT_TYPE(object)));
+
 	parent_class->finalize(object);
 }
 
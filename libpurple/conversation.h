@@ -245,6 +245,10 @@ struct _PurpleConversationClass {
  *                function should arrange for the message to be sent if the user
  *                accepts. If this field is %NULL, libpurple will fall back to
  *                using purple_request_action().
+ * @chat_update_users: Apply a batch of changes to the users of a chat in one
+ *                     go. If this field is %NULL, libpurple will fall back to
+ *                     the other chat_* functions.
+ *                     See purple_chat_conversation_begin_batch().
  *
  * Conversation operations and events.
  *
@@ -276,11 +280,13 @@ struct _PurpleConversationUiOps
 
 	void (*send_confirm)(PurpleConversation *conv, const char *message);
 
+	void (*chat_update_users)(PurpleChatConversation *chat,
+	                          const PurpleChatUsersDelta *delta);
+
 	/*< private >*/
 	void (*_purple_reserved1)(void);
 	void (*_purple_reserved2)(void);
 	void (*_purple_reserved3)(void);
-	void (*_purple_reserved4)(void);
 };
 
 G_BEGIN_DECLS
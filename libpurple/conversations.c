@@ -404,6 +404,11 @@ purple_conversations_init(void)
 						 G_TYPE_NONE, 3, PURPLE_TYPE_CHAT_CONVERSATION,
 						 G_TYPE_STRING, G_TYPE_STRING);
 
+	purple_signal_register(handle, "chat-users-changed",
+						 purple_marshal_VOID__POINTER_POINTER, G_TYPE_NONE, 2,
+						 PURPLE_TYPE_CHAT_CONVERSATION,
+						 G_TYPE_POINTER); /* (PurpleChatUsersDelta *) */
+
 	purple_signal_register(handle, "deleting-chat-user",
 						 purple_marshal_VOID__POINTER, G_TYPE_NONE, 1,
 						 PURPLE_TYPE_CHAT_USER);
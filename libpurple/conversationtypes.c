@@ -43,6 +43,18 @@ typedef struct _PurpleIMConversationPrivate       PurpleIMConversationPrivate;
 
 typedef struct _PurpleChatUserPrivate  PurpleChatUserPrivate;
 
+/*
+ * Changes to the users of a chat that the UI hasn't been told about yet.
+ */
+typedef struct
+{
+	int depth;            /* How many batches are open.                  */
+	GHashTable *added;    /* Users the UI hasn't seen -> new_arrivals.   */
+	GList *removed;       /* Users the UI should forget, oldest first.   */
+	GList *renamed;       /* PurpleChatUserRename's, oldest first.       */
+	GHashTable *updated;  /* Users the UI knows whose flags changed.     */
+} PurpleChatUsersBatch;
+
 /*
  * Data specific to Chats.
  */
@@ -55,6 +67,7 @@ struct _PurpleChatConversationPrivate
 	char *nick;         /* Your nick in this chat.                   */
 	gboolean left;      /* We left the chat and kept the window open */
 	GHashTable *users;  /* Hash table of the users in the room.      */
+	PurpleChatUsersBatch *batch; /* Changes not given to the UI yet. */
 };
 
 /* Chat Property enums */
@@ -602,6 +615,262 @@ _purple_conversation_user_equal(gconstpointer a, gconstpointer b)
 	return !g_utf8_collate(a, b);
 }
 
+static void
+chat_user_rename_free(PurpleChatUserRename *rename)
+{
+	g_free(rename->old_name);
+	g_free(rename->new_name);
+	g_free(rename->new_alias);
+	g_free(rename);
+}
+
+static void
+chat_users_batch_reset(PurpleChatUsersBatch *batch)
+{
+	g_hash_table_remove_all(batch->added);
+	g_hash_table_remove_all(batch->updated);
+	g_list_free_full(batch->removed, g_free);
+	batch->removed = NULL;
+	g_list_free_full(batch->renamed, (GDestroyNotify)chat_user_rename_free);
+	batch->renamed = NULL;
+}
+
+static void
+chat_users_batch_free(PurpleChatUsersBatch *batch)
+{
+	if (batch == NULL)
+		return;
+
+	chat_users_batch_reset(batch);
+	g_hash_table_destroy(batch->added);
+	g_hash_table_destroy(batch->updated);
+	g_free(batch);
+}
+
+/*
+ * Finds the rename that gave a user their name, which is the last one to
+ * that name before @before, or in the whole batch if @before is NULL.
+ */
+static GList *
+chat_users_batch_find_rename_link(PurpleChatUsersBatch *batch,
+		const char *new_name, GList *before)
+{
+	GList *l, *found = NULL;
+
+	for (l = batch->renamed; l != NULL && l != before; l = l->next) {
+		PurpleChatUserRename *rename = l->data;
+		if (_purple_conversation_user_equal(rename->new_name, new_name))
+			found = l;
+	}
+
+	return found;
+}
+
+static PurpleChatUserRename *
+chat_users_batch_find_rename(PurpleChatUsersBatch *batch, const char *new_name)
+{
+	GList *l = chat_users_batch_find_rename_link(batch, new_name, NULL);
+
+	return l ? l->data : NULL;
+}
+
+static void
+chat_users_batch_add(PurpleChatUsersBatch *batch, const char *user,
+		gboolean new_arrival)
+{
+	g_hash_table_replace(batch->added, g_strdup(user),
+			GINT_TO_POINTER(new_arrival));
+	g_hash_table_remove(batch->updated, user);
+}
+
+static void
+chat_users_batch_remove(PurpleChatUsersBatch *batch, const char *user)
+{
+	PurpleChatUserRename *rename;
+	GList *l, *prev;
+
+	g_hash_table_remove(batch->updated, user);
+
+	/* The UI never saw them. */
+	if (g_hash_table_remove(batch->added, user))
+		return;
+
+	/* The UI still knows them by the name they had before their first
+	 * rename, and removals come before renames, so drop all of them. */
+	l = chat_users_batch_find_rename_link(batch, user, NULL);
+	if (l != NULL) {
+		rename = l->data;
+		while ((prev = chat_users_batch_find_rename_link(batch,
+				rename->old_name, l)) != NULL) {
+			batch->renamed = g_list_delete_link(batch->renamed, l);
+			chat_user_rename_free(rename);
+			l = prev;
+			rename = l->data;
+		}
+
+		batch->renamed = g_list_delete_link(batch->renamed, l);
+		batch->removed = g_list_append(batch->removed,
+				g_strdup(rename->old_name));
+		chat_user_rename_free(rename);
+		return;
+	}
+
+	batch->removed = g_list_append(batch->removed, g_strdup(user));
+}
+
+static void
+chat_users_batch_update(PurpleChatUsersBatch *batch, const char *user)
+{
+	/* Users who are added or renamed are shown with their current flags
+	 * anyway. */
+	if (g_hash_table_contains(batch->added, user) ||
+			chat_users_batch_find_rename(batch, user) != NULL)
+		return;
+
+	g_hash_table_add(batch->updated, g_strdup(user));
+}
+
+static void
+chat_users_batch_rename(PurpleChatUsersBatch *batch, const char *old_user,
+		const char *new_user, const char *new_alias)
+{
+	PurpleChatUserRename *rename;
+	gpointer new_arrival;
+	GList *l;
+
+	/* Renaming puts the user back with their current flags. */
+	g_hash_table_remove(batch->updated, old_user);
+
+	if (g_hash_table_lookup_extended(batch->added, old_user, NULL, &new_arrival)) {
+		g_hash_table_remove(batch->added, old_user);
+		g_hash_table_replace(batch->added, g_strdup(new_user), new_arrival);
+		return;
+	}
+
+	/* Renames are applied in order, so one can only be folded into the
+	 * rename that gave the user their old name if nobody was renamed
+	 * since.  Otherwise the name in between may be what lets two users
+	 * swap names, A to T, B to A, then T to B. */
+	l = chat_users_batch_find_rename_link(batch, old_user, NULL);
+	if (l != NULL && l->next == NULL) {
+		rename = l->data;
+	} else {
+		rename = g_new0(PurpleChatUserRename, 1);
+		rename->old_name = g_strdup(old_user);
+		batch->renamed = g_list_append(batch->renamed, rename);
+	}
+
+	g_free(rename->new_name);
+	rename->new_name = g_strdup(new_user);
+	g_free(rename->new_alias);
+	rename->new_alias = g_strdup(new_alias);
+}
+
+/*
+ * Gives everything the batch collected to the UI and the
+ * "chat-users-changed" signal, and empties it.
+ */
+static void
+chat_users_batch_flush(PurpleChatConversation *chat)
+{
+	PurpleChatConversationPrivate *priv = PURPLE_CHAT_CONVERSATION_GET_PRIVATE(chat);
+	PurpleChatUsersBatch *batch = priv->batch;
+	PurpleConversationUiOps *ops;
+	PurpleChatUsersDelta delta = { NULL, NULL, NULL, NULL, NULL };
+	GHashTableIter it;
+	gpointer key, value;
+	GList *l;
+
+	g_hash_table_iter_init(&it, batch->added);
+	while (g_hash_table_iter_next(&it, &key, &value)) {
+		PurpleChatUser *cb = purple_chat_conversation_find_user(chat, key);
+		if (cb == NULL)
+			continue;
+		if (GPOINTER_TO_INT(value))
+			delta.arrived = g_list_prepend(delta.arrived, cb);
+		else
+			delta.added = g_list_prepend(delta.added, cb);
+	}
+	delta.added = g_list_sort(delta.added, (GCompareFunc)purple_chat_user_compare);
+	delta.arrived = g_list_sort(delta.arrived, (GCompareFunc)purple_chat_user_compare);
+
+	g_hash_table_iter_init(&it, batch->updated);
+	while (g_hash_table_iter_next(&it, &key, NULL)) {
+		PurpleChatUser *cb = purple_chat_conversation_find_user(chat, key);
+		if (cb != NULL)
+			delta.updated = g_list_prepend(delta.updated, cb);
+	}
+
+	delta.removed = batch->removed;
+	delta.renamed = batch->renamed;
+
+	if (delta.removed || delta.renamed || delta.added || delta.arrived ||
+			delta.updated) {
+		ops = purple_conversation_get_ui_ops(PURPLE_CONVERSATION(chat));
+
+		if (ops != NULL && ops->chat_update_users != NULL) {
+			ops->chat_update_users(chat, &delta);
+		} else if (ops != NULL) {
+			if (delta.removed && ops->chat_remove_users)
+				ops->chat_remove_users(chat, delta.removed);
+			for (l = delta.renamed; l && ops->chat_rename_user; l = l->next) {
+				PurpleChatUserRename *rename = l->data;
+				ops->chat_rename_user(chat, rename->old_name,
+						rename->new_name, rename->new_alias);
+			}
+			if (delta.added && ops->chat_add_users)
+				ops->chat_add_users(chat, delta.added, FALSE);
+			if (delta.arrived && ops->chat_add_users)
+				ops->chat_add_users(chat, delta.arrived, TRUE);
+			for (l = delta.updated; l && ops->chat_update_user; l = l->next)
+				ops->chat_update_user(l->data);
+		}
+
+		purple_signal_emit(purple_conversations_get_handle(),
+				"chat-users-changed", chat, &delta);
+	}
+
+	g_list_free(delta.added);
+	g_list_free(delta.arrived);
+	g_list_free(delta.updated);
+	chat_users_batch_reset(batch);
+}
+
+void
+purple_chat_conversation_begin_batch(PurpleChatConversation *chat)
+{
+	PurpleChatConversationPrivate *priv = PURPLE_CHAT_CONVERSATION_GET_PRIVATE(chat);
+
+	g_return_if_fail(priv != NULL);
+
+	if (priv->batch == NULL) {
+		priv->batch = g_new0(PurpleChatUsersBatch, 1);
+		priv->batch->added = g_hash_table_new_full(_purple_conversation_user_hash,
+				_purple_conversation_user_equal, g_free, NULL);
+		priv->batch->updated = g_hash_table_new_full(_purple_conversation_user_hash,
+				_purple_conversation_user_equal, g_free, NULL);
+	}
+
+	priv->batch->depth++;
+}
+
+void
+purple_chat_conversation_commit_batch(PurpleChatConversation *chat)
+{
+	PurpleChatConversationPrivate *priv = PURPLE_CHAT_CONVERSATION_GET_PRIVATE(chat);
+
+	g_return_if_fail(priv != NULL);
+	g_return_if_fail(priv->batch != NULL);
+
+	if (--priv->batch->depth > 0)
+		return;
+
+	chat_users_batch_flush(chat);
+
+	chat_users_batch_free(priv->batch);
+	priv->batch = NULL;
+}
+
 GList *
 purple_chat_conversation_get_users(const PurpleChatConversation *chat)
 {
@@ -906,7 +1175,10 @@ purple_chat_conversation_add_users(PurpleChatConversation *chat, GList *users, G
 			g_strdup(purple_chat_user_get_name(chatuser)),
 			chatuser);
 
-		cbuddies = g_list_prepend(cbuddies, chatuser);
+		if (priv->batch != NULL)
+			chat_users_batch_add(priv->batch, user, new_arrivals);
+		else
+			cbuddies = g_list_prepend(cbuddies, chatuser);
 
 		if (!quiet && new_arrivals) {
 			char *alias_esc = g_markup_escape_text(alias, -1);
@@ -935,6 +1207,9 @@ purple_chat_conversation_add_users(PurpleChatConversation *chat, GList *users, G
 			extra_msgs = extra_msgs->next;
 	}
 
+	if (cbuddies == NULL)
+		return;
+
 	cbuddies = g_list_sort(cbuddies, (GCompareFunc)purple_chat_user_compare);
 
 	if (ops != NULL && ops->chat_add_users != NULL)
@@ -1003,7 +1278,9 @@ purple_chat_conversation_rename_user(PurpleChatConversation *chat, const char *o
 	g_hash_table_replace(priv->users,
 		g_strdup(purple_chat_user_get_name(cb)), cb);
 
-	if (ops != NULL && ops->chat_rename_user != NULL)
+	if (priv->batch != NULL)
+		chat_users_batch_rename(priv->batch, old_user, new_user, new_alias);
+	else if (ops != NULL && ops->chat_rename_user != NULL)
 		ops->chat_rename_user(chat, old_user, new_user, new_alias);
 
 	cb = purple_chat_conversation_find_user(chat, old_user);
@@ -1106,6 +1383,9 @@ purple_chat_conversation_remove_users(PurpleChatConversation *chat, GList *users
 				purple_chat_user_get_name(cb));
 		}
 
+		if (priv->batch != NULL)
+			chat_users_batch_remove(priv->batch, user);
+
 		/* NOTE: Don't remove them from ignored in case they re-enter. */
 
 		if (!quiet) {
@@ -1141,7 +1421,7 @@ purple_chat_conversation_remove_users(PurpleChatConversation *chat, GList *users
 						 conv, user, reason);
 	}
 
-	if (ops != NULL && ops->chat_remove_users != NULL)
+	if (priv->batch == NULL && ops != NULL && ops->chat_remove_users != NULL)
 		ops->chat_remove_users(chat, users);
 }
 
@@ -1155,6 +1435,10 @@ purple_chat_conversation_clear_users(PurpleChatConversation *chat)
 
 	g_return_if_fail(priv != NULL);
 
+	/* Bring the UI up to date first, so it can forget everyone. */
+	if (priv->batch != NULL)
+		chat_users_batch_flush(chat);
+
 	ops = purple_conversation_get_ui_ops(PURPLE_CONVERSATION(chat));
 
 	if (ops != NULL && ops->chat_remove_users != NULL) {
@@ -1438,6 +1722,9 @@ purple_chat_conversation_dispose(GObject *object)
 	PurpleChatConversationPrivate *priv =
 			PURPLE_CHAT_CONVERSATION_GET_PRIVATE(object);
 
+	chat_users_batch_free(priv->batch);
+	priv->batch = NULL;
+
 	g_hash_table_remove_all(priv->users);
 
 	G_OBJECT_CLASS(parent_class)->dispose(object);
@@ -1710,6 +1997,7 @@ purple_chat_user_set_flags(PurpleChatUser *cb,
 	PurpleConversationUiOps *ops;
 	PurpleChatUserFlags oldflags;
 	PurpleChatUserPrivate *priv;
+	PurpleChatConversationPrivate *chat_priv;
 	priv = PURPLE_CHAT_USER_GET_PRIVATE(cb);
 
 	g_return_if_fail(priv != NULL);
@@ -1722,9 +2010,12 @@ purple_chat_user_set_flags(PurpleChatUser *cb,
 
 	g_object_notify_by_pspec(G_OBJECT(cb), cu_properties[CU_PROP_FLAGS]);
 
+	chat_priv = PURPLE_CHAT_CONVERSATION_GET_PRIVATE(priv->chat);
 	ops = purple_conversation_get_ui_ops(PURPLE_CONVERSATION(priv->chat));
 
-	if (ops != NULL && ops->chat_update_user != NULL)
+	if (chat_priv->batch != NULL)
+		chat_users_batch_update(chat_priv->batch, priv->name);
+	else if (ops != NULL && ops->chat_update_user != NULL)
 		ops->chat_update_user(cb);
 
 	purple_signal_emit(purple_conversations_get_handle(),
@@ -62,6 +62,9 @@ typedef struct _PurpleChatConversationClass  PurpleChatConversationClass;
 typedef struct _PurpleChatUser       PurpleChatUser;
 typedef struct _PurpleChatUserClass  PurpleChatUserClass;
 
+typedef struct _PurpleChatUserRename PurpleChatUserRename;
+typedef struct _PurpleChatUsersDelta PurpleChatUsersDelta;
+
 /**
  * PurpleIMTypingState:
  * @PURPLE_IM_NOT_TYPING: Not typing.
@@ -193,6 +196,51 @@ struct _PurpleChatUserClass {
 	void (*_purple_reserved4)(void);
 };
 
+/**
+ * PurpleChatUserRename:
+ * @old_name:  The name the user had.
+ * @new_name:  The name the user has now.
+ * @new_alias: The user's new alias.
+ *
+ * A user in a chat who changed their name during a batch.
+ */
+struct _PurpleChatUserRename
+{
+	char *old_name;
+	char *new_name;
+	char *new_alias;
+};
+
+/**
+ * PurpleChatUsersDelta:
+ * @removed: (element-type char*): The names of the users who left.
+ * @renamed: (element-type PurpleChatUserRename): The users who changed their
+ *           names, in the order they did.
+ * @added:   (element-type PurpleChatUser): The users who were already in the
+ *           room, sorted.
+ * @arrived: (element-type PurpleChatUser): The users who just joined the
+ *           room, sorted.
+ * @updated: (element-type PurpleChatUser): The users whose flags changed.
+ *
+ * The changes to the users of a chat made during a batch.  See
+ * purple_chat_conversation_begin_batch().
+ *
+ * The changes are already collapsed: a user who joined and left during the
+ * batch isn't mentioned at all, a user who joined and was then renamed is
+ * only added under the new name, and so on.  Applying @removed, @renamed,
+ * @added, @arrived and @updated in that order brings a user list up to date.
+ * The renames have to be applied one after another, as a user may be renamed
+ * to a name another user gives up later in the list.
+ */
+struct _PurpleChatUsersDelta
+{
+	GList *removed;
+	GList *renamed;
+	GList *added;
+	GList *arrived;
+	GList *updated;
+};
+
 G_BEGIN_DECLS
 
 /**************************************************************************/
@@ -595,6 +643,33 @@ void purple_chat_conversation_remove_user(PurpleChatConversation *chat,
 void purple_chat_conversation_remove_users(PurpleChatConversation *chat,
 		GList *users, const char *reason);
 
+/**
+ * purple_chat_conversation_begin_batch:
+ * @chat: The chat.
+ *
+ * Starts collecting changes to the users of a chat instead of passing each
+ * of them on to the UI.  This is meant for protocols that learn about many
+ * users at once, for example while joining a large room.
+ *
+ * Adding, removing and renaming users and changing their flags still
+ * updates the chat and emits the usual signals right away, but the UI only
+ * hears about the changes, in one #PurpleChatUsersDelta, when the batch is
+ * committed.  Batches can be nested; only the outermost commit delivers
+ * the changes.
+ */
+void purple_chat_conversation_begin_batch(PurpleChatConversation *chat);
+
+/**
+ * purple_chat_conversation_commit_batch:
+ * @chat: The chat.
+ *
+ * Ends a batch started by purple_chat_conversation_begin_batch().  If this
+ * was the outermost batch, the collected changes are given to the UI and
+ * the <link linkend="conversations-chat-users-changed"><literal>"chat-users-changed"</literal></link>
+ * signal is emitted.
+ */
+void purple_chat_conversation_commit_batch(PurpleChatConversation *chat);
+
 /**
  * purple_chat_conversation_has_user:
  * @chat:   The chat.
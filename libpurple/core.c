@@ -148,6 +148,7 @@ purple_core_init(const char *ui)
 	purple_prefs_init();
 
 	purple_debug_init();
+	_purple_eventloop_init();
 
 	if (ops != NULL)
 	{
@@ -197,6 +198,7 @@ purple_core_init(const char *ui)
 	purple_pounces_init();
 	_purple_socket_init();
 	purple_proxy_init();
+	purple_ssl_init();
 	purple_sound_init();
 	purple_stun_init();
 	purple_xfers_init();
@@ -258,6 +260,7 @@ purple_core_quit(void)
 	purple_sound_uninit();
 	purple_theme_manager_uninit();
 	purple_xfers_uninit();
+	purple_ssl_uninit();
 	purple_proxy_uninit();
 	_purple_socket_uninit();
 	_purple_image_store_uninit();
@@ -267,6 +270,8 @@ purple_core_quit(void)
 	if (ops != NULL && ops->quit != NULL)
 		ops->quit();
 
+	_purple_eventloop_uninit();
+
 	/* Everything after prefs_uninit must not try to read any prefs */
 	purple_prefs_uninit();
 	purple_plugins_uninit();
@@ -55,6 +55,10 @@ excluded = [\
 
     # Similiar to the above:
     "purple_notify_is_valid_ui_handle",
+
+    # This returns an array of structures, which can't be translated.
+    # purple_memstat_get_report() gives the same information.
+    "purple_memstat_get_snapshot",
     ]
 
 # This is a list of functions that return a GList* or GSList * whose elements
@@ -94,6 +98,53 @@ constlists = [
     "purple_conversation_get_message_history",
 ]
 
+# This is a list of bulk methods.  Each one walks a list of objects and
+# replies with an array of structs, one per object, so that clients don't
+# have to make one call per object and field.  For each method:
+#   "params": the input parameters, as (type, name) pairs,
+#   "list":   the C expression that gets the list,
+#   "free":   how to free the list afterwards, or None if it is not ours,
+#   "node":   the type of the objects in the list,
+#   "setup":  declarations to compute once per object, which is called node,
+#   "fields": the struct members, as (D-Bus type, name, C expression).
+bulkmethods = {
+    "purple_blist_get_buddies_info": {
+        "params": [],
+        "list": "purple_blist_get_buddies()",
+        "free": "g_slist_free",
+        "node": "PurpleBuddy",
+        "setup": [
+            "PurplePresence *presence = purple_buddy_get_presence(node);",
+            "PurpleStatus *status = purple_presence_get_active_status(presence);",
+        ],
+        "fields": [
+            ("i", "buddy", "purple_dbus_pointer_to_id(node)"),
+            ("i", "account", "purple_dbus_pointer_to_id(purple_buddy_get_account(node))"),
+            ("s", "name", "purple_buddy_get_name(node)"),
+            ("s", "alias", "purple_buddy_get_alias(node)"),
+            ("s", "group", "purple_group_get_name(purple_buddy_get_group(node))"),
+            ("s", "status", "purple_status_get_id(status)"),
+            ("s", "message", "purple_status_get_attr_string(status, \"message\")"),
+            ("i", "idle", "purple_presence_is_idle(presence) ? (dbus_int32_t)purple_presence_get_idle_time(presence) : 0"),
+        ],
+    },
+    "purple_conversation_get_message_history_info": {
+        "params": [("PurpleConversation", "conv")],
+        "list": "purple_conversation_get_message_history(conv)",
+        "free": None,
+        "node": "PurpleMessage",
+        "setup": [],
+        "fields": [
+            ("i", "message", "purple_dbus_pointer_to_id(node)"),
+            ("s", "author", "purple_message_get_author(node)"),
+            ("s", "alias", "purple_message_get_author_alias(node)"),
+            ("s", "contents", "purple_message_get_contents(node)"),
+            ("x", "time", "purple_message_get_time(node)"),
+            ("i", "flags", "purple_message_get_flags(node)"),
+        ],
+    },
+}
+
 pointer = "#pointer#"
 
 class MyException(Exception):
@@ -538,6 +589,75 @@ class ServerBinding (Binding):
                                % (name, "len"))
         self.addouttype("ay", name)
 
+class BulkBinding:
+    ctypes = {"i": ("dbus_int32_t ", "INT32"),
+              "u": ("dbus_uint32_t ", "UINT32"),
+              "x": ("dbus_int64_t ", "INT64"),
+              "b": ("dbus_bool_t ", "BOOLEAN"),
+              "s": ("const char *", "STRING")}
+
+    def __init__(self, name, spec):
+        self.name = name
+        self.spec = spec
+        self.dparams = ""
+        self.signature = "(%s)" % "".join(field[0] for field in spec["fields"])
+
+    def addstring(self, *items):
+        for item in items:
+            self.dparams += item + r"\0"
+
+    def process(self):
+        spec = self.spec
+        listtype = {"g_slist_free": "GSList"}.get(spec["free"], "GList")
+
+        print("static DBusMessage*")
+        print("%s_DBUS(DBusMessage *message_DBUS, DBusError *error_DBUS) {" % \
+              self.name)
+        print("\tDBusMessage *reply_DBUS;")
+        print("\tDBusMessageIter iter_DBUS, array_DBUS, struct_DBUS;")
+        print("\t%s *list_DBUS, *l_DBUS;" % listtype)
+        for type, name in spec["params"]:
+            print("\tdbus_int32_t %s_ID;" % name)
+            print("\t%s *%s;" % (type, name))
+
+        print("\tdbus_message_get_args(message_DBUS, error_DBUS,", end=' ')
+        for type, name in spec["params"]:
+            print("DBUS_TYPE_INT32, &%s_ID," % name, end=' ')
+            self.addstring("in", "i", name)
+        print("DBUS_TYPE_INVALID);")
+        print("\tCHECK_ERROR(error_DBUS);")
+        for type, name in spec["params"]:
+            print("\tPURPLE_DBUS_ID_TO_POINTER(%s, %s_ID, %s, error_DBUS);" % \
+                  (name, name, type))
+
+        print("\tlist_DBUS = %s;" % spec["list"])
+        print("\treply_DBUS = dbus_message_new_method_return (message_DBUS);")
+        print("\tdbus_message_iter_init_append(reply_DBUS, &iter_DBUS);")
+        print('\tdbus_message_iter_open_container(&iter_DBUS, DBUS_TYPE_ARRAY, "%s", &array_DBUS);' % \
+              self.signature)
+        print("\tfor (l_DBUS = list_DBUS; l_DBUS != NULL; l_DBUS = l_DBUS->next) {")
+        print("\t\t%s *node = l_DBUS->data;" % spec["node"])
+        for line in spec["setup"]:
+            print("\t\t%s" % line)
+        for dtype, name, expr in spec["fields"]:
+            print("\t\t%s%s_FIELD;" % (self.ctypes[dtype][0], name))
+        for dtype, name, expr in spec["fields"]:
+            if dtype == "s":
+                expr = "purple_null_to_emptystr(%s)" % expr
+            print("\t\t%s_FIELD = %s;" % (name, expr))
+        print("\t\tdbus_message_iter_open_container(&array_DBUS, DBUS_TYPE_STRUCT, NULL, &struct_DBUS);")
+        for dtype, name, expr in spec["fields"]:
+            print("\t\tdbus_message_iter_append_basic(&struct_DBUS, DBUS_TYPE_%s, &%s_FIELD);" % \
+                  (self.ctypes[dtype][1], name))
+        print("\t\tdbus_message_iter_close_container(&array_DBUS, &struct_DBUS);")
+        print("\t}")
+        print("\tdbus_message_iter_close_container(&iter_DBUS, &array_DBUS);")
+        if spec["free"] is not None:
+            print("\t%s(list_DBUS);" % spec["free"])
+        print("\treturn reply_DBUS;\n}\n")
+
+        self.addstring("out", "a" + self.signature, "info")
+
 class BindingSet:
     regexp = r"^(\w[^()]*)\(([^()]*)\)\s*;\s*$";
 
@@ -608,6 +728,11 @@ class ServerBindingSet (BindingSet):
         self.functions.append((binding.function.name, binding.dparams))
         
     def flush(self):
+        for name in sorted(bulkmethods):
+            binding = BulkBinding(name, bulkmethods[name])
+            binding.process()
+            self.functions.append((name, binding.dparams))
+
         print("static PurpleDBusBinding bindings_DBUS[] = { ")
         for function, params in self.functions:
             print('{"%s", "%s", %s_DBUS},' % \
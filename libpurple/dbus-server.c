@@ -44,6 +44,7 @@
 #include "dbus-bindings.h"
 #include "debug.h"
 #include "core.h"
+#include "prefs.h"
 #include "savedstatuses.h"
 #include "smiley.h"
 #include "smiley-list.h"
@@ -584,6 +585,266 @@ purple_dbus_register_bindings(void *handle, PurpleDBusBinding *bindings)
 			bindings);
 }
 
+
+
+/**************************************************************************/
+/* Signals                                                                */
+/**************************************************************************/
+
+/*
+ * Every libpurple signal gets one of these when it is registered, so that
+ * emitting it doesn't have to convert its name every time.  They are keyed
+ * by their D-Bus name and live as long as the process, like interned
+ * strings, since the signals that point to them may outlive this module.
+ */
+struct _PurpleDBusSignal
+{
+	char *dbus_name;
+	gboolean forward;     /* FALSE for signals that never go out on the bus */
+	guint subscribers;    /* Clients that asked for this signal by name */
+};
+
+/*
+ * A client that asked for signals with PurpleDbusSubscribeSignal.  It is
+ * forgotten when it leaves the bus.
+ */
+typedef struct
+{
+	char *name;
+	char *rule;           /* Our match rule for it leaving the bus */
+	GHashTable *signals;  /* Set of PurpleDBusSignal */
+	gboolean all;
+} PurpleDBusSubscriber;
+
+static GHashTable *signal_table = NULL;
+static GHashTable *subscribers = NULL;
+static guint all_subscribers = 0;
+static gboolean filter_signals = TRUE;
+
+static char *purple_dbus_convert_signal_name(const char *purple_name);
+
+/* Takes ownership of dbus_name. */
+static PurpleDBusSignal *
+purple_dbus_signal_get(char *dbus_name)
+{
+	PurpleDBusSignal *dbus_signal;
+
+	if (signal_table == NULL)
+		signal_table = g_hash_table_new(g_str_hash, g_str_equal);
+
+	dbus_signal = g_hash_table_lookup(signal_table, dbus_name);
+	if (dbus_signal != NULL) {
+		g_free(dbus_name);
+		return dbus_signal;
+	}
+
+	dbus_signal = g_new0(PurpleDBusSignal, 1);
+	dbus_signal->dbus_name = dbus_name;
+	dbus_signal->forward = TRUE;
+	g_hash_table_insert(signal_table, dbus_name, dbus_signal);
+
+	return dbus_signal;
+}
+
+PurpleDBusSignal *
+purple_dbus_signal_lookup(const char *name)
+{
+	PurpleDBusSignal *dbus_signal;
+
+	g_return_val_if_fail(name != NULL, NULL);
+
+	dbus_signal = purple_dbus_signal_get(purple_dbus_convert_signal_name(name));
+
+	/*
+	 * Our "dbus-method-called" signal must not be propagated to dbus.
+	 * What we really need is a flag for each signal that states whether
+	 * this signal is to be dbus-propagated or not.
+	 */
+	if (!strcmp(name, "dbus-method-called"))
+		dbus_signal->forward = FALSE;
+
+	return dbus_signal;
+}
+
+gboolean
+purple_dbus_signal_is_wanted(const PurpleDBusSignal *dbus_signal)
+{
+	if (dbus_signal == NULL || purple_dbus_connection == NULL)
+		return FALSE;
+
+	if (!dbus_signal->forward)
+		return FALSE;
+
+	if (!filter_signals)
+		return TRUE;
+
+	return all_subscribers > 0 || dbus_signal->subscribers > 0;
+}
+
+static void
+purple_dbus_subscriber_free(PurpleDBusSubscriber *subscriber)
+{
+	GHashTableIter iter;
+	PurpleDBusSignal *dbus_signal;
+
+	g_hash_table_iter_init(&iter, subscriber->signals);
+	while (g_hash_table_iter_next(&iter, (gpointer *)&dbus_signal, NULL))
+		dbus_signal->subscribers--;
+	g_hash_table_destroy(subscriber->signals);
+
+	if (subscriber->all)
+		all_subscribers--;
+
+	if (purple_dbus_connection != NULL)
+		dbus_bus_remove_match(purple_dbus_connection, subscriber->rule, NULL);
+
+	g_free(subscriber->rule);
+	g_free(subscriber->name);
+	g_free(subscriber);
+}
+
+static PurpleDBusSubscriber *
+purple_dbus_subscriber_get(const char *name)
+{
+	PurpleDBusSubscriber *subscriber;
+
+	subscriber = g_hash_table_lookup(subscribers, name);
+	if (subscriber != NULL)
+		return subscriber;
+
+	subscriber = g_new0(PurpleDBusSubscriber, 1);
+	subscriber->name = g_strdup(name);
+	subscriber->signals = g_hash_table_new(g_direct_hash, g_direct_equal);
+	subscriber->rule = g_strdup_printf("type='signal',sender='"
+			DBUS_SERVICE_DBUS "',interface='" DBUS_INTERFACE_DBUS "',"
+			"member='NameOwnerChanged',arg0='%s'", name);
+
+	/* Don't wait for the reply, the bus daemon won't refuse this. */
+	dbus_bus_add_match(purple_dbus_connection, subscriber->rule, NULL);
+
+	g_hash_table_insert(subscribers, subscriber->name, subscriber);
+
+	return subscriber;
+}
+
+static DBusMessage *
+purple_dbus_subscribe_signal_DBUS(DBusMessage *message_DBUS,
+		DBusError *error_DBUS)
+{
+	PurpleDBusSubscriber *subscriber;
+	const char *sender;
+	const char *name;
+
+	dbus_message_get_args(message_DBUS, error_DBUS, DBUS_TYPE_STRING, &name,
+			DBUS_TYPE_INVALID);
+	CHECK_ERROR(error_DBUS);
+
+	if ((sender = dbus_message_get_sender(message_DBUS)) == NULL) {
+		dbus_set_error(error_DBUS, DBUS_ERROR_INVALID_ARGS,
+				"Only clients on a bus can subscribe to signals");
+		return NULL;
+	}
+
+	subscriber = purple_dbus_subscriber_get(sender);
+
+	if (*name == '\0' || !strcmp(name, "*")) {
+		if (!subscriber->all) {
+			subscriber->all = TRUE;
+			all_subscribers++;
+		}
+	} else {
+		PurpleDBusSignal *dbus_signal;
+
+		dbus_signal = purple_dbus_signal_get(g_strdup(name));
+		if (!g_hash_table_contains(subscriber->signals, dbus_signal)) {
+			g_hash_table_add(subscriber->signals, dbus_signal);
+			dbus_signal->subscribers++;
+		}
+	}
+
+	return dbus_message_new_method_return(message_DBUS);
+}
+
+static DBusMessage *
+purple_dbus_unsubscribe_signal_DBUS(DBusMessage *message_DBUS,
+		DBusError *error_DBUS)
+{
+	PurpleDBusSubscriber *subscriber = NULL;
+	const char *sender;
+	const char *name;
+
+	dbus_message_get_args(message_DBUS, error_DBUS, DBUS_TYPE_STRING, &name,
+			DBUS_TYPE_INVALID);
+	CHECK_ERROR(error_DBUS);
+
+	if ((sender = dbus_message_get_sender(message_DBUS)) != NULL)
+		subscriber = g_hash_table_lookup(subscribers, sender);
+
+	if (subscriber == NULL)
+		return dbus_message_new_method_return(message_DBUS);
+
+	if (*name == '\0' || !strcmp(name, "*")) {
+		if (subscriber->all) {
+			subscriber->all = FALSE;
+			all_subscribers--;
+		}
+	} else {
+		PurpleDBusSignal *dbus_signal;
+
+		dbus_signal = g_hash_table_lookup(signal_table, name);
+		if (dbus_signal != NULL &&
+				g_hash_table_remove(subscriber->signals, dbus_signal))
+			dbus_signal->subscribers--;
+	}
+
+	if (!subscriber->all && g_hash_table_size(subscriber->signals) == 0)
+		g_hash_table_remove(subscribers, sender);
+
+	return dbus_message_new_method_return(message_DBUS);
+}
+
+static PurpleDBusBinding subscription_bindings[] = {
+	{"PurpleDbusSubscribeSignal", "in\0s\0name\0",
+		purple_dbus_subscribe_signal_DBUS},
+	{"PurpleDbusUnsubscribeSignal", "in\0s\0name\0",
+		purple_dbus_unsubscribe_signal_DBUS},
+	{NULL, NULL, NULL}
+};
+
+/* Forgets the subscriptions of clients that left the bus. */
+static DBusHandlerResult
+purple_dbus_filter(DBusConnection *connection, DBusMessage *message,
+		void *user_data)
+{
+	const char *name, *old_owner, *new_owner;
+
+	if (dbus_message_is_signal(message, DBUS_INTERFACE_DBUS,
+				"NameOwnerChanged") &&
+			dbus_message_get_args(message, NULL,
+				DBUS_TYPE_STRING, &name,
+				DBUS_TYPE_STRING, &old_owner,
+				DBUS_TYPE_STRING, &new_owner,
+				DBUS_TYPE_INVALID) &&
+			*new_owner == '\0')
+	{
+		g_hash_table_remove(subscribers, name);
+	}
+
+	return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
+static void
+purple_dbus_subscriptions_init(void)
+{
+	subscribers = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+			(GDestroyNotify)purple_dbus_subscriber_free);
+	dbus_connection_add_filter(purple_dbus_connection, purple_dbus_filter,
+			NULL, NULL);
+
+	purple_dbus_register_bindings(purple_dbus_get_handle(),
+			subscription_bindings);
+}
+
 static void
 purple_dbus_dispatch_init(void)
 {
@@ -635,18 +896,18 @@ purple_dbus_dispatch_init(void)
 			 G_TYPE_POINTER); /* pointer to a pointer */
 
 	PURPLE_DBUS_REGISTER_BINDINGS(purple_dbus_get_handle());
+	purple_dbus_subscriptions_init();
 
 	if (purple_debug_is_verbose())
 		purple_debug_misc("dbus", "initialized");
 }
 
-
-
-/**************************************************************************/
-/* Signals                                                                */
-/**************************************************************************/
-
-
+static void
+filter_signals_pref_cb(const char *name, PurplePrefType type,
+		gconstpointer value, gpointer data)
+{
+	filter_signals = GPOINTER_TO_INT(value);
+}
 
 static char *
 purple_dbus_convert_signal_name(const char *purple_name)
@@ -761,32 +1022,17 @@ purple_dbus_message_append_values(DBusMessageIter *iter,
 #undef my_arg
 
 void
-purple_dbus_signal_emit_purple(const char *name, int num_values,
+purple_dbus_signal_emit(PurpleDBusSignal *dbus_signal, int num_values,
 		GType *types, va_list vargs)
 {
 	DBusMessage *signal;
 	DBusMessageIter iter;
-	char *newname;
 
-#if 0 /* this is noisy with no dbus connection */
-	g_return_if_fail(purple_dbus_connection);
-#else
-	if (purple_dbus_connection == NULL)
+	if (!purple_dbus_signal_is_wanted(dbus_signal))
 		return;
-#endif
 
-
-	/*
-	 * The test below is a hack that prevents our "dbus-method-called"
-	 * signal from being propagated to dbus.  What we really need is a
-	 * flag for each signal that states whether this signal is to be
-	 * dbus-propagated or not.
-	 */
-	if (!strcmp(name, "dbus-method-called"))
-		return;
-
-	newname = purple_dbus_convert_signal_name(name);
-	signal = dbus_message_new_signal(PURPLE_DBUS_PATH, PURPLE_DBUS_INTERFACE, newname);
+	signal = dbus_message_new_signal(PURPLE_DBUS_PATH, PURPLE_DBUS_INTERFACE,
+			dbus_signal->dbus_name);
 	dbus_message_iter_init_append(signal, &iter);
 
 	if (purple_dbus_message_append_values(&iter, num_values, types, vargs))
@@ -794,14 +1040,25 @@ purple_dbus_signal_emit_purple(const char *name, int num_values,
 			purple_debug_warning("dbus",
 				"The signal \"%s\" caused some dbus error."
 				" (If you are not a developer, please ignore this message.)\n",
-				name);
+				dbus_signal->dbus_name);
 
 	dbus_connection_send(purple_dbus_connection, signal, NULL);
 
-	g_free(newname);
 	dbus_message_unref(signal);
 }
 
+void
+purple_dbus_signal_emit_purple(const char *name, int num_values,
+		GType *types, va_list vargs)
+{
+	/* this is noisy with no dbus connection */
+	if (purple_dbus_connection == NULL)
+		return;
+
+	purple_dbus_signal_emit(purple_dbus_signal_lookup(name), num_values,
+			types, vargs);
+}
+
 const char *
 purple_dbus_get_init_error(void)
 {
@@ -824,6 +1081,13 @@ purple_dbus_init(void)
 
 	purple_dbus_init_ids();
 
+	/* Only forward the signals that clients subscribed to. */
+	purple_prefs_add_none("/purple/dbus");
+	purple_prefs_add_bool("/purple/dbus/filter_signals", TRUE);
+	purple_prefs_connect_callback(purple_dbus_get_handle(),
+			"/purple/dbus/filter_signals", filter_signals_pref_cb, NULL);
+	filter_signals = purple_prefs_get_bool("/purple/dbus/filter_signals");
+
 	g_free(init_error);
 	init_error = NULL;
 	purple_dbus_dispatch_init();
@@ -835,9 +1099,19 @@ void
 purple_dbus_uninit(void)
 {
 	DBusError error;
+
+	purple_prefs_disconnect_by_handle(purple_dbus_get_handle());
+
 	if (!purple_dbus_connection)
 		return;
 
+	if (subscribers != NULL) {
+		g_hash_table_destroy(subscribers);
+		subscribers = NULL;
+		dbus_connection_remove_filter(purple_dbus_connection,
+				purple_dbus_filter, NULL);
+	}
+
 	dbus_error_init(&error);
 	dbus_connection_unregister_object_path(purple_dbus_connection, PURPLE_DBUS_PATH);
 	dbus_bus_release_name(purple_dbus_connection, PURPLE_DBUS_SERVICE, &error);
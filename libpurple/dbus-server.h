@@ -140,6 +140,51 @@ void purple_dbus_register_pointer(gpointer node, PurpleDBusType *type);
  */
 void purple_dbus_unregister_pointer(gpointer node);
 
+/**
+ * PurpleDBusSignal:
+ *
+ * The D-Bus side of a libpurple signal: its D-Bus name and whether any
+ * client wants it.  libpurple looks one up when a signal is registered.
+ */
+typedef struct _PurpleDBusSignal PurpleDBusSignal;
+
+/**
+ * purple_dbus_signal_lookup:
+ * @name: The name of the signal ("bla-bla-blaa")
+ *
+ * Gets the D-Bus side of a signal, converting its name once.  The result
+ * is never freed.
+ *
+ * Returns: (transfer none): The D-Bus signal.
+ */
+PurpleDBusSignal *purple_dbus_signal_lookup(const char *name);
+
+/**
+ * purple_dbus_signal_is_wanted:
+ * @dbus_signal: The D-Bus signal.
+ *
+ * Determines whether emitting a signal would send anything on the bus.
+ * Only the signals that some client asked for with the
+ * <literal>PurpleDbusSubscribeSignal</literal> method are sent.  Clearing
+ * the <literal>/purple/dbus/filter_signals</literal> preference sends every
+ * signal while we are connected, for clients that only add match rules.
+ *
+ * Returns: %TRUE if the signal would be sent.
+ */
+gboolean purple_dbus_signal_is_wanted(const PurpleDBusSignal *dbus_signal);
+
+/**
+ * purple_dbus_signal_emit:
+ * @dbus_signal: The D-Bus signal.
+ * @num_values:  The number of parameters.
+ * @types:       Array of GTypes representing the types of the parameters.
+ * @vargs:       A va_list containing the actual parameters.
+ *
+ * Emits a dbus signal, if it is wanted.
+ */
+void purple_dbus_signal_emit(PurpleDBusSignal *dbus_signal, int num_values,
+				GType *types, va_list vargs);
+
 /**
  * purple_dbus_signal_emit_purple:
  * @name:        The name of the signal ("bla-bla-blaa")
@@ -18,28 +18,380 @@
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
  */
+/* For dladdr() */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "internal.h"
+#include "debug.h"
 #include "eventloop.h"
+#include "prefs.h"
+#include "util.h"
+
+#ifdef HAVE_DLADDR
+#include <dlfcn.h>
+#endif
+
+#define PROFILE_DUMP_FILE      "eventloop-profile.txt"
+#define PROFILE_DUMP_INTERVAL  60   /* seconds */
+
+/* A timeout or input handler added while profiling, which is called through
+ * profiled_timeout_cb() or profiled_input_cb() so it can be timed. */
+typedef struct {
+	GCallback function;
+	gpointer data;
+	gboolean input;
+	guint handle;
+	guint running;    /* Nonzero while the callback is being called. */
+	gboolean removed; /* Removed while running, so free it afterwards. */
+} ProfiledSource;
 
 static PurpleEventLoopUiOps *eventloop_ui_ops = NULL;
 
+static gboolean profiling = FALSE;
+static guint slow_threshold = 100;
+static guint profile_dump_timer = 0;
+static GHashTable *profiles = NULL;          /* function -> PurpleEventLoopProfile */
+static GHashTable *profiled_timeouts = NULL; /* handle -> ProfiledSource */
+static GHashTable *profiled_inputs = NULL;   /* handle -> ProfiledSource */
+
+/* Timeouts are added from other threads too, such as GStreamer's streaming
+ * threads in mediamanager.c, so the profiled sources are kept under a lock.
+ * The profiles themselves are only touched from the main thread. */
+G_LOCK_DEFINE_STATIC(profiled_sources);
+
+/**************************************************************************
+ * Profiling
+ **************************************************************************/
+static char *
+profile_name(gconstpointer function)
+{
+#ifdef HAVE_DLADDR
+	Dl_info info;
+
+	if (dladdr((void *)function, &info) && info.dli_fname != NULL) {
+		char *module = g_path_get_basename(info.dli_fname);
+		char *name;
+
+		/* dladdr() gives the nearest exported symbol, which is only this
+		 * callback if it's at the same address.  Otherwise, the offset can
+		 * be given to addr2line. */
+		if (info.dli_sname != NULL && info.dli_saddr == function)
+			name = g_strdup_printf("%s (%s)", info.dli_sname, module);
+		else
+			name = g_strdup_printf("%s+0x%lx", module,
+				(unsigned long)((const char *)function -
+				                (const char *)info.dli_fbase));
+
+		g_free(module);
+		return name;
+	}
+#endif
+
+	return g_strdup_printf("%p", function);
+}
+
+static void
+profile_free(gpointer data)
+{
+	PurpleEventLoopProfile *profile = data;
+
+	g_free(profile->name);
+	g_free(profile);
+}
+
+static void
+profile_record(ProfiledSource *source, gint64 elapsed)
+{
+	PurpleEventLoopProfile *profile;
+	gint64 bound = 100;
+	guint bucket = 0;
+
+	if (!profiling)
+		return;
+
+	profile = g_hash_table_lookup(profiles, (gconstpointer)source->function);
+	if (profile == NULL) {
+		profile = g_new0(PurpleEventLoopProfile, 1);
+		profile->function = (gconstpointer)source->function;
+		profile->name = profile_name(profile->function);
+		profile->input = source->input;
+		g_hash_table_insert(profiles, (gpointer)profile->function, profile);
+	}
+
+	profile->calls++;
+	profile->total_time += elapsed;
+	profile->max_time = MAX(profile->max_time, (guint64)elapsed);
+
+	while (bucket < PURPLE_EVENTLOOP_PROFILE_BUCKETS - 1 && elapsed >= bound) {
+		bucket++;
+		bound *= 10;
+	}
+	profile->histogram[bucket]++;
+
+	if (slow_threshold > 0 && elapsed >= (gint64)slow_threshold * 1000) {
+		profile->slow_calls++;
+		purple_debug_warning("eventloop", "%s %s took %.1f ms\n",
+			source->input ? "Input handler" : "Timeout", profile->name,
+			elapsed / 1000.0);
+	}
+}
+
+static ProfiledSource *
+profiled_source_new(GCallback function, gpointer data, gboolean input)
+{
+	ProfiledSource *source = g_new0(ProfiledSource, 1);
+
+	source->function = function;
+	source->data = data;
+	source->input = input;
+
+	return source;
+}
+
+static gboolean
+profiled_timeout_cb(gpointer data)
+{
+	ProfiledSource *source = data;
+	gint64 start = g_get_monotonic_time();
+	gboolean ret;
+
+	/* This waits for the source to be registered if it was added from
+	 * another thread and fired before purple_timeout_add() returned. */
+	G_LOCK(profiled_sources);
+	source->running++;
+	G_UNLOCK(profiled_sources);
+
+	ret = ((GSourceFunc)source->function)(source->data);
+
+	profile_record(source, g_get_monotonic_time() - start);
+
+	G_LOCK(profiled_sources);
+	source->running--;
+	if (source->running == 0 && (!ret || source->removed)) {
+		g_hash_table_remove(profiled_timeouts, GUINT_TO_POINTER(source->handle));
+		ret = FALSE;
+	}
+	G_UNLOCK(profiled_sources);
+
+	return ret;
+}
+
+static void
+profiled_input_cb(gpointer data, gint fd, PurpleInputCondition cond)
+{
+	ProfiledSource *source = data;
+	gint64 start = g_get_monotonic_time();
+
+	G_LOCK(profiled_sources);
+	source->running++;
+	G_UNLOCK(profiled_sources);
+
+	((PurpleInputFunction)source->function)(source->data, fd, cond);
+
+	profile_record(source, g_get_monotonic_time() - start);
+
+	G_LOCK(profiled_sources);
+	source->running--;
+	if (source->running == 0 && source->removed)
+		g_hash_table_remove(profiled_inputs, GUINT_TO_POINTER(source->handle));
+	G_UNLOCK(profiled_sources);
+}
+
+/* Forgets a profiled source when it's removed, unless it's running, in
+ * which case its callback wrapper does so once it returns. */
+static void
+profiled_source_remove(GHashTable *sources, guint handle)
+{
+	ProfiledSource *source;
+
+	if (sources == NULL)
+		return;
+
+	G_LOCK(profiled_sources);
+	source = g_hash_table_lookup(sources, GUINT_TO_POINTER(handle));
+	if (source != NULL) {
+		if (source->running)
+			source->removed = TRUE;
+		else
+			g_hash_table_remove(sources, GUINT_TO_POINTER(handle));
+	}
+	G_UNLOCK(profiled_sources);
+}
+
+static gint
+profile_compare(gconstpointer a, gconstpointer b)
+{
+	const PurpleEventLoopProfile *x = a;
+	const PurpleEventLoopProfile *y = b;
+
+	return (x->total_time < y->total_time) - (x->total_time > y->total_time);
+}
+
+static void
+profile_dump(void)
+{
+	char *report = purple_eventloop_get_profile_report();
+
+	purple_util_write_data_to_file(PROFILE_DUMP_FILE, report, -1);
+	g_free(report);
+}
+
+static gboolean
+profile_dump_cb(gpointer data)
+{
+	profile_dump();
+
+	return TRUE;
+}
+
+void
+purple_eventloop_set_profiling(gboolean enabled)
+{
+	PurpleEventLoopUiOps *ops = purple_eventloop_get_ui_ops();
+
+	if (profiling == enabled)
+		return;
+
+	if (profiles == NULL) {
+		profiles = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+				NULL, profile_free);
+		profiled_timeouts = g_hash_table_new_full(g_direct_hash,
+				g_direct_equal, NULL, g_free);
+		profiled_inputs = g_hash_table_new_full(g_direct_hash,
+				g_direct_equal, NULL, g_free);
+	}
+
+	profiling = enabled;
+
+	/* The dump timer isn't profiled itself. */
+	if (enabled) {
+		if (ops->timeout_add_seconds)
+			profile_dump_timer = ops->timeout_add_seconds(
+					PROFILE_DUMP_INTERVAL, profile_dump_cb, NULL);
+		else
+			profile_dump_timer = ops->timeout_add(
+					1000 * PROFILE_DUMP_INTERVAL, profile_dump_cb, NULL);
+	} else {
+		ops->timeout_remove(profile_dump_timer);
+		profile_dump_timer = 0;
+	}
+
+	purple_debug_info("eventloop", "Profiling %s\n",
+			enabled ? "started" : "stopped");
+}
+
+gboolean
+purple_eventloop_get_profiling(void)
+{
+	return profiling;
+}
+
+void
+purple_eventloop_set_slow_threshold(guint msec)
+{
+	slow_threshold = msec;
+}
+
+guint
+purple_eventloop_get_slow_threshold(void)
+{
+	return slow_threshold;
+}
+
+GList *
+purple_eventloop_get_profile(void)
+{
+	if (profiles == NULL)
+		return NULL;
+
+	return g_list_sort(g_hash_table_get_values(profiles), profile_compare);
+}
+
+char *
+purple_eventloop_get_profile_report(void)
+{
+	GString *report = g_string_new(NULL);
+	GList *list, *l;
+
+	g_string_append_printf(report,
+			"Event loop profile, slow threshold %u ms%s\n", slow_threshold,
+			profiling ? "" : " (not profiling)");
+	g_string_append(report, "     calls   total ms    mean ms     max ms   slow"
+			"  <0.1ms    <1ms   <10ms  <100ms     <1s    >=1s  callback\n");
+
+	list = purple_eventloop_get_profile();
+	for (l = list; l != NULL; l = l->next) {
+		PurpleEventLoopProfile *profile = l->data;
+		int i;
+
+		g_string_append_printf(report,
+			"%10" G_GUINT64_FORMAT " %10.1f %10.3f %10.1f %6" G_GUINT64_FORMAT,
+			profile->calls, profile->total_time / 1000.0,
+			profile->total_time / 1000.0 / MAX(profile->calls, 1),
+			profile->max_time / 1000.0, profile->slow_calls);
+		for (i = 0; i < PURPLE_EVENTLOOP_PROFILE_BUCKETS; i++)
+			g_string_append_printf(report, " %7" G_GUINT64_FORMAT,
+				profile->histogram[i]);
+		g_string_append_printf(report, "  %s%s\n", profile->name,
+			profile->input ? " [input]" : "");
+	}
+	g_list_free(list);
+
+	return g_string_free(report, FALSE);
+}
+
+void
+purple_eventloop_reset_profile(void)
+{
+	if (profiles != NULL)
+		g_hash_table_remove_all(profiles);
+}
+
+/**************************************************************************
+ * Event Loop API
+ **************************************************************************/
 guint
 purple_timeout_add(guint interval, GSourceFunc function, gpointer data)
 {
 	PurpleEventLoopUiOps *ops = purple_eventloop_get_ui_ops();
+	ProfiledSource *source;
+
+	if (!profiling)
+		return ops->timeout_add(interval, function, data);
+
+	/* Keep the lock until the source is registered, in case it's being
+	 * added from another thread and fires before ops->timeout_add()
+	 * returns. */
+	source = profiled_source_new(G_CALLBACK(function), data, FALSE);
+	G_LOCK(profiled_sources);
+	source->handle = ops->timeout_add(interval, profiled_timeout_cb, source);
+	g_hash_table_insert(profiled_timeouts, GUINT_TO_POINTER(source->handle), source);
+	G_UNLOCK(profiled_sources);
 
-	return ops->timeout_add(interval, function, data);
+	return source->handle;
 }
 
 guint
 purple_timeout_add_seconds(guint interval, GSourceFunc function, gpointer data)
 {
 	PurpleEventLoopUiOps *ops = purple_eventloop_get_ui_ops();
+	ProfiledSource *source;
 
-	if (ops->timeout_add_seconds)
+	if (!ops->timeout_add_seconds)
+		return purple_timeout_add(1000 * interval, function, data);
+
+	if (!profiling)
 		return ops->timeout_add_seconds(interval, function, data);
-	else
-		return ops->timeout_add(1000 * interval, function, data);
+
+	source = profiled_source_new(G_CALLBACK(function), data, FALSE);
+	G_LOCK(profiled_sources);
+	source->handle = ops->timeout_add_seconds(interval, profiled_timeout_cb, source);
+	g_hash_table_insert(profiled_timeouts, GUINT_TO_POINTER(source->handle), source);
+	G_UNLOCK(profiled_sources);
+
+	return source->handle;
 }
 
 gboolean
@@ -47,6 +399,8 @@ purple_timeout_remove(guint tag)
 {
 	PurpleEventLoopUiOps *ops = purple_eventloop_get_ui_ops();
 
+	profiled_source_remove(profiled_timeouts, tag);
+
 	return ops->timeout_remove(tag);
 }
 
@@ -54,8 +408,18 @@ guint
 purple_input_add(int source, PurpleInputCondition condition, PurpleInputFunction func, gpointer user_data)
 {
 	PurpleEventLoopUiOps *ops = purple_eventloop_get_ui_ops();
+	ProfiledSource *profiled;
+
+	if (!profiling)
+		return ops->input_add(source, condition, func, user_data);
+
+	profiled = profiled_source_new(G_CALLBACK(func), user_data, TRUE);
+	G_LOCK(profiled_sources);
+	profiled->handle = ops->input_add(source, condition, profiled_input_cb, profiled);
+	g_hash_table_insert(profiled_inputs, GUINT_TO_POINTER(profiled->handle), profiled);
+	G_UNLOCK(profiled_sources);
 
-	return ops->input_add(source, condition, func, user_data);
+	return profiled->handle;
 }
 
 gboolean
@@ -63,6 +427,8 @@ purple_input_remove(guint tag)
 {
 	PurpleEventLoopUiOps *ops = purple_eventloop_get_ui_ops();
 
+	profiled_source_remove(profiled_inputs, tag);
+
 	return ops->input_remove(tag);
 }
 
@@ -110,6 +476,71 @@ purple_eventloop_get_ui_ops(void)
 	return eventloop_ui_ops;
 }
 
+/**************************************************************************
+ * Subsystem
+ **************************************************************************/
+static void
+profile_pref_cb(const char *name, PurplePrefType type, gconstpointer val,
+		gpointer data)
+{
+	purple_eventloop_set_profiling(GPOINTER_TO_INT(val));
+}
+
+static void
+slow_threshold_pref_cb(const char *name, PurplePrefType type,
+		gconstpointer val, gpointer data)
+{
+	purple_eventloop_set_slow_threshold(GPOINTER_TO_INT(val));
+}
+
+static void *
+eventloop_get_handle(void)
+{
+	static int handle;
+
+	return &handle;
+}
+
+void
+_purple_eventloop_init(void)
+{
+	const char *env;
+
+	purple_prefs_add_none("/purple/eventloop");
+	purple_prefs_add_bool("/purple/eventloop/profile", FALSE);
+	purple_prefs_add_int("/purple/eventloop/slow_threshold", 100);
+
+	purple_eventloop_set_slow_threshold(
+			purple_prefs_get_int("/purple/eventloop/slow_threshold"));
+	purple_eventloop_set_profiling(
+			purple_prefs_get_bool("/purple/eventloop/profile"));
+
+	/* The environment overrides the preferences without changing them. */
+	if ((env = g_getenv("PURPLE_EVENTLOOP_PROFILE")) != NULL) {
+		if (atoi(env) > 0)
+			purple_eventloop_set_slow_threshold(atoi(env));
+		purple_eventloop_set_profiling(TRUE);
+	}
+
+	purple_prefs_connect_callback(eventloop_get_handle(),
+			"/purple/eventloop/profile", profile_pref_cb, NULL);
+	purple_prefs_connect_callback(eventloop_get_handle(),
+			"/purple/eventloop/slow_threshold", slow_threshold_pref_cb, NULL);
+}
+
+void
+_purple_eventloop_uninit(void)
+{
+	purple_prefs_disconnect_by_handle(eventloop_get_handle());
+
+	/* The profiled sources are left alone, since the UI may still run
+	 * them after the core has gone. */
+	if (profiling) {
+		profile_dump();
+		purple_eventloop_set_profiling(FALSE);
+	}
+}
+
 /**************************************************************************
  * GBoxed code
  **************************************************************************/
@@ -59,6 +59,44 @@ typedef void (*PurpleInputFunction)(gpointer, gint, PurpleInputCondition);
 
 typedef struct _PurpleEventLoopUiOps PurpleEventLoopUiOps;
 
+/**
+ * PURPLE_EVENTLOOP_PROFILE_BUCKETS:
+ *
+ * The number of buckets in a #PurpleEventLoopProfile's histogram.  Calls
+ * that took under 0.1ms are counted in the first, under 1ms in the second,
+ * and so on up to a second; the last counts everything slower.
+ */
+#define PURPLE_EVENTLOOP_PROFILE_BUCKETS 6
+
+/**
+ * PurpleEventLoopProfile:
+ * @function:   The callback that was profiled.
+ * @name:       The callback's name and the module it is in, if it can be
+ *              found, or else its address.
+ * @input:      Whether the callback is an input handler, rather than a
+ *              timeout.
+ * @calls:      How many times the callback was called.
+ * @total_time: How long the calls took altogether, in microseconds.
+ * @max_time:   How long the longest call took, in microseconds.
+ * @slow_calls: How many calls took longer than the slow callback threshold.
+ * @histogram:  How many calls took how long; see
+ *              #PURPLE_EVENTLOOP_PROFILE_BUCKETS.
+ *
+ * What was recorded about the calls to one event loop callback while
+ * profiling was on.  See purple_eventloop_set_profiling().
+ */
+typedef struct
+{
+	gconstpointer function;
+	char *name;
+	gboolean input;
+	guint64 calls;
+	guint64 total_time;
+	guint64 max_time;
+	guint64 slow_calls;
+	guint64 histogram[PURPLE_EVENTLOOP_PROFILE_BUCKETS];
+} PurpleEventLoopProfile;
+
 /**
  * PurpleEventLoopUiOps:
  * @timeout_add: Should create a callback timer with an interval measured in
@@ -267,6 +305,82 @@ purple_input_get_error(int fd, int *error);
 int
 purple_input_pipe(int pipefd[2]);
 
+/**************************************************************************/
+/* Profiling API                                                          */
+/**************************************************************************/
+
+/**
+ * purple_eventloop_set_profiling:
+ * @enabled: Whether to profile event loop callbacks.
+ *
+ * Turns event loop profiling on or off.  While it's on, the timeouts and
+ * input handlers added with purple_timeout_add(),
+ * purple_timeout_add_seconds() and purple_input_add() are timed, and
+ * callbacks that take longer than the slow callback threshold are logged
+ * as debug warnings.  The profile is also written to eventloop-profile.txt
+ * in the user directory every minute.
+ *
+ * This is off by default.  It is turned on by the
+ * /purple/eventloop/profile preference, or by setting the
+ * PURPLE_EVENTLOOP_PROFILE environment variable, optionally to the slow
+ * callback threshold in milliseconds.
+ *
+ * Only callbacks added while profiling is on are timed.
+ */
+void purple_eventloop_set_profiling(gboolean enabled);
+
+/**
+ * purple_eventloop_get_profiling:
+ *
+ * Returns: Whether event loop callbacks are being profiled.
+ */
+gboolean purple_eventloop_get_profiling(void);
+
+/**
+ * purple_eventloop_set_slow_threshold:
+ * @msec: The threshold in milliseconds, or 0 not to log slow callbacks.
+ *
+ * Sets how long a callback can take while profiling before it's logged as
+ * slow.  This defaults to the /purple/eventloop/slow_threshold preference.
+ */
+void purple_eventloop_set_slow_threshold(guint msec);
+
+/**
+ * purple_eventloop_get_slow_threshold:
+ *
+ * Returns: How long a callback can take, in milliseconds, before it's
+ *          logged as slow.
+ */
+guint purple_eventloop_get_slow_threshold(void);
+
+/**
+ * purple_eventloop_get_profile:
+ *
+ * Returns what has been recorded about each event loop callback, most time
+ * consuming first.  The profiles belong to libpurple and are updated in
+ * place, so they must not be kept across main loop iterations.
+ *
+ * Returns: (transfer container) (element-type PurpleEventLoopProfile): The
+ *          profiles.
+ */
+GList *purple_eventloop_get_profile(void);
+
+/**
+ * purple_eventloop_get_profile_report:
+ *
+ * Formats the event loop profile as a table, one callback per line.
+ *
+ * Returns: The report, which must be freed with g_free().
+ */
+char *purple_eventloop_get_profile_report(void);
+
+/**
+ * purple_eventloop_reset_profile:
+ *
+ * Forgets everything recorded so far.
+ */
+void purple_eventloop_reset_profile(void);
+
 
 
 /**************************************************************************/
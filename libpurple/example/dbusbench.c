@@ -0,0 +1,412 @@
+/*
+ * pidgin
+ *
+ * Pidgin is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ *
+ */
+
+/*
+ * dbusbench measures what forwarding libpurple's signals to D-Bus costs,
+ * with and without the /purple/dbus/filter_signals preference.  It takes
+ * purple's bus name as a UI would, registers a few signals of its own,
+ * emits them in a burst and counts how many a second connection listening
+ * for every purple signal receives, and how long that took.  It needs a bus
+ * of its own, so run it with a private one:
+ *
+ *   dbus-run-session -- ./dbusbench
+ */
+
+#define DBUS_API_SUBJECT_TO_CHANGE
+
+#include "purple.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <dbus/dbus.h>
+#include <dbus/dbus-glib-lowlevel.h>
+
+#include <stdio.h>
+
+#include "dbus-server.h"
+
+#define BENCH_UI_ID      "dbusbench"
+#define BENCH_DONE       "dbusbench-done"
+#define BENCH_DONE_DBUS  "DbusbenchDone"
+#define BENCH_MESSAGE    "Hello, this is about as long as a message usually is."
+
+/**
+ * The following eventloop functions are used in both pidgin and purple-text. If your
+ * application uses glib mainloop, you can safely use this verbatim.
+ */
+#define PURPLE_GLIB_READ_COND  (G_IO_IN | G_IO_HUP | G_IO_ERR)
+#define PURPLE_GLIB_WRITE_COND (G_IO_OUT | G_IO_HUP | G_IO_ERR | G_IO_NVAL)
+
+typedef struct _PurpleGLibIOClosure {
+	PurpleInputFunction function;
+	guint result;
+	gpointer data;
+} PurpleGLibIOClosure;
+
+static void purple_glib_io_destroy(gpointer data)
+{
+	g_free(data);
+}
+
+static gboolean purple_glib_io_invoke(GIOChannel *source, GIOCondition condition, gpointer data)
+{
+	PurpleGLibIOClosure *closure = data;
+	PurpleInputCondition purple_cond = 0;
+
+	if (condition & PURPLE_GLIB_READ_COND)
+		purple_cond |= PURPLE_INPUT_READ;
+	if (condition & PURPLE_GLIB_WRITE_COND)
+		purple_cond |= PURPLE_INPUT_WRITE;
+
+	closure->function(closure->data, g_io_channel_unix_get_fd(source),
+		purple_cond);
+
+	return TRUE;
+}
+
+static guint glib_input_add(gint fd, PurpleInputCondition condition,
+	PurpleInputFunction function, gpointer data)
+{
+	PurpleGLibIOClosure *closure = g_new0(PurpleGLibIOClosure, 1);
+	GIOChannel *channel;
+	GIOCondition cond = 0;
+
+	closure->function = function;
+	closure->data = data;
+
+	if (condition & PURPLE_INPUT_READ)
+		cond |= PURPLE_GLIB_READ_COND;
+	if (condition & PURPLE_INPUT_WRITE)
+		cond |= PURPLE_GLIB_WRITE_COND;
+
+#if defined _WIN32 && !defined WINPIDGIN_USE_GLIB_IO_CHANNEL
+	channel = wpurple_g_io_channel_win32_new_socket(fd);
+#else
+	channel = g_io_channel_unix_new(fd);
+#endif
+	closure->result = g_io_add_watch_full(channel, G_PRIORITY_DEFAULT,
+		cond, purple_glib_io_invoke, closure, purple_glib_io_destroy);
+
+	g_io_channel_unref(channel);
+	return closure->result;
+}
+
+static PurpleEventLoopUiOps glib_eventloops =
+{
+	g_timeout_add,
+	g_source_remove,
+	glib_input_add,
+	g_source_remove,
+	NULL,
+	g_timeout_add_seconds,
+
+	/* padding */
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+/*** End of the eventloop functions. ***/
+
+static PurpleCoreUiOps bench_core_uiops =
+{
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+
+	/* padding */
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+
+/*** Options ***/
+static gint opt_signals = 50000;
+static gint opt_kinds = 10;
+
+static GOptionEntry option_entries[] = {
+	{ "signals", 'n', 0, G_OPTION_ARG_INT, &opt_signals,
+	  "Number of signals to emit in each run", "N" },
+	{ "kinds", 'k', 0, G_OPTION_ARG_INT, &opt_kinds,
+	  "Number of different signals to spread them over", "N" },
+	{ NULL }
+};
+
+static int handle;
+static gchar **signal_names = NULL;
+static gchar *user_dir = NULL;
+
+/*** The listening client ***/
+static DBusConnection *client = NULL;
+static guint received = 0;
+static gboolean done = FALSE;
+
+/* Counts the purple signals; the rest of the bus isn't interesting. */
+static DBusHandlerResult
+client_filter(DBusConnection *connection, DBusMessage *message, void *data)
+{
+	if (dbus_message_get_type(message) != DBUS_MESSAGE_TYPE_SIGNAL ||
+			!dbus_message_has_interface(message, PURPLE_DBUS_INTERFACE))
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	if (dbus_message_has_member(message, BENCH_DONE_DBUS))
+		done = TRUE;
+	else
+		received++;
+
+	return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+/* Calls one of the subscription methods with a signal name.  Purple answers
+ * from this same main loop, so keep running it instead of blocking. */
+static gboolean
+client_call(const char *method, const char *name)
+{
+	DBusMessage *message, *reply;
+	DBusPendingCall *pending = NULL;
+	gboolean ok;
+
+	message = dbus_message_new_method_call(PURPLE_DBUS_SERVICE,
+			PURPLE_DBUS_PATH, PURPLE_DBUS_INTERFACE, method);
+	dbus_message_append_args(message, DBUS_TYPE_STRING, &name,
+			DBUS_TYPE_INVALID);
+	ok = dbus_connection_send_with_reply(client, message, &pending, -1);
+	dbus_message_unref(message);
+	if (!ok || pending == NULL)
+		return FALSE;
+
+	while (!dbus_pending_call_get_completed(pending))
+		g_main_context_iteration(NULL, TRUE);
+
+	reply = dbus_pending_call_steal_reply(pending);
+	ok = dbus_message_get_type(reply) == DBUS_MESSAGE_TYPE_METHOD_RETURN;
+	dbus_message_unref(reply);
+	dbus_pending_call_unref(pending);
+
+	return ok;
+}
+
+static gboolean
+client_connect(void)
+{
+	DBusError error;
+
+	dbus_error_init(&error);
+	client = dbus_bus_get_private(DBUS_BUS_SESSION, &error);
+	if (client == NULL) {
+		fprintf(stderr, "Can't connect to the bus: %s\n", error.message);
+		dbus_error_free(&error);
+		return FALSE;
+	}
+	dbus_connection_set_exit_on_disconnect(client, FALSE);
+	dbus_connection_setup_with_g_main(client, NULL);
+
+	/* Listen the way clients that predate the subscriptions do: for
+	 * every signal purple sends. */
+	dbus_bus_add_match(client, "type='signal',interface='"
+			PURPLE_DBUS_INTERFACE "'", &error);
+	if (dbus_error_is_set(&error)) {
+		fprintf(stderr, "Can't add a match rule: %s\n", error.message);
+		dbus_error_free(&error);
+		return FALSE;
+	}
+	dbus_connection_add_filter(client, client_filter, NULL, NULL);
+
+	/* The end of each run is always wanted. */
+	return client_call("PurpleDbusSubscribeSignal", BENCH_DONE_DBUS);
+}
+
+static void
+client_disconnect(void)
+{
+	if (client == NULL)
+		return;
+
+	dbus_connection_close(client);
+	dbus_connection_unref(client);
+	client = NULL;
+}
+
+/*** Runs ***/
+static void
+register_signals(void)
+{
+	gint i;
+
+	signal_names = g_new0(gchar *, opt_kinds + 1);
+	for (i = 0; i < opt_kinds; i++) {
+		signal_names[i] = g_strdup_printf("dbusbench-signal-%d", i);
+		purple_signal_register(&handle, signal_names[i],
+			purple_marshal_VOID__POINTER_POINTER, G_TYPE_NONE, 2,
+			G_TYPE_STRING, G_TYPE_STRING);
+	}
+
+	purple_signal_register(&handle, BENCH_DONE, purple_marshal_VOID,
+		G_TYPE_NONE, 0);
+}
+
+/* Emits the signals and waits until the client heard the last one.
+ * subscription is the D-Bus name of the signal the client subscribes to for
+ * the run, if any. */
+static void
+run(const char *label, gboolean filter, const char *subscription)
+{
+	gint64 start, emitted, delivered;
+	gint i;
+
+	purple_prefs_set_bool("/purple/dbus/filter_signals", filter);
+	if (subscription != NULL)
+		client_call("PurpleDbusSubscribeSignal", subscription);
+
+	received = 0;
+	done = FALSE;
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < opt_signals; i++)
+		purple_signal_emit(&handle, signal_names[i % opt_kinds], "dbusbench",
+			BENCH_MESSAGE);
+	emitted = g_get_monotonic_time();
+
+	/* The bus keeps the order of one sender's messages, so this arrives
+	 * last. */
+	purple_signal_emit(&handle, BENCH_DONE);
+	while (!done)
+		g_main_context_iteration(NULL, TRUE);
+	delivered = g_get_monotonic_time();
+
+	if (subscription != NULL)
+		client_call("PurpleDbusUnsubscribeSignal", subscription);
+
+	printf("%-24s received %8u, emit %8.1f ms (%.2f us/signal), "
+		"delivered %8.1f ms\n", label, received,
+		(emitted - start) / 1000.0,
+		(gdouble)(emitted - start) / opt_signals,
+		(delivered - start) / 1000.0);
+}
+
+/* Removes the temporary user directory and everything in it. */
+static void
+remove_dir(const gchar *path)
+{
+	GDir *dir;
+	const gchar *name;
+
+	if ((dir = g_dir_open(path, 0, NULL)) != NULL) {
+		while ((name = g_dir_read_name(dir)) != NULL) {
+			gchar *child = g_build_filename(path, name, NULL);
+
+			if (g_file_test(child, G_FILE_TEST_IS_DIR) &&
+					!g_file_test(child, G_FILE_TEST_IS_SYMLINK))
+				remove_dir(child);
+			else
+				g_remove(child);
+			g_free(child);
+		}
+		g_dir_close(dir);
+	}
+
+	g_rmdir(path);
+}
+
+static void
+quit(void)
+{
+	client_disconnect();
+	purple_signals_unregister_by_instance(&handle);
+	purple_core_quit();
+	remove_dir(user_dir);
+	g_free(user_dir);
+	g_strfreev(signal_names);
+}
+
+int main(int argc, char *argv[])
+{
+	GOptionContext *context;
+	GError *error = NULL;
+
+	context = g_option_context_new(NULL);
+	g_option_context_set_summary(context,
+		"Measures forwarding purple signals to D-Bus, with and without "
+		"filtering them.\nRun it under dbus-run-session.");
+	g_option_context_add_main_entries(context, option_entries, NULL);
+	if (!g_option_context_parse(context, &argc, &argv, &error)) {
+		fprintf(stderr, "%s\n", error->message);
+		g_error_free(error);
+		return 1;
+	}
+	g_option_context_free(context);
+
+	if (opt_signals < 1 || opt_kinds < 1) {
+		fprintf(stderr, "--signals and --kinds must be at least 1.\n");
+		return 1;
+	}
+
+	/* Keep the preferences this changes away from the real ones. */
+	user_dir = g_dir_make_tmp("dbusbench-XXXXXX", &error);
+	if (user_dir == NULL) {
+		fprintf(stderr, "%s\n", error->message);
+		g_error_free(error);
+		return 1;
+	}
+	purple_util_set_user_dir(user_dir);
+
+	purple_debug_set_enabled(FALSE);
+	purple_core_set_ui_ops(&bench_core_uiops);
+	purple_eventloop_set_ui_ops(&glib_eventloops);
+
+	if (!purple_core_init(BENCH_UI_ID)) {
+		fprintf(stderr, "libpurple initialization failed.\n");
+		remove_dir(user_dir);
+		return 1;
+	}
+
+	/* The client calls purple by its bus name, so that has to be ours. */
+	if (purple_dbus_get_init_error() != NULL || !purple_dbus_is_owner()) {
+		fprintf(stderr, "%s\nRun dbusbench on a bus of its own, with "
+			"dbus-run-session.\n", purple_dbus_get_init_error() != NULL ?
+			purple_dbus_get_init_error() :
+			"Another client owns " PURPLE_DBUS_SERVICE ".");
+		quit();
+		return 1;
+	}
+
+	register_signals();
+	if (!client_connect()) {
+		quit();
+		return 1;
+	}
+
+	printf("dbusbench: %d signals over %d kinds\n", opt_signals, opt_kinds);
+	run("unfiltered", FALSE, NULL);
+	run("filtered, unsubscribed", TRUE, NULL);
+	run("filtered, one kind", TRUE, "DbusbenchSignal0");
+	run("filtered, every kind", TRUE, "*");
+
+	quit();
+
+	return 0;
+}
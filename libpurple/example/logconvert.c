@@ -0,0 +1,295 @@
+/*
+ * pidgin
+ *
+ * Pidgin is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ *
+ */
+
+/*
+ * logconvert rewrites the logs in a user directory with another logger, for
+ * example the html logs of every account as binary logs, or binary logs as
+ * html so they can be read without the binary logger.  Each new log has the
+ * same time as the old one, so it sits next to it, and the old one is left
+ * alone.  Logs that were converted before are skipped.  Don't run it on a
+ * user directory a client is using.
+ */
+
+#include "purple.h"
+
+#include <glib.h>
+
+#include <stdio.h>
+
+#define CONVERT_UI_ID "logconvert"
+
+/**
+ * The following eventloop functions are used in both pidgin and purple-text. If your
+ * application uses glib mainloop, you can safely use this verbatim.
+ */
+#define PURPLE_GLIB_READ_COND  (G_IO_IN | G_IO_HUP | G_IO_ERR)
+#define PURPLE_GLIB_WRITE_COND (G_IO_OUT | G_IO_HUP | G_IO_ERR | G_IO_NVAL)
+
+typedef struct _PurpleGLibIOClosure {
+	PurpleInputFunction function;
+	guint result;
+	gpointer data;
+} PurpleGLibIOClosure;
+
+static void purple_glib_io_destroy(gpointer data)
+{
+	g_free(data);
+}
+
+static gboolean purple_glib_io_invoke(GIOChannel *source, GIOCondition condition, gpointer data)
+{
+	PurpleGLibIOClosure *closure = data;
+	PurpleInputCondition purple_cond = 0;
+
+	if (condition & PURPLE_GLIB_READ_COND)
+		purple_cond |= PURPLE_INPUT_READ;
+	if (condition & PURPLE_GLIB_WRITE_COND)
+		purple_cond |= PURPLE_INPUT_WRITE;
+
+	closure->function(closure->data, g_io_channel_unix_get_fd(source),
+		purple_cond);
+
+	return TRUE;
+}
+
+static guint glib_input_add(gint fd, PurpleInputCondition condition,
+	PurpleInputFunction function, gpointer data)
+{
+	PurpleGLibIOClosure *closure = g_new0(PurpleGLibIOClosure, 1);
+	GIOChannel *channel;
+	GIOCondition cond = 0;
+
+	closure->function = function;
+	closure->data = data;
+
+	if (condition & PURPLE_INPUT_READ)
+		cond |= PURPLE_GLIB_READ_COND;
+	if (condition & PURPLE_INPUT_WRITE)
+		cond |= PURPLE_GLIB_WRITE_COND;
+
+#if defined _WIN32 && !defined WINPIDGIN_USE_GLIB_IO_CHANNEL
+	channel = wpurple_g_io_channel_win32_new_socket(fd);
+#else
+	channel = g_io_channel_unix_new(fd);
+#endif
+	closure->result = g_io_add_watch_full(channel, G_PRIORITY_DEFAULT,
+		cond, purple_glib_io_invoke, closure, purple_glib_io_destroy);
+
+	g_io_channel_unref(channel);
+	return closure->result;
+}
+
+static PurpleEventLoopUiOps glib_eventloops =
+{
+	g_timeout_add,
+	g_source_remove,
+	glib_input_add,
+	g_source_remove,
+	NULL,
+	g_timeout_add_seconds,
+
+	/* padding */
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+/*** End of the eventloop functions. ***/
+
+static PurpleCoreUiOps convert_core_uiops =
+{
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+
+	/* padding */
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+
+/*** Options ***/
+static gchar *opt_from = NULL;
+static gchar *opt_to = NULL;
+static gchar *opt_user_dir = NULL;
+static gchar *opt_plugin_path = NULL;
+static gboolean opt_verbose = FALSE;
+
+static GOptionEntry option_entries[] = {
+	{ "from", 'f', 0, G_OPTION_ARG_STRING, &opt_from,
+	  "Convert the logs written by this logger (default: html)", "html|txt|binary" },
+	{ "to", 't', 0, G_OPTION_ARG_STRING, &opt_to,
+	  "Write them with this logger (default: binary)", "html|txt|binary" },
+	{ "user-dir", 'u', 0, G_OPTION_ARG_FILENAME, &opt_user_dir,
+	  "Use this user directory instead of the default one", "DIR" },
+	{ "plugin-path", 'P', 0, G_OPTION_ARG_FILENAME, &opt_plugin_path,
+	  "Also look for protocols in this directory", "DIR" },
+	{ "verbose", 'v', 0, G_OPTION_ARG_NONE, &opt_verbose,
+	  "Say which logs are converted", NULL },
+	{ NULL }
+};
+
+static guint converted = 0;
+static guint skipped = 0;
+static guint failed = 0;
+static guint no_account = 0;
+
+/* Returns whether there's a log written by logger with the same time as
+ * the one at l.  Logs are sorted by time, so it would be next to it. */
+static gboolean
+has_converted_log(GList *l, PurpleLogLogger *logger)
+{
+	PurpleLog *log = l->data;
+	GList *m;
+
+	for (m = l->prev; m != NULL && ((PurpleLog *)m->data)->time == log->time; m = m->prev)
+		if (((PurpleLog *)m->data)->logger == logger)
+			return TRUE;
+
+	for (m = l->next; m != NULL && ((PurpleLog *)m->data)->time == log->time; m = m->next)
+		if (((PurpleLog *)m->data)->logger == logger)
+			return TRUE;
+
+	return FALSE;
+}
+
+static void
+convert_log_set(PurpleLogSet *set, PurpleLogLogger *from, PurpleLogLogger *to)
+{
+	GList *logs, *l;
+
+	/* Without the account, the logs of the set can't be found. */
+	if (set->account == NULL) {
+		no_account++;
+		return;
+	}
+
+	logs = purple_log_get_logs(set->type, set->name, set->account);
+
+	for (l = logs; l != NULL; l = l->next) {
+		PurpleLog *log = l->data;
+		PurpleLog *copy;
+
+		if (log->logger != from)
+			continue;
+
+		if (has_converted_log(l, to)) {
+			skipped++;
+			continue;
+		}
+
+		copy = purple_log_convert(log, to);
+		if (copy == NULL) {
+			failed++;
+			fprintf(stderr, "Could not convert a log of %s on %s from %s\n",
+				set->name, purple_account_get_username(set->account),
+				purple_date_format_full(localtime(&log->time)));
+			continue;
+		}
+
+		converted++;
+		if (opt_verbose)
+			printf("%s on %s: %s\n", set->name,
+				purple_account_get_username(set->account),
+				purple_date_format_full(localtime(&log->time)));
+		purple_log_free(copy);
+	}
+
+	g_list_free_full(logs, (GDestroyNotify)purple_log_free);
+}
+
+int main(int argc, char *argv[])
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	PurpleLogLogger *from, *to;
+	GHashTable *sets;
+	GHashTableIter iter;
+	PurpleLogSet *set;
+
+	context = g_option_context_new(NULL);
+	g_option_context_set_summary(context,
+		"Rewrites the logs in a user directory with another logger.");
+	g_option_context_add_main_entries(context, option_entries, NULL);
+	if (!g_option_context_parse(context, &argc, &argv, &error)) {
+		fprintf(stderr, "%s\n", error->message);
+		g_error_free(error);
+		return 1;
+	}
+	g_option_context_free(context);
+
+	if (opt_from == NULL)
+		opt_from = g_strdup("html");
+	if (opt_to == NULL)
+		opt_to = g_strdup("binary");
+
+	if (opt_user_dir != NULL)
+		purple_util_set_user_dir(opt_user_dir);
+
+	purple_debug_set_enabled(FALSE);
+	purple_core_set_ui_ops(&convert_core_uiops);
+	purple_eventloop_set_ui_ops(&glib_eventloops);
+
+	if (!purple_core_init(CONVERT_UI_ID)) {
+		fprintf(stderr, "libpurple initialization failed.\n");
+		return 1;
+	}
+
+	/* The protocols say which directory each account's logs are in. */
+	if (opt_plugin_path != NULL)
+		purple_plugins_add_search_path(opt_plugin_path);
+	purple_plugins_refresh();
+	purple_prefs_load();
+
+	from = purple_log_logger_find(opt_from);
+	to = purple_log_logger_find(opt_to);
+	if (from == NULL || to == NULL || to->write == NULL || from == to) {
+		fprintf(stderr, "Can't convert logs from %s to %s.\n", opt_from, opt_to);
+		purple_core_quit();
+		return 1;
+	}
+
+	sets = purple_log_get_log_sets();
+	g_hash_table_iter_init(&iter, sets);
+	while (g_hash_table_iter_next(&iter, (gpointer *)&set, NULL))
+		convert_log_set(set, from, to);
+	g_hash_table_destroy(sets);
+
+	purple_core_quit();
+
+	printf("Converted %u %s logs to %s, skipped %u converted before.\n",
+		converted, opt_from, opt_to, skipped);
+	if (no_account > 0)
+		printf("Skipped the logs of %u conversations with no account.\n",
+			no_account);
+	if (failed > 0)
+		printf("Could not convert %u logs.\n", failed);
+
+	g_free(opt_from);
+	g_free(opt_to);
+
+	return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,230 @@
+/*
+ * pidgin
+ *
+ * Pidgin is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ *
+ */
+
+/*
+ * mediabench pushes application data through the media manager, from the
+ * appsrc of one PURPLE_MEDIA_APPLICATION session straight into the appsink
+ * of another, and prints how fast it went with the calls that copy the data
+ * and with the _bytes() ones that lend it.  The media has no backend and
+ * nothing sits between the two elements, so the numbers are what libpurple
+ * and GStreamer cost, not what a network would.
+ */
+
+#include <config.h>
+
+#include "purple.h"
+#include "media-gst.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define TOTAL   (256 * 1024 * 1024)  /* bytes through each run */
+#define WINDOW  32                   /* buffers sent before reading them back */
+
+#ifdef HAVE_MEDIA_APPLICATION
+static const gsize sizes[] = { 1024, 16 * 1024, 256 * 1024 };
+
+static PurpleEventLoopUiOps bench_eventloop = {
+	g_timeout_add,
+	g_source_remove,
+	NULL,
+	NULL,
+	NULL,
+	g_timeout_add_seconds,
+
+	/* padding */
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+
+static gint64
+elapsed(gint64 start)
+{
+	return g_get_monotonic_time() - start;
+}
+
+/* Bytes per microsecond are megabytes per second. */
+static gdouble
+throughput(guint count, gsize size, gint64 time)
+{
+	return time > 0 ? (gdouble)count * size / time : 0.0;
+}
+
+static gint64
+run_copy(PurpleMediaManager *manager, PurpleMedia *media, gsize size)
+{
+	guint8 *out = g_malloc(size);
+	guint8 *in = g_malloc(size);
+	guint count = TOTAL / size;
+	guint i, j, window;
+	gint64 start;
+
+	memset(out, 'x', size);
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < count; i += window) {
+		window = MIN(WINDOW, count - i);
+		for (j = 0; j < window; j++)
+			if (purple_media_manager_send_application_data(manager, media,
+					"send", "buddy", out, size, FALSE) != (gint)size)
+				goto error;
+		for (j = 0; j < window; j++)
+			if (purple_media_manager_receive_application_data(manager, media,
+					"receive", "buddy", in, size, TRUE) != (gint)size)
+				goto error;
+	}
+
+	g_free(out);
+	g_free(in);
+	return elapsed(start);
+
+error:
+	g_free(out);
+	g_free(in);
+	return -1;
+}
+
+static gint64
+run_bytes(PurpleMediaManager *manager, PurpleMedia *media, gsize size)
+{
+	guint8 *data = g_malloc(size);
+	GBytes *out;
+	guint count = TOTAL / size;
+	guint i, j, window;
+	gint64 start;
+
+	memset(data, 'x', size);
+	out = g_bytes_new_take(data, size);
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < count; i += window) {
+		window = MIN(WINDOW, count - i);
+		for (j = 0; j < window; j++)
+			if (purple_media_manager_send_application_data_bytes(manager,
+					media, "send", "buddy", out, FALSE) != (gint)size)
+				goto error;
+		for (j = 0; j < window; j++) {
+			GBytes *in = purple_media_manager_receive_application_data_bytes(
+				manager, media, "receive", "buddy", TRUE);
+			gsize received = in != NULL ? g_bytes_get_size(in) : 0;
+
+			if (in != NULL)
+				g_bytes_unref(in);
+			if (received != size)
+				goto error;
+		}
+	}
+
+	g_bytes_unref(out);
+	return elapsed(start);
+
+error:
+	g_bytes_unref(out);
+	return -1;
+}
+#endif /* HAVE_MEDIA_APPLICATION */
+
+int main(int argc, char *argv[])
+{
+#ifdef HAVE_MEDIA_APPLICATION
+	PurpleMediaManager *manager;
+	PurpleMedia *media;
+	GstElement *pipeline, *appsrc, *appsink;
+	gchar *user_dir;
+	gint64 copy, bytes;
+	guint i;
+
+	gst_init(&argc, &argv);
+
+	/* The media manager keeps its preferences in the user directory, so
+	 * give it an empty one. */
+	user_dir = g_dir_make_tmp("mediabench-XXXXXX", NULL);
+	if (user_dir == NULL) {
+		fprintf(stderr, "Can't make a user directory.\n");
+		return 1;
+	}
+	purple_util_set_user_dir(user_dir);
+	purple_eventloop_set_ui_ops(&bench_eventloop);
+	purple_prefs_init();
+
+	manager = purple_media_manager_get();
+	media = g_object_new(PURPLE_TYPE_MEDIA, "manager", manager, NULL);
+
+	pipeline = purple_media_manager_get_pipeline(manager);
+	appsrc = purple_media_manager_get_element(manager,
+		PURPLE_MEDIA_SEND_APPLICATION, media, "send", "buddy");
+	appsink = purple_media_manager_get_element(manager,
+		PURPLE_MEDIA_RECV_APPLICATION, media, "receive", "buddy");
+	if (appsrc == NULL || appsink == NULL) {
+		fprintf(stderr, "Can't make the application data elements.\n");
+		g_rmdir(user_dir);
+		g_free(user_dir);
+		return 1;
+	}
+
+	gst_bin_add(GST_BIN(pipeline), appsink);
+	gst_element_link(appsrc, appsink);
+	gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+	/* Nothing is sent until the session is connected. */
+	g_signal_emit_by_name(media, "candidate-pair-established",
+		"send", "buddy", NULL, NULL);
+
+	printf("%d MiB per run, %d buffers in flight\n",
+		TOTAL / (1024 * 1024), WINDOW);
+
+	for (i = 0; i < G_N_ELEMENTS(sizes); i++) {
+		guint count = TOTAL / sizes[i];
+
+		copy = run_copy(manager, media, sizes[i]);
+		bytes = run_bytes(manager, media, sizes[i]);
+		if (copy < 0 || bytes < 0) {
+			fprintf(stderr, "Sending %" G_GSIZE_FORMAT " byte buffers "
+				"failed.\n", sizes[i]);
+			break;
+		}
+
+		printf("%6" G_GSIZE_FORMAT " byte buffers: copy %8.1f MB/s, "
+			"bytes %8.1f MB/s\n", sizes[i],
+			throughput(count, sizes[i], copy),
+			throughput(count, sizes[i], bytes));
+	}
+
+	gst_element_set_state(pipeline, GST_STATE_NULL);
+	gst_object_unref(appsrc);
+	g_object_unref(media);
+
+	g_rmdir(user_dir);
+	g_free(user_dir);
+
+	return i == G_N_ELEMENTS(sizes) ? 0 : 1;
+#else
+	fprintf(stderr, "libpurple was built without application media.\n");
+	return 1;
+#endif
+}
@@ -0,0 +1,621 @@
+/*
+ * pidgin
+ *
+ * Pidgin is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ *
+ */
+
+/*
+ * nullbench signs on a nullprpl account with its load generator turned on
+ * (see null_load_start() in libpurple/protocols/null/nullprpl.c), lets it
+ * run for a while, and reports how much the core got through: messages and
+ * presence changes per second, how late the main loop ran, and how much
+ * memory it took.  Nothing is displayed, so the numbers are libpurple's own.
+ *
+ * With --compare-loggers, it instead writes the same conversation with the
+ * html and binary loggers and reports how long each took to write and read
+ * back, and how much disk it took.
+ */
+
+#include "purple.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#  include <sys/resource.h>
+#  include <unistd.h>
+#endif
+#ifdef __GLIBC__
+#  include <malloc.h>
+#endif
+
+#include "defines.h"
+
+#define BENCH_UI_ID           "nullbench"
+#define BENCH_PROBE_INTERVAL  10  /* milliseconds */
+
+/**
+ * The following eventloop functions are used in both pidgin and purple-text. If your
+ * application uses glib mainloop, you can safely use this verbatim.
+ */
+#define PURPLE_GLIB_READ_COND  (G_IO_IN | G_IO_HUP | G_IO_ERR)
+#define PURPLE_GLIB_WRITE_COND (G_IO_OUT | G_IO_HUP | G_IO_ERR | G_IO_NVAL)
+
+typedef struct _PurpleGLibIOClosure {
+	PurpleInputFunction function;
+	guint result;
+	gpointer data;
+} PurpleGLibIOClosure;
+
+static void purple_glib_io_destroy(gpointer data)
+{
+	g_free(data);
+}
+
+static gboolean purple_glib_io_invoke(GIOChannel *source, GIOCondition condition, gpointer data)
+{
+	PurpleGLibIOClosure *closure = data;
+	PurpleInputCondition purple_cond = 0;
+
+	if (condition & PURPLE_GLIB_READ_COND)
+		purple_cond |= PURPLE_INPUT_READ;
+	if (condition & PURPLE_GLIB_WRITE_COND)
+		purple_cond |= PURPLE_INPUT_WRITE;
+
+	closure->function(closure->data, g_io_channel_unix_get_fd(source),
+		purple_cond);
+
+	return TRUE;
+}
+
+static guint glib_input_add(gint fd, PurpleInputCondition condition,
+	PurpleInputFunction function, gpointer data)
+{
+	PurpleGLibIOClosure *closure = g_new0(PurpleGLibIOClosure, 1);
+	GIOChannel *channel;
+	GIOCondition cond = 0;
+
+	closure->function = function;
+	closure->data = data;
+
+	if (condition & PURPLE_INPUT_READ)
+		cond |= PURPLE_GLIB_READ_COND;
+	if (condition & PURPLE_INPUT_WRITE)
+		cond |= PURPLE_GLIB_WRITE_COND;
+
+#if defined _WIN32 && !defined WINPIDGIN_USE_GLIB_IO_CHANNEL
+	channel = wpurple_g_io_channel_win32_new_socket(fd);
+#else
+	channel = g_io_channel_unix_new(fd);
+#endif
+	closure->result = g_io_add_watch_full(channel, G_PRIORITY_DEFAULT,
+		cond, purple_glib_io_invoke, closure, purple_glib_io_destroy);
+
+	g_io_channel_unref(channel);
+	return closure->result;
+}
+
+static PurpleEventLoopUiOps glib_eventloops =
+{
+	g_timeout_add,
+	g_source_remove,
+	glib_input_add,
+	g_source_remove,
+	NULL,
+	g_timeout_add_seconds,
+
+	/* padding */
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+/*** End of the eventloop functions. ***/
+
+static PurpleCoreUiOps bench_core_uiops =
+{
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+
+	/* padding */
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+
+/*** Options ***/
+static gint opt_buddies = 1000;
+static gint opt_presence_rate = 200;
+static gint opt_im_rate = 50;
+static gint opt_chat_size = 100;
+static gint opt_chat_rate = 50;
+static gint opt_duration = 30;
+static gboolean opt_logging = FALSE;
+static gchar *opt_user_dir = NULL;
+static gchar *opt_plugin_path = NULL;
+static gboolean opt_compare_loggers = FALSE;
+static gint opt_log_messages = 50000;
+
+static gboolean temporary_user_dir = FALSE;
+
+static GOptionEntry option_entries[] = {
+	{ "buddies", 'b', 0, G_OPTION_ARG_INT, &opt_buddies,
+	  "Number of synthetic buddies", "N" },
+	{ "presence-rate", 'p', 0, G_OPTION_ARG_INT, &opt_presence_rate,
+	  "Presence changes per second", "N" },
+	{ "im-rate", 'i', 0, G_OPTION_ARG_INT, &opt_im_rate,
+	  "IMs received per second", "N" },
+	{ "chat-size", 's', 0, G_OPTION_ARG_INT, &opt_chat_size,
+	  "Number of users in the chat room", "N" },
+	{ "chat-rate", 'c', 0, G_OPTION_ARG_INT, &opt_chat_rate,
+	  "Chat messages received per second", "N" },
+	{ "duration", 'd', 0, G_OPTION_ARG_INT, &opt_duration,
+	  "How long to run for, in seconds", "SECONDS" },
+	{ "logging", 'l', 0, G_OPTION_ARG_NONE, &opt_logging,
+	  "Log the conversations", NULL },
+	{ "user-dir", 'u', 0, G_OPTION_ARG_FILENAME, &opt_user_dir,
+	  "Use this user directory instead of a new temporary one", "DIR" },
+	{ "plugin-path", 'P', 0, G_OPTION_ARG_FILENAME, &opt_plugin_path,
+	  "Also look for nullprpl in this directory", "DIR" },
+	{ "compare-loggers", 'L', 0, G_OPTION_ARG_NONE, &opt_compare_loggers,
+	  "Compare the html and binary loggers instead", NULL },
+	{ "log-messages", 'm', 0, G_OPTION_ARG_INT, &opt_log_messages,
+	  "Number of messages to log when comparing loggers", "N" },
+	{ NULL }
+};
+
+/*** Measurements ***/
+static guint received_ims = 0;
+static guint received_chats = 0;
+static guint status_changes = 0;
+
+static gint64 enabled_time = 0;
+static gint64 start_time = 0;
+static gsize start_heap = 0;
+static gsize start_rss = 0;
+
+static GArray *latencies = NULL;  /* of gint64, in microseconds */
+static gint64 probe_due = 0;
+static guint probe_timer = 0;
+
+/* Returns the number of bytes the C library has handed out, or 0 if that
+ * can't be told. */
+static gsize
+heap_in_use(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	struct mallinfo2 info = mallinfo2();
+
+	return info.uordblks + info.hblkhd;
+#elif defined(__GLIBC__)
+	struct mallinfo info = mallinfo();
+
+	return (unsigned int)info.uordblks + (unsigned int)info.hblkhd;
+#else
+	return 0;
+#endif
+}
+
+/* Returns the resident set size in bytes, or 0 if it can't be told. */
+static gsize
+resident_set_size(void)
+{
+#ifdef __linux__
+	gchar *contents;
+	gsize pages = 0;
+
+	if (g_file_get_contents("/proc/self/statm", &contents, NULL, NULL)) {
+		sscanf(contents, "%*s %" G_GSIZE_FORMAT, &pages);
+		g_free(contents);
+	}
+
+	return pages * sysconf(_SC_PAGESIZE);
+#else
+	return 0;
+#endif
+}
+
+/* Returns the largest the resident set has been, in KiB, or 0. */
+static glong
+peak_resident_set_size(void)
+{
+#if defined(__linux__)
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+		return usage.ru_maxrss;
+#endif
+	return 0;
+}
+
+static gboolean
+probe_cb(gpointer data)
+{
+	gint64 now = g_get_monotonic_time();
+	gint64 late = MAX(now - probe_due, 0);
+
+	g_array_append_val(latencies, late);
+	probe_due = now + BENCH_PROBE_INTERVAL * 1000;
+
+	return TRUE;
+}
+
+static gint
+compare_latencies(gconstpointer a, gconstpointer b)
+{
+	gint64 x = *(const gint64 *)a;
+	gint64 y = *(const gint64 *)b;
+
+	return (x > y) - (x < y);
+}
+
+static double
+latency_percentile(int percentile)
+{
+	if (latencies->len == 0)
+		return 0;
+
+	return g_array_index(latencies, gint64,
+		(latencies->len - 1) * percentile / 100) / 1000.0;
+}
+
+static void
+received_im_cb(PurpleAccount *account, const char *sender,
+	const char *message, PurpleIMConversation *im, PurpleMessageFlags flags)
+{
+	received_ims++;
+}
+
+static void
+received_chat_cb(PurpleAccount *account, const char *sender,
+	const char *message, PurpleChatConversation *chat,
+	PurpleMessageFlags flags)
+{
+	received_chats++;
+}
+
+static void
+buddy_status_changed_cb(PurpleBuddy *buddy, PurpleStatus *old_status,
+	PurpleStatus *status)
+{
+	status_changes++;
+}
+
+static gboolean
+finish_cb(gpointer data)
+{
+	GMainLoop *loop = data;
+	double elapsed = (g_get_monotonic_time() - start_time) / (double)G_USEC_PER_SEC;
+	gsize heap = heap_in_use();
+	gsize rss = resident_set_size();
+
+	g_source_remove(probe_timer);
+	g_array_sort(latencies, compare_latencies);
+
+	printf("nullbench: %d buddies, %d presence changes/s, %d IMs/s, "
+		"%d chat messages/s in a room of %d, logging %s\n",
+		opt_buddies, opt_presence_rate, opt_im_rate, opt_chat_rate,
+		opt_chat_size, opt_logging ? "on" : "off");
+	printf("sign-on:   %.1f ms\n", (start_time - enabled_time) / 1000.0);
+	printf("run:       %.1f s\n", elapsed);
+	printf("IMs:       %u (%.1f/s)\n", received_ims, received_ims / elapsed);
+	printf("chat:      %u (%.1f/s)\n", received_chats, received_chats / elapsed);
+	printf("presence:  %u (%.1f/s)\n", status_changes, status_changes / elapsed);
+	printf("latency:   p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms "
+		"(%u samples)\n",
+		latency_percentile(50), latency_percentile(90),
+		latency_percentile(99), latency_percentile(100), latencies->len);
+	printf("heap:      %" G_GSIZE_FORMAT " KiB in use, %+" G_GINT64_FORMAT
+		" KiB while running\n", heap / 1024,
+		((gint64)heap - (gint64)start_heap) / 1024);
+	printf("rss:       %" G_GSIZE_FORMAT " KiB, %+" G_GINT64_FORMAT
+		" KiB while running, peak %ld KiB\n", rss / 1024,
+		((gint64)rss - (gint64)start_rss) / 1024, peak_resident_set_size());
+
+	g_main_loop_quit(loop);
+
+	return FALSE;
+}
+
+static gboolean
+start_cb(gpointer data)
+{
+	start_time = g_get_monotonic_time();
+	start_heap = heap_in_use();
+	start_rss = resident_set_size();
+
+	probe_due = start_time + BENCH_PROBE_INTERVAL * 1000;
+	probe_timer = g_timeout_add(BENCH_PROBE_INTERVAL, probe_cb, NULL);
+
+	g_timeout_add_seconds(opt_duration, finish_cb, data);
+
+	return FALSE;
+}
+
+/* Returns the size of the files in a directory. */
+static goffset
+dir_size(const gchar *path)
+{
+	GDir *dir;
+	const gchar *name;
+	goffset size = 0;
+
+	if ((dir = g_dir_open(path, 0, NULL)) == NULL)
+		return 0;
+
+	while ((name = g_dir_read_name(dir)) != NULL) {
+		gchar *child = g_build_filename(path, name, NULL);
+		GStatBuf st;
+
+		if (g_stat(child, &st) == 0 && S_ISREG(st.st_mode))
+			size += st.st_size;
+		g_free(child);
+	}
+	g_dir_close(dir);
+
+	return size;
+}
+
+/* Writes a conversation with a logger, then reads it back all at once and
+ * a page at a time, the way the log viewer does. */
+static void
+bench_logger(PurpleAccount *account, const gchar *id, gchar **messages)
+{
+	gchar *name = g_strdup_printf("logbench-%s", id);
+	time_t base = time(NULL) - opt_log_messages - 3600;
+	PurpleLog *log;
+	PurpleLogReader *reader;
+	GList *logs, *l;
+	gint64 start, write_time, read_time, page_time;
+	gchar *text, *dir;
+	gsize count = 0, first;
+	gint i;
+
+	purple_prefs_set_string("/purple/logging/format", id);
+	log = purple_log_new(PURPLE_LOG_IM, name, account, NULL, base, NULL);
+
+	/* Freeing the log closes it, which is when the binary logger writes
+	 * its index. */
+	start = g_get_monotonic_time();
+	for (i = 0; i < opt_log_messages; i++) {
+		purple_log_write(log,
+			(i % 2) ? PURPLE_MESSAGE_SEND : PURPLE_MESSAGE_RECV,
+			(i % 2) ? "nullbench" : name, base + i, messages[i]);
+	}
+	purple_log_free(log);
+	write_time = g_get_monotonic_time() - start;
+
+	log = NULL;
+	logs = purple_log_get_logs(PURPLE_LOG_IM, name, account);
+	for (l = logs; l != NULL; l = l->next) {
+		if (purple_strequal(((PurpleLog *)l->data)->logger->id, id))
+			log = l->data;
+	}
+	if (log == NULL) {
+		fprintf(stderr, "The %s log wasn't found.\n", id);
+		g_list_free_full(logs, (GDestroyNotify)purple_log_free);
+		g_free(name);
+		return;
+	}
+
+	start = g_get_monotonic_time();
+	text = purple_log_read(log, NULL);
+	read_time = g_get_monotonic_time() - start;
+	g_free(text);
+
+	start = g_get_monotonic_time();
+	reader = purple_log_reader_new(log);
+	count = purple_log_reader_get_count(reader);
+	for (first = 0; first < count; first += 100) {
+		text = purple_log_reader_read(reader, first, 100, NULL);
+		g_free(text);
+	}
+	purple_log_reader_free(reader);
+	page_time = g_get_monotonic_time() - start;
+
+	dir = purple_log_get_log_dir(PURPLE_LOG_IM, name, account);
+
+	printf("%-8s write %8.1f ms, read %8.1f ms, paged read %8.1f ms "
+		"(%" G_GSIZE_FORMAT " messages), %8" G_GINT64_FORMAT " KiB on disk\n",
+		id, write_time / 1000.0, read_time / 1000.0, page_time / 1000.0,
+		count, (gint64)dir_size(dir) / 1024);
+
+	g_free(dir);
+	g_list_free_full(logs, (GDestroyNotify)purple_log_free);
+	g_free(name);
+}
+
+static void
+compare_loggers(PurpleAccount *account)
+{
+	gchar *format = g_strdup(purple_prefs_get_string("/purple/logging/format"));
+	gchar **messages = g_new0(gchar *, opt_log_messages + 1);
+	gint i;
+
+	/* The same messages for both, made before anything is timed */
+	for (i = 0; i < opt_log_messages; i++) {
+		messages[i] = g_strdup_printf("Message <b>%d</b> of the logger "
+			"benchmark, about as long as a typical <i>message</i>.", i);
+	}
+
+	printf("nullbench: %d messages\n", opt_log_messages);
+	bench_logger(account, "html", messages);
+	bench_logger(account, "binary", messages);
+
+	purple_prefs_set_string("/purple/logging/format", format);
+	g_free(format);
+	g_strfreev(messages);
+}
+
+/* Removes a directory and everything in it. */
+static void
+remove_dir(const gchar *path)
+{
+	GDir *dir;
+	const gchar *name;
+
+	if ((dir = g_dir_open(path, 0, NULL)) != NULL) {
+		while ((name = g_dir_read_name(dir)) != NULL) {
+			gchar *child = g_build_filename(path, name, NULL);
+
+			if (g_file_test(child, G_FILE_TEST_IS_DIR) &&
+					!g_file_test(child, G_FILE_TEST_IS_SYMLINK))
+				remove_dir(child);
+			else
+				g_remove(child);
+			g_free(child);
+		}
+		g_dir_close(dir);
+	}
+
+	g_rmdir(path);
+}
+
+static void
+cleanup_user_dir(void)
+{
+	if (temporary_user_dir)
+		remove_dir(opt_user_dir);
+}
+
+static void
+signed_on_cb(PurpleConnection *gc, gpointer data)
+{
+	/* nullprpl sets up its buddies and chat room once it's signed on, so
+	 * start measuring after that. */
+	g_idle_add(start_cb, data);
+}
+
+int main(int argc, char *argv[])
+{
+	static int handle;
+	GOptionContext *context;
+	GError *error = NULL;
+	GMainLoop *loop;
+	PurpleAccount *account;
+	PurpleSavedStatus *status;
+
+	context = g_option_context_new(NULL);
+	g_option_context_set_summary(context,
+		"Runs nullprpl's load generator and reports how libpurple copes.");
+	g_option_context_add_main_entries(context, option_entries, NULL);
+	if (!g_option_context_parse(context, &argc, &argv, &error)) {
+		fprintf(stderr, "%s\n", error->message);
+		g_error_free(error);
+		return 1;
+	}
+	g_option_context_free(context);
+
+#ifndef _WIN32
+	/* libpurple's built-in DNS resolution forks processes to perform
+	 * blocking lookups without blocking the main process.  It does not
+	 * handle SIGCHLD itself, so if the UI does not you quickly get an army
+	 * of zombie subprocesses marching around.
+	 */
+	signal(SIGCHLD, SIG_IGN);
+#endif
+
+	/* Start from an empty buddy list and no saved logs, unless asked not to. */
+	if (opt_user_dir == NULL) {
+		opt_user_dir = g_dir_make_tmp("nullbench-XXXXXX", &error);
+		if (opt_user_dir == NULL) {
+			fprintf(stderr, "%s\n", error->message);
+			g_error_free(error);
+			return 1;
+		}
+		temporary_user_dir = TRUE;
+	}
+	purple_util_set_user_dir(opt_user_dir);
+
+	purple_debug_set_enabled(FALSE);
+	purple_core_set_ui_ops(&bench_core_uiops);
+	purple_eventloop_set_ui_ops(&glib_eventloops);
+
+	if (!purple_core_init(BENCH_UI_ID)) {
+		fprintf(stderr, "libpurple initialization failed.\n");
+		cleanup_user_dir();
+		return 1;
+	}
+
+	if (opt_plugin_path != NULL)
+		purple_plugins_add_search_path(opt_plugin_path);
+	purple_plugins_refresh();
+	purple_prefs_load();
+
+	purple_prefs_set_bool("/purple/logging/log_ims", opt_logging);
+	purple_prefs_set_bool("/purple/logging/log_chats", opt_logging);
+
+	if (purple_protocols_find("prpl-null") == NULL) {
+		fprintf(stderr, "nullprpl wasn't found; use --plugin-path to say "
+			"where it was built.\n");
+		purple_core_quit();
+		cleanup_user_dir();
+		return 1;
+	}
+
+	account = purple_account_new("nullbench", "prpl-null");
+	purple_account_set_int(account, "load_buddies", opt_buddies);
+	purple_account_set_int(account, "load_presence_rate", opt_presence_rate);
+	purple_account_set_int(account, "load_im_rate", opt_im_rate);
+	purple_account_set_int(account, "load_chat_size", opt_chat_size);
+	purple_account_set_int(account, "load_chat_rate", opt_chat_rate);
+	purple_accounts_add(account);
+
+	if (opt_compare_loggers) {
+		compare_loggers(account);
+		purple_core_quit();
+		cleanup_user_dir();
+		return 0;
+	}
+
+	loop = g_main_loop_new(NULL, FALSE);
+	latencies = g_array_new(FALSE, FALSE, sizeof(gint64));
+
+	purple_signal_connect(purple_connections_get_handle(), "signed-on",
+		&handle, PURPLE_CALLBACK(signed_on_cb), loop);
+	purple_signal_connect(purple_conversations_get_handle(), "received-im-msg",
+		&handle, PURPLE_CALLBACK(received_im_cb), NULL);
+	purple_signal_connect(purple_conversations_get_handle(), "received-chat-msg",
+		&handle, PURPLE_CALLBACK(received_chat_cb), NULL);
+	purple_signal_connect(purple_blist_get_handle(), "buddy-status-changed",
+		&handle, PURPLE_CALLBACK(buddy_status_changed_cb), NULL);
+
+	enabled_time = g_get_monotonic_time();
+	purple_account_set_enabled(account, BENCH_UI_ID, TRUE);
+	status = purple_savedstatus_new(NULL, PURPLE_STATUS_AVAILABLE);
+	purple_savedstatus_activate(status);
+
+	g_main_loop_run(loop);
+
+	purple_signals_disconnect_by_handle(&handle);
+	purple_core_quit();
+	cleanup_user_dir();
+	g_array_free(latencies, TRUE);
+	g_main_loop_unref(loop);
+
+	return 0;
+}
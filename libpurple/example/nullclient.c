@@ -142,7 +142,7 @@ static PurpleConversationUiOps null_conv_uiops =
 	NULL,                      /* present              */
 	NULL,                      /* has_focus            */
 	NULL,                      /* send_confirm         */
-	NULL,
+	NULL,                      /* chat_update_users    */
 	NULL,
 	NULL,
 	NULL
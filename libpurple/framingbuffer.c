@@ -0,0 +1,588 @@
+/* Purple is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ */
+#include "internal.h"
+#include "glibcompat.h"
+
+#include "framingbuffer.h"
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
+#define DEFAULT_CHUNK_SIZE 4096
+
+/* The most segments purple_framing_buffer_send() hands to one writev() */
+#define MAX_SEND_SEGMENTS 16
+
+#define PURPLE_FRAMING_BUFFER_GET_PRIVATE(obj) \
+	(G_TYPE_INSTANCE_GET_PRIVATE((obj), PURPLE_TYPE_FRAMING_BUFFER, PurpleFramingBufferPrivate))
+
+/******************************************************************************
+ * Structs
+ *****************************************************************************/
+typedef struct {
+	/** The memory holding this segment's bytes. */
+	guint8 *data;
+
+	/** How many bytes fit in data.  New data is only ever written to
+	 *  the last segment. */
+	gsize size;
+
+	/** The offset of the first unread byte. */
+	gsize start;
+
+	/** The offset just past the last byte written. */
+	gsize end;
+
+	/** TRUE if data was handed to us by purple_framing_buffer_append_owned()
+	 *  rather than allocated by the buffer. */
+	gboolean external;
+
+	/** How to free data, for external segments. */
+	GDestroyNotify destroy;
+} PurpleFramingSegment;
+
+typedef struct {
+	/** The segments holding unread data, oldest first. */
+	GQueue segments;
+
+	/** The number of unread bytes across all segments. */
+	gsize used;
+
+	/** The size of the segments we allocate for incoming data. */
+	gsize chunk_size;
+
+	/** One read segment kept around, so a connection that reads and
+	 *  handles a chunk at a time doesn't allocate for every read. */
+	PurpleFramingSegment *spare;
+} PurpleFramingBufferPrivate;
+
+/******************************************************************************
+ * Enums
+ *****************************************************************************/
+enum {
+	PROP_ZERO,
+	PROP_CHUNK_SIZE,
+	PROP_LAST,
+};
+
+/******************************************************************************
+ * Globals
+ *****************************************************************************/
+static GObjectClass *parent_class = NULL;
+static GParamSpec *properties[PROP_LAST];
+
+/******************************************************************************
+ * Segments
+ *****************************************************************************/
+static PurpleFramingSegment *
+purple_framing_segment_new(PurpleFramingBufferPrivate *priv, gsize size) {
+	PurpleFramingSegment *segment;
+
+	if(size <= priv->chunk_size && priv->spare != NULL) {
+		segment = priv->spare;
+		priv->spare = NULL;
+	} else {
+		segment = g_new0(PurpleFramingSegment, 1);
+		segment->size = MAX(size, priv->chunk_size);
+		segment->data = g_malloc(segment->size);
+	}
+
+	segment->start = segment->end = 0;
+
+	return segment;
+}
+
+static void
+purple_framing_segment_free(PurpleFramingBufferPrivate *priv,
+                            PurpleFramingSegment *segment)
+{
+	if(segment->external) {
+		if(segment->destroy != NULL)
+			segment->destroy(segment->data);
+	} else if(priv->spare == NULL && segment->size == priv->chunk_size) {
+		priv->spare = segment;
+		return;
+	} else {
+		g_free(segment->data);
+	}
+
+	g_free(segment);
+}
+
+static gboolean
+purple_framing_segment_match(GList *link, gsize pos, const guint8 *needle,
+                             gsize len)
+{
+	while(len > 0 && link != NULL) {
+		PurpleFramingSegment *segment = link->data;
+		gsize n = MIN(len, segment->end - pos);
+
+		if(memcmp(segment->data + pos, needle, n) != 0)
+			return FALSE;
+
+		needle += n;
+		len -= n;
+
+		link = link->next;
+		if(link != NULL)
+			pos = ((PurpleFramingSegment *)link->data)->start;
+	}
+
+	return (len == 0);
+}
+
+/******************************************************************************
+ * Object Stuff
+ *****************************************************************************/
+static void
+purple_framing_buffer_finalize(GObject *obj) {
+	PurpleFramingBufferPrivate *priv =
+			PURPLE_FRAMING_BUFFER_GET_PRIVATE(obj);
+
+	purple_framing_buffer_reset(PURPLE_FRAMING_BUFFER(obj));
+
+	if(priv->spare != NULL) {
+		g_free(priv->spare->data);
+		g_free(priv->spare);
+	}
+
+	G_OBJECT_CLASS(parent_class)->finalize(obj);
+}
+
+static void
+purple_framing_buffer_get_property(GObject *obj, guint param_id,
+                                   GValue *value, GParamSpec *pspec)
+{
+	PurpleFramingBufferPrivate *priv =
+			PURPLE_FRAMING_BUFFER_GET_PRIVATE(obj);
+
+	switch(param_id) {
+		case PROP_CHUNK_SIZE:
+			g_value_set_ulong(value, priv->chunk_size);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, param_id, pspec);
+			break;
+	}
+}
+
+static void
+purple_framing_buffer_set_property(GObject *obj, guint param_id,
+                                   const GValue *value, GParamSpec *pspec)
+{
+	PurpleFramingBufferPrivate *priv =
+			PURPLE_FRAMING_BUFFER_GET_PRIVATE(obj);
+	gsize chunk_size;
+
+	switch(param_id) {
+		case PROP_CHUNK_SIZE:
+			chunk_size = g_value_get_ulong(value);
+			priv->chunk_size = chunk_size ? chunk_size : DEFAULT_CHUNK_SIZE;
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, param_id, pspec);
+			break;
+	}
+}
+
+static void
+purple_framing_buffer_class_init(PurpleFramingBufferClass *klass) {
+	GObjectClass *obj_class = G_OBJECT_CLASS(klass);
+
+	parent_class = g_type_class_peek_parent(klass);
+
+	g_type_class_add_private(klass, sizeof(PurpleFramingBufferPrivate));
+
+	obj_class->finalize = purple_framing_buffer_finalize;
+	obj_class->get_property = purple_framing_buffer_get_property;
+	obj_class->set_property = purple_framing_buffer_set_property;
+
+	/* using a ulong for the gsize property, like PurpleCircularBuffer */
+	properties[PROP_CHUNK_SIZE] = g_param_spec_ulong("chunk-size",
+		                   "chunk-size",
+		                   "The size of the segments allocated for new data",
+		                   0, G_MAXSIZE, 0,
+		                   G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+		                   G_PARAM_STATIC_STRINGS);
+
+	g_object_class_install_properties(obj_class, PROP_LAST, properties);
+}
+
+/******************************************************************************
+ * API
+ *****************************************************************************/
+GType
+purple_framing_buffer_get_type(void) {
+	static GType type = 0;
+
+	if(G_UNLIKELY(type == 0)) {
+		static const GTypeInfo info = {
+			.class_size = sizeof(PurpleFramingBufferClass),
+			.class_init = (GClassInitFunc)purple_framing_buffer_class_init,
+			.instance_size = sizeof(PurpleFramingBuffer),
+		};
+
+		type = g_type_register_static(G_TYPE_OBJECT,
+		                              "PurpleFramingBuffer",
+		                              &info, 0);
+	}
+
+	return type;
+}
+
+PurpleFramingBuffer *
+purple_framing_buffer_new(gsize chunk_size) {
+	return g_object_new(PURPLE_TYPE_FRAMING_BUFFER,
+	                    "chunk-size", chunk_size,
+	                    NULL);
+}
+
+gpointer
+purple_framing_buffer_get_input(PurpleFramingBuffer *buffer, gsize *len) {
+	PurpleFramingBufferPrivate *priv = NULL;
+	PurpleFramingSegment *tail;
+
+	g_return_val_if_fail(PURPLE_IS_FRAMING_BUFFER(buffer), NULL);
+	g_return_val_if_fail(len != NULL, NULL);
+
+	priv = PURPLE_FRAMING_BUFFER_GET_PRIVATE(buffer);
+
+	/* Don't bother reading into the last few bytes of a segment, that
+	 * just means more reads. */
+	tail = g_queue_peek_tail(&priv->segments);
+	if(tail == NULL || tail->external ||
+			(tail->size - tail->end) < priv->chunk_size / 4)
+	{
+		tail = purple_framing_segment_new(priv, priv->chunk_size);
+		g_queue_push_tail(&priv->segments, tail);
+	}
+
+	*len = tail->size - tail->end;
+
+	return tail->data + tail->end;
+}
+
+void
+purple_framing_buffer_mark_written(PurpleFramingBuffer *buffer, gsize len) {
+	PurpleFramingBufferPrivate *priv = NULL;
+	PurpleFramingSegment *tail;
+
+	g_return_if_fail(PURPLE_IS_FRAMING_BUFFER(buffer));
+
+	priv = PURPLE_FRAMING_BUFFER_GET_PRIVATE(buffer);
+
+	tail = g_queue_peek_tail(&priv->segments);
+	g_return_if_fail(tail != NULL && !tail->external);
+	g_return_if_fail(tail->size - tail->end >= len);
+
+	tail->end += len;
+	priv->used += len;
+}
+
+void
+purple_framing_buffer_append(PurpleFramingBuffer *buffer, gconstpointer src,
+                             gsize len)
+{
+	const guint8 *data = src;
+
+	g_return_if_fail(PURPLE_IS_FRAMING_BUFFER(buffer));
+	g_return_if_fail(src != NULL || len == 0);
+
+	while(len > 0) {
+		gsize avail;
+		gpointer input;
+
+		input = purple_framing_buffer_get_input(buffer, &avail);
+		avail = MIN(avail, len);
+		memcpy(input, data, avail);
+		purple_framing_buffer_mark_written(buffer, avail);
+
+		data += avail;
+		len -= avail;
+	}
+}
+
+void
+purple_framing_buffer_append_owned(PurpleFramingBuffer *buffer, gpointer data,
+                                   gsize len, GDestroyNotify destroy)
+{
+	PurpleFramingBufferPrivate *priv = NULL;
+	PurpleFramingSegment *segment;
+
+	g_return_if_fail(PURPLE_IS_FRAMING_BUFFER(buffer));
+
+	if(len == 0) {
+		if(destroy != NULL)
+			destroy(data);
+		return;
+	}
+
+	priv = PURPLE_FRAMING_BUFFER_GET_PRIVATE(buffer);
+
+	segment = g_new0(PurpleFramingSegment, 1);
+	segment->data = data;
+	segment->size = segment->end = len;
+	segment->external = TRUE;
+	segment->destroy = destroy;
+
+	g_queue_push_tail(&priv->segments, segment);
+	priv->used += len;
+}
+
+gsize
+purple_framing_buffer_get_used(const PurpleFramingBuffer *buffer) {
+	PurpleFramingBufferPrivate *priv = NULL;
+
+	g_return_val_if_fail(PURPLE_IS_FRAMING_BUFFER(buffer), 0);
+
+	priv = PURPLE_FRAMING_BUFFER_GET_PRIVATE(buffer);
+
+	return priv->used;
+}
+
+gpointer
+purple_framing_buffer_peek(PurpleFramingBuffer *buffer, gsize len) {
+	PurpleFramingBufferPrivate *priv = NULL;
+	PurpleFramingSegment *head, *joined;
+	gsize copied = 0;
+
+	g_return_val_if_fail(PURPLE_IS_FRAMING_BUFFER(buffer), NULL);
+	g_return_val_if_fail(len > 0, NULL);
+
+	priv = PURPLE_FRAMING_BUFFER_GET_PRIVATE(buffer);
+
+	if(priv->used < len)
+		return NULL;
+
+	head = g_queue_peek_head(&priv->segments);
+	if(head->end - head->start >= len)
+		return head->data + head->start;
+
+	/* The data straddles segments, so gather it into a new one.  This is
+	 * the only time buffered data gets copied. */
+	joined = purple_framing_segment_new(priv, len);
+
+	while(copied < len) {
+		gsize n;
+
+		head = g_queue_peek_head(&priv->segments);
+		n = MIN(head->end - head->start, len - copied);
+
+		memcpy(joined->data + copied, head->data + head->start, n);
+		head->start += n;
+		copied += n;
+
+		if(head->start == head->end)
+			purple_framing_segment_free(priv,
+					g_queue_pop_head(&priv->segments));
+	}
+
+	joined->end = len;
+	g_queue_push_head(&priv->segments, joined);
+
+	return joined->data;
+}
+
+gssize
+purple_framing_buffer_find(PurpleFramingBuffer *buffer, gconstpointer needle,
+                           gsize needle_len)
+{
+	PurpleFramingBufferPrivate *priv = NULL;
+	const guint8 *first = needle;
+	gsize offset = 0;
+	GList *link;
+
+	g_return_val_if_fail(PURPLE_IS_FRAMING_BUFFER(buffer), -1);
+	g_return_val_if_fail(needle != NULL && needle_len > 0, -1);
+
+	priv = PURPLE_FRAMING_BUFFER_GET_PRIVATE(buffer);
+
+	for(link = priv->segments.head; link != NULL; link = link->next) {
+		PurpleFramingSegment *segment = link->data;
+		const guint8 *data = segment->data + segment->start;
+		gsize avail = segment->end - segment->start;
+		gsize i = 0;
+
+		while(i < avail) {
+			const guint8 *hit = memchr(data + i, *first, avail - i);
+
+			if(hit == NULL)
+				break;
+
+			i = hit - data;
+			if(purple_framing_segment_match(link, segment->start + i,
+			                                needle, needle_len))
+				return offset + i;
+			i++;
+		}
+
+		offset += avail;
+	}
+
+	return -1;
+}
+
+gboolean
+purple_framing_buffer_mark_read(PurpleFramingBuffer *buffer, gsize len) {
+	PurpleFramingBufferPrivate *priv = NULL;
+
+	g_return_val_if_fail(PURPLE_IS_FRAMING_BUFFER(buffer), FALSE);
+
+	priv = PURPLE_FRAMING_BUFFER_GET_PRIVATE(buffer);
+
+	g_return_val_if_fail(priv->used >= len, FALSE);
+
+	priv->used -= len;
+
+	while(len > 0) {
+		PurpleFramingSegment *head = g_queue_peek_head(&priv->segments);
+		gsize n = MIN(head->end - head->start, len);
+
+		head->start += n;
+		len -= n;
+
+		if(head->start < head->end)
+			break;
+
+		/* Keep reading into the last segment from the beginning */
+		if(priv->segments.length == 1 && !head->external)
+			head->start = head->end = 0;
+		else
+			purple_framing_segment_free(priv,
+					g_queue_pop_head(&priv->segments));
+	}
+
+	return TRUE;
+}
+
+gsize
+purple_framing_buffer_read(PurpleFramingBuffer *buffer, gpointer dest,
+                           gsize len)
+{
+	PurpleFramingBufferPrivate *priv = NULL;
+	guint8 *out = dest;
+	gsize copied = 0;
+	GList *link;
+
+	g_return_val_if_fail(PURPLE_IS_FRAMING_BUFFER(buffer), 0);
+	g_return_val_if_fail(dest != NULL || len == 0, 0);
+
+	priv = PURPLE_FRAMING_BUFFER_GET_PRIVATE(buffer);
+
+	len = MIN(len, priv->used);
+
+	for(link = priv->segments.head; copied < len; link = link->next) {
+		PurpleFramingSegment *segment = link->data;
+		gsize n = MIN(segment->end - segment->start, len - copied);
+
+		memcpy(out + copied, segment->data + segment->start, n);
+		copied += n;
+	}
+
+	purple_framing_buffer_mark_read(buffer, len);
+
+	return len;
+}
+
+gconstpointer
+purple_framing_buffer_get_output(const PurpleFramingBuffer *buffer,
+                                 gsize *len)
+{
+	PurpleFramingBufferPrivate *priv = NULL;
+	PurpleFramingSegment *head;
+
+	g_return_val_if_fail(PURPLE_IS_FRAMING_BUFFER(buffer), NULL);
+
+	priv = PURPLE_FRAMING_BUFFER_GET_PRIVATE(buffer);
+
+	head = g_queue_peek_head(&priv->segments);
+	if(priv->used == 0 || head == NULL) {
+		if(len != NULL)
+			*len = 0;
+		return NULL;
+	}
+
+	if(len != NULL)
+		*len = head->end - head->start;
+
+	return head->data + head->start;
+}
+
+gssize
+purple_framing_buffer_send(PurpleFramingBuffer *buffer, int fd) {
+	PurpleFramingBufferPrivate *priv = NULL;
+	gssize ret;
+#ifndef _WIN32
+	struct iovec iov[MAX_SEND_SEGMENTS];
+	GList *link;
+	int count = 0;
+#else
+	gconstpointer output;
+	gsize len;
+#endif
+
+	g_return_val_if_fail(PURPLE_IS_FRAMING_BUFFER(buffer), -1);
+
+	priv = PURPLE_FRAMING_BUFFER_GET_PRIVATE(buffer);
+
+	if(priv->used == 0)
+		return 0;
+
+#ifndef _WIN32
+	for(link = priv->segments.head;
+	    link != NULL && count < MAX_SEND_SEGMENTS;
+	    link = link->next)
+	{
+		PurpleFramingSegment *segment = link->data;
+
+		if(segment->end == segment->start)
+			continue;
+
+		iov[count].iov_base = segment->data + segment->start;
+		iov[count].iov_len = segment->end - segment->start;
+		count++;
+	}
+
+	ret = writev(fd, iov, count);
+#else
+	output = purple_framing_buffer_get_output(buffer, &len);
+	ret = send(fd, output, len, 0);
+#endif
+
+	if(ret > 0)
+		purple_framing_buffer_mark_read(buffer, ret);
+
+	return ret;
+}
+
+void
+purple_framing_buffer_reset(PurpleFramingBuffer *buffer) {
+	PurpleFramingBufferPrivate *priv = NULL;
+	PurpleFramingSegment *segment;
+
+	g_return_if_fail(PURPLE_IS_FRAMING_BUFFER(buffer));
+
+	priv = PURPLE_FRAMING_BUFFER_GET_PRIVATE(buffer);
+
+	while((segment = g_queue_pop_head(&priv->segments)) != NULL)
+		purple_framing_segment_free(priv, segment);
+
+	priv->used = 0;
+}
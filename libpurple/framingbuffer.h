@@ -0,0 +1,232 @@
+/* Purple is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ */
+
+#ifndef PURPLE_FRAMING_BUFFER_H
+#define PURPLE_FRAMING_BUFFER_H
+/**
+ * SECTION:framingbuffer
+ * @section_id: libpurple-framingbuffer
+ * @short_description: <filename>framingbuffer.h</filename>
+ * @title: Framing Buffer
+ *
+ * A framing buffer holds the bytes of a stream connection that have not been
+ * handled yet.  Data is kept in a list of segments, so appending never moves
+ * what is already buffered, and reading just advances a cursor.  Protocols
+ * read straight into the buffer with purple_framing_buffer_get_input() and
+ * look at whole frames in place with purple_framing_buffer_peek(); bytes are
+ * only copied when a frame straddles two segments.
+ *
+ * The same buffer works as a send queue: purple_framing_buffer_append_owned()
+ * queues data without copying it, and purple_framing_buffer_send() writes as
+ * many segments as the socket takes in a single call.
+ */
+
+#include <glib.h>
+#include <glib-object.h>
+
+#define PURPLE_TYPE_FRAMING_BUFFER            (purple_framing_buffer_get_type())
+#define PURPLE_FRAMING_BUFFER(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj), PURPLE_TYPE_FRAMING_BUFFER, PurpleFramingBuffer))
+#define PURPLE_FRAMING_BUFFER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass), PURPLE_TYPE_FRAMING_BUFFER, PurpleFramingBufferClass))
+#define PURPLE_IS_FRAMING_BUFFER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj), PURPLE_TYPE_FRAMING_BUFFER))
+#define PURPLE_IS_FRAMING_BUFFER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass), PURPLE_TYPE_FRAMING_BUFFER))
+#define PURPLE_FRAMING_BUFFER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj), PURPLE_TYPE_FRAMING_BUFFER, PurpleFramingBufferClass))
+
+typedef struct _PurpleFramingBuffer           PurpleFramingBuffer;
+typedef struct _PurpleFramingBufferClass      PurpleFramingBufferClass;
+
+struct _PurpleFramingBuffer {
+	/*< private >*/
+	GObject parent;
+};
+
+struct _PurpleFramingBufferClass {
+	/*< private >*/
+	GObjectClass parent;
+
+	void (*purple_reserved1)(void);
+	void (*purple_reserved2)(void);
+	void (*purple_reserved3)(void);
+	void (*purple_reserved4)(void);
+};
+
+G_BEGIN_DECLS
+
+GType purple_framing_buffer_get_type(void);
+
+/**
+ * purple_framing_buffer_new:
+ * @chunk_size: The size of the segments the buffer allocates for incoming
+ *              data.  Pass in "0" to use the default of 4096 bytes.
+ *
+ * Creates a new framing buffer.  This will not allocate any memory for
+ * segments until data is added to it.
+ *
+ * Returns: The new PurpleFramingBuffer.
+ */
+PurpleFramingBuffer *purple_framing_buffer_new(gsize chunk_size);
+
+/**
+ * purple_framing_buffer_get_input:
+ * @buffer: The PurpleFramingBuffer to add data to.
+ * @len:    Return location for the number of bytes that may be written.
+ *
+ * Returns a pointer to free space at the end of the buffer, allocating a new
+ * segment if needed, so data can be read from a socket straight into the
+ * buffer.  Call purple_framing_buffer_mark_written() afterwards with the
+ * number of bytes actually written.
+ *
+ * Returns: The space to write new data to.
+ */
+gpointer purple_framing_buffer_get_input(PurpleFramingBuffer *buffer, gsize *len);
+
+/**
+ * purple_framing_buffer_mark_written:
+ * @buffer: The PurpleFramingBuffer the data was written to.
+ * @len:    The number of bytes written to the space returned by
+ *          purple_framing_buffer_get_input().
+ *
+ * Adds bytes written to the input space to the buffered data.
+ */
+void purple_framing_buffer_mark_written(PurpleFramingBuffer *buffer, gsize len);
+
+/**
+ * purple_framing_buffer_append:
+ * @buffer: The PurpleFramingBuffer to which to append the data.
+ * @src:    Pointer to the data to copy into the buffer.
+ * @len:    Number of bytes to copy into the buffer.
+ *
+ * Copies data to the end of the buffer.
+ */
+void purple_framing_buffer_append(PurpleFramingBuffer *buffer, gconstpointer src, gsize len);
+
+/**
+ * purple_framing_buffer_append_owned:
+ * @buffer:  The PurpleFramingBuffer to which to append the data.
+ * @data:    The data to add.  The buffer takes ownership of it.
+ * @len:     The number of bytes of @data to add.
+ * @destroy: Function to free @data once it has been read, or %NULL.
+ *
+ * Adds data to the end of the buffer without copying it.  This is meant for
+ * send queues, where whole messages are queued and written out later.
+ */
+void purple_framing_buffer_append_owned(PurpleFramingBuffer *buffer, gpointer data, gsize len, GDestroyNotify destroy);
+
+/**
+ * purple_framing_buffer_get_used:
+ * @buffer: The PurpleFramingBuffer from which to get used count.
+ *
+ * Returns the number of bytes in the buffer that have not been read yet.
+ *
+ * Returns: The number of bytes that contain unread data.
+ */
+gsize purple_framing_buffer_get_used(const PurpleFramingBuffer *buffer);
+
+/**
+ * purple_framing_buffer_peek:
+ * @buffer: The PurpleFramingBuffer to look at.
+ * @len:    The number of bytes needed.
+ *
+ * Makes the first @len unread bytes available as one contiguous block,
+ * without marking them as read.  This is how a protocol looks at a whole
+ * frame once it knows the frame's length.  The data may be modified in
+ * place.  The pointer stays valid until the next call that peeks into,
+ * reads from, resets or destroys the buffer; appending data does not move
+ * it.
+ *
+ * Returns: A pointer to the first @len unread bytes, or %NULL if fewer than
+ *          @len bytes are buffered.
+ */
+gpointer purple_framing_buffer_peek(PurpleFramingBuffer *buffer, gsize len);
+
+/**
+ * purple_framing_buffer_find:
+ * @buffer:     The PurpleFramingBuffer to search.
+ * @needle:     The bytes to look for, such as a line terminator.
+ * @needle_len: The length of @needle.
+ *
+ * Searches the unread data for a delimiter, across segment boundaries.
+ *
+ * Returns: The offset of the first occurrence of @needle from the start of
+ *          the unread data, or -1 if it is not buffered yet.
+ */
+gssize purple_framing_buffer_find(PurpleFramingBuffer *buffer, gconstpointer needle, gsize needle_len);
+
+/**
+ * purple_framing_buffer_mark_read:
+ * @buffer: The PurpleFramingBuffer to mark bytes read from.
+ * @len:    The number of bytes to mark as read.
+ *
+ * Marks the first @len unread bytes as read.  Segments that have been read
+ * completely are freed.
+ *
+ * Returns: TRUE if we successfully marked the bytes as having been read, FALSE
+ *         otherwise.
+ */
+gboolean purple_framing_buffer_mark_read(PurpleFramingBuffer *buffer, gsize len);
+
+/**
+ * purple_framing_buffer_read:
+ * @buffer: The PurpleFramingBuffer to read from.
+ * @dest:   Where to copy the data to.
+ * @len:    The maximum number of bytes to read.
+ *
+ * Copies unread data out of the buffer and marks it as read.
+ *
+ * Returns: The number of bytes copied.
+ */
+gsize purple_framing_buffer_read(PurpleFramingBuffer *buffer, gpointer dest, gsize len);
+
+/**
+ * purple_framing_buffer_get_output:
+ * @buffer: The PurpleFramingBuffer from which to get the output pointer.
+ * @len:    Return location for the number of contiguous bytes available.
+ *
+ * Returns the unread data in the first segment of the buffer.  This is
+ * useful for writing the buffer to something other than a socket, such as
+ * an SSL connection; call purple_framing_buffer_mark_read() with however much
+ * was written.
+ *
+ * Returns: The output pointer for the buffer, or %NULL if it is empty.
+ */
+gconstpointer purple_framing_buffer_get_output(const PurpleFramingBuffer *buffer, gsize *len);
+
+/**
+ * purple_framing_buffer_send:
+ * @buffer: The PurpleFramingBuffer to write out.
+ * @fd:     The socket to write to.
+ *
+ * Writes as much of the buffer to a socket as it accepts, using one
+ * vectored write for all the segments where the platform has it, and marks
+ * what was written as read.
+ *
+ * Returns: The number of bytes written, or -1 on error, with errno set.
+ */
+gssize purple_framing_buffer_send(PurpleFramingBuffer *buffer, int fd);
+
+/**
+ * purple_framing_buffer_reset:
+ * @buffer: The PurpleFramingBuffer to reset.
+ *
+ * Discards the buffer contents.
+ */
+void purple_framing_buffer_reset(PurpleFramingBuffer *buffer);
+
+G_END_DECLS
+
+#endif /* PURPLE_FRAMING_BUFFER_H */
@@ -3149,6 +3149,38 @@ purple_http_url_get_fragment(const PurpleHttpURL *parsed_url)
 
 /*** HTTP Subsystem ***********************************************************/
 
+#ifdef ENABLE_MEMSTAT
+static gsize purple_http_gstring_size(GString *str)
+{
+	if (str == NULL)
+		return 0;
+	return sizeof(GString) + str->allocated_len;
+}
+
+/* Buffers are resized all over, so it's simpler to add them up when asked. */
+static void purple_http_memstat_sample(gssize *count, gssize *bytes)
+{
+	GList *it;
+
+	*count = *bytes = 0;
+	for (it = purple_http_hc_list; it; it = g_list_next(it)) {
+		PurpleHttpConnection *hc = it->data;
+
+		(*count)++;
+		*bytes += sizeof(PurpleHttpConnection);
+		*bytes += purple_http_gstring_size(hc->request_header);
+		*bytes += purple_http_gstring_size(hc->response_buffer);
+		*bytes += purple_http_gstring_size(hc->contents_reader_buffer);
+		if (hc->gz_stream)
+			*bytes += purple_http_gstring_size(hc->gz_stream->pending);
+		if (hc->request->contents)
+			*bytes += hc->request->contents_length;
+		if (hc->response)
+			*bytes += purple_http_gstring_size(hc->response->contents);
+	}
+}
+#endif
+
 void purple_http_init(void)
 {
 	purple_http_re_url = g_regex_new("^"
@@ -3193,6 +3225,11 @@ void purple_http_init(void)
 	purple_http_hc_by_gc = g_hash_table_new_full(g_direct_hash,
 		g_direct_equal, NULL, (GDestroyNotify)g_list_free);
 	purple_http_cancelling_gc = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+#ifdef ENABLE_MEMSTAT
+	_purple_memstat_set_sampler(PURPLE_MEMSTAT_HTTP,
+		purple_http_memstat_sample);
+#endif
 }
 
 static void purple_http_foreach_conn_cancel(gpointer _hc, gpointer user_data)
@@ -3227,4 +3264,8 @@ void purple_http_uninit(void)
 	purple_http_hc_by_ptr = NULL;
 	g_hash_table_destroy(purple_http_cancelling_gc);
 	purple_http_cancelling_gc = NULL;
+
+#ifdef ENABLE_MEMSTAT
+	_purple_memstat_set_sampler(PURPLE_MEMSTAT_HTTP, NULL);
+#endif
 }
@@ -19,6 +19,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02111-1301 USA
  */
 
+#include "internal.h"
 #include "image-store.h"
 
 #include "eventloop.h"
@@ -210,12 +211,36 @@ purple_image_store_get_uri(PurpleImage *image)
 	return g_strdup_printf(PURPLE_IMAGE_STORE_PROTOCOL "%u", img_id);
 }
 
+#ifdef ENABLE_MEMSTAT
+static void
+image_store_memstat_sample(gssize *count, gssize *bytes)
+{
+	GHashTableIter it;
+	gpointer image;
+
+	*count = *bytes = 0;
+	if (id_to_image == NULL)
+		return;
+
+	g_hash_table_iter_init(&it, id_to_image);
+	while (g_hash_table_iter_next(&it, NULL, &image)) {
+		(*count)++;
+		*bytes += _purple_image_get_memory_size(image);
+	}
+}
+#endif
+
 void
 _purple_image_store_init(void)
 {
 	id_to_image = g_hash_table_new(g_direct_hash, g_direct_equal);
 	temp_images = g_hash_table_new_full(g_direct_hash, g_direct_equal,
 		NULL, g_object_unref);
+
+#ifdef ENABLE_MEMSTAT
+	_purple_memstat_set_sampler(PURPLE_MEMSTAT_IMAGES,
+		image_store_memstat_sample);
+#endif
 }
 
 void
@@ -230,4 +255,8 @@ _purple_image_store_uninit(void)
 
 	g_hash_table_destroy(id_to_image);
 	id_to_image = NULL;
+
+#ifdef ENABLE_MEMSTAT
+	_purple_memstat_set_sampler(PURPLE_MEMSTAT_IMAGES, NULL);
+#endif
 }
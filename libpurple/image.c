@@ -267,6 +267,21 @@ purple_image_get_size(PurpleImage *image)
 	return priv->contents->len;
 }
 
+gsize
+_purple_image_get_memory_size(PurpleImage *image)
+{
+	PurpleImagePrivate *priv = PURPLE_IMAGE_GET_PRIVATE(image);
+	gsize size;
+
+	g_return_val_if_fail(priv != NULL, 0);
+
+	size = _purple_memstat_type_size(G_OBJECT_TYPE(image));
+	if (priv->contents)
+		size += priv->contents->allocated_len;
+
+	return size;
+}
+
 gconstpointer
 purple_image_get_data(PurpleImage *image)
 {
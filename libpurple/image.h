@@ -300,6 +300,16 @@ purple_image_transfer_close(PurpleImage *image);
 void
 purple_image_transfer_failed(PurpleImage *image);
 
+/**
+ * _purple_image_get_memory_size: (skip)
+ * @image: the image.
+ *
+ * Returns how much memory an @image uses, without loading its contents if
+ * they aren't loaded yet.
+ */
+gsize
+_purple_image_get_memory_size(PurpleImage *image);
+
 G_END_DECLS
 
 #endif /* _PURPLE_IMAGE_H_ */
@@ -152,6 +152,22 @@
 #define PURPLE_ASSERT_CONNECTION_IS_VALID(gc) \
 	_purple_assert_connection_is_valid(gc, __FILE__, __LINE__)
 
+/* Memory accounting (see memstat.h).  Without ENABLE_MEMSTAT, these
+ * compile to nothing and their arguments aren't evaluated. */
+#ifdef ENABLE_MEMSTAT
+#define PURPLE_MEMSTAT_ADD(counter, count, bytes) \
+	_purple_memstat_add((counter), (count), (bytes))
+#else
+#define PURPLE_MEMSTAT_ADD(counter, count, bytes) G_STMT_START { } G_STMT_END
+#endif
+
+#define PURPLE_MEMSTAT_ALLOC(counter, bytes) \
+	PURPLE_MEMSTAT_ADD((counter), 1, (gssize)(bytes))
+#define PURPLE_MEMSTAT_FREE(counter, bytes) \
+	PURPLE_MEMSTAT_ADD((counter), -1, -(gssize)(bytes))
+#define PURPLE_MEMSTAT_RESIZE(counter, delta) \
+	PURPLE_MEMSTAT_ADD((counter), 0, (gssize)(delta))
+
 #ifdef __clang__
 
 #define PURPLE_BEGIN_IGNORE_CAST_ALIGN \
@@ -194,6 +210,7 @@ typedef union
 
 #include "accounts.h"
 #include "connection.h"
+#include "memstat.h"
 
 /**
  * _purple_account_set_current_error:
@@ -393,6 +410,65 @@ _purple_socket_init(void);
 void
 _purple_socket_uninit(void);
 
+/**
+ * _purple_eventloop_init: (skip)
+ *
+ * Sets up event loop profiling.
+ */
+void
+_purple_eventloop_init(void);
+
+/**
+ * _purple_eventloop_uninit: (skip)
+ *
+ * Stops event loop profiling, writing out the profile if it was on.
+ */
+void
+_purple_eventloop_uninit(void);
+
+/**
+ * PurpleMemStatSampler:
+ * @count: Set to the number of live objects.
+ * @bytes: Set to the number of bytes they use.
+ *
+ * Measures a population that is cheaper to walk when asked than to keep
+ * count of as it changes.  See _purple_memstat_set_sampler().
+ */
+typedef void (*PurpleMemStatSampler)(gssize *count, gssize *bytes);
+
+/**
+ * _purple_memstat_add: (skip)
+ * @counter: The counter.
+ * @count:   The change in the number of live objects.
+ * @bytes:   The change in the number of bytes they use.
+ *
+ * Updates a memory accounting counter.  Use the PURPLE_MEMSTAT_* macros
+ * instead, so that accounting can be compiled out.
+ */
+void
+_purple_memstat_add(PurpleMemStatCounter counter, gssize count, gssize bytes);
+
+/**
+ * _purple_memstat_set_sampler: (skip)
+ * @counter: The counter.
+ * @sampler: The function that measures it, or %NULL.
+ *
+ * Makes a counter be measured by @sampler whenever a snapshot is taken,
+ * instead of being updated as objects come and go.
+ */
+void
+_purple_memstat_set_sampler(PurpleMemStatCounter counter,
+		PurpleMemStatSampler sampler);
+
+/**
+ * _purple_memstat_type_size: (skip)
+ * @type: A #GTypeInstance type.
+ *
+ * Returns the size of an instance of @type, including its private data.
+ */
+gsize
+_purple_memstat_type_size(GType type);
+
 /**
  * _purple_message_init: (skip)
  *
@@ -409,6 +485,62 @@ _purple_message_init(void);
 void
 _purple_message_uninit(void);
 
+/**
+ * _purple_statuses_coalesce_buddy_status: (skip)
+ * @buddy:      The buddy.
+ * @old_status: The status that was active before the change.
+ *
+ * Holds back purple_buddy_update_status() for @buddy if presence
+ * notifications are being coalesced.
+ *
+ * Returns: %TRUE if the notification will be sent later.
+ */
+gboolean
+_purple_statuses_coalesce_buddy_status(PurpleBuddy *buddy,
+	PurpleStatus *old_status);
+
+/**
+ * _purple_statuses_coalesce_buddy_idle: (skip)
+ * @buddy:    The buddy.
+ * @old_idle: Whether the buddy was idle before the change.
+ *
+ * Holds back the idle notifications for @buddy if presence notifications
+ * are being coalesced.
+ *
+ * Returns: %TRUE if the notifications will be sent later.
+ */
+gboolean
+_purple_statuses_coalesce_buddy_idle(PurpleBuddy *buddy, gboolean old_idle);
+
+/**
+ * _purple_statuses_flush_buddy: (skip)
+ * @buddy: The buddy.
+ *
+ * Sends any presence notifications that are being held back for @buddy.
+ */
+void
+_purple_statuses_flush_buddy(PurpleBuddy *buddy);
+
+/**
+ * _purple_statuses_flush_account: (skip)
+ * @account: The account, or %NULL for every account.
+ *
+ * Sends any presence notifications that are being held back for the
+ * buddies of @account.
+ */
+void
+_purple_statuses_flush_account(PurpleAccount *account);
+
+/**
+ * _purple_statuses_forget_buddy: (skip)
+ * @buddy: The buddy.
+ *
+ * Drops any presence notifications that are being held back for @buddy,
+ * which is going away.
+ */
+void
+_purple_statuses_forget_buddy(PurpleBuddy *buddy);
+
 void
 _purple_assert_connection_is_valid(PurpleConnection *gc,
 	const gchar *file, int line);
@@ -36,6 +36,7 @@ static GSList *loggers = NULL;
 static PurpleLogLogger *html_logger;
 static PurpleLogLogger *txt_logger;
 static PurpleLogLogger *old_logger;
+static PurpleLogLogger *binary_logger;
 
 struct _purple_logsize_user {
 	char *name;
@@ -45,6 +46,11 @@ static GHashTable *logsize_users = NULL;
 static GHashTable *logsize_users_decayed = NULL;
 
 static void log_get_log_sets_common(GHashTable *sets);
+static char *process_txt_log(char *txt, char *to_free);
+
+/* The html and txt loggers write the offset of every message in a log to
+ * a file next to it, with this extension. */
+#define LOG_INDEX_EXT ".idx"
 
 static gsize html_logger_write(PurpleLog *log, PurpleMessageFlags type,
 							  const char *from, time_t time, const char *message);
@@ -70,6 +76,19 @@ static GList *txt_logger_list_syslog(PurpleAccount *account);
 static char *txt_logger_read(PurpleLog *log, PurpleLogReadFlags *flags);
 static int txt_logger_total_size(PurpleLogType type, const char *name, PurpleAccount *account);
 
+static gsize binary_logger_write(PurpleLog *log, PurpleMessageFlags type,
+								const char *from, time_t time, const char *message);
+static void binary_logger_finalize(PurpleLog *log);
+static GList *binary_logger_list(PurpleLogType type, const char *sn, PurpleAccount *account);
+static GList *binary_logger_list_syslog(PurpleAccount *account);
+static char *binary_logger_read(PurpleLog *log, PurpleLogReadFlags *flags);
+static int binary_logger_total_size(PurpleLogType type, const char *name, PurpleAccount *account);
+static gboolean binary_log_get_offsets(const char *data, gsize size, GArray *offsets);
+static gboolean binary_log_decode(const char *data, gsize size, gsize offset,
+		time_t *time, PurpleMessageFlags *flags, char **from, char **message);
+static void binary_log_format(PurpleLog *log, const char *data, gsize size,
+		GArray *offsets, gsize first, gsize count, GString *str);
+
 /**************************************************************************
  * PUBLIC LOGGING FUNCTIONS ***********************************************
  **************************************************************************/
@@ -486,6 +505,22 @@ PurpleLogLogger *purple_log_logger_get()
 	return current_logger;
 }
 
+PurpleLogLogger *purple_log_logger_find(const char *id)
+{
+	GSList *n;
+
+	g_return_val_if_fail(id != NULL, NULL);
+
+	for (n = loggers; n; n = n->next) {
+		PurpleLogLogger *logger = n->data;
+
+		if (purple_strequal(logger->id, id))
+			return logger;
+	}
+
+	return NULL;
+}
+
 GList *purple_log_logger_get_options(void)
 {
 	GSList *n;
@@ -680,6 +715,20 @@ void purple_log_init(void)
 									 purple_log_common_is_deletable);
 	purple_log_logger_add(txt_logger);
 
+	binary_logger = purple_log_logger_new("binary", _("Binary"), 11,
+									 NULL,
+									 binary_logger_write,
+									 binary_logger_finalize,
+									 binary_logger_list,
+									 binary_logger_read,
+									 purple_log_common_sizer,
+									 binary_logger_total_size,
+									 binary_logger_list_syslog,
+									 NULL,
+									 purple_log_common_deleter,
+									 purple_log_common_is_deletable);
+	purple_log_logger_add(binary_logger);
+
 	old_logger = purple_log_logger_new("old", _("Old flat format"), 9,
 									 NULL,
 									 NULL,
@@ -736,6 +785,10 @@ purple_log_uninit(void)
 	purple_log_logger_free(txt_logger);
 	txt_logger = NULL;
 
+	purple_log_logger_remove(binary_logger);
+	purple_log_logger_free(binary_logger);
+	binary_logger = NULL;
+
 	purple_log_logger_remove(old_logger);
 	purple_log_logger_free(old_logger);
 	old_logger = NULL;
@@ -796,6 +849,52 @@ static char *log_get_timestamp(PurpleLog *log, time_t when)
 		return g_strdup(purple_time_format(tm));
 }
 
+/* Recovers the time of a message from a timestamp log_get_timestamp()
+ * wrote, given the time of the message before it.  Only the time of day
+ * is read, so a message earlier in the day than the one before it is
+ * taken to be from the next day.  Returns after if there's no time. */
+static time_t log_parse_timestamp(const char *date, time_t after)
+{
+	const char *p;
+	int hour = 0, min = 0, sec = 0;
+	struct tm tm, *local;
+	time_t when;
+
+	for (p = date; *p != '\0'; p++) {
+		if (g_ascii_isdigit(*p) && (p == date || !g_ascii_isdigit(p[-1])) &&
+				sscanf(p, "%d:%d:%d", &hour, &min, &sec) == 3)
+			break;
+	}
+	if (*p == '\0' || hour > 23 || min > 59 || sec > 60)
+		return after;
+
+	/* A 12-hour clock */
+	if ((strstr(p, "PM") || strstr(p, "pm")) && hour < 12)
+		hour += 12;
+	else if ((strstr(p, "AM") || strstr(p, "am")) && hour == 12)
+		hour = 0;
+
+	local = localtime(&after);
+	if (local == NULL)
+		return after;
+
+	tm = *local;
+	tm.tm_hour = hour;
+	tm.tm_min = min;
+	tm.tm_sec = sec;
+	tm.tm_isdst = -1;
+
+	/* Allow for a clock that went back a little. */
+	when = mktime(&tm);
+	if (when != (time_t)-1 && when + 60 < after) {
+		tm.tm_mday++;
+		tm.tm_isdst = -1;
+		when = mktime(&tm);
+	}
+
+	return when == (time_t)-1 ? after : when;
+}
+
 /* NOTE: This can return msg (which you may or may not want to g_free())
  * NOTE: or a newly allocated string which you MUST g_free().
  * TODO: XXX: does it really works?
@@ -933,6 +1032,7 @@ void purple_log_common_writer(PurpleLog *log, const char *ext)
 		g_free(filename);
 
 		log->logger_data = data = g_slice_new0(PurpleLogCommonLoggerData);
+		data->path = path;
 
 		data->file = g_fopen(path, "a");
 		if (data->file == NULL)
@@ -945,10 +1045,8 @@ void purple_log_common_writer(PurpleLog *log, const char *ext)
 					_("Logging of this conversation failed."),
 					PURPLE_MESSAGE_ERROR);
 
-			g_free(path);
 			return;
 		}
-		g_free(path);
 	}
 }
 
@@ -1208,8 +1306,12 @@ gboolean purple_log_common_deleter(PurpleLog *log)
 		return FALSE;
 
 	ret = g_unlink(data->path);
-	if (ret == 0)
+	if (ret == 0) {
+		char *index = g_strconcat(data->path, LOG_INDEX_EXT, NULL);
+		g_unlink(index);
+		g_free(index);
 		return TRUE;
+	}
 	else if (ret == -1)
 	{
 		purple_debug_error("log", "Failed to delete: %s - %s\n", data->path, g_strerror(errno));
@@ -1285,55 +1387,303 @@ static char *process_txt_log(char *txt, char *to_free)
 }
 
 /****************************
- ** HTML LOGGER *************
+ ** LOG INDEX ***************
  ****************************/
 
-static gsize html_logger_write(PurpleLog *log, PurpleMessageFlags type,
-							  const char *from, time_t time, const char *message)
+/* The index is an array of little-endian 64-bit offsets, one for each
+ * message, so a log can be read a few messages at a time without finding
+ * where each message starts.  It lives in the extra_data of the logger data
+ * of the html and txt loggers. */
+
+static void log_index_open(PurpleLogCommonLoggerData *data)
 {
-	char *msg_fixed;
-	char *image_corrected_msg;
-	char *date;
-	char *header;
-	char *escaped_from;
-	PurpleProtocol *protocol =
-			purple_protocols_find(purple_account_get_protocol_id(log->account));
-	PurpleLogCommonLoggerData *data = log->logger_data;
-	gsize written = 0;
+	char *path;
 
-	if(!data) {
-		const char *proto = purple_protocol_class_list_icon(protocol, log->account, NULL);
-		const char *date;
-		purple_log_common_writer(log, ".html");
+	if (data->path == NULL || data->file == NULL)
+		return;
 
-		data = log->logger_data;
+	/* A log that already has messages in it keeps its index. */
+	path = g_strconcat(data->path, LOG_INDEX_EXT, NULL);
+	data->extra_data = g_fopen(path, ftell(data->file) > 0 ? "ab" : "wb");
+	if (data->extra_data == NULL)
+		purple_debug_warning("log", "Could not create log index %s\n", path);
+	g_free(path);
+}
 
-		/* if we can't write to the file, give up before we hurt ourselves */
-		if(!data->file)
-			return 0;
+static void log_index_append(PurpleLogCommonLoggerData *data)
+{
+	FILE *index = data->extra_data;
+	long offset;
+	guint64 entry;
 
-		date = purple_date_format_full(localtime(&log->time));
+	if (index == NULL)
+		return;
 
-		written += fprintf(data->file, "<html><head>");
-		written += fprintf(data->file, "<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\">");
-		written += fprintf(data->file, "<title>");
-		if (log->type == PURPLE_LOG_SYSTEM)
-			header = g_strdup_printf("System log for account %s (%s) connected at %s",
-					purple_account_get_username(log->account), proto, date);
-		else
-			header = g_strdup_printf("Conversation with %s at %s on %s (%s)",
-					log->name, date, purple_account_get_username(log->account), proto);
+	offset = ftell(data->file);
+	if (offset < 0) {
+		fclose(index);
+		data->extra_data = NULL;
+		return;
+	}
 
-		written += fprintf(data->file, "%s", header);
-		written += fprintf(data->file, "</title></head><body>");
-		written += fprintf(data->file, "<h3>%s</h3>\n", header);
-		g_free(header);
+	entry = GUINT64_TO_LE((guint64)offset);
+	fwrite(&entry, sizeof(entry), 1, index);
+	fflush(index);
+}
+
+static void log_index_close(PurpleLogCommonLoggerData *data)
+{
+	if (data->extra_data != NULL) {
+		fclose(data->extra_data);
+		data->extra_data = NULL;
 	}
+}
 
-	/* if we can't write to the file, give up before we hurt ourselves */
-	if(!data->file)
+/****************************
+ ** LOG READER **************
+ ****************************/
+
+struct _PurpleLogReader {
+	PurpleLog *log;
+	PurpleLogReadFlags flags;
+
+	GMappedFile *file;   /* The log file of an html, txt or binary log */
+	char *contents;      /* Or what the logger's read function returned */
+	const char *data;
+	gsize size;
+
+	GArray *offsets;     /* Where each message starts in data */
+	gboolean escape;     /* Whether messages are plain text to be escaped */
+	gboolean binary;     /* Whether offsets are records of a binary log */
+};
+
+static gboolean
+log_reader_load_index(PurpleLogReader *reader, const char *path, gsize start)
+{
+	char *index_path, *index;
+	gsize len, i;
+	guint64 entry, prev = start;
+
+	index_path = g_strconcat(path, LOG_INDEX_EXT, NULL);
+	if (!g_file_get_contents(index_path, &index, &len, NULL)) {
+		g_free(index_path);
+		return FALSE;
+	}
+	g_free(index_path);
+
+	/* Don't trust an index that doesn't match the log. */
+	if (len == 0 || len % sizeof(entry) != 0) {
+		g_free(index);
+		return FALSE;
+	}
+
+	for (i = 0; i < len; i += sizeof(entry)) {
+		gsize offset;
+
+		memcpy(&entry, index + i, sizeof(entry));
+		entry = GUINT64_FROM_LE(entry);
+
+		if ((i == 0 && entry != start) || entry < prev ||
+				entry > reader->size) {
+			g_array_set_size(reader->offsets, 0);
+			g_free(index);
+			return FALSE;
+		}
+
+		offset = entry;
+		g_array_append_val(reader->offsets, offset);
+		prev = entry;
+	}
+
+	g_free(index);
+	return TRUE;
+}
+
+/* Without an index, every line is a message. */
+static void
+log_reader_index_lines(PurpleLogReader *reader, gsize start)
+{
+	const char *p, *end = reader->data + reader->size;
+
+	for (p = reader->data + start; p < end; ) {
+		const char *nl = memchr(p, '\n', end - p);
+		gsize offset = p - reader->data;
+
+		g_array_append_val(reader->offsets, offset);
+		if (nl == NULL)
+			break;
+		p = nl + 1;
+	}
+}
+
+PurpleLogReader *purple_log_reader_new(PurpleLog *log)
+{
+	PurpleLogReader *reader;
+	PurpleLogCommonLoggerData *data;
+	gsize start = 0;
+
+	g_return_val_if_fail(log != NULL, NULL);
+	g_return_val_if_fail(log->logger != NULL, NULL);
+
+	reader = g_new0(PurpleLogReader, 1);
+	reader->log = log;
+	reader->offsets = g_array_new(FALSE, FALSE, sizeof(gsize));
+
+	data = log->logger_data;
+	if ((log->logger == html_logger || log->logger == txt_logger ||
+			log->logger == binary_logger) &&
+			data != NULL && data->path != NULL)
+	{
+		GError *error = NULL;
+
+		reader->file = g_mapped_file_new(data->path, FALSE, &error);
+		if (reader->file == NULL) {
+			purple_debug_warning("log", "Could not map %s: %s\n",
+					data->path, error->message);
+			g_error_free(error);
+		}
+	}
+
+	if (reader->file != NULL) {
+		const char *header_end;
+
+		reader->data = g_mapped_file_get_contents(reader->file);
+		reader->size = g_mapped_file_get_length(reader->file);
+
+		if (log->logger == binary_logger) {
+			reader->flags = PURPLE_LOG_READ_NO_NEWLINE;
+			reader->binary = TRUE;
+
+			/* A log we can't make sense of has no messages. */
+			if (!binary_log_get_offsets(reader->data, reader->size,
+					reader->offsets))
+				g_array_set_size(reader->offsets, 0);
+
+			return reader;
+		}
+
+		if (log->logger == html_logger) {
+			reader->flags = PURPLE_LOG_READ_NO_NEWLINE;
+		} else {
+			reader->flags = 0;
+			reader->escape = TRUE;
+		}
+
+		/* Skip the header line, like the loggers' read functions. */
+		header_end = reader->size ? memchr(reader->data, '\n', reader->size) : NULL;
+		if (header_end != NULL)
+			start = header_end + 1 - reader->data;
+
+		if (log_reader_load_index(reader, data->path, start))
+			return reader;
+	} else {
+		reader->contents = purple_log_read(log, &reader->flags);
+		reader->data = reader->contents;
+		reader->size = strlen(reader->contents);
+	}
+
+	log_reader_index_lines(reader, start);
+
+	return reader;
+}
+
+void purple_log_reader_free(PurpleLogReader *reader)
+{
+	g_return_if_fail(reader != NULL);
+
+	if (reader->file != NULL)
+		g_mapped_file_unref(reader->file);
+	g_free(reader->contents);
+	g_array_free(reader->offsets, TRUE);
+	g_free(reader);
+}
+
+gsize purple_log_reader_get_count(PurpleLogReader *reader)
+{
+	g_return_val_if_fail(reader != NULL, 0);
+
+	return reader->offsets->len;
+}
+
+char *purple_log_reader_read(PurpleLogReader *reader, gsize first, gsize count,
+		PurpleLogReadFlags *flags)
+{
+	gsize total, start, end;
+	char *ret;
+
+	g_return_val_if_fail(reader != NULL, NULL);
+
+	if (flags)
+		*flags = reader->flags;
+
+	total = reader->offsets->len;
+	if (first >= total || count == 0)
+		return NULL;
+	count = MIN(count, total - first);
+
+	if (reader->binary) {
+		GString *str = g_string_new(NULL);
+
+		binary_log_format(reader->log, reader->data, reader->size,
+				reader->offsets, first, count, str);
+		return g_string_free(str, FALSE);
+	}
+
+	start = g_array_index(reader->offsets, gsize, first);
+	if (first + count < total)
+		end = g_array_index(reader->offsets, gsize, first + count);
+	else
+		end = reader->size;
+
+	ret = g_strndup(reader->data + start, end - start);
+	if (reader->escape)
+		ret = process_txt_log(ret, NULL);
+	purple_str_strip_char(ret, '\r');
+
+	return ret;
+}
+
+gsize purple_log_reader_find_time(PurpleLogReader *reader, time_t when)
+{
+	gsize low = 0, high;
+
+	g_return_val_if_fail(reader != NULL, 0);
+
+	/* Only binary logs know when each message was written. */
+	if (!reader->binary)
 		return 0;
 
+	high = reader->offsets->len;
+	while (low < high) {
+		gsize mid = low + (high - low) / 2;
+		time_t time;
+
+		if (binary_log_decode(reader->data, reader->size,
+				g_array_index(reader->offsets, gsize, mid),
+				&time, NULL, NULL, NULL) && time < when)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+/****************************
+ ** HTML LOGGER *************
+ ****************************/
+
+/* Formats a message the way the html logger writes it, or returns %NULL
+ * if it isn't logged. */
+static char *html_logger_format(PurpleLog *log, PurpleMessageFlags type,
+							   const char *from, time_t time, const char *message)
+{
+	char *msg_fixed;
+	char *image_corrected_msg;
+	char *date;
+	char *escaped_from;
+	char *line = NULL;
+
 	escaped_from = g_markup_escape_text(from != NULL ? from : "<NULL>",
 			-1);
 
@@ -1348,42 +1698,207 @@ static gsize html_logger_write(PurpleLog *log, PurpleMessageFlags type,
 	date = log_get_timestamp(log, time);
 
 	if(log->type == PURPLE_LOG_SYSTEM){
-		written += fprintf(data->file, "---- %s @ %s ----<br/>\n", msg_fixed, date);
+		line = g_strdup_printf("---- %s @ %s ----<br/>\n", msg_fixed, date);
 	} else {
 		if (type & PURPLE_MESSAGE_SYSTEM)
-			written += fprintf(data->file, "<font size=\"2\">(%s)</font><b> %s</b><br/>\n", date, msg_fixed);
+			line = g_strdup_printf("<font size=\"2\">(%s)</font><b> %s</b><br/>\n", date, msg_fixed);
 		else if (type & PURPLE_MESSAGE_RAW)
-			written += fprintf(data->file, "<font size=\"2\">(%s)</font> %s<br/>\n", date, msg_fixed);
+			line = g_strdup_printf("<font size=\"2\">(%s)</font> %s<br/>\n", date, msg_fixed);
 		else if (type & PURPLE_MESSAGE_ERROR)
-			written += fprintf(data->file, "<font color=\"#FF0000\"><font size=\"2\">(%s)</font><b> %s</b></font><br/>\n", date, msg_fixed);
+			line = g_strdup_printf("<font color=\"#FF0000\"><font size=\"2\">(%s)</font><b> %s</b></font><br/>\n", date, msg_fixed);
 		else if (type & PURPLE_MESSAGE_AUTO_RESP) {
 			if (type & PURPLE_MESSAGE_SEND)
-				written += fprintf(data->file, _("<font color=\"#16569E\"><font size=\"2\">(%s)</font> <b>%s &lt;AUTO-REPLY&gt;:</b></font> %s<br/>\n"), date, escaped_from, msg_fixed);
+				line = g_strdup_printf(_("<font color=\"#16569E\"><font size=\"2\">(%s)</font> <b>%s &lt;AUTO-REPLY&gt;:</b></font> %s<br/>\n"), date, escaped_from, msg_fixed);
 			else if (type & PURPLE_MESSAGE_RECV)
-				written += fprintf(data->file, _("<font color=\"#A82F2F\"><font size=\"2\">(%s)</font> <b>%s &lt;AUTO-REPLY&gt;:</b></font> %s<br/>\n"), date, escaped_from, msg_fixed);
+				line = g_strdup_printf(_("<font color=\"#A82F2F\"><font size=\"2\">(%s)</font> <b>%s &lt;AUTO-REPLY&gt;:</b></font> %s<br/>\n"), date, escaped_from, msg_fixed);
 		} else if (type & PURPLE_MESSAGE_RECV) {
 			if(purple_message_meify(msg_fixed, -1))
-				written += fprintf(data->file, "<font color=\"#062585\"><font size=\"2\">(%s)</font> <b>***%s</b></font> %s<br/>\n",
+				line = g_strdup_printf("<font color=\"#062585\"><font size=\"2\">(%s)</font> <b>***%s</b></font> %s<br/>\n",
 						date, escaped_from, msg_fixed);
 			else
-				written += fprintf(data->file, "<font color=\"#A82F2F\"><font size=\"2\">(%s)</font> <b>%s:</b></font> %s<br/>\n",
+				line = g_strdup_printf("<font color=\"#A82F2F\"><font size=\"2\">(%s)</font> <b>%s:</b></font> %s<br/>\n",
 						date, escaped_from, msg_fixed);
 		} else if (type & PURPLE_MESSAGE_SEND) {
 			if(purple_message_meify(msg_fixed, -1))
-				written += fprintf(data->file, "<font color=\"#062585\"><font size=\"2\">(%s)</font> <b>***%s</b></font> %s<br/>\n",
+				line = g_strdup_printf("<font color=\"#062585\"><font size=\"2\">(%s)</font> <b>***%s</b></font> %s<br/>\n",
 						date, escaped_from, msg_fixed);
 			else
-				written += fprintf(data->file, "<font color=\"#16569E\"><font size=\"2\">(%s)</font> <b>%s:</b></font> %s<br/>\n",
+				line = g_strdup_printf("<font color=\"#16569E\"><font size=\"2\">(%s)</font> <b>%s:</b></font> %s<br/>\n",
 						date, escaped_from, msg_fixed);
 		} else {
 			purple_debug_error("log", "Unhandled message type.\n");
-			written += fprintf(data->file, "<font size=\"2\">(%s)</font><b> %s:</b></font> %s<br/>\n",
+			line = g_strdup_printf("<font size=\"2\">(%s)</font><b> %s:</b></font> %s<br/>\n",
 						date, escaped_from, msg_fixed);
 		}
 	}
 	g_free(date);
 	g_free(msg_fixed);
 	g_free(escaped_from);
+
+	return line;
+}
+
+/* Takes suffix off the end of str, if it's there. */
+static gboolean log_strip_suffix(char *str, const char *suffix)
+{
+	if (!g_str_has_suffix(str, suffix))
+		return FALSE;
+
+	str[strlen(str) - strlen(suffix)] = '\0';
+	return TRUE;
+}
+
+/* Recovers a message from what html_logger_format() wrote, as nearly as
+ * the markup around it allows.  time is the time of the message before it
+ * on the way in.  A line that can't be made out is kept as a raw message.
+ * Returns FALSE if there is no message. */
+static gboolean html_logger_parse(PurpleLog *log, const char *line, gsize len,
+		time_t *time, PurpleMessageFlags *flags, char **from, char **message)
+{
+	char *text, *p, *end;
+	const char *color = NULL;
+	const char *body = NULL;
+
+	text = g_strstrip(g_strndup(line, len));
+	if (log_strip_suffix(text, "</body></html>"))
+		g_strchomp(text);
+	log_strip_suffix(text, "<br/>");
+
+	if (*text == '\0') {
+		g_free(text);
+		return FALSE;
+	}
+
+	*flags = PURPLE_MESSAGE_RAW;
+	*from = NULL;
+	*message = NULL;
+	p = text;
+
+	if (log->type == PURPLE_LOG_SYSTEM) {
+		if (g_str_has_prefix(p, "---- ") && log_strip_suffix(p, " ----") &&
+				(end = g_strrstr(p + 5, " @ ")) != NULL) {
+			*end = '\0';
+			*time = log_parse_timestamp(end + 3, *time);
+			*flags = PURPLE_MESSAGE_SYSTEM;
+			body = p + 5;
+		}
+		*message = g_strdup(body ? body : text);
+		g_free(text);
+		return TRUE;
+	}
+
+	if (g_str_has_prefix(p, "<font color=\"") &&
+			(end = strstr(p, "\">")) != NULL) {
+		*end = '\0';
+		color = p + 13;
+		p = end + 2;
+	}
+
+	if (!g_str_has_prefix(p, "<font size=\"2\">(") ||
+			(end = strstr(p, ")</font>")) == NULL) {
+		/* Not something we wrote; keep all of it. */
+		g_free(text);
+		text = g_strstrip(g_strndup(line, len));
+		*message = text;
+		return TRUE;
+	}
+
+	*end = '\0';
+	*time = log_parse_timestamp(p + 16, *time);
+	p = end + 8;
+
+	if (color == NULL || purple_strequal(color, "#FF0000")) {
+		if (color != NULL)
+			log_strip_suffix(p, "</font>");
+
+		if (g_str_has_prefix(p, "<b> ") && log_strip_suffix(p, "</b>")) {
+			*flags = color ? PURPLE_MESSAGE_ERROR : PURPLE_MESSAGE_SYSTEM;
+			body = p + 4;
+		} else if (*p == ' ') {
+			body = p + 1;
+		}
+	} else if (g_str_has_prefix(p, " <b>") &&
+			(end = strstr(p, "</b></font> ")) != NULL) {
+		char *sender = p + 4;
+
+		*end = '\0';
+		body = end + 12;
+
+		if (purple_strequal(color, "#062585") &&
+				g_str_has_prefix(sender, "***")) {
+			/* The direction of an action isn't kept. */
+			*flags = PURPLE_MESSAGE_RECV;
+			*from = purple_unescape_html(sender + 3);
+			*message = g_strconcat("/me ", body, NULL);
+		} else {
+			*flags = purple_strequal(color, "#16569E") ?
+					PURPLE_MESSAGE_SEND : PURPLE_MESSAGE_RECV;
+			if (log_strip_suffix(sender, " &lt;AUTO-REPLY&gt;:"))
+				*flags |= PURPLE_MESSAGE_AUTO_RESP;
+			else
+				log_strip_suffix(sender, ":");
+			*from = purple_unescape_html(sender);
+		}
+	}
+
+	if (*message == NULL)
+		*message = g_strdup(body ? body : p);
+
+	g_free(text);
+	return TRUE;
+}
+
+static gsize html_logger_write(PurpleLog *log, PurpleMessageFlags type,
+							  const char *from, time_t time, const char *message)
+{
+	char *line;
+	char *header;
+	PurpleProtocol *protocol =
+			purple_protocols_find(purple_account_get_protocol_id(log->account));
+	PurpleLogCommonLoggerData *data = log->logger_data;
+	gsize written = 0;
+
+	if(!data) {
+		const char *proto = purple_protocol_class_list_icon(protocol, log->account, NULL);
+		const char *date;
+		purple_log_common_writer(log, ".html");
+
+		data = log->logger_data;
+
+		/* if we can't write to the file, give up before we hurt ourselves */
+		if(!data->file)
+			return 0;
+
+		log_index_open(data);
+
+		date = purple_date_format_full(localtime(&log->time));
+
+		written += fprintf(data->file, "<html><head>");
+		written += fprintf(data->file, "<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\">");
+		written += fprintf(data->file, "<title>");
+		if (log->type == PURPLE_LOG_SYSTEM)
+			header = g_strdup_printf("System log for account %s (%s) connected at %s",
+					purple_account_get_username(log->account), proto, date);
+		else
+			header = g_strdup_printf("Conversation with %s at %s on %s (%s)",
+					log->name, date, purple_account_get_username(log->account), proto);
+
+		written += fprintf(data->file, "%s", header);
+		written += fprintf(data->file, "</title></head><body>");
+		written += fprintf(data->file, "<h3>%s</h3>\n", header);
+		g_free(header);
+	}
+
+	/* if we can't write to the file, give up before we hurt ourselves */
+	if(!data->file)
+		return 0;
+
+	line = html_logger_format(log, type, from, time, message);
+	if (line != NULL) {
+		log_index_append(data);
+		written += fprintf(data->file, "%s", line);
+		g_free(line);
+	}
 	fflush(data->file);
 
 	return written;
@@ -1397,6 +1912,7 @@ static void html_logger_finalize(PurpleLog *log)
 			fprintf(data->file, "</body></html>\n");
 			fclose(data->file);
 		}
+		log_index_close(data);
 		g_free(data->path);
 
 		g_slice_free(PurpleLogCommonLoggerData, data);
@@ -1416,20 +1932,22 @@ static GList *html_logger_list_syslog(PurpleAccount *account)
 static char *html_logger_read(PurpleLog *log, PurpleLogReadFlags *flags)
 {
 	char *read;
+	gsize length;
 	PurpleLogCommonLoggerData *data = log->logger_data;
 	*flags = PURPLE_LOG_READ_NO_NEWLINE;
 	if (!data || !data->path)
 		return g_strdup(_("<font color=\"red\"><b>Unable to find log path!</b></font>"));
-	if (g_file_get_contents(data->path, &read, NULL, NULL)) {
+	if (g_file_get_contents(data->path, &read, &length, NULL)) {
 		char *minus_header = strchr(read, '\n');
 
 		if (!minus_header)
 			return read;
 
-		minus_header = g_strdup(minus_header + 1);
-		g_free(read);
+		/* Move the body over the header instead of copying it. */
+		minus_header++;
+		memmove(read, minus_header, length - (minus_header - read) + 1);
 
-		return minus_header;
+		return read;
 	}
 	return g_strdup_printf(_("<font color=\"red\"><b>Could not read file: %s</b></font>"), data->path);
 }
@@ -1444,15 +1962,126 @@ static int html_logger_total_size(PurpleLogType type, const char *name, PurpleAc
  ** PLAIN TEXT LOGGER *******
  ****************************/
 
+/* Formats a message the way the txt logger writes it, or returns %NULL
+ * if it isn't logged. */
+static char *txt_logger_format(PurpleLog *log, PurpleMessageFlags type,
+							  const char *from, time_t time, const char *message)
+{
+	char *date;
+	char *stripped = NULL;
+	char *line = NULL;
+
+	stripped = purple_markup_strip_html(message);
+	date = log_get_timestamp(log, time);
+
+	if(log->type == PURPLE_LOG_SYSTEM){
+		line = g_strdup_printf("---- %s @ %s ----\n", stripped, date);
+	} else {
+		if (type & PURPLE_MESSAGE_SEND ||
+			type & PURPLE_MESSAGE_RECV) {
+			if (type & PURPLE_MESSAGE_AUTO_RESP) {
+				line = g_strdup_printf(_("(%s) %s <AUTO-REPLY>: %s\n"), date,
+						from, stripped);
+			} else {
+				if(purple_message_meify(stripped, -1))
+					line = g_strdup_printf("(%s) ***%s %s\n", date, from,
+							stripped);
+				else
+					line = g_strdup_printf("(%s) %s: %s\n", date, from,
+							stripped);
+			}
+		} else if (type & PURPLE_MESSAGE_SYSTEM ||
+			type & PURPLE_MESSAGE_ERROR ||
+			type & PURPLE_MESSAGE_RAW)
+			line = g_strdup_printf("(%s) %s\n", date, stripped);
+		else if (type & PURPLE_MESSAGE_NO_LOG) {
+			/* This shouldn't happen */
+		} else
+			line = g_strdup_printf("(%s) %s%s %s\n", date, from ? from : "",
+					from ? ":" : "", stripped);
+	}
+	g_free(date);
+	g_free(stripped);
+
+	return line;
+}
+
+/* Recovers a message from what txt_logger_format() wrote.  Without markup,
+ * a line with a colon is taken to be a received message from whoever is
+ * before it, and any other line to be a system message.  time is the time
+ * of the message before it on the way in.  Returns FALSE if there is no
+ * message. */
+static gboolean txt_logger_parse(PurpleLog *log, const char *line, gsize len,
+		time_t *time, PurpleMessageFlags *flags, char **from, char **message)
+{
+	char *text, *p, *end, *escaped;
+	const char *body = NULL;
+	gboolean action = FALSE;
+
+	text = g_strstrip(g_strndup(line, len));
+	if (*text == '\0') {
+		g_free(text);
+		return FALSE;
+	}
+
+	*flags = PURPLE_MESSAGE_RAW;
+	*from = NULL;
+	p = text;
+
+	if (log->type == PURPLE_LOG_SYSTEM) {
+		if (g_str_has_prefix(p, "---- ") && log_strip_suffix(p, " ----") &&
+				(end = g_strrstr(p + 5, " @ ")) != NULL) {
+			*end = '\0';
+			*time = log_parse_timestamp(end + 3, *time);
+			*flags = PURPLE_MESSAGE_SYSTEM;
+			body = p + 5;
+		}
+	} else if (*p == '(' && (end = strstr(p, ") ")) != NULL) {
+		*end = '\0';
+		*time = log_parse_timestamp(p + 1, *time);
+		p = end + 2;
+
+		if (g_str_has_prefix(p, "***") && (end = strchr(p, ' ')) != NULL) {
+			*end = '\0';
+			*flags = PURPLE_MESSAGE_RECV;
+			*from = g_strdup(p + 3);
+			body = end + 1;
+			action = TRUE;
+		} else if ((end = strstr(p, " <AUTO-REPLY>: ")) != NULL) {
+			*end = '\0';
+			*flags = PURPLE_MESSAGE_RECV | PURPLE_MESSAGE_AUTO_RESP;
+			*from = g_strdup(p);
+			body = end + 15;
+		} else if ((end = strstr(p, ": ")) != NULL) {
+			*end = '\0';
+			*flags = PURPLE_MESSAGE_RECV;
+			*from = g_strdup(p);
+			body = end + 2;
+		} else {
+			*flags = PURPLE_MESSAGE_SYSTEM;
+			body = p;
+		}
+	}
+
+	/* The other loggers want markup. */
+	escaped = g_markup_escape_text(body ? body : text, -1);
+	p = purple_strdup_withhtml(escaped);
+	*message = action ? g_strconcat("/me ", p, NULL) : g_strdup(p);
+
+	g_free(p);
+	g_free(escaped);
+	g_free(text);
+	return TRUE;
+}
+
 static gsize txt_logger_write(PurpleLog *log,
 							 PurpleMessageFlags type,
 							 const char *from, time_t time, const char *message)
 {
-	char *date;
 	PurpleProtocol *protocol =
 			purple_protocols_find(purple_account_get_protocol_id(log->account));
 	PurpleLogCommonLoggerData *data = log->logger_data;
-	char *stripped = NULL;
+	char *line;
 
 	gsize written = 0;
 
@@ -1470,6 +2099,8 @@ static gsize txt_logger_write(PurpleLog *log,
 		if(!data || !data->file)
 			return 0;
 
+		log_index_open(data);
+
 		if (log->type == PURPLE_LOG_SYSTEM)
 			written += fprintf(data->file, "System log for account %s (%s) connected at %s\n",
 				purple_account_get_username(log->account), proto,
@@ -1484,39 +2115,12 @@ static gsize txt_logger_write(PurpleLog *log,
 	if(!data->file)
 		return 0;
 
-	stripped = purple_markup_strip_html(message);
-	date = log_get_timestamp(log, time);
-
-	if(log->type == PURPLE_LOG_SYSTEM){
-		written += fprintf(data->file, "---- %s @ %s ----\n", stripped, date);
-	} else {
-		if (type & PURPLE_MESSAGE_SEND ||
-			type & PURPLE_MESSAGE_RECV) {
-			if (type & PURPLE_MESSAGE_AUTO_RESP) {
-				written += fprintf(data->file, _("(%s) %s <AUTO-REPLY>: %s\n"), date,
-						from, stripped);
-			} else {
-				if(purple_message_meify(stripped, -1))
-					written += fprintf(data->file, "(%s) ***%s %s\n", date, from,
-							stripped);
-				else
-					written += fprintf(data->file, "(%s) %s: %s\n", date, from,
-							stripped);
-			}
-		} else if (type & PURPLE_MESSAGE_SYSTEM ||
-			type & PURPLE_MESSAGE_ERROR ||
-			type & PURPLE_MESSAGE_RAW)
-			written += fprintf(data->file, "(%s) %s\n", date, stripped);
-		else if (type & PURPLE_MESSAGE_NO_LOG) {
-			/* This shouldn't happen */
-			g_free(stripped);
-			return written;
-		} else
-			written += fprintf(data->file, "(%s) %s%s %s\n", date, from ? from : "",
-					from ? ":" : "", stripped);
+	line = txt_logger_format(log, type, from, time, message);
+	if (line != NULL) {
+		log_index_append(data);
+		written += fprintf(data->file, "%s", line);
+		g_free(line);
 	}
-	g_free(date);
-	g_free(stripped);
 	fflush(data->file);
 
 	return written;
@@ -1528,6 +2132,7 @@ static void txt_logger_finalize(PurpleLog *log)
 	if (data) {
 		if(data->file)
 			fclose(data->file);
+		log_index_close(data);
 		g_free(data->path);
 
 		g_slice_free(PurpleLogCommonLoggerData, data);
@@ -1568,6 +2173,460 @@ static int txt_logger_total_size(PurpleLogType type, const char *name, PurpleAcc
 }
 
 
+/****************************
+ ** BINARY LOGGER ***********
+ ****************************/
+
+/* A binary log is BINARY_LOG_MAGIC followed by records.  Each record is a
+ * 32-bit length and that many bytes, the first of which is the kind of the
+ * record.  A message record then holds the time, the message flags, the
+ * length of the sender, the sender and the message, which runs to the end
+ * of the record.  When a log is closed, an index record with the offset of
+ * every message record is written last.  It ends with its own offset and
+ * BINARY_LOG_INDEX_MAGIC, so it can be found from the end of the file.
+ * Logs that weren't closed are read record by record instead.  All integers
+ * are little-endian. */
+
+#define BINARY_LOG_EXT ".plog"
+#define BINARY_LOG_MAGIC "PLOG\001\0\0\0"
+#define BINARY_LOG_INDEX_MAGIC "PLOGIDX\0"
+#define BINARY_LOG_MAGIC_LEN 8
+
+#define BINARY_RECORD_MESSAGE 0
+#define BINARY_RECORD_INDEX   1
+
+/* The kind, time, flags and sender length of a message record */
+#define BINARY_MESSAGE_HEADER_LEN (1 + 8 + 4 + 2)
+/* The kind and count of an index record, and its offset and magic */
+#define BINARY_INDEX_HEADER_LEN (1 + 8)
+#define BINARY_INDEX_TRAILER_LEN (8 + BINARY_LOG_MAGIC_LEN)
+
+struct binary_logger_data {
+	GArray *offsets;     /* The offset of each message record written */
+	gboolean complete;   /* Whether that is every message in the file */
+};
+
+static guint16 binary_get_uint16(const char *p)
+{
+	guint16 val;
+	memcpy(&val, p, sizeof(val));
+	return GUINT16_FROM_LE(val);
+}
+
+static guint32 binary_get_uint32(const char *p)
+{
+	guint32 val;
+	memcpy(&val, p, sizeof(val));
+	return GUINT32_FROM_LE(val);
+}
+
+static guint64 binary_get_uint64(const char *p)
+{
+	guint64 val;
+	memcpy(&val, p, sizeof(val));
+	return GUINT64_FROM_LE(val);
+}
+
+/* Finds the record at offset.  Returns the offset of the record after it,
+ * or 0 if the record doesn't fit in the log. */
+static gsize binary_log_next_record(const char *data, gsize size, gsize offset,
+		const char **body, gsize *len)
+{
+	guint32 length;
+
+	if (offset > size || size - offset < 4)
+		return 0;
+
+	length = binary_get_uint32(data + offset);
+	if (length == 0 || length > size - offset - 4)
+		return 0;
+
+	*body = data + offset + 4;
+	*len = length;
+
+	return offset + 4 + length;
+}
+
+static gboolean binary_log_decode(const char *data, gsize size, gsize offset,
+		time_t *time, PurpleMessageFlags *flags, char **from, char **message)
+{
+	const char *body;
+	gsize len;
+	guint16 from_len;
+
+	if (!binary_log_next_record(data, size, offset, &body, &len) ||
+			len < BINARY_MESSAGE_HEADER_LEN ||
+			body[0] != BINARY_RECORD_MESSAGE)
+		return FALSE;
+
+	from_len = binary_get_uint16(body + 13);
+	if (from_len > len - BINARY_MESSAGE_HEADER_LEN)
+		return FALSE;
+
+	if (time != NULL)
+		*time = (time_t)(gint64)binary_get_uint64(body + 1);
+	if (flags != NULL)
+		*flags = binary_get_uint32(body + 9);
+	if (from != NULL)
+		*from = from_len ? g_strndup(body + BINARY_MESSAGE_HEADER_LEN, from_len) : NULL;
+	if (message != NULL)
+		*message = g_strndup(body + BINARY_MESSAGE_HEADER_LEN + from_len,
+				len - BINARY_MESSAGE_HEADER_LEN - from_len);
+
+	return TRUE;
+}
+
+static gboolean binary_log_load_index(const char *data, gsize size, GArray *offsets)
+{
+	const char *body;
+	gsize len, count, i;
+	guint64 index_offset, prev = 0;
+
+	if (size < BINARY_LOG_MAGIC_LEN + 4 + BINARY_INDEX_HEADER_LEN + BINARY_INDEX_TRAILER_LEN ||
+			memcmp(data + size - BINARY_LOG_MAGIC_LEN, BINARY_LOG_INDEX_MAGIC,
+				BINARY_LOG_MAGIC_LEN) != 0)
+		return FALSE;
+
+	index_offset = binary_get_uint64(data + size - BINARY_INDEX_TRAILER_LEN);
+	if (index_offset >= size ||
+			binary_log_next_record(data, size, index_offset, &body, &len) != size ||
+			len < BINARY_INDEX_HEADER_LEN + BINARY_INDEX_TRAILER_LEN ||
+			body[0] != BINARY_RECORD_INDEX)
+		return FALSE;
+
+	count = len - BINARY_INDEX_HEADER_LEN - BINARY_INDEX_TRAILER_LEN;
+	if (count % 8 != 0 || count / 8 != binary_get_uint64(body + 1))
+		return FALSE;
+	count /= 8;
+
+	for (i = 0; i < count; i++) {
+		guint64 entry = binary_get_uint64(body + BINARY_INDEX_HEADER_LEN + i * 8);
+		gsize offset;
+
+		if (entry < BINARY_LOG_MAGIC_LEN || entry >= index_offset ||
+				(i > 0 && entry <= prev)) {
+			g_array_set_size(offsets, 0);
+			return FALSE;
+		}
+
+		offset = entry;
+		g_array_append_val(offsets, offset);
+		prev = entry;
+	}
+
+	return TRUE;
+}
+
+/* Finds the offset of every message in a binary log. */
+static gboolean binary_log_get_offsets(const char *data, gsize size, GArray *offsets)
+{
+	gsize offset, next;
+
+	if (size < BINARY_LOG_MAGIC_LEN ||
+			memcmp(data, BINARY_LOG_MAGIC, BINARY_LOG_MAGIC_LEN) != 0)
+		return FALSE;
+
+	if (binary_log_load_index(data, size, offsets))
+		return TRUE;
+
+	for (offset = BINARY_LOG_MAGIC_LEN; offset < size; offset = next) {
+		const char *body;
+		gsize len;
+
+		/* The rest of the log was cut short. */
+		next = binary_log_next_record(data, size, offset, &body, &len);
+		if (next == 0)
+			break;
+
+		if (body[0] == BINARY_RECORD_MESSAGE)
+			g_array_append_val(offsets, offset);
+	}
+
+	return TRUE;
+}
+
+/* Appends some messages of a binary log as the html logger writes them. */
+static void binary_log_format(PurpleLog *log, const char *data, gsize size,
+		GArray *offsets, gsize first, gsize count, GString *str)
+{
+	gsize i;
+
+	for (i = first; i < first + count && i < offsets->len; i++) {
+		PurpleMessageFlags flags;
+		time_t time;
+		char *from, *message, *line;
+
+		if (!binary_log_decode(data, size, g_array_index(offsets, gsize, i),
+				&time, &flags, &from, &message))
+			continue;
+
+		line = html_logger_format(log, flags, from, time, message);
+		if (line != NULL)
+			g_string_append(str, line);
+
+		g_free(line);
+		g_free(from);
+		g_free(message);
+	}
+}
+
+static void binary_log_write_index(FILE *file, GArray *offsets)
+{
+	long offset = ftell(file);
+	guint32 length;
+	guint64 val;
+	guint8 kind = BINARY_RECORD_INDEX;
+	guint i;
+
+	if (offset < 0 || offsets->len > (G_MAXUINT32 -
+			BINARY_INDEX_HEADER_LEN - BINARY_INDEX_TRAILER_LEN) / 8)
+		return;
+
+	length = GUINT32_TO_LE(BINARY_INDEX_HEADER_LEN + offsets->len * 8 +
+			BINARY_INDEX_TRAILER_LEN);
+	fwrite(&length, sizeof(length), 1, file);
+	fwrite(&kind, sizeof(kind), 1, file);
+
+	val = GUINT64_TO_LE((guint64)offsets->len);
+	fwrite(&val, sizeof(val), 1, file);
+	for (i = 0; i < offsets->len; i++) {
+		val = GUINT64_TO_LE(g_array_index(offsets, guint64, i));
+		fwrite(&val, sizeof(val), 1, file);
+	}
+
+	val = GUINT64_TO_LE((guint64)offset);
+	fwrite(&val, sizeof(val), 1, file);
+	fwrite(BINARY_LOG_INDEX_MAGIC, 1, BINARY_LOG_MAGIC_LEN, file);
+}
+
+static gsize binary_logger_write(PurpleLog *log, PurpleMessageFlags type,
+								const char *from, time_t time, const char *message)
+{
+	PurpleLogCommonLoggerData *data = log->logger_data;
+	struct binary_logger_data *bdata;
+	char *image_corrected_msg;
+	char header[4 + BINARY_MESSAGE_HEADER_LEN];
+	gsize from_len, message_len, record_len;
+	gsize written = 0;
+	guint16 val16;
+	guint32 val32;
+	guint64 val64;
+	long offset;
+
+	if (data == NULL) {
+		purple_log_common_writer(log, BINARY_LOG_EXT);
+
+		data = log->logger_data;
+
+		/* if we can't write to the file, give up before we hurt ourselves */
+		if (data == NULL || data->file == NULL)
+			return 0;
+
+		bdata = g_new0(struct binary_logger_data, 1);
+		bdata->offsets = g_array_new(FALSE, FALSE, sizeof(guint64));
+		data->extra_data = bdata;
+
+		/* A log that was written to before already has its magic, but
+		 * our index wouldn't have the messages that are already in it. */
+		if (ftell(data->file) == 0) {
+			bdata->complete = TRUE;
+			written += fwrite(BINARY_LOG_MAGIC, 1, BINARY_LOG_MAGIC_LEN, data->file);
+		}
+	}
+
+	/* if we can't write to the file, give up before we hurt ourselves */
+	if (data->file == NULL)
+		return 0;
+
+	bdata = data->extra_data;
+
+	image_corrected_msg = convert_image_tags(log, message);
+
+	from_len = from ? MIN(strlen(from), G_MAXUINT16) : 0;
+	message_len = MIN(strlen(image_corrected_msg),
+			G_MAXUINT32 - BINARY_MESSAGE_HEADER_LEN - G_MAXUINT16);
+	record_len = BINARY_MESSAGE_HEADER_LEN + from_len + message_len;
+
+	val32 = GUINT32_TO_LE((guint32)record_len);
+	memcpy(header, &val32, sizeof(val32));
+	header[4] = BINARY_RECORD_MESSAGE;
+	val64 = GUINT64_TO_LE((guint64)(gint64)time);
+	memcpy(header + 5, &val64, sizeof(val64));
+	val32 = GUINT32_TO_LE((guint32)type);
+	memcpy(header + 13, &val32, sizeof(val32));
+	val16 = GUINT16_TO_LE((guint16)from_len);
+	memcpy(header + 17, &val16, sizeof(val16));
+
+	offset = ftell(data->file);
+	if (offset >= 0) {
+		guint64 entry = offset;
+		g_array_append_val(bdata->offsets, entry);
+	} else {
+		bdata->complete = FALSE;
+	}
+
+	written += fwrite(header, 1, sizeof(header), data->file);
+	if (from_len > 0)
+		written += fwrite(from, 1, from_len, data->file);
+	written += fwrite(image_corrected_msg, 1, message_len, data->file);
+	fflush(data->file);
+
+	/* A record that was cut short can't be indexed. */
+	if (written < sizeof(header) + from_len + message_len)
+		bdata->complete = FALSE;
+
+	if (image_corrected_msg != message)
+		g_free(image_corrected_msg);
+
+	return written;
+}
+
+static void binary_logger_finalize(PurpleLog *log)
+{
+	PurpleLogCommonLoggerData *data = log->logger_data;
+	struct binary_logger_data *bdata;
+
+	if (data == NULL)
+		return;
+
+	bdata = data->extra_data;
+
+	if (data->file) {
+		if (bdata != NULL && bdata->complete && bdata->offsets->len > 0)
+			binary_log_write_index(data->file, bdata->offsets);
+		fclose(data->file);
+	}
+
+	if (bdata != NULL) {
+		g_array_free(bdata->offsets, TRUE);
+		g_free(bdata);
+	}
+	g_free(data->path);
+
+	g_slice_free(PurpleLogCommonLoggerData, data);
+}
+
+static GList *binary_logger_list(PurpleLogType type, const char *sn, PurpleAccount *account)
+{
+	return purple_log_common_lister(type, sn, account, BINARY_LOG_EXT, binary_logger);
+}
+
+static GList *binary_logger_list_syslog(PurpleAccount *account)
+{
+	return purple_log_common_lister(PURPLE_LOG_SYSTEM, ".system", account, BINARY_LOG_EXT, binary_logger);
+}
+
+static char *binary_logger_read(PurpleLog *log, PurpleLogReadFlags *flags)
+{
+	PurpleLogCommonLoggerData *data = log->logger_data;
+	GMappedFile *file;
+	GArray *offsets;
+	GString *read;
+	gboolean valid;
+
+	*flags = PURPLE_LOG_READ_NO_NEWLINE;
+	if (!data || !data->path)
+		return g_strdup(_("<font color=\"red\"><b>Unable to find log path!</b></font>"));
+
+	file = g_mapped_file_new(data->path, FALSE, NULL);
+	if (file == NULL)
+		return g_strdup_printf(_("<font color=\"red\"><b>Could not read file: %s</b></font>"), data->path);
+
+	offsets = g_array_new(FALSE, FALSE, sizeof(gsize));
+	read = g_string_new(NULL);
+
+	valid = binary_log_get_offsets(g_mapped_file_get_contents(file),
+			g_mapped_file_get_length(file), offsets);
+	if (valid)
+		binary_log_format(log, g_mapped_file_get_contents(file),
+				g_mapped_file_get_length(file), offsets, 0, offsets->len, read);
+
+	g_array_free(offsets, TRUE);
+	g_mapped_file_unref(file);
+
+	if (!valid) {
+		g_string_free(read, TRUE);
+		return g_strdup_printf(_("<font color=\"red\"><b>Could not read file: %s</b></font>"), data->path);
+	}
+
+	return g_string_free(read, FALSE);
+}
+
+static int binary_logger_total_size(PurpleLogType type, const char *name, PurpleAccount *account)
+{
+	return purple_log_common_total_sizer(type, name, account, BINARY_LOG_EXT);
+}
+
+PurpleLog *purple_log_convert(PurpleLog *log, PurpleLogLogger *logger)
+{
+	PurpleLogReader *reader;
+	PurpleLog *copy;
+	time_t time;
+	gsize i;
+
+	g_return_val_if_fail(log != NULL, NULL);
+	g_return_val_if_fail(logger != NULL && logger->write != NULL, NULL);
+
+	if (log->logger == logger || (log->logger != html_logger &&
+			log->logger != txt_logger && log->logger != binary_logger))
+		return NULL;
+
+	/* The reader finds where each message starts, from the index of the
+	 * log if it has one. */
+	reader = purple_log_reader_new(log);
+	if (reader->file == NULL || reader->offsets->len == 0) {
+		purple_log_reader_free(reader);
+		return NULL;
+	}
+
+	copy = purple_log_new(log->type, log->name, log->account, NULL,
+			log->time, log->tm);
+
+	/* purple_log_new() sets up the log for the current logger. */
+	if (copy->logger != logger) {
+		if (copy->logger && copy->logger->finalize)
+			copy->logger->finalize(copy);
+		copy->logger = logger;
+		copy->logger_data = NULL;
+		if (logger->create)
+			logger->create(copy);
+	}
+
+	time = log->time;
+	for (i = 0; i < reader->offsets->len; i++) {
+		gsize start = g_array_index(reader->offsets, gsize, i);
+		gsize end = reader->size;
+		PurpleMessageFlags flags;
+		char *from, *message;
+		gboolean found;
+
+		if (i + 1 < reader->offsets->len)
+			end = g_array_index(reader->offsets, gsize, i + 1);
+
+		if (reader->binary)
+			found = binary_log_decode(reader->data, reader->size, start,
+					&time, &flags, &from, &message);
+		else if (log->logger == html_logger)
+			found = html_logger_parse(log, reader->data + start,
+					end - start, &time, &flags, &from, &message);
+		else
+			found = txt_logger_parse(log, reader->data + start,
+					end - start, &time, &flags, &from, &message);
+
+		if (!found)
+			continue;
+
+		purple_log_write(copy, flags, from, time, message);
+		g_free(from);
+		g_free(message);
+	}
+
+	purple_log_reader_free(reader);
+
+	return copy;
+}
+
+
 /****************
  * OLD LOGGER ***
  ****************/
@@ -41,6 +41,7 @@ typedef struct _PurpleLog PurpleLog;
 typedef struct _PurpleLogLogger PurpleLogLogger;
 typedef struct _PurpleLogCommonLoggerData PurpleLogCommonLoggerData;
 typedef struct _PurpleLogSet PurpleLogSet;
+typedef struct _PurpleLogReader PurpleLogReader;
 
 typedef enum {
 	PURPLE_LOG_IM,
@@ -271,6 +272,89 @@ void purple_log_write(PurpleLog *log,
  */
 char *purple_log_read(PurpleLog *log, PurpleLogReadFlags *flags);
 
+/**
+ * purple_log_reader_new:
+ * @log:   The log to read from
+ *
+ * Opens a log to be read a few messages at a time, instead of all at once
+ * with purple_log_read().  Logs written by the html, txt and binary loggers
+ * are mapped into memory rather than read, and the offset of each message
+ * comes from the index those loggers keep.  Other logs are read
+ * with purple_log_read() and split into lines.
+ *
+ * The log must not be freed before the reader.
+ *
+ * Returns: (transfer full): The new reader
+ */
+PurpleLogReader *purple_log_reader_new(PurpleLog *log);
+
+/**
+ * purple_log_reader_get_count:
+ * @reader: The reader
+ *
+ * Returns the number of messages in a log.
+ *
+ * Returns: The number of messages
+ */
+gsize purple_log_reader_get_count(PurpleLogReader *reader);
+
+/**
+ * purple_log_reader_read:
+ * @reader: The reader
+ * @first:  The index of the first message to read
+ * @count:  How many messages to read
+ * @flags:  The returned logging flags.
+ *
+ * Reads some messages from a log.  The markup is the same as that
+ * purple_log_read() returns for those messages.
+ *
+ * Returns: The messages in Purple Markup, or %NULL if @first is past the
+ *          last message.
+ */
+char *purple_log_reader_read(PurpleLogReader *reader, gsize first, gsize count,
+		PurpleLogReadFlags *flags);
+
+/**
+ * purple_log_reader_find_time:
+ * @reader: The reader
+ * @when:   The time to look for
+ *
+ * Finds the first message written at or after a time.  Only the binary
+ * logger keeps the time of each message, so this is always 0 for other
+ * logs.
+ *
+ * Returns: The index of the message, which is the number of messages if
+ *          they were all written before @when.
+ */
+gsize purple_log_reader_find_time(PurpleLogReader *reader, time_t when);
+
+/**
+ * purple_log_reader_free:
+ * @reader: The reader
+ *
+ * Frees a reader.
+ */
+void purple_log_reader_free(PurpleLogReader *reader);
+
+/**
+ * purple_log_convert:
+ * @log:    The html, txt or binary log to convert
+ * @logger: The logger to write the new log with
+ *
+ * Writes every message of a log to a new log written by @logger, with the
+ * same time, so it sits next to the old one.  The binary logger keeps each
+ * message as it was written.  The html and txt loggers only keep text, so
+ * the sender, the kind of message and its time of day are recovered from
+ * that text as nearly as it allows, and anything that can't be made out is
+ * written as a raw message.
+ *
+ * Returns: (transfer full): The new log, which must be freed with
+ *          purple_log_free(), or %NULL if @log wasn't written by one of
+ *          those loggers, was written by @logger, or has no messages that
+ *          can be read.
+ */
+PurpleLog *purple_log_convert(PurpleLog *log, PurpleLogLogger *logger);
+
 /**
  * purple_log_get_logs:
  * @type:                The type of the log
@@ -605,6 +689,16 @@ void purple_log_logger_set (PurpleLogLogger *logger);
  */
 PurpleLogLogger *purple_log_logger_get (void);
 
+/**
+ * purple_log_logger_find:
+ * @id:           The id of the logger
+ *
+ * Finds a logger that has been added.
+ *
+ * Returns: The logger, or %NULL if no logger has that id
+ */
+PurpleLogLogger *purple_log_logger_find(const char *id);
+
 /**
  * purple_log_logger_get_options:
  *
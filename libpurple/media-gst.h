@@ -208,6 +208,31 @@ void purple_media_manager_set_video_caps(PurpleMediaManager *manager,
  */
 GstCaps *purple_media_manager_get_video_caps(PurpleMediaManager *manager);
 
+/**
+ * purple_media_gst_buffer_new_from_bytes:
+ * @bytes: The data to wrap.
+ *
+ * Creates a read-only buffer that uses the data of @bytes without copying
+ * it.  The buffer keeps a reference to @bytes.
+ *
+ * Returns: (transfer full): The new buffer.
+ */
+GstBuffer *purple_media_gst_buffer_new_from_bytes(GBytes *bytes);
+
+/**
+ * purple_media_gst_buffer_get_bytes:
+ * @buffer: The buffer.
+ * @offset: Where in @buffer to start.
+ *
+ * Gets a view of the data in @buffer from @offset on.  The buffer stays
+ * mapped and referenced until the returned #GBytes is freed.  Data that is
+ * held in a single memory block, as it usually is, isn't copied.
+ *
+ * Returns: (transfer full): The data, or %NULL if @buffer couldn't be
+ *          mapped.
+ */
+GBytes *purple_media_gst_buffer_get_bytes(GstBuffer *buffer, gsize offset);
+
 gchar *purple_media_element_info_get_id(PurpleMediaElementInfo *info);
 gchar *purple_media_element_info_get_name(PurpleMediaElementInfo *info);
 PurpleMediaElementType purple_media_element_info_get_element_type(
@@ -1054,6 +1054,9 @@ create_recv_appsink(PurpleMediaElementInfo *element_info, PurpleMedia *media,
 		GstCaps *caps = gst_caps_new_empty_simple ("application/octet-stream");
 
 		appsink = gst_element_factory_make("appsink", NULL);
+		/* Received data is handed out without copying, so the sink must
+		 * not keep the last buffer alive behind the reader's back. */
+		g_object_set (appsink, "enable-last-sample", FALSE, NULL);
 
 		info->appsink = (GstAppSink *)appsink;
 
@@ -1753,18 +1756,18 @@ purple_media_manager_set_application_data_callbacks(PurpleMediaManager *manager,
 #endif
 }
 
-gint
-purple_media_manager_send_application_data (
-	PurpleMediaManager *manager, PurpleMedia *media, const gchar *session_id,
-	const gchar *participant, gpointer buffer, guint size, gboolean blocking)
-{
 #ifdef HAVE_MEDIA_APPLICATION
+/* Takes ownership of gstbuffer. */
+static gint
+send_application_buffer (PurpleMediaManager *manager, PurpleMedia *media,
+	const gchar *session_id, const gchar *participant, GstBuffer *gstbuffer,
+	gboolean blocking)
+{
 	PurpleMediaAppDataInfo * info = get_app_data_info_and_lock (manager,
 		media, session_id, participant);
 
 	if (info && info->appsrc && info->connected) {
-		GstBuffer *gstbuffer = gst_buffer_new_wrapped (g_memdup (buffer, size),
-			size);
+		gsize size = gst_buffer_get_size (gstbuffer);
 		GstAppSrc *appsrc = gst_object_ref (info->appsrc);
 
 		g_mutex_unlock (&manager->priv->appdata_mutex);
@@ -1787,7 +1790,35 @@ purple_media_manager_send_application_data (
 		}
 	}
 	g_mutex_unlock (&manager->priv->appdata_mutex);
+	gst_buffer_unref (gstbuffer);
 	return -1;
+}
+#endif
+
+gint
+purple_media_manager_send_application_data (
+	PurpleMediaManager *manager, PurpleMedia *media, const gchar *session_id,
+	const gchar *participant, gpointer buffer, guint size, gboolean blocking)
+{
+#ifdef HAVE_MEDIA_APPLICATION
+	/* The caller keeps its buffer, so this one has to be copied. */
+	return send_application_buffer (manager, media, session_id, participant,
+		gst_buffer_new_wrapped (g_memdup (buffer, size), size), blocking);
+#else
+	return -1;
+#endif
+}
+
+gint
+purple_media_manager_send_application_data_bytes (
+	PurpleMediaManager *manager, PurpleMedia *media, const gchar *session_id,
+	const gchar *participant, GBytes *bytes, gboolean blocking)
+{
+#ifdef HAVE_MEDIA_APPLICATION
+	g_return_val_if_fail (bytes != NULL, -1);
+
+	return send_application_buffer (manager, media, session_id, participant,
+		purple_media_gst_buffer_new_from_bytes (bytes), blocking);
 #else
 	return -1;
 #endif
@@ -1881,7 +1912,119 @@ purple_media_manager_receive_application_data (
 #endif
 }
 
+GBytes *
+purple_media_manager_receive_application_data_bytes (
+	PurpleMediaManager *manager, PurpleMedia *media, const gchar *session_id,
+	const gchar *participant, gboolean blocking)
+{
+#ifdef HAVE_MEDIA_APPLICATION
+	PurpleMediaAppDataInfo * info = get_app_data_info_and_lock (manager,
+		media, session_id, participant);
+	GBytes *bytes = NULL;
+
+	while (info) {
+		if (!info->current_sample && info->appsink && info->num_samples > 0) {
+			info->current_sample = gst_app_sink_pull_sample (info->appsink);
+			info->sample_offset = 0;
+			if (info->current_sample)
+				info->num_samples--;
+			else
+				/* The sink is flushing or at EOS, there's nothing to pull */
+				info->num_samples = 0;
+		}
+
+		if (info->current_sample) {
+			GstBuffer *gstbuffer = gst_sample_get_buffer (
+				info->current_sample);
+
+			/* Hand out whatever is left of the sample. The view keeps its
+			 * own reference to the buffer. */
+			if (gstbuffer)
+				bytes = purple_media_gst_buffer_get_bytes (gstbuffer,
+					info->sample_offset);
+
+			gst_sample_unref (info->current_sample);
+			info->current_sample = NULL;
+			info->sample_offset = 0;
+
+			if (bytes)
+				break;
+			continue;
+		}
+
+		if (!blocking || info->appsink == NULL)
+			break;
+
+		g_cond_wait (&info->readable_cond, &manager->priv->appdata_mutex);
+
+		/* We've been signaled, we need to unlock and regrab the info
+		 * struct to make sure nothing changed */
+		g_mutex_unlock (&manager->priv->appdata_mutex);
+		info = get_app_data_info_and_lock (manager,
+			media, session_id, participant);
+	}
+
+	g_mutex_unlock (&manager->priv->appdata_mutex);
+	return bytes;
+#else
+	return NULL;
+#endif
+}
+
 #ifdef USE_VV
+typedef struct
+{
+	GstBuffer *buffer;
+	GstMapInfo info;
+} PurpleMediaBufferMapping;
+
+static void
+buffer_mapping_free(PurpleMediaBufferMapping *mapping)
+{
+	gst_buffer_unmap(mapping->buffer, &mapping->info);
+	gst_buffer_unref(mapping->buffer);
+	g_slice_free(PurpleMediaBufferMapping, mapping);
+}
+
+GstBuffer *
+purple_media_gst_buffer_new_from_bytes(GBytes *bytes)
+{
+	gconstpointer data;
+	gsize size;
+
+	g_return_val_if_fail(bytes != NULL, NULL);
+
+	data = g_bytes_get_data(bytes, &size);
+	if (size == 0)
+		return gst_buffer_new();
+
+	return gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY,
+			(gpointer)data, size, 0, size, g_bytes_ref(bytes),
+			(GDestroyNotify)g_bytes_unref);
+}
+
+GBytes *
+purple_media_gst_buffer_get_bytes(GstBuffer *buffer, gsize offset)
+{
+	PurpleMediaBufferMapping *mapping;
+
+	g_return_val_if_fail(GST_IS_BUFFER(buffer), NULL);
+
+	mapping = g_slice_new(PurpleMediaBufferMapping);
+	if (!gst_buffer_map(buffer, &mapping->info, GST_MAP_READ)) {
+		g_slice_free(PurpleMediaBufferMapping, mapping);
+		return NULL;
+	}
+
+	if (offset > mapping->info.size)
+		offset = mapping->info.size;
+
+	mapping->buffer = gst_buffer_ref(buffer);
+
+	return g_bytes_new_with_free_func(mapping->info.data + offset,
+			mapping->info.size - offset,
+			(GDestroyNotify)buffer_mapping_free, mapping);
+}
 
 static void
 videosink_disable_last_sample(GstElement *sink)
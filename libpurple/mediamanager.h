@@ -382,6 +382,46 @@ gint purple_media_manager_receive_application_data (
 	const gchar *participant, gpointer buffer, guint max_size,
 	gboolean blocking);
 
+/**
+ * purple_media_manager_send_application_data_bytes:
+ * @manager: The manager to send data with.
+ * @media: The media instance to which the session belongs.
+ * @session_id: The session to send data to.
+ * @participant: The participant to send data to.
+ * @bytes: The data to send.
+ * @blocking: Whether to block until the data was send or not.
+ *
+ * Like purple_media_manager_send_application_data(), but without copying
+ * the data.  The session keeps a reference to @bytes until the data has
+ * been sent, so it must not be changed in the meantime.
+ *
+ * Returns: Number of bytes sent or -1 in case of error.
+ */
+gint purple_media_manager_send_application_data_bytes (
+	PurpleMediaManager *manager, PurpleMedia *media, const gchar *session_id,
+	const gchar *participant, GBytes *bytes, gboolean blocking);
+
+/**
+ * purple_media_manager_receive_application_data_bytes:
+ * @manager: The manager to receive data with.
+ * @media: The media instance to which the session belongs.
+ * @session_id: The session to receive data from.
+ * @participant: The participant to receive data from.
+ * @blocking: Whether to block until data is available or return at once.
+ *
+ * Receives the next chunk of data from a #PURPLE_MEDIA_APPLICATION
+ * session, as it was received from the network.  The data is not copied:
+ * the returned #GBytes holds on to the received buffer until it is
+ * unreferenced.  If purple_media_manager_receive_application_data() already
+ * read part of the chunk, only the rest is returned.
+ *
+ * Returns: (transfer full): The data, or %NULL if there is none or in case
+ *          of error.
+ */
+GBytes *purple_media_manager_receive_application_data_bytes (
+	PurpleMediaManager *manager, PurpleMedia *media, const gchar *session_id,
+	const gchar *participant, gboolean blocking);
+
 /*}@*/
 
 G_END_DECLS
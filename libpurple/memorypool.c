@@ -20,6 +20,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02111-1301 USA
  */
 
+#include "internal.h"
 #include "memorypool.h"
 
 #include <string.h>
@@ -94,6 +95,8 @@ purple_memory_pool_block_new(gulong block_size)
 	block->end_ptr = PURPLE_MEMORY_POINTER_SHIFT(block_raw, total_size);
 	block->next = NULL;
 
+	PURPLE_MEMSTAT_ALLOC(PURPLE_MEMSTAT_MEMORY_POOLS, total_size);
+
 	return block;
 }
 
@@ -173,6 +176,8 @@ purple_memory_pool_cleanup_impl(PurpleMemoryPool *pool)
 	priv->last_block = NULL;
 	while (blk) {
 		PurpleMemoryPoolBlock *next = blk->next;
+		PURPLE_MEMSTAT_FREE(PURPLE_MEMSTAT_MEMORY_POOLS,
+			(gchar *)blk->end_ptr - (gchar *)blk);
 		g_free(blk);
 		blk = next;
 	}
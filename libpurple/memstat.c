@@ -0,0 +1,203 @@
+/* purple
+ *
+ * Purple is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ */
+#include "internal.h"
+#include "memstat.h"
+
+static const char * const counter_names[PURPLE_MEMSTAT_COUNTERS] = {
+	"blist nodes",
+	"xml nodes",
+	"conversations",
+	"message history",
+	"images",
+	"http",
+	"circular buffers",
+	"memory pools"
+};
+
+#ifdef ENABLE_MEMSTAT
+/* Objects may be created and freed outside of the main thread, such as
+ * PurpleXmlNodes parsed by a plugin's worker thread.  Taking a lock for
+ * every XML node would serialize parsing, so the counters are updated
+ * atomically instead, which is why every field is pointer sized. */
+typedef struct
+{
+	gssize count;
+	gssize bytes;
+	gssize peak_bytes;
+	gsize allocs;
+} MemStatCounter;
+
+static MemStatCounter counters[PURPLE_MEMSTAT_COUNTERS];
+static PurpleMemStatSampler samplers[PURPLE_MEMSTAT_COUNTERS];
+
+void
+_purple_memstat_add(PurpleMemStatCounter counter, gssize count, gssize bytes)
+{
+	MemStatCounter *stat = &counters[counter];
+	gssize now, peak;
+
+	g_atomic_pointer_add(&stat->count, count);
+	now = g_atomic_pointer_add(&stat->bytes, bytes) + bytes;
+	if (count > 0)
+		g_atomic_pointer_add(&stat->allocs, count);
+
+	do {
+		peak = (gssize)g_atomic_pointer_get(&stat->peak_bytes);
+		if (now <= peak)
+			break;
+	} while (!g_atomic_pointer_compare_and_exchange(&stat->peak_bytes,
+			peak, now));
+}
+
+void
+_purple_memstat_set_sampler(PurpleMemStatCounter counter,
+		PurpleMemStatSampler sampler)
+{
+	samplers[counter] = sampler;
+}
+#endif /* ENABLE_MEMSTAT */
+
+gsize
+_purple_memstat_type_size(GType type)
+{
+	GTypeQuery query;
+	gsize size;
+
+	g_type_query(type, &query);
+	size = query.instance_size;
+
+#if GLIB_CHECK_VERSION(2, 38, 0)
+	/* The private structures are allocated along with the instance. */
+	size -= g_type_class_get_instance_private_offset(g_type_class_peek(type));
+#endif
+
+	return size;
+}
+
+gboolean
+purple_memstat_is_enabled(void)
+{
+#ifdef ENABLE_MEMSTAT
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+gssize
+purple_memstat_get_count(PurpleMemStatCounter counter)
+{
+	PurpleMemStat *snapshot;
+	gssize count;
+
+	g_return_val_if_fail(counter < PURPLE_MEMSTAT_COUNTERS, 0);
+
+	snapshot = purple_memstat_get_snapshot();
+	count = snapshot[counter].count;
+	g_free(snapshot);
+
+	return count;
+}
+
+gssize
+purple_memstat_get_bytes(PurpleMemStatCounter counter)
+{
+	PurpleMemStat *snapshot;
+	gssize bytes;
+
+	g_return_val_if_fail(counter < PURPLE_MEMSTAT_COUNTERS, 0);
+
+	snapshot = purple_memstat_get_snapshot();
+	bytes = snapshot[counter].bytes;
+	g_free(snapshot);
+
+	return bytes;
+}
+
+PurpleMemStat *
+purple_memstat_get_snapshot(void)
+{
+	PurpleMemStat *snapshot = g_new0(PurpleMemStat, PURPLE_MEMSTAT_COUNTERS);
+	int i;
+
+#ifdef ENABLE_MEMSTAT
+	for (i = 0; i < PURPLE_MEMSTAT_COUNTERS; i++) {
+		MemStatCounter *stat = &counters[i];
+
+		/* Each field is read on its own, so a snapshot taken while
+		 * another thread is allocating may be off by that allocation. */
+		snapshot[i].count = (gssize)g_atomic_pointer_get(&stat->count);
+		snapshot[i].bytes = (gssize)g_atomic_pointer_get(&stat->bytes);
+		snapshot[i].peak_bytes =
+			(gssize)g_atomic_pointer_get(&stat->peak_bytes);
+		snapshot[i].allocs = (gsize)g_atomic_pointer_get(&stat->allocs);
+
+		/* Samplers walk main thread data structures. */
+		if (samplers[i] != NULL)
+			samplers[i](&snapshot[i].count, &snapshot[i].bytes);
+	}
+#endif
+
+	for (i = 0; i < PURPLE_MEMSTAT_COUNTERS; i++)
+		snapshot[i].name = counter_names[i];
+
+	return snapshot;
+}
+
+char *
+purple_memstat_get_report(void)
+{
+	PurpleMemStat *snapshot;
+	GString *report;
+	gssize total = 0;
+	int i;
+
+	if (!purple_memstat_is_enabled())
+		return g_strdup("Memory accounting was not compiled in.\n");
+
+	snapshot = purple_memstat_get_snapshot();
+	report = g_string_new("Memory accounting\n");
+	g_string_append(report, "counter                count       bytes  "
+			"peak bytes    allocated\n");
+
+	for (i = 0; i < PURPLE_MEMSTAT_COUNTERS; i++) {
+		PurpleMemStat *stat = &snapshot[i];
+
+		g_string_append_printf(report,
+				"%-18s %9" G_GSSIZE_FORMAT " %11" G_GSSIZE_FORMAT,
+				stat->name, stat->count, stat->bytes);
+		if (stat->allocs > 0)
+			g_string_append_printf(report,
+					" %11" G_GSSIZE_FORMAT " %12" G_GUINT64_FORMAT "\n",
+					stat->peak_bytes, stat->allocs);
+		else
+			g_string_append(report, "           -            -\n");
+
+		total += stat->bytes;
+	}
+
+	g_string_append_printf(report, "%-28s %11" G_GSSIZE_FORMAT "\n",
+			"total", total);
+
+	g_free(snapshot);
+
+	return g_string_free(report, FALSE);
+}
@@ -0,0 +1,151 @@
+/* purple
+ *
+ * Purple is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ */
+
+#ifndef _PURPLE_MEMSTAT_H_
+#define _PURPLE_MEMSTAT_H_
+/**
+ * SECTION:memstat
+ * @section_id: libpurple-memstat
+ * @short_description: <filename>memstat.h</filename>
+ * @title: Memory Accounting API
+ *
+ * libpurple keeps a live count and an approximate size of some of its larger
+ * object populations, so that the memory used by a long-running client can be
+ * attributed to something.  The sizes count what each object allocates
+ * itself, not allocator overhead or anything it only refers to.
+ *
+ * Accounting can be left out when building with
+ * <literal>--disable-memstat</literal>, in which case it costs nothing and
+ * every counter reads zero.
+ */
+
+#include <glib.h>
+
+/**
+ * PurpleMemStatCounter:
+ * @PURPLE_MEMSTAT_BLIST_NODES:       Buddy list nodes.
+ * @PURPLE_MEMSTAT_XMLNODES:          #PurpleXmlNode<!-- -->s, counting
+ *                                    attributes and data as nodes.
+ * @PURPLE_MEMSTAT_CONVERSATIONS:     Conversations.
+ * @PURPLE_MEMSTAT_MESSAGE_HISTORY:   Messages kept in conversation histories.
+ * @PURPLE_MEMSTAT_IMAGES:            Images in the image store, including
+ *                                    buddy icons and smileys.
+ * @PURPLE_MEMSTAT_HTTP:              HTTP connections and their buffers.
+ * @PURPLE_MEMSTAT_CIRCULAR_BUFFERS:  #PurpleCircularBuffer storage.
+ * @PURPLE_MEMSTAT_MEMORY_POOLS:      #PurpleMemoryPool blocks, such as those
+ *                                    used by #PurpleTrie.
+ * @PURPLE_MEMSTAT_COUNTERS:          The number of counters.
+ *
+ * The object populations that are accounted for.
+ */
+typedef enum
+{
+	PURPLE_MEMSTAT_BLIST_NODES = 0,
+	PURPLE_MEMSTAT_XMLNODES,
+	PURPLE_MEMSTAT_CONVERSATIONS,
+	PURPLE_MEMSTAT_MESSAGE_HISTORY,
+	PURPLE_MEMSTAT_IMAGES,
+	PURPLE_MEMSTAT_HTTP,
+	PURPLE_MEMSTAT_CIRCULAR_BUFFERS,
+	PURPLE_MEMSTAT_MEMORY_POOLS,
+
+	PURPLE_MEMSTAT_COUNTERS
+} PurpleMemStatCounter;
+
+/**
+ * PurpleMemStat:
+ * @name:       The counter's name.
+ * @count:      How many objects are alive.
+ * @bytes:      How many bytes they use.
+ * @peak_bytes: The most bytes they have used at once.
+ * @allocs:     How many objects have been created altogether.
+ *
+ * One counter in a snapshot from purple_memstat_get_snapshot().  Counters
+ * that are sampled when the snapshot is taken, rather than kept up to date,
+ * have no peak or total.
+ */
+typedef struct
+{
+	const char *name;
+	gssize count;
+	gssize bytes;
+	gssize peak_bytes;
+	guint64 allocs;
+} PurpleMemStat;
+
+G_BEGIN_DECLS
+
+/**************************************************************************/
+/* Memory Accounting API                                                  */
+/**************************************************************************/
+
+/**
+ * purple_memstat_is_enabled:
+ *
+ * Returns whether memory accounting was compiled in.
+ *
+ * Returns: %TRUE if the counters are kept, or %FALSE if they always read
+ *          zero.
+ */
+gboolean purple_memstat_is_enabled(void);
+
+/**
+ * purple_memstat_get_count:
+ * @counter: The counter.
+ *
+ * Returns how many objects a counter has alive.
+ *
+ * Returns: The number of objects.
+ */
+gssize purple_memstat_get_count(PurpleMemStatCounter counter);
+
+/**
+ * purple_memstat_get_bytes:
+ * @counter: The counter.
+ *
+ * Returns how many bytes a counter's objects use.
+ *
+ * Returns: The number of bytes.
+ */
+gssize purple_memstat_get_bytes(PurpleMemStatCounter counter);
+
+/**
+ * purple_memstat_get_snapshot:
+ *
+ * Takes a consistent snapshot of every counter.
+ *
+ * Returns: An array of #PURPLE_MEMSTAT_COUNTERS counters, indexed by
+ *          #PurpleMemStatCounter, which must be g_free()'d.
+ */
+PurpleMemStat *purple_memstat_get_snapshot(void);
+
+/**
+ * purple_memstat_get_report:
+ *
+ * Formats a snapshot of every counter as a table.
+ *
+ * Returns: The report, which must be g_free()'d.
+ */
+char *purple_memstat_get_report(void);
+
+G_END_DECLS
+
+#endif /* _PURPLE_MEMSTAT_H_ */
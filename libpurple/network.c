@@ -46,6 +46,7 @@
 #include "nat-pmp.h"
 #include "network.h"
 #include "prefs.h"
+#include "resolvercache.h"
 #include "stun.h"
 #include "upnp.h"
 
@@ -76,6 +77,11 @@ struct _PurpleNetworkListenData {
 
 static gboolean force_online = FALSE;
 
+/* The resolver everyone shares, and the one it replaced as the default */
+static GResolver *resolver_cache = NULL;
+static GResolver *system_resolver = NULL;
+static gulong network_changed_id = 0;
+
 /* Cached IP addresses for STUN and TURN servers (set globally in prefs) */
 static gchar *stun_ip = NULL;
 static gchar *turn_ip = NULL;
@@ -765,6 +771,23 @@ _purple_network_set_common_socket_flags(int fd)
 	return succ;
 }
 
+static void
+purple_network_dns_ttl_changed_cb(const char *name, PurplePrefType type,
+                                  gconstpointer value, gpointer data)
+{
+	purple_resolver_cache_set_ttl(PURPLE_RESOLVER_CACHE(resolver_cache),
+		purple_prefs_get_int("/purple/network/dns_cache_ttl"),
+		purple_prefs_get_int("/purple/network/dns_negative_ttl"));
+}
+
+static void
+purple_network_changed_cb(GNetworkMonitor *monitor, gboolean available,
+                          gpointer data)
+{
+	/* Names may resolve differently on the new network */
+	purple_resolver_cache_clear(PURPLE_RESOLVER_CACHE(resolver_cache));
+}
+
 void
 purple_network_init(void)
 {
@@ -781,6 +804,25 @@ purple_network_init(void)
 	purple_prefs_add_bool  ("/purple/network/ports_range_use", FALSE);
 	purple_prefs_add_int   ("/purple/network/ports_range_start", 1024);
 	purple_prefs_add_int   ("/purple/network/ports_range_end", 2048);
+	purple_prefs_add_int   ("/purple/network/dns_cache_ttl", 300);
+	purple_prefs_add_int   ("/purple/network/dns_negative_ttl", 30);
+	purple_prefs_add_int   ("/purple/network/connection_race_delay", 250);
+
+	/* Every lookup made through GIO goes through the cache from now on */
+	system_resolver = g_resolver_get_default();
+	resolver_cache = purple_resolver_cache_new(system_resolver);
+	g_resolver_set_default(resolver_cache);
+	purple_network_dns_ttl_changed_cb(NULL, PURPLE_PREF_INT, NULL, NULL);
+
+	purple_prefs_connect_callback(purple_network_get_handle(),
+		"/purple/network/dns_cache_ttl",
+		purple_network_dns_ttl_changed_cb, NULL);
+	purple_prefs_connect_callback(purple_network_get_handle(),
+		"/purple/network/dns_negative_ttl",
+		purple_network_dns_ttl_changed_cb, NULL);
+
+	network_changed_id = g_signal_connect(g_network_monitor_get_default(),
+		"network-changed", G_CALLBACK(purple_network_changed_cb), NULL);
 
 	if(purple_prefs_get_bool("/purple/network/map_ports") || purple_prefs_get_bool("/purple/network/auto_ip"))
 		purple_upnp_discover(NULL, NULL);
@@ -807,6 +849,18 @@ purple_network_uninit(void)
 	g_hash_table_destroy(upnp_port_mappings);
 	g_hash_table_destroy(nat_pmp_port_mappings);
 
+	purple_prefs_disconnect_by_handle(purple_network_get_handle());
+
+	g_signal_handler_disconnect(g_network_monitor_get_default(),
+		network_changed_id);
+	network_changed_id = 0;
+
+	g_resolver_set_default(system_resolver);
+	g_object_unref(system_resolver);
+	system_resolver = NULL;
+	g_object_unref(resolver_cache);
+	resolver_cache = NULL;
+
 	/* TODO: clean up remaining port mappings, note calling
 	 purple_upnp_remove_port_mapping from here doesn't quite work... */
 }
@@ -3,6 +3,7 @@
 #include <stdio.h>
 
 #include "debug.h"
+#include "eventloop.h"
 #include "glibcompat.h"
 #include "log.h"
 #include "plugins.h"
@@ -38,6 +39,536 @@ static int get_month(const char *month)
 }
 
 
+/*****************************************************************************
+ * Session Cache                                                             *
+ *****************************************************************************/
+
+/* Finding the conversations in a Trillian, QIP or aMSN log means reading the
+ * whole file, and the log viewer lists (and sizes) every log each time it's
+ * opened.  So the sessions found in each file are remembered, along with the
+ * size each one reads back as, until the file's modification time or size
+ * changes.  The cache is kept in log_reader.xml, and the log directories are
+ * indexed by a thread when the plugin is loaded so that the first list is
+ * quick too.
+ */
+
+#define LOG_READER_CACHE_FILE "log_reader.xml"
+#define LOG_READER_CACHE_SAVE_INTERVAL 60 /* seconds */
+
+typedef enum {
+	LOG_READER_ADIUM,
+	LOG_READER_TRILLIAN,
+	LOG_READER_QIP,
+	LOG_READER_AMSN
+} log_reader_format;
+
+struct log_reader_session {
+	time_t time;
+	int offset;
+	int length;
+	int size;        /* What the session reads back as, or -1 if unknown. */
+	char *nickname;  /* Their nickname in the session, for Trillian. */
+};
+
+struct log_reader_file {
+	log_reader_format format;
+	gint64 mtime;
+	gint64 file_size;
+	GArray *sessions;
+	guint parse_errors;  /* Session starts that couldn't be parsed and
+	                        haven't been reported yet. */
+};
+
+struct log_reader_index_dirs {
+	char *trillian;
+	char *qip;
+	char *amsn;
+};
+
+static GHashTable *session_cache = NULL;
+static gboolean session_cache_dirty = FALSE;
+G_LOCK_DEFINE_STATIC(session_cache);
+
+static guint session_cache_save_timer = 0;
+static GThread *index_thread = NULL;
+static GCancellable *index_cancellable = NULL;
+
+/* The scanners return how many session starts they couldn't parse. */
+static guint trillian_logger_scan(char *contents, GArray *sessions);
+static guint qip_logger_scan(const char *contents, GArray *sessions);
+static guint amsn_logger_scan(const char *contents, GArray *sessions);
+
+static void log_reader_session_clear(gpointer data)
+{
+	struct log_reader_session *session = data;
+
+	g_free(session->nickname);
+}
+
+static GArray *log_reader_sessions_new(guint reserved)
+{
+	GArray *sessions;
+
+	sessions = g_array_sized_new(FALSE, FALSE,
+			sizeof(struct log_reader_session), reserved);
+	g_array_set_clear_func(sessions, log_reader_session_clear);
+
+	return sessions;
+}
+
+static void log_reader_session_append(GArray *sessions, time_t time,
+		int offset, int length, const char *nickname)
+{
+	struct log_reader_session session;
+
+	session.time = time;
+	session.offset = offset;
+	session.length = length;
+	session.size = -1;
+	session.nickname = g_strdup(nickname);
+
+	g_array_append_val(sessions, session);
+}
+
+static void log_reader_file_free(gpointer data)
+{
+	struct log_reader_file *file = data;
+
+	g_array_unref(file->sessions);
+	g_free(file);
+}
+
+/* Reads the sessions out of a file.  This is called without the cache locked,
+ * possibly from the indexing thread, so it mustn't touch anything else. */
+static struct log_reader_file *
+log_reader_file_scan(const char *path, log_reader_format format,
+		gint64 mtime, gint64 file_size)
+{
+	struct log_reader_file *file;
+	char *contents;
+
+	file = g_new0(struct log_reader_file, 1);
+	file->format = format;
+	file->mtime = mtime;
+	file->file_size = file_size;
+	file->sessions = log_reader_sessions_new(0);
+
+	/* An Adium log is a single conversation, and finding it doesn't need
+	 * the file to be read.  It's only here so its size can be remembered. */
+	if (format == LOG_READER_ADIUM) {
+		log_reader_session_append(file->sessions, 0, 0, file_size, NULL);
+		return file;
+	}
+
+	if (!g_file_get_contents(path, &contents, NULL, NULL)) {
+		log_reader_file_free(file);
+		return NULL;
+	}
+
+	if (format == LOG_READER_TRILLIAN)
+		file->parse_errors = trillian_logger_scan(contents, file->sessions);
+	else if (format == LOG_READER_QIP)
+		file->parse_errors = qip_logger_scan(contents, file->sessions);
+	else if (format == LOG_READER_AMSN)
+		file->parse_errors = amsn_logger_scan(contents, file->sessions);
+
+	g_free(contents);
+
+	return file;
+}
+
+/* Returns the cache entry for a file, scanning the file again if it changed.
+ * The cache must be locked; it's unlocked while the file is scanned, so the
+ * entry is only good until the lock is released. */
+static struct log_reader_file *
+log_reader_cache_get(const char *path, log_reader_format format)
+{
+	struct log_reader_file *file;
+	GStatBuf st;
+
+	if (session_cache == NULL)
+		return NULL;
+
+	if (g_stat(path, &st) != 0) {
+		/* Don't keep remembering logs that were deleted. */
+		if (g_hash_table_remove(session_cache, path))
+			session_cache_dirty = TRUE;
+		return NULL;
+	}
+
+	file = g_hash_table_lookup(session_cache, path);
+	if (file != NULL && file->format == format &&
+			file->mtime == (gint64)st.st_mtime &&
+			file->file_size == (gint64)st.st_size)
+		return file;
+
+	G_UNLOCK(session_cache);
+	file = log_reader_file_scan(path, format, st.st_mtime, st.st_size);
+	G_LOCK(session_cache);
+
+	/* The plugin may have been unloaded in the meantime. */
+	if (file != NULL && session_cache == NULL) {
+		log_reader_file_free(file);
+		return NULL;
+	}
+
+	if (file != NULL) {
+		g_hash_table_replace(session_cache, g_strdup(path), file);
+		session_cache_dirty = TRUE;
+	} else if (session_cache != NULL &&
+			g_hash_table_remove(session_cache, path)) {
+		session_cache_dirty = TRUE;
+	}
+
+	return file;
+}
+
+/* Files can be scanned by the indexing thread, which mustn't call into the
+ * UI, so the sessions that couldn't be parsed are reported when the file is
+ * next listed. */
+static void log_reader_report_parse_errors(const char *path,
+		log_reader_format format, guint errors)
+{
+	if (errors == 0)
+		return;
+
+	if (format == LOG_READER_TRILLIAN)
+		purple_debug_error("Trillian log timestamp parse",
+				"Session Start parsing error (%u in %s)\n", errors, path);
+	else if (format == LOG_READER_QIP)
+		purple_debug_error("QIP logger list",
+				"Parsing timestamp error (%u in %s)\n", errors, path);
+	else if (format == LOG_READER_AMSN)
+		purple_debug_error("aMSN logger",
+				"Error parsing start date (%u in %s)\n", errors, path);
+}
+
+/* Returns a copy of the sessions in a file, or NULL if it can't be read. */
+static GArray *log_reader_get_sessions(const char *path, log_reader_format format)
+{
+	struct log_reader_file *file;
+	GArray *sessions = NULL;
+	guint parse_errors = 0;
+	guint i;
+
+	G_LOCK(session_cache);
+	file = log_reader_cache_get(path, format);
+	if (file != NULL) {
+		parse_errors = file->parse_errors;
+		file->parse_errors = 0;
+
+		sessions = log_reader_sessions_new(file->sessions->len);
+		for (i = 0; i < file->sessions->len; i++) {
+			struct log_reader_session *session = &g_array_index(
+				file->sessions, struct log_reader_session, i);
+
+			log_reader_session_append(sessions, session->time,
+				session->offset, session->length, session->nickname);
+		}
+	}
+	G_UNLOCK(session_cache);
+
+	log_reader_report_parse_errors(path, format, parse_errors);
+
+	return sessions;
+}
+
+static struct log_reader_session *
+log_reader_file_find_session(struct log_reader_file *file, int offset)
+{
+	guint i;
+
+	for (i = 0; i < file->sessions->len; i++) {
+		struct log_reader_session *session = &g_array_index(
+			file->sessions, struct log_reader_session, i);
+
+		if (session->offset == offset)
+			return session;
+	}
+
+	return NULL;
+}
+
+/* Returns the size the session at @offset was last read back as, or -1. */
+static int log_reader_get_size(const char *path, log_reader_format format, int offset)
+{
+	struct log_reader_file *file;
+	struct log_reader_session *session;
+	int size = -1;
+
+	G_LOCK(session_cache);
+	file = log_reader_cache_get(path, format);
+	if (file != NULL && (session = log_reader_file_find_session(file, offset)))
+		size = session->size;
+	G_UNLOCK(session_cache);
+
+	return size;
+}
+
+static void log_reader_set_size(const char *path, log_reader_format format,
+		int offset, int size)
+{
+	struct log_reader_file *file;
+	struct log_reader_session *session;
+
+	G_LOCK(session_cache);
+	file = log_reader_cache_get(path, format);
+	if (file != NULL && (session = log_reader_file_find_session(file, offset))) {
+		session->size = size;
+		session_cache_dirty = TRUE;
+	}
+	G_UNLOCK(session_cache);
+}
+
+static void log_reader_set_int_attrib(PurpleXmlNode *node, const char *attr, gint64 value)
+{
+	char buf[32];
+
+	g_snprintf(buf, sizeof(buf), "%" G_GINT64_FORMAT, value);
+	purple_xmlnode_set_attrib(node, attr, buf);
+}
+
+static gint64 log_reader_get_int_attrib(PurpleXmlNode *node, const char *attr, gint64 fallback)
+{
+	const char *value = purple_xmlnode_get_attrib(node, attr);
+
+	return value ? g_ascii_strtoll(value, NULL, 10) : fallback;
+}
+
+static void log_reader_cache_load(void)
+{
+	PurpleXmlNode *root, *node, *child;
+
+	root = purple_util_read_xml_from_file(LOG_READER_CACHE_FILE,
+			_("foreign log index"));
+	if (root == NULL)
+		return;
+
+	for (node = purple_xmlnode_get_child(root, "file"); node != NULL;
+			node = purple_xmlnode_get_next_twin(node)) {
+		const char *path = purple_xmlnode_get_attrib(node, "path");
+		struct log_reader_file *file;
+
+		if (path == NULL)
+			continue;
+
+		file = g_new0(struct log_reader_file, 1);
+		file->format = log_reader_get_int_attrib(node, "format", 0);
+		file->mtime = log_reader_get_int_attrib(node, "mtime", 0);
+		file->file_size = log_reader_get_int_attrib(node, "size", 0);
+		file->sessions = log_reader_sessions_new(0);
+
+		for (child = purple_xmlnode_get_child(node, "session"); child != NULL;
+				child = purple_xmlnode_get_next_twin(child)) {
+			struct log_reader_session *session;
+
+			log_reader_session_append(file->sessions,
+				log_reader_get_int_attrib(child, "time", 0),
+				log_reader_get_int_attrib(child, "offset", 0),
+				log_reader_get_int_attrib(child, "length", 0),
+				purple_xmlnode_get_attrib(child, "nickname"));
+			session = &g_array_index(file->sessions,
+				struct log_reader_session, file->sessions->len - 1);
+			session->size = log_reader_get_int_attrib(child, "read-size", -1);
+		}
+
+		g_hash_table_replace(session_cache, g_strdup(path), file);
+	}
+
+	purple_xmlnode_free(root);
+}
+
+static void log_reader_cache_save(void)
+{
+	PurpleXmlNode *root;
+	GHashTableIter iter;
+	gpointer key, value;
+	char *data;
+
+	G_LOCK(session_cache);
+	if (session_cache == NULL || !session_cache_dirty) {
+		G_UNLOCK(session_cache);
+		return;
+	}
+
+	root = purple_xmlnode_new("log_reader");
+	purple_xmlnode_set_attrib(root, "version", "1.0");
+
+	g_hash_table_iter_init(&iter, session_cache);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		struct log_reader_file *file = value;
+		PurpleXmlNode *node;
+		guint i;
+
+		node = purple_xmlnode_new_child(root, "file");
+		purple_xmlnode_set_attrib(node, "path", key);
+		log_reader_set_int_attrib(node, "format", file->format);
+		log_reader_set_int_attrib(node, "mtime", file->mtime);
+		log_reader_set_int_attrib(node, "size", file->file_size);
+
+		for (i = 0; i < file->sessions->len; i++) {
+			struct log_reader_session *session = &g_array_index(
+				file->sessions, struct log_reader_session, i);
+			PurpleXmlNode *child = purple_xmlnode_new_child(node, "session");
+
+			log_reader_set_int_attrib(child, "time", session->time);
+			log_reader_set_int_attrib(child, "offset", session->offset);
+			log_reader_set_int_attrib(child, "length", session->length);
+			if (session->size >= 0)
+				log_reader_set_int_attrib(child, "read-size", session->size);
+			if (session->nickname != NULL)
+				purple_xmlnode_set_attrib(child, "nickname", session->nickname);
+		}
+	}
+
+	session_cache_dirty = FALSE;
+	G_UNLOCK(session_cache);
+
+	data = purple_xmlnode_to_formatted_str(root, NULL);
+	purple_util_write_data_to_file(LOG_READER_CACHE_FILE, data, -1);
+	g_free(data);
+	purple_xmlnode_free(root);
+}
+
+static gboolean log_reader_cache_save_cb(gpointer data)
+{
+	log_reader_cache_save();
+
+	return TRUE;
+}
+
+/* Scans the files ending in @suffix in @dir. */
+static void log_reader_index_dir(const char *dir, log_reader_format format,
+		const char *suffix)
+{
+	GDir *d;
+	const char *name;
+
+	if ((d = g_dir_open(dir, 0, NULL)) == NULL)
+		return;
+
+	while ((name = g_dir_read_name(d)) != NULL &&
+			!g_cancellable_is_cancelled(index_cancellable)) {
+		char *path;
+
+		if (!g_str_has_suffix(name, suffix))
+			continue;
+
+		path = g_build_filename(dir, name, NULL);
+		G_LOCK(session_cache);
+		log_reader_cache_get(path, format);
+		G_UNLOCK(session_cache);
+		g_free(path);
+	}
+
+	g_dir_close(d);
+}
+
+/* Scans the files ending in @suffix in @dir/x/@subdir for each directory x
+ * in @dir.  @subdir may be NULL. */
+static void log_reader_index_subdirs(const char *dir, const char *subdir,
+		log_reader_format format, const char *suffix)
+{
+	GDir *d;
+	const char *name;
+
+	if (dir == NULL || !*dir || (d = g_dir_open(dir, 0, NULL)) == NULL)
+		return;
+
+	while ((name = g_dir_read_name(d)) != NULL &&
+			!g_cancellable_is_cancelled(index_cancellable)) {
+		char *path = g_build_filename(dir, name, subdir, NULL);
+
+		log_reader_index_dir(path, format, suffix);
+		g_free(path);
+	}
+
+	g_dir_close(d);
+}
+
+static gpointer log_reader_index_thread(gpointer data)
+{
+	struct log_reader_index_dirs *dirs = data;
+
+	/* `log_dir`/PROTOCOL/buddy.log and `log_dir`/PROTOCOL/Query/buddy.log */
+	log_reader_index_subdirs(dirs->trillian, NULL, LOG_READER_TRILLIAN, ".log");
+	log_reader_index_subdirs(dirs->trillian, "Query", LOG_READER_TRILLIAN, ".log");
+
+	/* `log_dir`/username/History/buddy.txt */
+	log_reader_index_subdirs(dirs->qip, "History", LOG_READER_QIP, ".txt");
+
+	/* `log_dir`/username/logs/buddy.log and
+	 * `log_dir`/username/logs/Month Year/buddy.log */
+	if (dirs->amsn != NULL && *dirs->amsn) {
+		GDir *d = g_dir_open(dirs->amsn, 0, NULL);
+		const char *name;
+
+		while (d && (name = g_dir_read_name(d)) != NULL &&
+				!g_cancellable_is_cancelled(index_cancellable)) {
+			char *path = g_build_filename(dirs->amsn, name, "logs", NULL);
+
+			log_reader_index_dir(path, LOG_READER_AMSN, ".log");
+			log_reader_index_subdirs(path, NULL, LOG_READER_AMSN, ".log");
+			g_free(path);
+		}
+
+		if (d)
+			g_dir_close(d);
+	}
+
+	g_free(dirs->trillian);
+	g_free(dirs->qip);
+	g_free(dirs->amsn);
+	g_free(dirs);
+
+	return NULL;
+}
+
+static void log_reader_cache_init(void)
+{
+	struct log_reader_index_dirs *dirs;
+
+	session_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+			g_free, log_reader_file_free);
+	log_reader_cache_load();
+
+	session_cache_save_timer = purple_timeout_add_seconds(
+			LOG_READER_CACHE_SAVE_INTERVAL, log_reader_cache_save_cb, NULL);
+
+	/* The preferences are only read here, on the main thread. */
+	dirs = g_new0(struct log_reader_index_dirs, 1);
+	dirs->trillian = g_strdup(purple_prefs_get_string(
+			"/plugins/core/log_reader/trillian/log_directory"));
+	dirs->qip = g_strdup(purple_prefs_get_string(
+			"/plugins/core/log_reader/qip/log_directory"));
+	dirs->amsn = g_strdup(purple_prefs_get_string(
+			"/plugins/core/log_reader/amsn/log_directory"));
+
+	index_cancellable = g_cancellable_new();
+	index_thread = g_thread_new("log_reader", log_reader_index_thread, dirs);
+}
+
+static void log_reader_cache_uninit(void)
+{
+	g_cancellable_cancel(index_cancellable);
+	g_thread_join(index_thread);
+	index_thread = NULL;
+	g_object_unref(index_cancellable);
+	index_cancellable = NULL;
+
+	purple_timeout_remove(session_cache_save_timer);
+	session_cache_save_timer = 0;
+
+	log_reader_cache_save();
+
+	G_LOCK(session_cache);
+	g_hash_table_destroy(session_cache);
+	session_cache = NULL;
+	session_cache_dirty = FALSE;
+	G_UNLOCK(session_cache);
+}
+
+
 /*****************************************************************************
  * Adium Logger                                                              *
  *****************************************************************************/
@@ -281,7 +812,7 @@ static int adium_logger_size (PurpleLog *log)
 {
 	struct adium_logger_data *data;
 	char *text;
-	size_t size;
+	int size;
 
 	g_return_val_if_fail(log != NULL, 0);
 
@@ -296,10 +827,15 @@ static int adium_logger_size (PurpleLog *log)
 		return st.st_size;
 	}
 
+	if ((size = log_reader_get_size(data->path, LOG_READER_ADIUM, 0)) >= 0)
+		return size;
+
 	text = adium_logger_read(log, NULL);
 	size = strlen(text);
 	g_free(text);
 
+	log_reader_set_size(data->path, LOG_READER_ADIUM, 0, size);
+
 	return size;
 }
 
@@ -1092,6 +1628,118 @@ struct trillian_logger_data {
 	char *their_nickname;
 };
 
+/* Finds the sessions in the contents of a Trillian log, which it modifies. */
+static guint trillian_logger_scan(char *contents, GArray *sessions)
+{
+	struct log_reader_session *session = NULL;
+	guint errors = 0;
+	int offset = 0;
+	int last_line_offset = 0;
+	gchar *line;
+	gchar *c;
+
+	line = contents;
+	c = contents;
+	while (*c) {
+		offset++;
+
+		if (*c != '\n') {
+			c++;
+			continue;
+		}
+
+		*c = '\0';
+		if (purple_str_has_prefix(line, "Session Close ")) {
+			if (session && !session->length) {
+				if (!(session->length = last_line_offset - session->offset)) {
+					/* This log had no data, so we remove it. */
+					g_array_remove_index(sessions, sessions->len - 1);
+				}
+			}
+			session = NULL;
+		} else if (line[0] && line[1] && line[2] &&
+				   purple_str_has_prefix(&line[3], "sion Start ")) {
+			/* The conditional is to make sure we're not reading off
+			 * the end of the string.  We don't want strlen(), as that'd
+			 * have to count the whole string needlessly.
+			 *
+			 * The odd check here is because a Session Start at the
+			 * beginning of the file can be overwritten with a UTF-8
+			 * byte order mark.  Yes, it's weird.
+			 */
+			char *their_nickname = line;
+			char *timestamp;
+
+			if (session && !session->length)
+				session->length = last_line_offset - session->offset;
+			session = NULL;
+
+			while (*their_nickname && (*their_nickname != ':'))
+				their_nickname++;
+			their_nickname++;
+
+			/* This code actually has nothing to do with
+			 * the timestamp YET. I'm simply using this
+			 * variable for now to NUL-terminate the
+			 * their_nickname string.
+			 */
+			timestamp = their_nickname;
+			while (*timestamp && *timestamp != ')')
+				timestamp++;
+
+			if (*timestamp == ')') {
+				char *month;
+				struct tm tm;
+
+				*timestamp = '\0';
+				if (line[0] && line[1] && line[2])
+					timestamp += 3;
+
+				/* Now we start dealing with the timestamp. */
+
+				/* Skip over the day name. */
+				while (*timestamp && (*timestamp != ' '))
+					timestamp++;
+				*timestamp = '\0';
+				timestamp++;
+
+				/* Parse out the month. */
+				month = timestamp;
+				while (*timestamp &&  (*timestamp != ' '))
+					timestamp++;
+				*timestamp = '\0';
+				timestamp++;
+
+				/* Parse the day, time, and year. */
+				if (sscanf(timestamp, "%u %u:%u:%u %u",
+						&tm.tm_mday, &tm.tm_hour,
+						&tm.tm_min, &tm.tm_sec,
+						&tm.tm_year) != 5) {
+					errors++;
+				} else {
+					tm.tm_year -= 1900;
+
+					/* Let the C library deal with
+					 * daylight savings time.
+					 */
+					tm.tm_isdst = -1;
+					tm.tm_mon = get_month(month);
+
+					log_reader_session_append(sessions, mktime(&tm),
+						offset, 0, their_nickname);
+					session = &g_array_index(sessions,
+						struct log_reader_session, sessions->len - 1);
+				}
+			}
+		}
+		c++;
+		line = c;
+		last_line_offset = offset;
+	}
+
+	return errors;
+}
+
 static GList *trillian_logger_list(PurpleLogType type, const char *sn, PurpleAccount *account)
 {
 	GList *list = NULL;
@@ -1101,11 +1749,8 @@ static GList *trillian_logger_list(PurpleLogType type, const char *sn, PurpleAcc
 	const char *buddy_name;
 	char *filename;
 	char *path;
-	GError *error = NULL;
-	gchar *contents = NULL;
-	gsize length;
-	gchar *line;
-	gchar *c;
+	GArray *sessions;
+	guint i;
 
 	g_return_val_if_fail(sn != NULL, NULL);
 	g_return_val_if_fail(account != NULL, NULL);
@@ -1128,152 +1773,41 @@ static GList *trillian_logger_list(PurpleLogType type, const char *sn, PurpleAcc
 	path = g_build_filename(
 		logdir, protocol_name, filename, NULL);
 
-	purple_debug_info("Trillian log list", "Reading %s\n", path);
-	/* FIXME: There's really no need to read the entire file at once.
-	 * See src/log.c:old_logger_list for a better approach.
-	 */
-	if (!g_file_get_contents(path, &contents, &length, &error)) {
-		if (error) {
-			g_error_free(error);
-			error = NULL;
-		}
+	purple_debug_info("Trillian log list", "Listing %s\n", path);
+	sessions = log_reader_get_sessions(path, LOG_READER_TRILLIAN);
+	if (sessions == NULL) {
 		g_free(path);
 
 		path = g_build_filename(
 			logdir, protocol_name, "Query", filename, NULL);
-		purple_debug_info("Trillian log list", "Reading %s\n", path);
-		if (!g_file_get_contents(path, &contents, &length, &error)) {
-			if (error)
-				g_error_free(error);
-		}
+		purple_debug_info("Trillian log list", "Listing %s\n", path);
+		sessions = log_reader_get_sessions(path, LOG_READER_TRILLIAN);
 	}
 	g_free(filename);
 
-	if (contents) {
-		struct trillian_logger_data *data = NULL;
-		int offset = 0;
-		int last_line_offset = 0;
-
-		line = contents;
-		c = contents;
-		while (*c) {
-			offset++;
-
-			if (*c != '\n') {
-				c++;
-				continue;
-			}
-
-			*c = '\0';
-			if (purple_str_has_prefix(line, "Session Close ")) {
-				if (data && !data->length) {
-					if (!(data->length = last_line_offset - data->offset)) {
-						/* This log had no data, so we remove it. */
-						GList *last = g_list_last(list);
-
-						purple_debug_info("Trillian log list",
-						                  "Empty log. Offset %i\n", data->offset);
-
-						trillian_logger_finalize((PurpleLog *)last->data);
-						list = g_list_delete_link(list, last);
-					}
-				}
-			} else if (line[0] && line[1] && line[2] &&
-					   purple_str_has_prefix(&line[3], "sion Start ")) {
-				/* The conditional is to make sure we're not reading off
-				 * the end of the string.  We don't want strlen(), as that'd
-				 * have to count the whole string needlessly.
-				 *
-				 * The odd check here is because a Session Start at the
-				 * beginning of the file can be overwritten with a UTF-8
-				 * byte order mark.  Yes, it's weird.
-				 */
-				char *their_nickname = line;
-				char *timestamp;
-
-				if (data && !data->length)
-					data->length = last_line_offset - data->offset;
-
-				while (*their_nickname && (*their_nickname != ':'))
-					their_nickname++;
-				their_nickname++;
-
-				/* This code actually has nothing to do with
-				 * the timestamp YET. I'm simply using this
-				 * variable for now to NUL-terminate the
-				 * their_nickname string.
-				 */
-				timestamp = their_nickname;
-				while (*timestamp && *timestamp != ')')
-					timestamp++;
-
-				if (*timestamp == ')') {
-					char *month;
-					struct tm tm;
-
-					*timestamp = '\0';
-					if (line[0] && line[1] && line[2])
-						timestamp += 3;
-
-					/* Now we start dealing with the timestamp. */
-
-					/* Skip over the day name. */
-					while (*timestamp && (*timestamp != ' '))
-						timestamp++;
-					*timestamp = '\0';
-					timestamp++;
-
-					/* Parse out the month. */
-					month = timestamp;
-					while (*timestamp &&  (*timestamp != ' '))
-						timestamp++;
-					*timestamp = '\0';
-					timestamp++;
-
-					/* Parse the day, time, and year. */
-					if (sscanf(timestamp, "%u %u:%u:%u %u",
-							&tm.tm_mday, &tm.tm_hour,
-							&tm.tm_min, &tm.tm_sec,
-							&tm.tm_year) != 5) {
-
-						purple_debug_error("Trillian log timestamp parse",
-						                   "Session Start parsing error\n");
-					} else {
-						PurpleLog *log;
-
-						tm.tm_year -= 1900;
-
-						/* Let the C library deal with
-						 * daylight savings time.
-						 */
-						tm.tm_isdst = -1;
-						tm.tm_mon = get_month(month);
-
-						data = g_new0(
-							struct trillian_logger_data, 1);
-						data->path = g_strdup(path);
-						data->offset = offset;
-						data->length = 0;
-						data->their_nickname =
-							g_strdup(their_nickname);
-
-						/* XXX: Look into this later... Should we pass in a struct tm? */
-						log = purple_log_new(PURPLE_LOG_IM,
-							sn, account, NULL, mktime(&tm), NULL);
-						log->logger = trillian_logger;
-						log->logger_data = data;
-
-						list = g_list_prepend(list, log);
-					}
-				}
-			}
-			c++;
-			line = c;
-			last_line_offset = offset;
-		}
-
-		g_free(contents);
+	for (i = 0; sessions && i < sessions->len; i++) {
+		struct log_reader_session *session = &g_array_index(
+			sessions, struct log_reader_session, i);
+		struct trillian_logger_data *data;
+		PurpleLog *log;
+
+		data = g_new0(struct trillian_logger_data, 1);
+		data->path = g_strdup(path);
+		data->offset = session->offset;
+		data->length = session->length;
+		data->their_nickname = g_strdup(session->nickname);
+
+		/* XXX: Look into this later... Should we pass in a struct tm? */
+		log = purple_log_new(PURPLE_LOG_IM,
+			sn, account, NULL, session->time, NULL);
+		log->logger = trillian_logger;
+		log->logger_data = data;
+
+		list = g_list_prepend(list, log);
 	}
+
+	if (sessions)
+		g_array_unref(sessions);
 	g_free(path);
 
 	g_free(protocol_name);
@@ -1592,7 +2126,7 @@ static int trillian_logger_size (PurpleLog *log)
 {
 	struct trillian_logger_data *data;
 	char *text;
-	size_t size;
+	int size;
 
 	g_return_val_if_fail(log != NULL, 0);
 
@@ -1602,10 +2136,17 @@ static int trillian_logger_size (PurpleLog *log)
 		return data ? data->length : 0;
 	}
 
+	if (data && (size = log_reader_get_size(data->path,
+			LOG_READER_TRILLIAN, data->offset)) >= 0)
+		return size;
+
 	text = trillian_logger_read(log, NULL);
 	size = strlen(text);
 	g_free(text);
 
+	if (data)
+		log_reader_set_size(data->path, LOG_READER_TRILLIAN, data->offset, size);
+
 	return size;
 }
 
@@ -1645,64 +2186,21 @@ struct qip_logger_data {
 	int length;
 };
 
-static GList *qip_logger_list(PurpleLogType type, const char *sn, PurpleAccount *account)
+/* Finds the sessions in the contents of a QIP log. */
+static guint qip_logger_scan(const char *contents, GArray *sessions)
 {
-	GList *list = NULL;
-	const char *logdir;
-	PurpleProtocol *protocol;
-	char *username;
-	char *filename;
-	char *path;
-	char *contents;
-	struct qip_logger_data *data = NULL;
+	guint errors = 0;
 	struct tm prev_tm;
 	struct tm tm;
 	gboolean prev_tm_init = FALSE;
 	gboolean main_cycle = TRUE;
-	char *c;
-	char *start_log;
-	char *new_line = NULL;
+	const char *c;
+	const char *start_log;
+	const char *new_line = NULL;
 	int offset = 0;
-	GError *error;
-
-	g_return_val_if_fail(sn != NULL, NULL);
-	g_return_val_if_fail(account != NULL, NULL);
 
 	memset(&tm, 0, sizeof(tm));
 
-	/* QIP only supports ICQ. */
-	if (strcmp(purple_account_get_protocol_id(account), "prpl-icq"))
-		return NULL;
-
-	logdir = purple_prefs_get_string("/plugins/core/log_reader/qip/log_directory");
-
-	/* By clearing the log directory path, this logger can be (effectively) disabled. */
-	if (!logdir || !*logdir)
-		return NULL;
-
-	protocol = purple_protocols_find(purple_account_get_protocol_id(account));
-	if (!protocol)
-		return NULL;
-
-	username = g_strdup(purple_normalize(account, purple_account_get_username(account)));
-	filename = g_strdup_printf("%s.txt", purple_normalize(account, sn));
-	path = g_build_filename(logdir, username, "History", filename, NULL);
-	g_free(username);
-	g_free(filename);
-
-	purple_debug_info("QIP logger", "Reading %s\n", path);
-
-	error = NULL;
-	if (!g_file_get_contents(path, &contents, NULL, &error)) {
-		purple_debug_error("QIP logger",
-				   "Couldn't read file %s: %s \n", path,
-				   (error && error->message) ? error->message : "Unknown error");
-		if (error)
-			g_error_free(error);
-		g_free(path);
-		return list;
-	}
-
 	c = contents;
 	start_log = contents;
 	while (main_cycle) {
@@ -1713,7 +2211,7 @@ static GList *qip_logger_list(PurpleLogType type, const char *sn, PurpleAccount
 			if (purple_str_has_prefix(c, QIP_LOG_IN_MESSAGE) ||
 				purple_str_has_prefix(c, QIP_LOG_OUT_MESSAGE)) {
 
-				char *tmp;
+				const char *tmp;
 
 				new_line = c;
 
@@ -1742,9 +2240,7 @@ static GList *qip_logger_list(PurpleLogType type, const char *sn, PurpleAccount
 					if (sscanf(timestamp, "%u:%u:%u %u/%u/%u",
 						&tm.tm_hour, &tm.tm_min, &tm.tm_sec,
 						&tm.tm_mday, &tm.tm_mon, &tm.tm_year) != 6) {
-
-						purple_debug_error("QIP logger list",
-							"Parsing timestamp error\n");
+						errors++;
 					} else {
 						tm.tm_mon -= 1;
 						tm.tm_year -= 1900;
@@ -1770,26 +2266,11 @@ static GList *qip_logger_list(PurpleLogType type, const char *sn, PurpleAccount
 
 		/* adding  log */
 		if (add_new_log && prev_tm_init) {
-			PurpleLog *log;
+			int length = new_line - start_log;
 
-			/* filling data */
-			data = g_new0(struct qip_logger_data, 1);
-			data->path = g_strdup(path);
-			data->length = new_line - start_log;
-			data->offset = offset;
-			offset += data->length;
-			purple_debug_info("QIP logger list",
-				"Creating log: path = (%s); length = (%d); offset = (%d)\n",
-				data->path, data->length, data->offset);
-
-			/* XXX: Look into this later... Should we pass in a struct tm? */
-			log = purple_log_new(PURPLE_LOG_IM, sn, account,
-				NULL, mktime(&prev_tm), NULL);
-
-			log->logger = qip_logger;
-			log->logger_data = data;
-
-			list = g_list_prepend(list, log);
+			log_reader_session_append(sessions, mktime(&prev_tm),
+				offset, length, NULL);
+			offset += length;
 
 			prev_tm = tm;
 			start_log = new_line;
@@ -1802,7 +2283,75 @@ static GList *qip_logger_list(PurpleLogType type, const char *sn, PurpleAccount
 		}
 	}
 
-	g_free(contents);
+	return errors;
+}
+
+static GList *qip_logger_list(PurpleLogType type, const char *sn, PurpleAccount *account)
+{
+	GList *list = NULL;
+	const char *logdir;
+	PurpleProtocol *protocol;
+	char *username;
+	char *filename;
+	char *path;
+	GArray *sessions;
+	guint i;
+
+	g_return_val_if_fail(sn != NULL, NULL);
+	g_return_val_if_fail(account != NULL, NULL);
+
+	/* QIP only supports ICQ. */
+	if (strcmp(purple_account_get_protocol_id(account), "prpl-icq"))
+		return NULL;
+
+	logdir = purple_prefs_get_string("/plugins/core/log_reader/qip/log_directory");
+
+	/* By clearing the log directory path, this logger can be (effectively) disabled. */
+	if (!logdir || !*logdir)
+		return NULL;
+
+	protocol = purple_protocols_find(purple_account_get_protocol_id(account));
+	if (!protocol)
+		return NULL;
+
+	username = g_strdup(purple_normalize(account, purple_account_get_username(account)));
+	filename = g_strdup_printf("%s.txt", purple_normalize(account, sn));
+	path = g_build_filename(logdir, username, "History", filename, NULL);
+	g_free(username);
+	g_free(filename);
+
+	purple_debug_info("QIP logger", "Listing %s\n", path);
+
+	sessions = log_reader_get_sessions(path, LOG_READER_QIP);
+	if (sessions == NULL) {
+		purple_debug_error("QIP logger", "Couldn't read file %s\n", path);
+		g_free(path);
+		return list;
+	}
+
+	for (i = 0; i < sessions->len; i++) {
+		struct log_reader_session *session = &g_array_index(
+			sessions, struct log_reader_session, i);
+		struct qip_logger_data *data;
+		PurpleLog *log;
+
+		/* filling data */
+		data = g_new0(struct qip_logger_data, 1);
+		data->path = g_strdup(path);
+		data->length = session->length;
+		data->offset = session->offset;
+
+		/* XXX: Look into this later... Should we pass in a struct tm? */
+		log = purple_log_new(PURPLE_LOG_IM, sn, account,
+			NULL, session->time, NULL);
+
+		log->logger = qip_logger;
+		log->logger_data = data;
+
+		list = g_list_prepend(list, log);
+	}
+
+	g_array_unref(sessions);
 	g_free(path);
 	return g_list_reverse(list);
 }
@@ -1971,7 +2520,7 @@ static int qip_logger_size (PurpleLog *log)
 {
 	struct qip_logger_data *data;
 	char *text;
-	size_t size;
+	int size;
 
 	g_return_val_if_fail(log != NULL, 0);
 
@@ -1981,10 +2530,17 @@ static int qip_logger_size (PurpleLog *log)
 		return data ? data->length : 0;
 	}
 
+	if (data && (size = log_reader_get_size(data->path,
+			LOG_READER_QIP, data->offset)) >= 0)
+		return size;
+
 	text = qip_logger_read(log, NULL);
 	size = strlen(text);
 	g_free(text);
 
+	if (data)
+		log_reader_set_size(data->path, LOG_READER_QIP, data->offset, size);
+
 	return size;
 }
 
@@ -2020,101 +2576,92 @@ struct amsn_logger_data {
 #define AMSN_LOG_CONV_END "|\"LRED[You have closed the window on "
 #define AMSN_LOG_CONV_EXTRA "01 Aug 2001 00:00:00]"
 
-static GList *amsn_logger_parse_file(char *filename, const char *sn, PurpleAccount *account)
+/* Finds the sessions in the contents of an aMSN log. */
+static guint amsn_logger_scan(const char *contents, GArray *sessions)
 {
-	GList *list = NULL;
-	GError *error;
-	char *contents;
-	struct amsn_logger_data *data;
-	PurpleLog *log;
-
-	purple_debug_info("aMSN logger", "Reading %s\n", filename);
-	error = NULL;
-	if (!g_file_get_contents(filename, &contents, NULL, &error)) {
-		purple_debug_error("aMSN logger",
-		                   "Couldn't read file %s: %s \n", filename,
-		                   (error && error->message) ?
-		                    error->message : "Unknown error");
-		if (error)
-			g_error_free(error);
-	} else {
-		char *c = contents;
-		gboolean found_start = FALSE;
-		char *start_log = c;
-		int offset = 0;
-		struct tm tm;
-		while (c && *c) {
-			if (purple_str_has_prefix(c, AMSN_LOG_CONV_START)) {
-				char month[4];
-				if (sscanf(c + strlen(AMSN_LOG_CONV_START),
-				           "%u %3s %u %u:%u:%u",
-				           &tm.tm_mday, (char*)&month, &tm.tm_year,
-				           &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6) {
-					found_start = FALSE;
-					purple_debug_error("aMSN logger",
-					                   "Error parsing start date for %s\n",
-					                   filename);
-				} else {
-					tm.tm_year -= 1900;
-
-					/* Let the C library deal with
-					 * daylight savings time.
-					 */
-					tm.tm_isdst = -1;
-					tm.tm_mon = get_month(month);
+	const char *c = contents;
+	guint errors = 0;
+	gboolean found_start = FALSE;
+	const char *start_log = c;
+	int offset = 0;
+	struct tm tm;
 
-					found_start = TRUE;
-					offset = c - contents;
-					start_log = c;
-				}
-			} else if (purple_str_has_prefix(c, AMSN_LOG_CONV_END) && found_start) {
-				data = g_new0(struct amsn_logger_data, 1);
-				data->path = g_strdup(filename);
-				data->offset = offset;
-				data->length = c - start_log
-					             + strlen(AMSN_LOG_CONV_END)
-					             + strlen(AMSN_LOG_CONV_EXTRA);
-				log = purple_log_new(PURPLE_LOG_IM, sn, account, NULL, mktime(&tm), NULL);
-				log->logger = amsn_logger;
-				log->logger_data = data;
-				list = g_list_prepend(list, log);
+	while (c && *c) {
+		if (purple_str_has_prefix(c, AMSN_LOG_CONV_START)) {
+			char month[4];
+			if (sscanf(c + strlen(AMSN_LOG_CONV_START),
+			           "%u %3s %u %u:%u:%u",
+			           &tm.tm_mday, (char*)&month, &tm.tm_year,
+			           &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6) {
 				found_start = FALSE;
+				errors++;
+			} else {
+				tm.tm_year -= 1900;
+
+				/* Let the C library deal with
+				 * daylight savings time.
+				 */
+				tm.tm_isdst = -1;
+				tm.tm_mon = get_month(month);
 
-				purple_debug_info("aMSN logger",
-				                  "Found log for %s:"
-				                  " path = (%s),"
-				                  " offset = (%d),"
-				                  " length = (%d)\n",
-				                  sn, data->path, data->offset, data->length);
+				found_start = TRUE;
+				offset = c - contents;
+				start_log = c;
 			}
-			c = strchr(c, '\n');
-			if (c)
-				c++;
+		} else if (purple_str_has_prefix(c, AMSN_LOG_CONV_END) && found_start) {
+			log_reader_session_append(sessions, mktime(&tm), offset,
+				c - start_log
+				+ strlen(AMSN_LOG_CONV_END)
+				+ strlen(AMSN_LOG_CONV_EXTRA), NULL);
+			found_start = FALSE;
 		}
+		c = strchr(c, '\n');
+		if (c)
+			c++;
+	}
 
-		/* I've seen the file end without the AMSN_LOG_CONV_END bit */
-		if (found_start) {
-			data = g_new0(struct amsn_logger_data, 1);
-			data->path = g_strdup(filename);
-			data->offset = offset;
-			data->length = c - start_log
-				             + strlen(AMSN_LOG_CONV_END)
-				             + strlen(AMSN_LOG_CONV_EXTRA);
-			log = purple_log_new(PURPLE_LOG_IM, sn, account, NULL, mktime(&tm), NULL);
-			log->logger = amsn_logger;
-			log->logger_data = data;
-			list = g_list_prepend(list, log);
+	/* I've seen the file end without the AMSN_LOG_CONV_END bit */
+	if (found_start) {
+		log_reader_session_append(sessions, mktime(&tm), offset,
+			strlen(start_log), NULL);
+	}
 
-			purple_debug_info("aMSN logger",
-			                  "Found log for %s:"
-			                  " path = (%s),"
-			                  " offset = (%d),"
-			                  " length = (%d)\n",
-			                  sn, data->path, data->offset, data->length);
-		}
-		g_free(contents);
+	return errors;
+}
+
+static GList *amsn_logger_parse_file(char *filename, const char *sn, PurpleAccount *account)
+{
+	GList *list = NULL;
+	GArray *sessions;
+	guint i;
+
+	purple_debug_info("aMSN logger", "Listing %s\n", filename);
+
+	sessions = log_reader_get_sessions(filename, LOG_READER_AMSN);
+	if (sessions == NULL) {
+		purple_debug_error("aMSN logger",
+		                   "Couldn't read file %s\n", filename);
+		return NULL;
 	}
 
+	for (i = 0; i < sessions->len; i++) {
+		struct log_reader_session *session = &g_array_index(
+			sessions, struct log_reader_session, i);
+		struct amsn_logger_data *data;
+		PurpleLog *log;
+
+		data = g_new0(struct amsn_logger_data, 1);
+		data->path = g_strdup(filename);
+		data->offset = session->offset;
+		data->length = session->length;
+		log = purple_log_new(PURPLE_LOG_IM, sn, account, NULL, session->time, NULL);
+		log->logger = amsn_logger;
+		log->logger_data = data;
+		list = g_list_prepend(list, log);
+	}
+
+	g_array_unref(sessions);
+
 	return list;
 }
 
@@ -2327,10 +2874,17 @@ static int amsn_logger_size(PurpleLog *log)
 		return data ? data->length : 0;
 	}
 
+	if (data && (size = log_reader_get_size(data->path,
+			LOG_READER_AMSN, data->offset)) >= 0)
+		return size;
+
 	text = amsn_logger_read(log, NULL);
 	size = strlen(text);
 	g_free(text);
 
+	if (data)
+		log_reader_set_size(data->path, LOG_READER_AMSN, data->offset, size);
+
 	return size;
 }
 
@@ -2709,6 +3263,7 @@ plugin_load(PurplePlugin *plugin, GError **error)
 	g_return_val_if_fail(plugin != NULL, FALSE);
 
 	log_reader_init_prefs();
+	log_reader_cache_init();
 
 	/* The names of IM clients are marked for translation at the request of
 	   translators who wanted to transliterate them.  Many translators
@@ -2798,6 +3353,8 @@ plugin_unload(PurplePlugin *plugin, GError **error)
 	purple_log_logger_free(amsn_logger);
 	amsn_logger = NULL;
 
+	log_reader_cache_uninit();
+
 	return TRUE;
 }
 
@@ -25,6 +25,7 @@
 
 #include "debug.h"
 #include "pounce.h"
+#include "protocols.h"
 #include "util.h"
 
 /*
@@ -44,6 +45,8 @@ struct _PurplePounce
 	PurpleAccount *pouncer;       /* The user who is pouncing.  */
 
 	char *pouncee;                /* The buddy to pounce on.    */
+	char *index_key;              /* The pouncee as filed in
+	                                 pounce_index.              */
 
 	GHashTable *actions;          /* The registered actions.    */
 
@@ -90,8 +93,21 @@ typedef struct
 
 } PurplePounceHandler;
 
+/*
+ * The pounces on one buddy.  Pounces are indexed by pouncer account and
+ * normalized, casefolded pouncee, so an event only has to look at the
+ * pounces that could match it.
+ */
+typedef struct
+{
+	GList *pounces;               /* The pounces, oldest first. */
+	PurplePounceEvent events;     /* All the events they pounce on. */
+
+} PurplePounceBucket;
+
 
 static GHashTable *pounce_handlers = NULL;
+static GHashTable *pounce_index = NULL; /* account -> (key -> bucket) */
 static GList      *pounces = NULL;
 static guint       save_timer = 0;
 static gboolean    pounces_loaded = FALSE;
@@ -101,6 +117,135 @@ static gboolean    pounces_loaded = FALSE;
  * Private utility functions                                         *
  *********************************************************************/
 
+/*
+ * The key a buddy's pounces are filed under.  This matches the same
+ * names the old purple_utf8_strcasecmp() comparison did, including
+ * never matching invalid UTF-8.
+ */
+static char *
+pounce_index_key(const PurpleAccount *account, const char *name)
+{
+	const char *norm = purple_normalize(account, name);
+
+	if (!g_utf8_validate(norm, -1, NULL))
+		return NULL;
+
+	return g_utf8_casefold(norm, -1);
+}
+
+static void
+free_pounce_bucket(gpointer data)
+{
+	PurplePounceBucket *bucket = data;
+
+	g_list_free(bucket->pounces);
+	g_free(bucket);
+}
+
+static PurplePounceBucket *
+pounce_index_lookup(const PurpleAccount *account, const char *key)
+{
+	GHashTable *buddies;
+
+	if (pounce_index == NULL || key == NULL)
+		return NULL;
+
+	buddies = g_hash_table_lookup(pounce_index, account);
+	if (buddies == NULL)
+		return NULL;
+
+	return g_hash_table_lookup(buddies, key);
+}
+
+static void
+pounce_index_update_events(PurplePounceBucket *bucket)
+{
+	GList *l;
+
+	bucket->events = PURPLE_POUNCE_NONE;
+	for (l = bucket->pounces; l != NULL; l = l->next)
+		bucket->events |= ((PurplePounce *)l->data)->events;
+}
+
+static void
+pounce_index_add(PurplePounce *pounce)
+{
+	GHashTable *buddies;
+	PurplePounceBucket *bucket;
+
+	if (pounce_index == NULL)
+		return;
+
+	pounce->index_key = pounce_index_key(pounce->pouncer, pounce->pouncee);
+	if (pounce->index_key == NULL)
+		return;
+
+	buddies = g_hash_table_lookup(pounce_index, pounce->pouncer);
+	if (buddies == NULL)
+	{
+		buddies = g_hash_table_new_full(g_str_hash, g_str_equal,
+		                                g_free, free_pounce_bucket);
+		g_hash_table_insert(pounce_index, pounce->pouncer, buddies);
+	}
+
+	bucket = g_hash_table_lookup(buddies, pounce->index_key);
+	if (bucket == NULL)
+	{
+		bucket = g_new0(PurplePounceBucket, 1);
+		g_hash_table_insert(buddies, g_strdup(pounce->index_key), bucket);
+	}
+
+	bucket->pounces = g_list_append(bucket->pounces, pounce);
+	bucket->events |= pounce->events;
+}
+
+static void
+pounce_index_remove(PurplePounce *pounce)
+{
+	GHashTable *buddies;
+	PurplePounceBucket *bucket;
+
+	bucket = pounce_index_lookup(pounce->pouncer, pounce->index_key);
+	if (bucket != NULL)
+	{
+		bucket->pounces = g_list_remove(bucket->pounces, pounce);
+
+		if (bucket->pounces != NULL)
+			pounce_index_update_events(bucket);
+		else
+		{
+			buddies = g_hash_table_lookup(pounce_index, pounce->pouncer);
+			g_hash_table_remove(buddies, pounce->index_key);
+			if (g_hash_table_size(buddies) == 0)
+				g_hash_table_remove(pounce_index, pounce->pouncer);
+		}
+	}
+
+	g_free(pounce->index_key);
+	pounce->index_key = NULL;
+}
+
+/*
+ * Normalizing depends on the protocol, so refile everything when the
+ * set of protocols changes.
+ */
+static void
+pounce_index_rebuild(void)
+{
+	GList *l;
+
+	g_hash_table_remove_all(pounce_index);
+
+	for (l = pounces; l != NULL; l = l->next)
+	{
+		PurplePounce *pounce = l->data;
+
+		g_free(pounce->index_key);
+		pounce->index_key = NULL;
+		pounce_index_add(pounce);
+	}
+}
+
 static PurplePounceActionData *
 find_action_data(const PurplePounce *pounce, const char *name)
 {
@@ -660,6 +805,7 @@ purple_pounce_new(const char *ui_type, PurpleAccount *pouncer,
 		handler->new_pounce(pounce);
 
 	pounces = g_list_append(pounces, pounce);
+	pounce_index_add(pounce);
 
 	schedule_pounces_save();
 
@@ -676,6 +822,7 @@ purple_pounce_destroy(PurplePounce *pounce)
 	handler = g_hash_table_lookup(pounce_handlers, pounce->ui_type);
 
 	pounces = g_list_remove(pounces, pounce);
+	pounce_index_remove(pounce);
 
 	g_free(pounce->ui_type);
 	g_free(pounce->pouncee);
@@ -738,11 +885,17 @@ purple_pounce_destroy_all_by_buddy(PurpleBuddy *buddy)
 void
 purple_pounce_set_events(PurplePounce *pounce, PurplePounceEvent events)
 {
+	PurplePounceBucket *bucket;
+
 	g_return_if_fail(pounce != NULL);
 	g_return_if_fail(events != PURPLE_POUNCE_NONE);
 
 	pounce->events = events;
 
+	bucket = pounce_index_lookup(pounce->pouncer, pounce->index_key);
+	if (bucket != NULL)
+		pounce_index_update_events(bucket);
+
 	schedule_pounces_save();
 }
 
@@ -762,7 +915,9 @@ purple_pounce_set_pouncer(PurplePounce *pounce, PurpleAccount *pouncer)
 	g_return_if_fail(pounce  != NULL);
 	g_return_if_fail(pouncer != NULL);
 
+	pounce_index_remove(pounce);
 	pounce->pouncer = pouncer;
+	pounce_index_add(pounce);
 
 	schedule_pounces_save();
 }
@@ -773,8 +928,10 @@ purple_pounce_set_pouncee(PurplePounce *pounce, const char *pouncee)
 	g_return_if_fail(pounce  != NULL);
 	g_return_if_fail(pouncee != NULL);
 
+	pounce_index_remove(pounce);
 	g_free(pounce->pouncee);
 	pounce->pouncee = g_strdup(pouncee);
+	pounce_index_add(pounce);
 
 	schedule_pounces_save();
 }
@@ -949,27 +1106,30 @@ purple_pounce_execute(const PurpleAccount *pouncer, const char *pouncee,
 {
 	PurplePounce *pounce;
 	PurplePounceHandler *handler;
+	PurplePounceBucket *bucket;
 	PurplePresence *presence;
 	GList *l, *l_next;
-	char *norm_pouncee;
+	char *key;
 
 	g_return_if_fail(pouncer != NULL);
 	g_return_if_fail(pouncee != NULL);
 	g_return_if_fail(events  != PURPLE_POUNCE_NONE);
 
-	norm_pouncee = g_strdup(purple_normalize(pouncer, pouncee));
+	key = pounce_index_key(pouncer, pouncee);
+	bucket = pounce_index_lookup(pouncer, key);
+	g_free(key);
 
-	for (l = purple_pounces_get_all(); l != NULL; l = l_next)
+	if (bucket == NULL || !(bucket->events & events))
+		return;
+
+	presence = purple_account_get_presence(pouncer);
+
+	for (l = bucket->pounces; l != NULL; l = l_next)
 	{
 		pounce = (PurplePounce *)l->data;
 		l_next = l->next;
 
-		presence = purple_account_get_presence(pouncer);
-
 		if ((purple_pounce_get_events(pounce) & events) &&
-			(purple_pounce_get_pouncer(pounce) == pouncer) &&
-			!purple_utf8_strcasecmp(purple_normalize(pouncer, purple_pounce_get_pouncee(pounce)),
-								  norm_pouncee) &&
 			(pounce->options == PURPLE_POUNCE_OPTION_NONE ||
 			 (pounce->options & PURPLE_POUNCE_OPTION_AWAY &&
 			  !purple_presence_is_available(presence))))
@@ -985,42 +1145,36 @@ purple_pounce_execute(const PurpleAccount *pouncer, const char *pouncee,
 			}
 		}
 	}
-
-	g_free(norm_pouncee);
 }
 
 PurplePounce *
 purple_find_pounce(const PurpleAccount *pouncer, const char *pouncee,
 				 PurplePounceEvent events)
 {
-	PurplePounce *pounce = NULL;
+	PurplePounceBucket *bucket;
 	GList *l;
-	char *norm_pouncee;
+	char *key;
 
 	g_return_val_if_fail(pouncer != NULL, NULL);
 	g_return_val_if_fail(pouncee != NULL, NULL);
 	g_return_val_if_fail(events  != PURPLE_POUNCE_NONE, NULL);
 
-	norm_pouncee = g_strdup(purple_normalize(pouncer, pouncee));
+	key = pounce_index_key(pouncer, pouncee);
+	bucket = pounce_index_lookup(pouncer, key);
+	g_free(key);
 
-	for (l = purple_pounces_get_all(); l != NULL; l = l->next)
-	{
-		pounce = (PurplePounce *)l->data;
+	if (bucket == NULL || !(bucket->events & events))
+		return NULL;
 
-		if ((purple_pounce_get_events(pounce) & events) &&
-			(purple_pounce_get_pouncer(pounce) == pouncer) &&
-			!purple_utf8_strcasecmp(purple_normalize(pouncer, purple_pounce_get_pouncee(pounce)),
-								  norm_pouncee))
-		{
-			break;
-		}
+	for (l = bucket->pounces; l != NULL; l = l->next)
+	{
+		PurplePounce *pounce = (PurplePounce *)l->data;
 
-		pounce = NULL;
+		if (purple_pounce_get_events(pounce) & events)
+			return pounce;
 	}
 
-	g_free(norm_pouncee);
-
-	return pounce;
+	return NULL;
 }
 
 void
@@ -1147,6 +1301,12 @@ received_message_cb(PurpleAccount *account, const char *name, void *data)
 	purple_pounce_execute(account, name, PURPLE_POUNCE_MESSAGE_RECEIVED);
 }
 
+static void
+protocols_changed_cb(PurpleProtocol *protocol, void *data)
+{
+	pounce_index_rebuild();
+}
+
 void *
 purple_pounces_get_handle(void)
 {
@@ -1161,9 +1321,12 @@ purple_pounces_init(void)
 	void *handle       = purple_pounces_get_handle();
 	void *blist_handle = purple_blist_get_handle();
 	void *conv_handle  = purple_conversations_get_handle();
+	void *protocols_handle = purple_protocols_get_handle();
 
 	pounce_handlers = g_hash_table_new_full(g_str_hash, g_str_equal,
 											g_free, free_pounce_handler);
+	pounce_index = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+	                                     NULL, (GDestroyNotify)g_hash_table_destroy);
 
 	purple_signal_connect(blist_handle, "buddy-idle-changed",
 	                    handle, PURPLE_CALLBACK(buddy_idle_changed_cb), NULL);
@@ -1186,6 +1349,11 @@ purple_pounces_init(void)
 	purple_signal_connect(conv_handle, "received-im-msg",
 						handle, PURPLE_CALLBACK(received_message_cb), NULL);
 
+	purple_signal_connect(protocols_handle, "protocol-added",
+						handle, PURPLE_CALLBACK(protocols_changed_cb), NULL);
+	purple_signal_connect(protocols_handle, "protocol-removed",
+						handle, PURPLE_CALLBACK(protocols_changed_cb), NULL);
+
 	purple_pounces_load();
 }
 
@@ -1203,4 +1371,7 @@ purple_pounces_uninit()
 
 	g_hash_table_destroy(pounce_handlers);
 	pounce_handlers = NULL;
+
+	g_hash_table_destroy(pounce_index);
+	pounce_index = NULL;
 }
@@ -811,6 +811,9 @@ purple_buddy_presence_update_idle(PurplePresence *presence, gboolean old_idle)
 	PurpleAccount *account = purple_buddy_get_account(buddy);
 	gboolean idle = purple_presence_is_idle(presence);
 
+	if (_purple_statuses_coalesce_buddy_idle(buddy, old_idle))
+		return;
+
 	if (!old_idle && idle)
 	{
 		if (purple_prefs_get_bool("/purple/logging/log_system"))
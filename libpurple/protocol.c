@@ -917,6 +917,14 @@ purple_protocol_roomlist_iface_room_serialize(PurpleProtocol *protocol,
 	DEFINE_PROTOCOL_FUNC_WITH_RETURN(protocol, NULL, room_serialize, room);
 }
 
+PurpleRoomlist *
+purple_protocol_roomlist_iface_get_list_filtered(PurpleProtocol *protocol,
+		PurpleConnection *gc, const char *filter)
+{
+	DEFINE_PROTOCOL_FUNC_WITH_RETURN(protocol, NULL, get_list_filtered, gc,
+			filter);
+}
+
 #undef DEFINE_PROTOCOL_FUNC_WITH_RETURN
 #undef DEFINE_PROTOCOL_FUNC
 
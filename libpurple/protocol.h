@@ -611,6 +611,11 @@ struct _PurpleProtocolRoomlistIface
 
 	/* room list serialize */
 	char *(*room_serialize)(PurpleRoomlistRoom *room);
+
+	/* get_list, asking the server for only the rooms whose name contains
+	 * a string */
+	PurpleRoomlist *(*get_list_filtered)(PurpleConnection *gc,
+						 const char *filter);
 };
 
 #define PURPLE_PROTOCOL_HAS_ROOMLIST_IFACE(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj), PURPLE_TYPE_PROTOCOL_ROOMLIST_IFACE))
@@ -1126,6 +1131,9 @@ void purple_protocol_roomlist_iface_expand_category(PurpleProtocol *,
 char *purple_protocol_roomlist_iface_room_serialize(PurpleProtocol *,
 		PurpleRoomlistRoom *room);
 
+PurpleRoomlist *purple_protocol_roomlist_iface_get_list_filtered(PurpleProtocol *,
+		PurpleConnection *gc, const char *filter);
+
 /**************************************************************************/
 /* Protocol Attention Interface API                                       */
 /**************************************************************************/
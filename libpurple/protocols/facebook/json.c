@@ -27,14 +27,24 @@
 #include "json.h"
 #include "util.h"
 
+typedef struct _FbJsonPath FbJsonPath;
 typedef struct _FbJsonValue FbJsonValue;
 
+struct _FbJsonPath
+{
+	const gchar *name;
+	GSList *children;
+	GSList *values;
+};
+
 struct _FbJsonValue
 {
 	const gchar *expr;
+	gchar **path;
 	FbJsonType type;
 	gboolean required;
 	GValue value;
+	JsonNode *node;
 };
 
 struct _FbJsonValuesPrivate
@@ -42,6 +52,7 @@ struct _FbJsonValuesPrivate
 	JsonNode *root;
 	GQueue *queue;
 	GList *next;
+	FbJsonPath *paths;
 
 	gboolean isarray;
 	JsonArray *array;
@@ -52,6 +63,18 @@ struct _FbJsonValuesPrivate
 
 G_DEFINE_TYPE(FbJsonValues, fb_json_values, G_TYPE_OBJECT);
 
+static void
+fb_json_path_free(FbJsonPath *path)
+{
+	if (path == NULL) {
+		return;
+	}
+
+	g_slist_free_full(path->children, (GDestroyNotify) fb_json_path_free);
+	g_slist_free(path->values);
+	g_free(path);
+}
+
 static void
 fb_json_values_dispose(GObject *obj)
 {
@@ -65,9 +88,13 @@ fb_json_values_dispose(GObject *obj)
 			g_value_unset(&value->value);
 		}
 
+		g_strfreev(value->path);
 		g_free(value);
 	}
 
+	fb_json_path_free(priv->paths);
+	priv->paths = NULL;
+
 	if (priv->array != NULL) {
 		json_array_unref(priv->array);
 	}
@@ -258,7 +285,7 @@ fb_json_bldr_add_strf(JsonBuilder *bldr, const gchar *name,
 JsonNode *
 fb_json_node_new(const gchar *data, gssize size, GError **error)
 {
-	gchar *slice;
+	gchar *slice = NULL;
 	JsonNode *root;
 	JsonParser *prsr;
 
@@ -268,26 +295,95 @@ fb_json_node_new(const gchar *data, gssize size, GError **error)
 		size = strlen(data);
 	}
 
+#if !JSON_CHECK_VERSION(1, 0, 2)
 	/* Ensure data is null terminated for json-glib < 1.0.2 */
-	slice = g_strndup(data, size);
+	data = slice = g_strndup(data, size);
+#endif
+
 	prsr = json_parser_new();
 
-	if (!json_parser_load_from_data(prsr, slice, size, error)) {
+	if (!json_parser_load_from_data(prsr, data, size, error)) {
 		g_object_unref(prsr);
 		g_free(slice);
 		return NULL;
 	}
 
+#if JSON_CHECK_VERSION(1, 4, 0)
+	root = json_parser_steal_root(prsr);
+#else
 	root = json_parser_get_root(prsr);
 	root = json_node_copy(root);
+#endif
 
 	g_object_unref(prsr);
 	g_free(slice);
 	return root;
 }
 
-JsonNode *
-fb_json_node_get(JsonNode *root, const gchar *expr, GError **error)
+/* Splits a path which only selects object members, like "$.a.b", into the
+ * names of the members. Returns NULL for anything else, which has to be
+ * left to JsonPath. */
+static gchar **
+fb_json_path_compile(const gchar *expr)
+{
+	const gchar *c;
+
+	if (purple_strequal(expr, "$")) {
+		return g_new0(gchar *, 1);
+	}
+
+	if (!g_str_has_prefix(expr, "$.") || (expr[2] == '\0')) {
+		return NULL;
+	}
+
+	for (c = expr + 2; *c != '\0'; c++) {
+		if (!g_ascii_isalnum(*c) && (*c != '_') &&
+		    ((*c != '.') || (c[1] == '.') || (c[1] == '\0')))
+		{
+			return NULL;
+		}
+	}
+
+	return g_strsplit(expr + 2, ".", -1);
+}
+
+static JsonNode *
+fb_json_path_walk(JsonNode *root, gchar **path)
+{
+	JsonObject *obj;
+
+	for (; (root != NULL) && (*path != NULL); path++) {
+		if (!JSON_NODE_HOLDS_OBJECT(root)) {
+			return NULL;
+		}
+
+		obj = json_node_get_object(root);
+		root = json_object_get_member(obj, *path);
+	}
+
+	return root;
+}
+
+static gboolean
+fb_json_node_check(JsonNode *node, const gchar *expr, GError **error)
+{
+	if (node == NULL) {
+		g_set_error(error, FB_JSON_ERROR, FB_JSON_ERROR_NOMATCH,
+		            _("No matches for %s"), expr);
+		return FALSE;
+	}
+
+	if (JSON_NODE_HOLDS_NULL(node)) {
+		g_set_error(error, FB_JSON_ERROR, FB_JSON_ERROR_NULL,
+		            _("Null value for %s"), expr);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static JsonNode *
+fb_json_node_query(JsonNode *root, const gchar *expr, GError **error)
 {
 	GError *err = NULL;
 	guint size;
@@ -337,6 +433,48 @@ fb_json_node_get(JsonNode *root, const gchar *expr, GError **error)
 	return ret;
 }
 
+/* Looks up the node at expr without copying it when possible. If *owned is
+ * set, the returned node is a copy that has to be freed. */
+static JsonNode *
+fb_json_node_lookup(JsonNode *root, const gchar *expr, gboolean *owned,
+                    GError **error)
+{
+	gchar **path;
+	JsonNode *node;
+
+	path = fb_json_path_compile(expr);
+
+	if (path == NULL) {
+		*owned = TRUE;
+		return fb_json_node_query(root, expr, error);
+	}
+
+	*owned = FALSE;
+	node = fb_json_path_walk(root, path);
+	g_strfreev(path);
+
+	if (!fb_json_node_check(node, expr, error)) {
+		return NULL;
+	}
+
+	return node;
+}
+
+JsonNode *
+fb_json_node_get(JsonNode *root, const gchar *expr, GError **error)
+{
+	gboolean owned;
+	JsonNode *node;
+
+	node = fb_json_node_lookup(root, expr, &owned, error);
+
+	if ((node != NULL) && !owned) {
+		node = json_node_copy(node);
+	}
+
+	return node;
+}
+
 JsonNode *
 fb_json_node_get_nth(JsonNode *root, guint n)
 {
@@ -355,85 +493,110 @@ fb_json_node_get_nth(JsonNode *root, guint n)
 JsonArray *
 fb_json_node_get_arr(JsonNode *root, const gchar *expr, GError **error)
 {
+	gboolean owned;
 	JsonArray *ret;
 	JsonNode *rslt;
 
-	rslt = fb_json_node_get(root, expr, error);
+	rslt = fb_json_node_lookup(root, expr, &owned, error);
 
 	if (rslt == NULL) {
 		return NULL;
 	}
 
 	ret = json_node_dup_array(rslt);
-	json_node_free(rslt);
+
+	if (owned) {
+		json_node_free(rslt);
+	}
+
 	return ret;
 }
 
 gboolean
 fb_json_node_get_bool(JsonNode *root, const gchar *expr, GError **error)
 {
+	gboolean owned;
 	gboolean ret;
 	JsonNode *rslt;
 
-	rslt = fb_json_node_get(root, expr, error);
+	rslt = fb_json_node_lookup(root, expr, &owned, error);
 
 	if (rslt == NULL) {
 		return FALSE;
 	}
 
 	ret = json_node_get_boolean(rslt);
-	json_node_free(rslt);
+
+	if (owned) {
+		json_node_free(rslt);
+	}
+
 	return ret;
 }
 
 gdouble
 fb_json_node_get_dbl(JsonNode *root, const gchar *expr, GError **error)
 {
+	gboolean owned;
 	gdouble ret;
 	JsonNode *rslt;
 
-	rslt = fb_json_node_get(root, expr, error);
+	rslt = fb_json_node_lookup(root, expr, &owned, error);
 
 	if (rslt == NULL) {
 		return 0.0;
 	}
 
 	ret = json_node_get_double(rslt);
-	json_node_free(rslt);
+
+	if (owned) {
+		json_node_free(rslt);
+	}
+
 	return ret;
 }
 
 gint64
 fb_json_node_get_int(JsonNode *root, const gchar *expr, GError **error)
 {
+	gboolean owned;
 	gint64 ret;
 	JsonNode *rslt;
 
-	rslt = fb_json_node_get(root, expr, error);
+	rslt = fb_json_node_lookup(root, expr, &owned, error);
 
 	if (rslt == NULL) {
 		return 0;
 	}
 
 	ret = json_node_get_int(rslt);
-	json_node_free(rslt);
+
+	if (owned) {
+		json_node_free(rslt);
+	}
+
 	return ret;
 }
 
 gchar *
 fb_json_node_get_str(JsonNode *root, const gchar *expr, GError **error)
 {
+	gboolean owned;
 	gchar *ret;
 	JsonNode *rslt;
 
-	rslt = fb_json_node_get(root, expr, error);
+	rslt = fb_json_node_lookup(root, expr, &owned, error);
 
 	if (rslt == NULL) {
 		return NULL;
 	}
 
 	ret = json_node_dup_string(rslt);
-	json_node_free(rslt);
+
+	if (owned) {
+		json_node_free(rslt);
+	}
+
 	return ret;
 }
 
@@ -465,10 +628,15 @@ fb_json_values_add(FbJsonValues *values, FbJsonType type, gboolean required,
 
 	value = g_new0(FbJsonValue, 1);
 	value->expr = expr;
+	value->path = fb_json_path_compile(expr);
 	value->type = type;
 	value->required = required;
 
 	g_queue_push_tail(priv->queue, value);
+
+	/* Rebuilt with the next update */
+	fb_json_path_free(priv->paths);
+	priv->paths = NULL;
 }
 
 JsonNode *
@@ -511,11 +679,83 @@ fb_json_values_set_array(FbJsonValues *values, gboolean required,
 	}
 }
 
+/* Merges the compiled paths of the values into one tree, so the values
+ * sharing a prefix are looked up together. */
+static FbJsonPath *
+fb_json_values_compile(FbJsonValues *values)
+{
+	FbJsonPath *path;
+	FbJsonPath *paths;
+	FbJsonValue *value;
+	FbJsonValuesPrivate *priv = values->priv;
+	gchar **name;
+	GList *l;
+	GSList *m;
+
+	paths = g_new0(FbJsonPath, 1);
+
+	for (l = priv->queue->head; l != NULL; l = l->next) {
+		value = l->data;
+
+		if (value->path == NULL) {
+			continue;
+		}
+
+		for (path = paths, name = value->path; *name != NULL; name++) {
+			for (m = path->children; m != NULL; m = m->next) {
+				if (purple_strequal(((FbJsonPath *) m->data)->name, *name)) {
+					break;
+				}
+			}
+
+			if (m == NULL) {
+				m = g_slist_prepend(NULL, g_new0(FbJsonPath, 1));
+				((FbJsonPath *) m->data)->name = *name;
+				path->children = g_slist_concat(path->children, m);
+			}
+
+			path = m->data;
+		}
+
+		path->values = g_slist_prepend(path->values, value);
+	}
+
+	return paths;
+}
+
+static void
+fb_json_values_collect(FbJsonPath *path, JsonNode *node)
+{
+	FbJsonPath *child;
+	GSList *l;
+	JsonObject *obj = NULL;
+
+	for (l = path->values; l != NULL; l = l->next) {
+		((FbJsonValue *) l->data)->node = node;
+	}
+
+	if ((node != NULL) && JSON_NODE_HOLDS_OBJECT(node)) {
+		obj = json_node_get_object(node);
+	}
+
+	for (l = path->children; l != NULL; l = l->next) {
+		child = l->data;
+		node = NULL;
+
+		if (obj != NULL) {
+			node = json_object_get_member(obj, child->name);
+		}
+
+		fb_json_values_collect(child, node);
+	}
+}
+
 gboolean
 fb_json_values_update(FbJsonValues *values, GError **error)
 {
 	FbJsonValue *value;
 	FbJsonValuesPrivate *priv;
+	gboolean owned;
 	GError *err = NULL;
 	GList *l;
 	GType type;
@@ -545,16 +785,36 @@ fb_json_values_update(FbJsonValues *values, GError **error)
 
 	g_return_val_if_fail(root != NULL, FALSE);
 
+	/* Find the nodes of all the simple paths in one walk */
+	if (priv->paths == NULL) {
+		priv->paths = fb_json_values_compile(values);
+	}
+
+	fb_json_values_collect(priv->paths, root);
+
 	for (l = priv->queue->head; l != NULL; l = l->next) {
 		value = l->data;
-		node = fb_json_node_get(root, value->expr, &err);
+
+		if (value->path != NULL) {
+			owned = FALSE;
+			node = value->node;
+
+			if (!fb_json_node_check(node, value->expr, &err)) {
+				node = NULL;
+			}
+		} else {
+			owned = TRUE;
+			node = fb_json_node_query(root, value->expr, &err);
+		}
 
 		if (G_IS_VALUE(&value->value)) {
 			g_value_unset(&value->value);
 		}
 
 		if (err != NULL) {
-			json_node_free(node);
+			if (owned && (node != NULL)) {
+				json_node_free(node);
+			}
 
 			if (value->required) {
 				g_propagate_error(error, err);
@@ -573,12 +833,19 @@ fb_json_values_update(FbJsonValues *values, GError **error)
 			            g_type_name(value->type),
 			            g_type_name(type),
 				    value->expr);
-			json_node_free(node);
+
+			if (owned) {
+				json_node_free(node);
+			}
+
 			return FALSE;
 		}
 
 		json_node_get_value(node, &value->value);
-		json_node_free(node);
+
+		if (owned) {
+			json_node_free(node);
+		}
 	}
 
 	priv->next = priv->queue->head;
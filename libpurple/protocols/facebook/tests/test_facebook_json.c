@@ -0,0 +1,187 @@
+/*
+ * Purple
+ *
+ * Purple is the legal property of its developers, whose names are too
+ * numerous to list here. Please refer to the COPYRIGHT file distributed
+ * with this source distribution
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02111-1301 USA
+ */
+
+#include <glib.h>
+
+#include "../json.h"
+
+#define THREADS 500
+
+/* Builds a thread list response shaped like the ones the sync requests get */
+static gchar *
+test_facebook_json_thread_list(guint threads)
+{
+	GString *str = g_string_new("{\"viewer\":{\"message_threads\":{"
+		"\"sync_sequence_id\":\"1234\",\"unread_count\":3,\"nodes\":[");
+	guint i;
+
+	for (i = 0; i < threads; i++) {
+		g_string_append_printf(str,
+			"%s{\"thread_key\":{\"thread_fbid\":\"%u\","
+			"\"other_user_id\":null},\"name\":\"Thread %u\","
+			"\"unread_count\":%u,\"is_group_thread\":true,"
+			"\"all_participants\":{\"nodes\":["
+			"{\"messaging_actor\":{\"id\":\"%u\",\"name\":\"Alice\"}},"
+			"{\"messaging_actor\":{\"id\":\"%u\",\"name\":\"Bob\"}}]},"
+			"\"last_message\":{\"nodes\":[{\"message\":{\"text\":"
+			"\"Hello there, this is message number %u\"},"
+			"\"timestamp_precise\":\"14%011u\"}]}}",
+			(i > 0) ? "," : "", 100000 + i, i, i % 5,
+			200000 + i, 300000 + i, i, i);
+	}
+
+	g_string_append(str, "]}}}");
+	return g_string_free(str, FALSE);
+}
+
+static guint
+test_facebook_json_parse(const gchar *data)
+{
+	FbJsonValues *values;
+	GError *err = NULL;
+	guint count = 0;
+	JsonNode *root;
+
+	root = fb_json_node_new(data, -1, &err);
+	g_assert_no_error(err);
+
+	values = fb_json_values_new(root);
+	fb_json_values_add(values, FB_JSON_TYPE_STR, TRUE, "$.thread_key.thread_fbid");
+	fb_json_values_add(values, FB_JSON_TYPE_STR, FALSE, "$.thread_key.other_user_id");
+	fb_json_values_add(values, FB_JSON_TYPE_STR, FALSE, "$.name");
+	fb_json_values_add(values, FB_JSON_TYPE_INT, TRUE, "$.unread_count");
+	fb_json_values_add(values, FB_JSON_TYPE_STR, FALSE, "$.missing.member");
+	fb_json_values_set_array(values, TRUE, "$.viewer.message_threads.nodes");
+
+	while (fb_json_values_update(values, &err)) {
+		gchar *name;
+
+		g_assert_cmpuint(100000 + count, ==,
+			g_ascii_strtoull(fb_json_values_next_str(values, "0"), NULL, 10));
+		g_assert(fb_json_values_next_str(values, NULL) == NULL);
+
+		name = g_strdup_printf("Thread %u", count);
+		g_assert_cmpstr(name, ==, fb_json_values_next_str(values, NULL));
+		g_free(name);
+
+		g_assert_cmpint(count % 5, ==, fb_json_values_next_int(values, -1));
+		g_assert_cmpstr("default", ==, fb_json_values_next_str(values, "default"));
+		count++;
+	}
+
+	g_assert_no_error(err);
+	g_object_unref(values);
+	json_node_free(root);
+	return count;
+}
+
+static void
+test_facebook_json_values(void)
+{
+	gchar *data;
+
+	data = test_facebook_json_thread_list(10);
+	g_assert_cmpuint(10, ==, test_facebook_json_parse(data));
+	g_free(data);
+}
+
+static void
+test_facebook_json_errors(void)
+{
+	FbJsonValues *values;
+	GError *err = NULL;
+	JsonNode *root;
+
+	root = fb_json_node_new("{\"a\":{\"b\":\"str\",\"c\":null},\"d\":[1,2]}",
+	                        -1, &err);
+	g_assert_no_error(err);
+
+	values = fb_json_values_new(root);
+	fb_json_values_add(values, FB_JSON_TYPE_STR, TRUE, "$.a.c");
+	g_assert(!fb_json_values_update(values, &err));
+	g_assert_error(err, FB_JSON_ERROR, FB_JSON_ERROR_NULL);
+	g_clear_error(&err);
+	g_object_unref(values);
+
+	values = fb_json_values_new(root);
+	fb_json_values_add(values, FB_JSON_TYPE_INT, TRUE, "$.a.b");
+	g_assert(!fb_json_values_update(values, &err));
+	g_assert_error(err, FB_JSON_ERROR, FB_JSON_ERROR_TYPE);
+	g_clear_error(&err);
+	g_object_unref(values);
+
+	values = fb_json_values_new(root);
+	fb_json_values_add(values, FB_JSON_TYPE_STR, TRUE, "$.a.b.c");
+	g_assert(!fb_json_values_update(values, &err));
+	g_assert_error(err, FB_JSON_ERROR, FB_JSON_ERROR_NOMATCH);
+	g_clear_error(&err);
+	g_object_unref(values);
+
+	/* Anything more than member access still goes through JsonPath */
+	values = fb_json_values_new(root);
+	fb_json_values_add(values, FB_JSON_TYPE_STR, TRUE, "$.a.b");
+	fb_json_values_add(values, FB_JSON_TYPE_INT, TRUE, "$.d[1]");
+	g_assert(fb_json_values_update(values, &err));
+	g_assert_no_error(err);
+	g_assert_cmpstr("str", ==, fb_json_values_next_str(values, NULL));
+	g_assert_cmpint(2, ==, fb_json_values_next_int(values, 0));
+	g_object_unref(values);
+
+	json_node_free(root);
+}
+
+static void
+test_facebook_json_thread_list_perf(void)
+{
+	gchar *data;
+	gdouble elapsed;
+	guint i;
+	guint runs = g_test_perf() ? 100 : 1;
+
+	data = test_facebook_json_thread_list(THREADS);
+
+	g_test_timer_start();
+
+	for (i = 0; i < runs; i++) {
+		g_assert_cmpuint(THREADS, ==, test_facebook_json_parse(data));
+	}
+
+	elapsed = g_test_timer_elapsed();
+	g_test_minimized_result(elapsed / runs,
+		"parsed a %u thread list in %f seconds", THREADS, elapsed / runs);
+
+	g_free(data);
+}
+
+gint
+main(gint argc, gchar **argv) {
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/facebook/json/values",
+	                test_facebook_json_values);
+	g_test_add_func("/facebook/json/errors",
+	                test_facebook_json_errors);
+	g_test_add_func("/facebook/json/thread_list",
+	                test_facebook_json_thread_list_perf);
+
+	return g_test_run();
+}
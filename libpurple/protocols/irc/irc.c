@@ -760,7 +760,8 @@ static void irc_chat_set_topic(PurpleConnection *gc, int id, const char *topic)
 	g_free(buf);
 }
 
-static PurpleRoomlist *irc_roomlist_get_list(PurpleConnection *gc)
+static PurpleRoomlist *irc_roomlist_get_list_filtered(PurpleConnection *gc,
+		const char *filter)
 {
 	struct irc_conn *irc;
 	GList *fields = NULL;
@@ -785,13 +786,27 @@ static PurpleRoomlist *irc_roomlist_get_list(PurpleConnection *gc)
 
 	purple_roomlist_set_fields(irc->roomlist, fields);
 
-	buf = irc_format(irc, "v", "LIST");
+	/* Only servers that say so match channel names against a mask, and a
+	 * mask can't have spaces or commas in it. */
+	if (filter != NULL && *filter != '\0' && irc->list_masks &&
+			strpbrk(filter, " ,") == NULL) {
+		char *mask = g_strdup_printf("*%s*", filter);
+		buf = irc_format(irc, "vc", "LIST", mask);
+		g_free(mask);
+	} else {
+		buf = irc_format(irc, "v", "LIST");
+	}
 	irc_send(irc, buf);
 	g_free(buf);
 
 	return irc->roomlist;
 }
 
+static PurpleRoomlist *irc_roomlist_get_list(PurpleConnection *gc)
+{
+	return irc_roomlist_get_list_filtered(gc, NULL);
+}
+
 static void irc_roomlist_cancel(PurpleRoomlist *list)
 {
 	PurpleAccount *account = purple_roomlist_get_account(list);
@@ -926,6 +941,7 @@ irc_protocol_roomlist_iface_init(PurpleProtocolRoomlistIface *roomlist_iface)
 {
 	roomlist_iface->get_list = irc_roomlist_get_list;
 	roomlist_iface->cancel   = irc_roomlist_cancel;
+	roomlist_iface->get_list_filtered = irc_roomlist_get_list_filtered;
 }
 
 static void
@@ -104,6 +104,7 @@ struct irc_conn {
 		time_t signon;
 	} whois;
 	PurpleRoomlist *roomlist;
+	gboolean list_masks; /* LIST takes a mask to match channel names */
 
 	gboolean quitting;
 
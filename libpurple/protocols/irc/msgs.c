@@ -212,6 +212,8 @@ void irc_msg_features(struct irc_conn *irc, const char *name, const char *from,
 		if (!strncmp(features[i], "PREFIX=", 7)) {
 			if ((val = strchr(features[i] + 7, ')')) != NULL)
 				irc->mode_chars = g_strdup(val + 1);
+		} else if (!strncmp(features[i], "ELIST=", 6)) {
+			irc->list_masks = (strpbrk(features[i] + 6, "Mm") != NULL);
 		}
 	}
 
@@ -1045,6 +1047,8 @@ void irc_msg_mode(struct irc_conn *irc, const char *name, const char *from, char
 			gboolean add = FALSE;
 			mcur = args[1];
 			cur = args[2];
+			/* A mode line can change many users at once. */
+			purple_chat_conversation_begin_batch(chat);
 			while (*cur && *mcur) {
 				if ((*mcur == '+') || (*mcur == '-')) {
 					add = (*mcur == '+') ? TRUE : FALSE;
@@ -1081,6 +1085,7 @@ void irc_msg_mode(struct irc_conn *irc, const char *name, const char *from, char
 				if (*mcur)
 					mcur++;
 			}
+			purple_chat_conversation_commit_batch(chat);
 		}
 	} else {					/* User		*/
 	}
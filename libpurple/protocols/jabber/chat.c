@@ -428,6 +428,13 @@ void jabber_chat_leave(PurpleConnection *gc, int id)
 
 	jabber_chat_part(chat, NULL);
 
+	/* The conversation is going away, so there is nobody to show the
+	 * occupants to. */
+	if (chat->occupants_timeout) {
+		purple_timeout_remove(chat->occupants_timeout);
+		chat->occupants_timeout = 0;
+	}
+
 	chat->left = TRUE;
 }
 
@@ -442,6 +449,8 @@ void jabber_chat_destroy(JabberChat *chat)
 
 void jabber_chat_free(JabberChat *chat)
 {
+	jabber_chat_occupants_done(chat);
+
 	if(chat->config_dialog_handle)
 		purple_request_close(chat->config_dialog_type, chat->config_dialog_handle);
 
@@ -453,6 +462,46 @@ void jabber_chat_free(JabberChat *chat)
 	g_free(chat);
 }
 
+static gboolean
+jabber_chat_occupants_timeout_cb(gpointer data)
+{
+	JabberChat *chat = data;
+
+	purple_debug_warning("jabber", "Didn't get our own presence in %s@%s, "
+			"showing the occupants anyway\n", chat->room, chat->server);
+
+	chat->occupants_timeout = 0;
+	if (chat->conv && !chat->left)
+		purple_chat_conversation_commit_batch(chat->conv);
+
+	return FALSE;
+}
+
+void jabber_chat_occupants_begin(JabberChat *chat)
+{
+	g_return_if_fail(chat->conv != NULL);
+
+	if (chat->occupants_timeout)
+		return;
+
+	/* XEP-0045 sends our own presence after everyone else's. */
+	purple_chat_conversation_begin_batch(chat->conv);
+	chat->occupants_timeout = purple_timeout_add_seconds(10,
+			jabber_chat_occupants_timeout_cb, chat);
+}
+
+void jabber_chat_occupants_done(JabberChat *chat)
+{
+	if (!chat->occupants_timeout)
+		return;
+
+	purple_timeout_remove(chat->occupants_timeout);
+	chat->occupants_timeout = 0;
+
+	if (chat->conv && !chat->left)
+		purple_chat_conversation_commit_batch(chat->conv);
+}
+
 gboolean jabber_chat_find_buddy(PurpleChatConversation *conv, const char *name)
 {
 	return purple_chat_conversation_has_user(conv, name);
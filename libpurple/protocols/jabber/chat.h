@@ -53,6 +53,7 @@ typedef struct _JabberChat {
 	GHashTable *members;
 	gboolean left;
 	time_t joined;
+	guint occupants_timeout;
 } JabberChat;
 
 GList *jabber_chat_info(PurpleConnection *gc);
@@ -80,6 +81,13 @@ JabberChat *jabber_chat_find_by_id(JabberStream *js, int id);
 JabberChat *jabber_chat_find_by_conv(PurpleChatConversation *conv);
 void jabber_chat_destroy(JabberChat *chat);
 void jabber_chat_free(JabberChat *chat);
+
+/**
+ * Batches the occupants we are told about while joining a room, until
+ * jabber_chat_occupants_done() is called or a timeout runs out.
+ */
+void jabber_chat_occupants_begin(JabberChat *chat);
+void jabber_chat_occupants_done(JabberChat *chat);
 gboolean jabber_chat_find_buddy(PurpleChatConversation *conv, const char *name);
 void jabber_chat_invite(PurpleConnection *gc, int id, const char *message,
 		const char *name);
@@ -636,6 +636,9 @@ handle_presence_chat(JabberStream *js, JabberPresence *presence, PurpleXmlNode *
 
 			jabber_chat_disco_traffic(chat);
 			g_free(room_jid);
+
+			if (chat->muc && !is_our_resource)
+				jabber_chat_occupants_begin(chat);
 		}
 
 		jbr = jabber_buddy_track_resource(presence->jb, presence->jid_from->resource, presence->priority, presence->state, presence->status);
@@ -650,8 +653,10 @@ handle_presence_chat(JabberStream *js, JabberPresence *presence, PurpleXmlNode *
 			purple_chat_user_set_flags(purple_chat_conversation_find_user(chat->conv, presence->jid_from->resource),
 					flags);
 
-		if (is_our_resource && chat->joined == 0)
+		if (is_our_resource && chat->joined == 0) {
 			chat->joined = time(NULL);
+			jabber_chat_occupants_done(chat);
+		}
 
 	} else if (presence->type == JABBER_PRESENCE_UNAVAILABLE) {
 		gboolean nick_change = FALSE;
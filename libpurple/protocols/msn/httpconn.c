@@ -285,7 +285,7 @@ msn_httpconn_read_finish(gpointer _httpconn)
 
 	httpconn->finish_timer = 0;
 
-	if (httpconn->servconn->rx_len > 0) {
+	if (purple_framing_buffer_get_used(httpconn->servconn->rx_buf) > 0) {
 		if (msn_servconn_process_data(httpconn->servconn) == NULL)
 			return FALSE;
 	}
@@ -325,9 +325,8 @@ msn_httpconn_read(PurpleHttpConnection *phc, PurpleHttpResponse *response,
 
 	got_data = purple_http_response_get_data(response, &got_len);
 
-	g_free(httpconn->servconn->rx_buf);
-	httpconn->servconn->rx_buf = g_memdup(got_data, got_len);
-	httpconn->servconn->rx_len = got_len;
+	purple_framing_buffer_reset(httpconn->servconn->rx_buf);
+	purple_framing_buffer_append(httpconn->servconn->rx_buf, got_data, got_len);
 
 	httpconn->current_request = NULL;
 	httpconn->finish_timer = purple_timeout_add(0, msn_httpconn_read_finish,
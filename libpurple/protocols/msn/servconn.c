@@ -53,7 +53,8 @@ msn_servconn_new(MsnSession *session, MsnServConnType type)
 
 	servconn->num = session->servconns_count++;
 
-	servconn->tx_buf = purple_circular_buffer_new(MSN_BUF_LEN);
+	servconn->rx_buf = purple_framing_buffer_new(MSN_BUF_LEN);
+	servconn->tx_buf = purple_framing_buffer_new(MSN_BUF_LEN);
 	servconn->tx_handler = 0;
 	servconn->timeout_sec = 0;
 	servconn->timeout_handle = 0;
@@ -84,6 +85,7 @@ msn_servconn_destroy(MsnServConn *servconn)
 
 	g_free(servconn->host);
 
+	g_object_unref(G_OBJECT(servconn->rx_buf));
 	g_object_unref(G_OBJECT(servconn->tx_buf));
 	if (servconn->tx_handler > 0)
 		purple_input_remove(servconn->tx_handler);
@@ -285,8 +287,9 @@ msn_servconn_disconnect(MsnServConn *servconn)
 
 	close(servconn->fd);
 
-	servconn->rx_buf = NULL;
-	servconn->rx_len = 0;
+	/* msn_servconn_process_data() clears it once it's done with it */
+	if (!servconn->processing)
+		purple_framing_buffer_reset(servconn->rx_buf);
 	servconn->payload_len = 0;
 
 	servconn->connected = FALSE;
@@ -330,19 +333,14 @@ servconn_write_cb(gpointer data, gint source, PurpleInputCondition cond)
 {
 	MsnServConn *servconn = data;
 	gssize ret;
-	int writelen;
-	const gchar *output = NULL;
 
-	writelen = purple_circular_buffer_get_max_read(servconn->tx_buf);
-	output = purple_circular_buffer_get_output(servconn->tx_buf);
-
-	if (writelen == 0) {
+	if (purple_framing_buffer_get_used(servconn->tx_buf) == 0) {
 		purple_input_remove(servconn->tx_handler);
 		servconn->tx_handler = 0;
 		return;
 	}
 
-	ret = write(servconn->fd, output, writelen);
+	ret = purple_framing_buffer_send(servconn->tx_buf, servconn->fd);
 
 	if (ret < 0 && errno == EAGAIN)
 		return;
@@ -351,7 +349,6 @@ servconn_write_cb(gpointer data, gint source, PurpleInputCondition cond)
 		return;
 	}
 
-	purple_circular_buffer_mark_read(servconn->tx_buf, ret);
 	servconn_timeout_renew(servconn);
 }
 
@@ -393,7 +390,7 @@ msn_servconn_write(MsnServConn *servconn, const char *buf, size_t len)
 				servconn->tx_handler = purple_input_add(
 					servconn->fd, PURPLE_INPUT_WRITE,
 					servconn_write_cb, servconn);
-			purple_circular_buffer_append(servconn->tx_buf, buf + ret,
+			purple_framing_buffer_append(servconn->tx_buf, buf + ret,
 				len - ret);
 		}
 	}
@@ -415,7 +412,8 @@ static void
 read_cb(gpointer data, gint source, PurpleInputCondition cond)
 {
 	MsnServConn *servconn;
-	char buf[MSN_BUF_LEN];
+	gpointer buf;
+	gsize buflen;
 	gssize len;
 
 	servconn = data;
@@ -425,7 +423,8 @@ read_cb(gpointer data, gint source, PurpleInputCondition cond)
 		purple_connection_update_last_received(gc);
 	}
 
-	len = read(servconn->fd, buf, sizeof(buf) - 1);
+	buf = purple_framing_buffer_get_input(servconn->rx_buf, &buflen);
+	len = read(servconn->fd, buf, buflen);
 	if (len < 0 && errno == EAGAIN)
 		return;
 	if (len <= 0) {
@@ -437,11 +436,7 @@ read_cb(gpointer data, gint source, PurpleInputCondition cond)
 		return;
 	}
 
-	buf[len] = '\0';
-
-	servconn->rx_buf = g_realloc(servconn->rx_buf, len + servconn->rx_len + 1);
-	memcpy(servconn->rx_buf + servconn->rx_len, buf, len + 1);
-	servconn->rx_len += len;
+	purple_framing_buffer_mark_written(servconn->rx_buf, len);
 
 	servconn = msn_servconn_process_data(servconn);
 	if (servconn)
@@ -450,63 +445,50 @@ read_cb(gpointer data, gint source, PurpleInputCondition cond)
 
 MsnServConn *msn_servconn_process_data(MsnServConn *servconn)
 {
-	char *cur, *end, *old_rx_buf;
-	int cur_len;
-
-	end = old_rx_buf = servconn->rx_buf;
+	PurpleFramingBuffer *rx_buf = servconn->rx_buf;
+	char *cur;
+	gssize cur_len;
 
 	servconn->processing = TRUE;
 
 	do
 	{
-		cur = end;
-
 		if (servconn->payload_len)
 		{
-			if (servconn->rx_len < 0 || servconn->payload_len >
-				(gsize)servconn->rx_len)
-			{
+			cur = purple_framing_buffer_peek(rx_buf, servconn->payload_len);
+
+			if (cur == NULL)
 				/* The payload is still not complete. */
 				break;
-			}
 
 			cur_len = servconn->payload_len;
-			end += cur_len;
+			msn_cmdproc_process_payload(servconn->cmdproc, cur, cur_len);
+			servconn->payload_len = 0;
 		}
 		else
 		{
-			end = strstr(cur, "\r\n");
+			cur_len = purple_framing_buffer_find(rx_buf, "\r\n", 2);
 
-			if (end == NULL)
+			if (cur_len < 0)
 				/* The command is still not complete. */
 				break;
 
-			*end = '\0';
-			end += 2;
-			cur_len = end - cur;
-		}
-
-		servconn->rx_len -= cur_len;
+			/* Terminate the command in place, over the \r */
+			cur = purple_framing_buffer_peek(rx_buf, cur_len + 2);
+			cur[cur_len] = '\0';
+			cur_len += 2;
 
-		if (servconn->payload_len)
-		{
-			msn_cmdproc_process_payload(servconn->cmdproc, cur, cur_len);
-			servconn->payload_len = 0;
-		}
-		else
-		{
 			msn_cmdproc_process_cmd_text(servconn->cmdproc, cur);
 			servconn->payload_len = servconn->cmdproc->last_cmd->payload_len;
 		}
-	} while (servconn->connected && !servconn->wasted && servconn->rx_len > 0);
 
-	if (servconn->connected && !servconn->wasted)
-	{
-		if (servconn->rx_len > 0)
-			servconn->rx_buf = g_memdup(cur, servconn->rx_len);
-		else
-			servconn->rx_buf = NULL;
-	}
+		purple_framing_buffer_mark_read(rx_buf, cur_len);
+	} while (servconn->connected && !servconn->wasted &&
+		purple_framing_buffer_get_used(rx_buf) > 0);
+
+	/* Anything left over belonged to a connection that's gone now */
+	if (!servconn->connected || servconn->wasted)
+		purple_framing_buffer_reset(rx_buf);
 
 	servconn->processing = FALSE;
 
@@ -515,7 +497,6 @@ MsnServConn *msn_servconn_process_data(MsnServConn *servconn)
 		servconn = NULL;
 	}
 
-	g_free(old_rx_buf);
 	return servconn;
 }
 
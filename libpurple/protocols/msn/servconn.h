@@ -24,7 +24,7 @@
 #ifndef MSN_SERVCONN_H
 #define MSN_SERVCONN_H
 
-#include "circularbuffer.h"
+#include "framingbuffer.h"
 
 typedef struct _MsnServConn MsnServConn;
 
@@ -80,14 +80,13 @@ struct _MsnServConn
 	int fd; /**< The connection's file descriptor. */
 	int inpa; /**< The connection's input handler. */
 
-	char *rx_buf; /**< The receive buffer. */
-	int rx_len; /**< The receive buffer lenght. */
+	PurpleFramingBuffer *rx_buf; /**< The receive buffer. */
 
 	size_t payload_len; /**< The length of the payload.
 						  It's only set when we've received a command that
 						  has a payload. */
 
-	PurpleCircularBuffer *tx_buf;
+	PurpleFramingBuffer *tx_buf;
 	guint tx_handler;
 	guint timeout_sec;
 	guint timeout_handle;
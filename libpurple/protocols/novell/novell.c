@@ -677,6 +677,7 @@ _join_conf_resp_cb(NMUser * user, NMERR_T ret_code,
 
 			nm_conference_set_data(conference, (gpointer) chat);
 
+			purple_chat_conversation_begin_batch(chat);
 			count = nm_conference_get_participant_count(conference);
 			for (i = 0; i < count; i++) {
 				ur = nm_conference_get_participant(conference, i);
@@ -686,6 +687,7 @@ _join_conf_resp_cb(NMUser * user, NMERR_T ret_code,
 											PURPLE_CHAT_USER_NONE, TRUE);
 				}
 			}
+			purple_chat_conversation_commit_batch(chat);
 		}
 	}
 }
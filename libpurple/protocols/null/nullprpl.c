@@ -194,6 +194,175 @@ static void report_status_change(PurpleConnection *from, PurpleConnection *to,
 }
 
 
+/*
+ * load generation. if an account's "load_buddies" or "load_chat_size" option
+ * is set, signing it on fills its buddy list with that many synthetic buddies
+ * (and/or joins a chat room with that many synthetic occupants), then runs a
+ * timer that changes their presence and delivers IMs and chat messages at the
+ * configured rates. this exercises the core's signal, buddy list,
+ * conversation and logging paths without any other accounts or servers; see
+ * libpurple/example/nullbench.c for a driver that measures them.
+ */
+#define NULL_LOAD_TICK   10           /* milliseconds between timer runs */
+#define NULL_LOAD_GROUP  "Null Load"
+#define NULL_LOAD_ROOM   "load"
+
+typedef struct {
+  PurpleConnection *gc;
+  guint timer;
+  int buddies;
+  int presence_rate;     /* presence changes per second */
+  int im_rate;           /* IMs per second */
+  int chat_rate;         /* chat messages per second */
+  int chat_size;
+  int chat_id;
+  double presence_due;   /* events owed, carried between timer runs */
+  double im_due;
+  double chat_due;
+  guint serial;
+} NullLoad;
+
+static char *load_user_name(int n) {
+  return g_strdup_printf("load%d", n);
+}
+
+static void load_presence(NullLoad *load) {
+  static const char *status_ids[] = {
+    NULL_STATUS_ONLINE, NULL_STATUS_AWAY, NULL_STATUS_OFFLINE
+  };
+  char *who = load_user_name(g_random_int_range(0, load->buddies));
+  char *message = g_strdup_printf("load status %u", ++load->serial);
+
+  purple_protocol_got_user_status(purple_connection_get_account(load->gc), who,
+      status_ids[g_random_int_range(0, G_N_ELEMENTS(status_ids))],
+      "message", message, NULL);
+
+  g_free(message);
+  g_free(who);
+}
+
+static void load_im(NullLoad *load) {
+  char *who = load_user_name(g_random_int_range(0, MAX(load->buddies, 1)));
+  char *message = g_strdup_printf("load message %u", ++load->serial);
+
+  purple_serv_got_im(load->gc, who, message, PURPLE_MESSAGE_RECV, time(NULL));
+
+  g_free(message);
+  g_free(who);
+}
+
+static void load_chat(NullLoad *load) {
+  char *who = load_user_name(g_random_int_range(0, load->chat_size));
+  char *message = g_strdup_printf("load chat message %u", ++load->serial);
+
+  purple_serv_got_chat_in(load->gc, load->chat_id, who, PURPLE_MESSAGE_RECV,
+                          message, time(NULL));
+
+  g_free(message);
+  g_free(who);
+}
+
+static gboolean load_tick(gpointer data) {
+  NullLoad *load = (NullLoad *)data;
+
+  if (load->buddies > 0) {
+    load->presence_due += load->presence_rate * NULL_LOAD_TICK / 1000.0;
+    for (; load->presence_due >= 1; load->presence_due--)
+      load_presence(load);
+  }
+
+  load->im_due += load->im_rate * NULL_LOAD_TICK / 1000.0;
+  for (; load->im_due >= 1; load->im_due--)
+    load_im(load);
+
+  if (load->chat_size > 0) {
+    load->chat_due += load->chat_rate * NULL_LOAD_TICK / 1000.0;
+    for (; load->chat_due >= 1; load->chat_due--)
+      load_chat(load);
+  }
+
+  return TRUE;
+}
+
+static void null_load_start(PurpleConnection *gc) {
+  PurpleAccount *acct = purple_connection_get_account(gc);
+  NullLoad *load;
+  int i;
+
+  load = g_new0(NullLoad, 1);
+  load->gc = gc;
+  load->buddies = purple_account_get_int(acct, "load_buddies", 0);
+  load->presence_rate = purple_account_get_int(acct, "load_presence_rate", 0);
+  load->im_rate = purple_account_get_int(acct, "load_im_rate", 0);
+  load->chat_rate = purple_account_get_int(acct, "load_chat_rate", 0);
+  load->chat_size = purple_account_get_int(acct, "load_chat_size", 0);
+
+  if (load->buddies <= 0 && load->chat_size <= 0) {
+    g_free(load);
+    return;
+  }
+
+  purple_debug_info("nullprpl", "generating load for %s: %d buddies, "
+                    "%d presence changes/s, %d IMs/s, %d chat messages/s "
+                    "in a room of %d\n", purple_account_get_username(acct),
+                    load->buddies, load->presence_rate, load->im_rate,
+                    load->chat_rate, load->chat_size);
+
+  if (load->buddies > 0) {
+    PurpleGroup *group = purple_blist_find_group(NULL_LOAD_GROUP);
+
+    if (!group) {
+      group = purple_group_new(NULL_LOAD_GROUP);
+      purple_blist_add_group(group, NULL);
+    }
+
+    for (i = 0; i < load->buddies; i++) {
+      char *who = load_user_name(i);
+
+      if (!purple_blist_find_buddy(acct, who))
+        purple_blist_add_buddy(purple_buddy_new(acct, who, NULL), NULL, group,
+                               NULL);
+      purple_protocol_got_user_status(acct, who, NULL_STATUS_ONLINE, NULL);
+      g_free(who);
+    }
+  }
+
+  if (load->chat_size > 0) {
+    PurpleChatConversation *chat;
+    GList *users = NULL;
+    GList *flags = NULL;
+
+    load->chat_id = g_str_hash(NULL_LOAD_ROOM);
+    chat = purple_serv_got_joined_chat(gc, load->chat_id, NULL_LOAD_ROOM);
+
+    for (i = load->chat_size - 1; i >= 0; i--) {
+      users = g_list_prepend(users, load_user_name(i));
+      flags = g_list_prepend(flags, GINT_TO_POINTER(PURPLE_CHAT_USER_NONE));
+    }
+
+    if (chat)
+      purple_chat_conversation_add_users(chat, users, NULL, flags, FALSE);
+
+    g_list_free_full(users, g_free);
+    g_list_free(flags);
+  }
+
+  load->timer = purple_timeout_add(NULL_LOAD_TICK, load_tick, load);
+  purple_connection_set_protocol_data(gc, load);
+}
+
+static void null_load_stop(PurpleConnection *gc) {
+  NullLoad *load = purple_connection_get_protocol_data(gc);
+
+  if (!load)
+    return;
+
+  purple_timeout_remove(load->timer);
+  purple_connection_set_protocol_data(gc, NULL);
+  g_free(load);
+}
+
+
 /*
  * UI callbacks
  */
@@ -406,10 +575,15 @@ static void null_login(PurpleAccount *acct)
 
   g_list_free(offline_messages);
   g_hash_table_remove(goffline_messages, purple_account_get_username(acct));
+
+  /* start generating load, if this account asks for it */
+  null_load_start(gc);
 }
 
 static void null_close(PurpleConnection *gc)
 {
+  null_load_stop(gc);
+
   /* notify other nullprotocol accounts */
   foreach_null_gc(report_status_change, gc, NULL);
 }
@@ -1017,6 +1191,23 @@ null_protocol_init(PurpleProtocol *protocol)
 
   protocol->user_splits = g_list_append(NULL, split);
   protocol->account_options = g_list_append(NULL, option);
+
+  /* load generation; see null_load_start() */
+  option = purple_account_option_int_new(_("Load: buddies"),
+                                         "load_buddies", 0);
+  protocol->account_options = g_list_append(protocol->account_options, option);
+  option = purple_account_option_int_new(_("Load: presence changes per second"),
+                                         "load_presence_rate", 0);
+  protocol->account_options = g_list_append(protocol->account_options, option);
+  option = purple_account_option_int_new(_("Load: IMs per second"),
+                                         "load_im_rate", 0);
+  protocol->account_options = g_list_append(protocol->account_options, option);
+  option = purple_account_option_int_new(_("Load: chat room size"),
+                                         "load_chat_size", 0);
+  protocol->account_options = g_list_append(protocol->account_options, option);
+  option = purple_account_option_int_new(_("Load: chat messages per second"),
+                                         "load_chat_rate", 0);
+  protocol->account_options = g_list_append(protocol->account_options, option);
 }
 
 /*
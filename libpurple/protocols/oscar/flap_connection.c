@@ -113,86 +113,53 @@ flap_connection_get_rateclass(FlapConnection *conn, guint16 family, guint16 subt
 	return conn->default_rateclass;
 }
 
-/*
- * Attempt to calculate what our new current average would be if we
- * were to send a SNAC in this rateclass at the given time.
- */
-static guint32
-rateclass_get_new_current(FlapConnection *conn, struct rateclass *rateclass, struct timeval *now)
-{
-	unsigned long timediff; /* In milliseconds */
-	guint32 current;
-
-	/* This formula is documented at http://dev.aol.com/aim/oscar/#RATELIMIT */
-	timediff = (now->tv_sec - rateclass->last.tv_sec) * 1000 + (now->tv_usec - rateclass->last.tv_usec) / 1000;
-	current = ((rateclass->current * (rateclass->windowsize - 1)) + timediff) / rateclass->windowsize;
-
-	return MIN(current, rateclass->max);
-}
+static gboolean flap_connection_send_queued(gpointer data);
 
 /*
- * Attempt to send the contents of a given queue
- *
- * @return TRUE if the queue was completely emptied or was initially
- *         empty; FALSE if rate limiting prevented it from being
- *         emptied.
+ * Make sure the queued SNACs get another look in @a delay
+ * milliseconds.  There's only ever one timer per connection, armed
+ * for whichever rateclass becomes ready first.
  */
-static gboolean flap_connection_send_snac_queue(FlapConnection *conn, struct timeval now, GQueue *queue)
+static void
+flap_connection_schedule_queued(FlapConnection *conn, guint delay)
 {
-	while (!g_queue_is_empty(queue))
-	{
-		QueuedSnac *queued_snac;
-		struct rateclass *rateclass;
-
-		queued_snac = g_queue_peek_head(queue);
+	gint64 wakeup;
 
-		rateclass = flap_connection_get_rateclass(conn, queued_snac->family, queued_snac->subtype);
-		if (rateclass != NULL)
-		{
-			guint32 new_current;
-
-			new_current = rateclass_get_new_current(conn, rateclass, &now);
-
-			if (rateclass->dropping_snacs || new_current <= rateclass->alert)
-				/* Not ready to send this SNAC yet--keep waiting. */
-				return FALSE;
+	wakeup = g_get_monotonic_time() + (gint64)delay * 1000;
 
-			rateclass->current = new_current;
-			rateclass->last.tv_sec = now.tv_sec;
-			rateclass->last.tv_usec = now.tv_usec;
-		}
-
-		flap_connection_send(conn, queued_snac->frame);
-		g_free(queued_snac);
-		g_queue_pop_head(queue);
+	if (conn->queued_timeout != 0)
+	{
+		if (conn->queued_wakeup <= wakeup)
+			return;
+		purple_timeout_remove(conn->queued_timeout);
 	}
 
-	/* We emptied the queue */
-	return TRUE;
+	conn->queued_wakeup = wakeup;
+	conn->queued_timeout = purple_timeout_add(delay, flap_connection_send_queued, conn);
 }
 
 static gboolean flap_connection_send_queued(gpointer data)
 {
 	FlapConnection *conn;
+	QueuedSnac *queued_snac;
 	struct timeval now;
+	guint delay = 0;
 
 	conn = data;
+	conn->queued_timeout = 0;
 	gettimeofday(&now, NULL);
 
-	purple_debug_info("oscar", "Attempting to send %u queued SNACs and %u queued low-priority SNACs for %p\n",
-					  (conn->queued_snacs ? conn->queued_snacs->length : 0),
-					  (conn->queued_lowpriority_snacs ? conn->queued_lowpriority_snacs->length : 0),
-					  conn);
-	if (!conn->queued_snacs || flap_connection_send_snac_queue(conn, now, conn->queued_snacs)) {
-		if (!conn->queued_lowpriority_snacs || flap_connection_send_snac_queue(conn, now, conn->queued_lowpriority_snacs)) {
-			/* Both queues emptied. */
-			conn->queued_timeout = 0;
-			return FALSE;
-		}
+	while ((queued_snac = rateclass_dequeue(&conn->queued_rateclasses, &now, &delay)) != NULL)
+	{
+		flap_connection_send(conn, queued_snac->frame);
+		g_free(queued_snac);
 	}
 
-	/* We couldn't send all our SNACs. Keep trying */
-	return TRUE;
+	/* We couldn't send all our SNACs.  Come back when we can. */
+	if (!g_queue_is_empty(&conn->queued_rateclasses))
+		flap_connection_schedule_queued(conn, delay);
+
+	return FALSE;
 }
 
 /**
@@ -226,54 +193,40 @@ flap_connection_send_snac_with_priority(OscarData *od, FlapConnection *conn, gui
 		byte_stream_putbs(&frame->data, data, length);
 	}
 
-	if (conn->queued_timeout != 0)
-		enqueue = TRUE;
-	else if ((rateclass = flap_connection_get_rateclass(conn, family, subtype)) != NULL)
+	rateclass = flap_connection_get_rateclass(conn, family, subtype);
+	if (rateclass != NULL)
 	{
 		struct timeval now;
-		guint32 new_current;
 
 		gettimeofday(&now, NULL);
-		new_current = rateclass_get_new_current(conn, rateclass, &now);
 
-		if (rateclass->dropping_snacs || new_current <= rateclass->alert)
+		/* SNACs in the same rateclass always go out in order */
+		if (rateclass_is_queued(rateclass))
+			enqueue = TRUE;
+		else if (rateclass_get_delay(rateclass, &now) > 0)
 		{
-			purple_debug_info("oscar", "Current rate for conn %p would be %u, but we alert at %u; enqueueing\n", conn, new_current, rateclass->alert);
+			purple_debug_info("oscar", "Current rate for conn %p would be %u, but we alert at %u; enqueueing\n", conn, rateclass_get_new_current(rateclass, &now), rateclass->alert);
 
 			enqueue = TRUE;
 		}
 		else
+			rateclass_mark_sent(rateclass, &now);
+
+		if (enqueue)
 		{
-			rateclass->current = new_current;
-			rateclass->last.tv_sec = now.tv_sec;
-			rateclass->last.tv_usec = now.tv_usec;
-		}
-	}
+			/* We've been sending too fast, so delay this message */
+			QueuedSnac *queued_snac;
 
-	if (enqueue)
-	{
-		/* We've been sending too fast, so delay this message */
-		QueuedSnac *queued_snac;
+			queued_snac = g_new(QueuedSnac, 1);
+			queued_snac->family = family;
+			queued_snac->subtype = subtype;
+			queued_snac->frame = frame;
 
-		queued_snac = g_new(QueuedSnac, 1);
-		queued_snac->family = family;
-		queued_snac->subtype = subtype;
-		queued_snac->frame = frame;
+			rateclass_enqueue(&conn->queued_rateclasses, rateclass, queued_snac, high_priority);
+			flap_connection_schedule_queued(conn, rateclass_get_delay(rateclass, &now));
 
-		if (high_priority) {
-			if (!conn->queued_snacs)
-				conn->queued_snacs = g_queue_new();
-			g_queue_push_tail(conn->queued_snacs, queued_snac);
-		} else {
-			if (!conn->queued_lowpriority_snacs)
-				conn->queued_lowpriority_snacs = g_queue_new();
-			g_queue_push_tail(conn->queued_lowpriority_snacs, queued_snac);
+			return;
 		}
-
-		if (conn->queued_timeout == 0)
-			conn->queued_timeout = purple_timeout_add(500, flap_connection_send_queued, conn);
-
-		return;
 	}
 
 	flap_connection_send(conn, frame);
@@ -332,6 +285,7 @@ flap_connection_new(OscarData *od, int type)
 
 	conn = g_new0(FlapConnection, 1);
 	conn->od = od;
+	conn->rx_buf = purple_framing_buffer_new(0);
 	conn->buffer_outgoing = purple_circular_buffer_new(0);
 	conn->fd = -1;
 	conn->subtype = -1;
@@ -403,8 +357,8 @@ flap_connection_close(OscarData *od, FlapConnection *conn)
 		conn->gsc = NULL;
 	}
 
-	g_free(conn->buffer_incoming.data.data);
-	conn->buffer_incoming.data.data = NULL;
+	g_object_unref(G_OBJECT(conn->rx_buf));
+	conn->rx_buf = NULL;
 
 	g_object_unref(G_OBJECT(conn->buffer_outgoing));
 	conn->buffer_outgoing = NULL;
@@ -502,34 +456,24 @@ flap_connection_destroy_cb(gpointer data)
 	g_slist_free(conn->groups);
 	while (conn->rateclasses != NULL)
 	{
-		g_free(conn->rateclasses->data);
-		conn->rateclasses = g_slist_delete_link(conn->rateclasses, conn->rateclasses);
-	}
-
-	g_hash_table_destroy(conn->rateclass_members);
+		struct rateclass *rateclass;
+		QueuedSnac *queued_snac;
 
-	if (conn->queued_snacs) {
-		while (!g_queue_is_empty(conn->queued_snacs))
+		rateclass = conn->rateclasses->data;
+		while ((queued_snac = g_queue_pop_head(&rateclass->queued_snacs)) != NULL ||
+				(queued_snac = g_queue_pop_head(&rateclass->queued_lowpriority_snacs)) != NULL)
 		{
-			QueuedSnac *queued_snac;
-			queued_snac = g_queue_pop_head(conn->queued_snacs);
 			flap_frame_destroy(queued_snac->frame);
 			g_free(queued_snac);
 		}
-		g_queue_free(conn->queued_snacs);
-	}
 
-	if (conn->queued_lowpriority_snacs) {
-		while (!g_queue_is_empty(conn->queued_lowpriority_snacs))
-		{
-			QueuedSnac *queued_snac;
-			queued_snac = g_queue_pop_head(conn->queued_lowpriority_snacs);
-			flap_frame_destroy(queued_snac->frame);
-			g_free(queued_snac);
-		}
-		g_queue_free(conn->queued_lowpriority_snacs);
+		g_free(rateclass);
+		conn->rateclasses = g_slist_delete_link(conn->rateclasses, conn->rateclasses);
 	}
 
+	g_hash_table_destroy(conn->rateclass_members);
+	g_queue_clear(&conn->queued_rateclasses);
+
 	if (conn->queued_timeout > 0)
 		purple_timeout_remove(conn->queued_timeout);
 
@@ -881,110 +825,71 @@ flap_connection_recv(FlapConnection *conn)
 	gpointer buf;
 	gsize buflen;
 	gssize read;
+	guint8 *header;
+	guint16 payloadlen;
 
 	/* Read data until we run out of data and break out of the loop */
 	while (TRUE)
 	{
-		/* Start reading a new FLAP */
-		if (conn->buffer_incoming.data.data == NULL)
-		{
-			buf = conn->header + conn->header_received;
-			buflen = 6 - conn->header_received;
-
-			/* Read the first 6 bytes (the FLAP header) */
-			if (conn->gsc)
-				read = purple_ssl_read(conn->gsc, buf, buflen);
-			else
-				read = recv(conn->fd, buf, buflen, 0);
+		buf = purple_framing_buffer_get_input(conn->rx_buf, &buflen);
 
-			/* Check if the FLAP server closed the connection */
-			if (read == 0)
-			{
-				flap_connection_schedule_destroy(conn,
-						OSCAR_DISCONNECT_REMOTE_CLOSED, NULL);
-				break;
-			}
+		if (conn->gsc)
+			read = purple_ssl_read(conn->gsc, buf, buflen);
+		else
+			read = recv(conn->fd, buf, buflen, 0);
 
-			/* If there was an error then close the connection */
-			if (read < 0)
-			{
-				if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
-					/* No worries */
-					break;
+		/* Check if the FLAP server closed the connection */
+		if (read == 0)
+		{
+			flap_connection_schedule_destroy(conn,
+					OSCAR_DISCONNECT_REMOTE_CLOSED, NULL);
+			break;
+		}
 
-				/* Error! */
-				flap_connection_schedule_destroy(conn,
-						OSCAR_DISCONNECT_LOST_CONNECTION, g_strerror(errno));
+		/* If there was an error then close the connection */
+		if (read < 0)
+		{
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+				/* No worries */
 				break;
-			}
-			purple_connection_update_last_received(conn->od->gc);
 
-			/* If we don't even have a complete FLAP header then do nothing */
-			conn->header_received += read;
-			if (conn->header_received < 6)
-				break;
+			/* Error! */
+			flap_connection_schedule_destroy(conn,
+					OSCAR_DISCONNECT_LOST_CONNECTION, g_strerror(errno));
+			break;
+		}
+		purple_connection_update_last_received(conn->od->gc);
+
+		purple_framing_buffer_mark_written(conn->rx_buf, read);
 
+		/* Handle every complete FLAP we have, straight out of the buffer */
+		while ((header = purple_framing_buffer_peek(conn->rx_buf, 6)) != NULL)
+		{
 			/* All FLAP frames must start with the byte 0x2a */
-			if (aimutil_get8(&conn->header[0]) != 0x2a)
+			if (aimutil_get8(&header[0]) != 0x2a)
 			{
 				flap_connection_schedule_destroy(conn,
 						OSCAR_DISCONNECT_INVALID_DATA, NULL);
-				break;
+				return;
 			}
 
-			/* Initialize a new temporary FlapFrame for incoming data */
-			conn->buffer_incoming.channel = aimutil_get8(&conn->header[1]);
-			conn->buffer_incoming.seqnum = aimutil_get16(&conn->header[2]);
-			conn->buffer_incoming.data.len = aimutil_get16(&conn->header[4]);
-			conn->buffer_incoming.data.data = g_new(guint8, conn->buffer_incoming.data.len);
-			conn->buffer_incoming.data.offset = 0;
-		}
-
-		buflen = conn->buffer_incoming.data.len - conn->buffer_incoming.data.offset;
-		if (buflen)
-		{
-			buf = &conn->buffer_incoming.data.data[conn->buffer_incoming.data.offset];
-			/* Read data into the temporary FlapFrame until it is complete */
-			if (conn->gsc)
-				read = purple_ssl_read(conn->gsc, buf, buflen);
-			else
-				read = recv(conn->fd, buf, buflen, 0);
-
-			/* Check if the FLAP server closed the connection */
-			if (read == 0)
-			{
-				flap_connection_schedule_destroy(conn,
-						OSCAR_DISCONNECT_REMOTE_CLOSED, NULL);
+			/* If we don't have the whole FLAP yet then wait for the rest */
+			payloadlen = aimutil_get16(&header[4]);
+			header = purple_framing_buffer_peek(conn->rx_buf, 6 + payloadlen);
+			if (header == NULL)
 				break;
-			}
 
-			if (read < 0)
-			{
-				if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
-					/* No worries */
-					break;
+			conn->buffer_incoming.channel = aimutil_get8(&header[1]);
+			conn->buffer_incoming.seqnum = aimutil_get16(&header[2]);
+			byte_stream_init(&conn->buffer_incoming.data, header + 6, payloadlen);
 
-				/* Error! */
-				flap_connection_schedule_destroy(conn,
-						OSCAR_DISCONNECT_LOST_CONNECTION, g_strerror(errno));
-				break;
-			}
+			/* We have a complete FLAP!  Handle it and continue reading */
+			parse_flap(conn->od, conn, &conn->buffer_incoming);
+			conn->lastactivity = time(NULL);
 
-			conn->buffer_incoming.data.offset += read;
-			if (conn->buffer_incoming.data.offset < conn->buffer_incoming.data.len)
-				/* Waiting for more data to arrive */
-				break;
+			conn->buffer_incoming.data.data = NULL;
+			purple_framing_buffer_mark_read(conn->rx_buf, 6 + payloadlen);
 		}
-
-		/* We have a complete FLAP!  Handle it and continue reading */
-		byte_stream_rewind(&conn->buffer_incoming.data);
-		parse_flap(conn->od, conn, &conn->buffer_incoming);
-		conn->lastactivity = time(NULL);
-
-		g_free(conn->buffer_incoming.data.data);
-		conn->buffer_incoming.data.data = NULL;
-
-		conn->header_received = 0;
 	}
 }
 
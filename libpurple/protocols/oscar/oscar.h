@@ -31,6 +31,7 @@
 
 #include "internal.h"
 #include "circularbuffer.h"
+#include "framingbuffer.h"
 #include "debug.h"
 #include "eventloop.h"
 #include "http.h"
@@ -298,9 +299,8 @@ struct _FlapConnection
 
 	int fd;
 	PurpleSslConnection *gsc;
-	guint8 header[6];
-	gssize header_received;
-	FlapFrame buffer_incoming;
+	PurpleFramingBuffer *rx_buf; /**< Data read from the connection that hasn't been parsed into FLAPs yet. */
+	FlapFrame buffer_incoming; /**< The FLAP being parsed.  Its data points into rx_buf. */
 	PurpleCircularBuffer *buffer_outgoing;
 	guint watcher_incoming;
 	guint watcher_outgoing;
@@ -314,9 +314,9 @@ struct _FlapConnection
 	struct rateclass *default_rateclass;
 	GHashTable *rateclass_members; /* Key is family and subtype, value is pointer to the rateclass struct to use. */
 
-	GQueue *queued_snacs; /**< Contains QueuedSnacs. */
-	GQueue *queued_lowpriority_snacs; /**< Contains QueuedSnacs to send only once queued_snacs is empty */
+	GQueue queued_rateclasses; /**< struct rateclasses with QueuedSnacs waiting, in the order they take turns. */
 	guint queued_timeout;
+	gint64 queued_wakeup; /**< Monotonic time at which queued_timeout fires. */
 
 	void *internal; /* internal conn-specific libfaim data */
 };
@@ -1319,8 +1319,19 @@ struct rateclass {
 	guint8 dropping_snacs;
 
 	struct timeval last; /**< The time when we last sent a SNAC of this rate class. */
+
+	GQueue queued_snacs; /**< Contains QueuedSnacs. */
+	GQueue queued_lowpriority_snacs; /**< Contains QueuedSnacs to send only once queued_snacs is empty */
 };
 
+/* rateclass.c */
+guint32 rateclass_get_new_current(struct rateclass *rateclass, struct timeval *now);
+guint rateclass_get_delay(struct rateclass *rateclass, struct timeval *now);
+void rateclass_mark_sent(struct rateclass *rateclass, struct timeval *now);
+gboolean rateclass_is_queued(struct rateclass *rateclass);
+void rateclass_enqueue(GQueue *pending, struct rateclass *rateclass, gpointer snac, gboolean high_priority);
+gpointer rateclass_dequeue(GQueue *pending, struct timeval *now, guint *delay);
+
 int aim_cachecookie(OscarData *od, IcbmCookie *cookie);
 IcbmCookie *aim_uncachecookie(OscarData *od, guint8 *cookie, int type);
 IcbmCookie *aim_mkcookie(guint8 *, int, void *);
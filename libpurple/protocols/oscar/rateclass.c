@@ -0,0 +1,184 @@
+/*
+ * Purple's oscar protocol plugin
+ * This file is the legal property of its developers.
+ * Please see the AUTHORS file distributed alongside this file.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+*/
+
+/*
+ * Rate class bookkeeping and the per-rate class SNAC queues.
+ *
+ * Every rate class keeps its own queues of SNACs that could not be sent
+ * right away, so a class that is being throttled (usually ICBM) never
+ * holds up SNACs for other classes.  Classes that have something
+ * queued take turns, and we always know exactly how long a class has
+ * to wait, so nobody needs to poll.
+ */
+
+#include "oscar.h"
+
+/*
+ * How long to wait before looking at a class again when we can't work
+ * out when it will be ready: when the server told us it's dropping
+ * SNACs, or its parameters make the alert level unreachable.
+ */
+#define RATECLASS_RETRY 500
+
+static long
+rateclass_get_timediff(struct rateclass *rateclass, struct timeval *now)
+{
+	return (now->tv_sec - rateclass->last.tv_sec) * 1000 + (now->tv_usec - rateclass->last.tv_usec) / 1000;
+}
+
+/*
+ * Attempt to calculate what our new current average would be if we
+ * were to send a SNAC in this rateclass at the given time.
+ */
+guint32
+rateclass_get_new_current(struct rateclass *rateclass, struct timeval *now)
+{
+	unsigned long timediff; /* In milliseconds */
+	guint32 current;
+
+	/* This formula is documented at http://dev.aol.com/aim/oscar/#RATELIMIT */
+	timediff = rateclass_get_timediff(rateclass, now);
+	current = ((rateclass->current * (rateclass->windowsize - 1)) + timediff) / rateclass->windowsize;
+
+	return MIN(current, rateclass->max);
+}
+
+/*
+ * Work out how many milliseconds from now a SNAC in this rateclass can
+ * be sent without pushing our average down to the alert level.  This
+ * is rateclass_get_new_current() solved for the time difference:
+ * the new average stays above alert as long as
+ *
+ *     current * (windowsize - 1) + timediff >= (alert + 1) * windowsize
+ *
+ * @return 0 if a SNAC can be sent right now.
+ */
+guint
+rateclass_get_delay(struct rateclass *rateclass, struct timeval *now)
+{
+	gint64 needed;
+
+	if (rateclass->dropping_snacs || rateclass->max <= rateclass->alert)
+		return RATECLASS_RETRY;
+
+	if (rateclass->windowsize == 0)
+		return 0;
+
+	needed = (gint64)(rateclass->alert + 1) * rateclass->windowsize
+			- (gint64)rateclass->current * (rateclass->windowsize - 1)
+			- rateclass_get_timediff(rateclass, now);
+
+	return needed > 0 ? (guint)needed : 0;
+}
+
+/*
+ * Record that we've sent a SNAC in this rateclass at the given time.
+ */
+void
+rateclass_mark_sent(struct rateclass *rateclass, struct timeval *now)
+{
+	rateclass->current = rateclass_get_new_current(rateclass, now);
+	rateclass->last.tv_sec = now->tv_sec;
+	rateclass->last.tv_usec = now->tv_usec;
+}
+
+/*
+ * @return TRUE if this rateclass has SNACs waiting to be sent.  New
+ *         SNACs for the class must be queued behind them.
+ */
+gboolean
+rateclass_is_queued(struct rateclass *rateclass)
+{
+	return !g_queue_is_empty(&rateclass->queued_snacs) ||
+			!g_queue_is_empty(&rateclass->queued_lowpriority_snacs);
+}
+
+/**
+ * Queue a SNAC until its rateclass allows it to be sent.
+ *
+ * @param pending The connection's queue of rateclasses that have
+ *        SNACs waiting.
+ * @param high_priority If FALSE, the SNAC is only sent once all the
+ *        high priority SNACs for the same rateclass have been sent.
+ */
+void
+rateclass_enqueue(GQueue *pending, struct rateclass *rateclass, gpointer snac, gboolean high_priority)
+{
+	if (!rateclass_is_queued(rateclass))
+		g_queue_push_tail(pending, rateclass);
+
+	if (high_priority)
+		g_queue_push_tail(&rateclass->queued_snacs, snac);
+	else
+		g_queue_push_tail(&rateclass->queued_lowpriority_snacs, snac);
+}
+
+/**
+ * Take the next SNAC that may be sent right now.  The rateclasses in
+ * @a pending take turns, so one class with a long queue can't starve
+ * the others.  The returned SNAC is counted against its rateclass as
+ * if it was sent at @a now.
+ *
+ * @param delay If no SNAC can be sent yet, set to the number of
+ *        milliseconds until one can.
+ *
+ * @return The SNAC to send, or NULL if there is none that may be sent
+ *         yet (or nothing queued at all).
+ */
+gpointer
+rateclass_dequeue(GQueue *pending, struct timeval *now, guint *delay)
+{
+	guint i, length;
+	guint earliest = G_MAXUINT;
+
+	length = g_queue_get_length(pending);
+	for (i = 0; i < length; i++)
+	{
+		struct rateclass *rateclass;
+		gpointer snac;
+		guint wait;
+
+		rateclass = g_queue_pop_head(pending);
+		wait = rateclass_get_delay(rateclass, now);
+		if (wait > 0)
+		{
+			/* Not ready to send this class yet--keep waiting. */
+			earliest = MIN(earliest, wait);
+			g_queue_push_tail(pending, rateclass);
+			continue;
+		}
+
+		snac = g_queue_pop_head(&rateclass->queued_snacs);
+		if (snac == NULL)
+			snac = g_queue_pop_head(&rateclass->queued_lowpriority_snacs);
+		rateclass_mark_sent(rateclass, now);
+
+		/* Go to the back of the line for the next turn */
+		if (rateclass_is_queued(rateclass))
+			g_queue_push_tail(pending, rateclass);
+
+		return snac;
+	}
+
+	if (delay != NULL)
+		*delay = (earliest == G_MAXUINT) ? 0 : earliest;
+
+	return NULL;
+}
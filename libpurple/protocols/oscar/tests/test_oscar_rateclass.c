@@ -0,0 +1,207 @@
+/*
+ * Purple
+ *
+ * Purple is the legal property of its developers, whose names are too
+ * numerous to list here. Please refer to the COPYRIGHT file distributed
+ * with this source distribution
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02111-1301 USA
+ */
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "../oscar.h"
+
+#define ICBM_BURST 30
+#define ICBM_LOWPRIORITY 5
+#define FEEDBAG_BURST 10
+#define FEEDBAG_AT 20000 /* ms into the ICBM burst */
+
+typedef struct {
+	struct rateclass *rateclass;
+	gboolean high_priority;
+	guint queued_at;
+	guint sent_at;
+} TestSnac;
+
+static void
+test_oscar_rateclass_set_time(struct timeval *now, guint ms) {
+	now->tv_sec = 1000 + ms / 1000;
+	now->tv_usec = (ms % 1000) * 1000;
+}
+
+/* Parameters shaped like the ones the AIM servers hand out */
+static void
+test_oscar_rateclass_init(struct rateclass *rateclass, guint16 classid,
+                          guint32 windowsize, guint32 alert, guint32 limit)
+{
+	memset(rateclass, 0, sizeof(struct rateclass));
+	rateclass->classid = classid;
+	rateclass->windowsize = windowsize;
+	rateclass->clear = alert + 100;
+	rateclass->alert = alert;
+	rateclass->limit = limit;
+	rateclass->disconnect = limit - 1000;
+	rateclass->current = 6000;
+	rateclass->max = 6000;
+	test_oscar_rateclass_set_time(&rateclass->last, 0);
+}
+
+static void
+test_oscar_rateclass_enqueue(GQueue *pending, TestSnac *snacs, guint count,
+                             struct rateclass *rateclass,
+                             gboolean high_priority, guint now)
+{
+	guint i;
+
+	for(i = 0; i < count; i++) {
+		snacs[i].rateclass = rateclass;
+		snacs[i].high_priority = high_priority;
+		snacs[i].queued_at = now;
+		snacs[i].sent_at = 0;
+		rateclass_enqueue(pending, rateclass, &snacs[i], high_priority);
+	}
+}
+
+/*
+ * Queue a burst of IMs, and some buddy list edits while the IMs are
+ * being throttled.  A simulated server keeps its own view of each
+ * rateclass and checks that we never push it down to the alert level.
+ */
+static void
+test_oscar_rateclass_burst(void) {
+	struct rateclass icbm, feedbag, server_icbm, server_feedbag;
+	TestSnac icbms[ICBM_BURST], lowpriority[ICBM_LOWPRIORITY];
+	TestSnac feedbags[FEEDBAG_BURST];
+	GQueue pending = G_QUEUE_INIT;
+	struct timeval now;
+	guint total = ICBM_BURST + ICBM_LOWPRIORITY + FEEDBAG_BURST;
+	guint sent = 0, now_ms = 0, last_icbm = 0;
+	guint icbm_latency = 0, feedbag_latency = 0;
+	gboolean feedbag_queued = FALSE;
+
+	test_oscar_rateclass_init(&icbm, 3, 20, 5000, 4000);
+	test_oscar_rateclass_init(&feedbag, 2, 10, 2000, 1500);
+	server_icbm = icbm;
+	server_feedbag = feedbag;
+
+	test_oscar_rateclass_enqueue(&pending, lowpriority, ICBM_LOWPRIORITY,
+	                             &icbm, FALSE, 0);
+	test_oscar_rateclass_enqueue(&pending, icbms, ICBM_BURST,
+	                             &icbm, TRUE, 0);
+
+	while(sent < total) {
+		TestSnac *snac;
+		struct rateclass *server;
+		guint delay = 0;
+
+		test_oscar_rateclass_set_time(&now, now_ms);
+		snac = rateclass_dequeue(&pending, &now, &delay);
+
+		if(snac != NULL) {
+			server = (snac->rateclass == &icbm) ? &server_icbm : &server_feedbag;
+			g_assert_cmpuint(rateclass_get_new_current(server, &now), >,
+			                 server->alert);
+			rateclass_mark_sent(server, &now);
+
+			snac->sent_at = now_ms;
+			if(snac->rateclass == &icbm) {
+				/* Low priority SNACs wait for every high priority one */
+				if(snac->high_priority)
+					last_icbm = now_ms;
+				else
+					g_assert_cmpuint(icbms[ICBM_BURST - 1].sent_at, >, 0);
+				icbm_latency = MAX(icbm_latency, now_ms - snac->queued_at);
+			} else {
+				feedbag_latency = MAX(feedbag_latency, now_ms - snac->queued_at);
+			}
+
+			sent++;
+			continue;
+		}
+
+		g_assert_cmpuint(delay, >, 0);
+
+		if(!feedbag_queued && now_ms + delay > FEEDBAG_AT) {
+			now_ms = FEEDBAG_AT;
+			test_oscar_rateclass_enqueue(&pending, feedbags, FEEDBAG_BURST,
+			                             &feedbag, TRUE, now_ms);
+			feedbag_queued = TRUE;
+			continue;
+		}
+
+		/* The delay is exact: nothing can go out a millisecond early */
+		now_ms += delay - 1;
+		test_oscar_rateclass_set_time(&now, now_ms);
+		g_assert(rateclass_dequeue(&pending, &now, &delay) == NULL);
+		g_assert_cmpuint(delay, ==, 1);
+		now_ms++;
+	}
+
+	g_assert(g_queue_is_empty(&pending));
+	g_assert(feedbag_queued);
+
+	/* The IM burst must not hold up an unrelated rateclass */
+	g_assert_cmpuint(feedbag_latency, ==, 0);
+
+	g_test_message("%u IMs took %u ms to drain", ICBM_BURST + ICBM_LOWPRIORITY,
+	               icbm_latency);
+	g_test_message("buddy list edits queued %u ms into the burst waited "
+	               "%u ms (%u ms behind a single FIFO)", FEEDBAG_AT,
+	               feedbag_latency, last_icbm - FEEDBAG_AT);
+	g_test_minimized_result(icbm_latency / 1000.0,
+	                        "IM burst drained in %f seconds",
+	                        icbm_latency / 1000.0);
+}
+
+static void
+test_oscar_rateclass_delay(void) {
+	struct rateclass rateclass;
+	struct timeval now;
+	guint delay;
+
+	test_oscar_rateclass_init(&rateclass, 1, 20, 5000, 4000);
+	test_oscar_rateclass_set_time(&now, 0);
+	g_assert_cmpuint(0, ==, rateclass_get_delay(&rateclass, &now));
+
+	/* Right at the alert level: wait until the average climbs above it */
+	rateclass.current = 5000;
+	delay = rateclass_get_delay(&rateclass, &now);
+	g_assert_cmpuint(delay, >, 0);
+
+	test_oscar_rateclass_set_time(&now, delay - 1);
+	g_assert_cmpuint(rateclass_get_new_current(&rateclass, &now), <=, 5000);
+	test_oscar_rateclass_set_time(&now, delay);
+	g_assert_cmpuint(rateclass_get_new_current(&rateclass, &now), >, 5000);
+	g_assert_cmpuint(0, ==, rateclass_get_delay(&rateclass, &now));
+
+	/* Nothing goes out while the server says it's dropping SNACs */
+	rateclass.dropping_snacs = 1;
+	g_assert_cmpuint(0, <, rateclass_get_delay(&rateclass, &now));
+}
+
+gint
+main(gint argc, gchar **argv) {
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/oscar/rateclass/delay",
+	                test_oscar_rateclass_delay);
+	g_test_add_func("/oscar/rateclass/burst",
+	                test_oscar_rateclass_burst);
+
+	return g_test_run();
+}
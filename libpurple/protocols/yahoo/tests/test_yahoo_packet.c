@@ -0,0 +1,171 @@
+/*
+ * Purple is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ */
+#include <glib.h>
+#include <string.h>
+
+#include "../ymsg.h"
+#include "../yahoo_packet.h"
+
+#define D "\xc0\x80"
+
+static struct yahoo_packet *
+read_packet(const gchar *body, gsize len, guchar **buf)
+{
+	struct yahoo_packet *pkt = yahoo_packet_new(0, 0, 0);
+
+	*buf = g_memdup(body, len);
+	yahoo_packet_read(pkt, *buf, len);
+
+	return pkt;
+}
+
+static void
+test_packet_read(void) {
+	struct yahoo_packet *pkt;
+	struct yahoo_pair *pair;
+	guchar *buf;
+	GSList *l;
+	const int keys[] = { 1, 7, 7, 14 };
+	const gchar *values[] = { "me", "alice", "bob", "hello" };
+	const gchar body[] = "1" D "me" D "7" D "alice" D "7" D "bob" D
+	                     "14" D "hello" D;
+	guint i = 0;
+
+	pkt = read_packet(body, sizeof(body) - 1, &buf);
+
+	/* pkt->hash lists every pair in the order it was received. */
+	for (l = pkt->hash; l; l = l->next, i++) {
+		pair = l->data;
+		g_assert_cmpuint(i, <, G_N_ELEMENTS(keys));
+		g_assert_cmpint(pair->key, ==, keys[i]);
+		g_assert_cmpstr(pair->value, ==, values[i]);
+
+		/* The values are not copies. */
+		g_assert((guchar *)pair->value > buf);
+		g_assert((guchar *)pair->value < buf + sizeof(body) - 1);
+	}
+	g_assert_cmpuint(i, ==, G_N_ELEMENTS(keys));
+
+	yahoo_packet_free(pkt);
+	g_free(buf);
+}
+
+static void
+test_packet_lookup(void) {
+	struct yahoo_packet *pkt;
+	struct yahoo_pair *pair;
+	guchar *buf;
+	const gchar body[] = "1" D "me" D "7" D "alice" D "7" D "bob" D
+	                     "14" D "hello" D "7" D "carol" D;
+
+	pkt = read_packet(body, sizeof(body) - 1, &buf);
+
+	g_assert_cmpstr(yahoo_packet_get_first(pkt, 1), ==, "me");
+	g_assert_cmpstr(yahoo_packet_get_last(pkt, 1), ==, "me");
+	g_assert_cmpstr(yahoo_packet_get_first(pkt, 7), ==, "alice");
+	g_assert_cmpstr(yahoo_packet_get_last(pkt, 7), ==, "carol");
+	g_assert(yahoo_packet_get_first(pkt, 5) == NULL);
+	g_assert(yahoo_packet_get_last(pkt, 5) == NULL);
+
+	pair = yahoo_packet_find(pkt, 7);
+	g_assert_cmpstr(pair->value, ==, "alice");
+	pair = yahoo_packet_find_next(pkt, pair);
+	g_assert_cmpstr(pair->value, ==, "bob");
+	pair = yahoo_packet_find_next(pkt, pair);
+	g_assert_cmpstr(pair->value, ==, "carol");
+	g_assert(yahoo_packet_find_next(pkt, pair) == NULL);
+
+	yahoo_packet_free(pkt);
+	g_free(buf);
+}
+
+static void
+test_packet_lookup_unindexed(void) {
+	struct yahoo_packet *pkt = yahoo_packet_new(0, 0, 0);
+	struct yahoo_pair *pair;
+
+	yahoo_packet_hash(pkt, "ssi", 7, "alice", 1, "me", 7, 42);
+
+	pair = yahoo_packet_find(pkt, 1);
+	g_assert_cmpstr(pair->value, ==, "me");
+	g_assert(yahoo_packet_find_next(pkt, pair) == NULL);
+	g_assert_cmpstr(yahoo_packet_get_first(pkt, 1), ==, "me");
+	g_assert(yahoo_packet_get_last(pkt, 3) == NULL);
+
+	/* Repeated keys are found in the order they were added, as they are
+	 * in a packet that was read. */
+	pair = yahoo_packet_find(pkt, 7);
+	g_assert_cmpstr(pair->value, ==, "alice");
+	pair = yahoo_packet_find_next(pkt, pair);
+	g_assert_cmpstr(pair->value, ==, "42");
+	g_assert(yahoo_packet_find_next(pkt, pair) == NULL);
+	g_assert_cmpstr(yahoo_packet_get_first(pkt, 7), ==, "alice");
+	g_assert_cmpstr(yahoo_packet_get_last(pkt, 7), ==, "42");
+
+	yahoo_packet_free(pkt);
+}
+
+static void
+test_packet_read_malformed(void) {
+	struct yahoo_packet *pkt;
+	struct yahoo_pair *pair;
+	guchar *buf;
+	const gchar truncated[] = "1" D "me" D "14" D "truncated";
+	const gchar terminated[] = "1" D "me" D "\0" "2" D "junk" D;
+
+	/* A value that isn't terminated is dropped. */
+	pkt = read_packet(truncated, sizeof(truncated) - 1, &buf);
+	g_assert_cmpuint(g_slist_length(pkt->hash), ==, 1);
+	g_assert_cmpstr(yahoo_packet_get_first(pkt, 1), ==, "me");
+	g_assert(yahoo_packet_get_first(pkt, 14) == NULL);
+	yahoo_packet_free(pkt);
+	g_free(buf);
+
+	/* Nothing after a null terminator is parsed. */
+	pkt = read_packet(terminated, sizeof(terminated) - 1, &buf);
+	g_assert_cmpuint(g_slist_length(pkt->hash), ==, 1);
+	pair = pkt->hash->data;
+	g_assert_cmpint(pair->key, ==, 1);
+	yahoo_packet_free(pkt);
+	g_free(buf);
+
+	/* No pairs at all. */
+	pkt = read_packet("garbage", 7, &buf);
+	g_assert(pkt->hash == NULL);
+	g_assert(yahoo_packet_get_first(pkt, 1) == NULL);
+	yahoo_packet_free(pkt);
+	g_free(buf);
+}
+
+gint
+main(gint argc, gchar **argv) {
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/yahoo/packet/read",
+	                test_packet_read);
+	g_test_add_func("/yahoo/packet/lookup",
+	                test_packet_lookup);
+	g_test_add_func("/yahoo/packet/lookup unindexed",
+	                test_packet_lookup_unindexed);
+	g_test_add_func("/yahoo/packet/read malformed",
+	                test_packet_read_malformed);
+
+	return g_test_run();
+}
@@ -110,6 +110,93 @@ size_t yahoo_packet_length(struct yahoo_packet *pkt)
 	return len;
 }
 
+/*
+ * A packet that was read from the network keeps all of its pairs in one
+ * allocation: the pairs themselves, the GSList links that pkt->hash is made
+ * of, a small open-addressed table mapping each key to the first and last
+ * pair with that key, and a chain from every pair to the next one with the
+ * same key.  Pair numbers are stored plus one, so that 0 means none.
+ */
+struct yahoo_key_slot {
+	int key;
+	guint first;
+	guint last;
+};
+
+struct yahoo_packet_index {
+	guint count;
+	guint mask;
+	struct yahoo_pair *pairs;
+	GSList *links;
+	struct yahoo_key_slot *slots;
+	guint *next;
+};
+
+static struct yahoo_packet_index *
+yahoo_packet_index_new(guint max_pairs)
+{
+	struct yahoo_packet_index *index;
+	guint slots = 8;
+	guchar *p;
+
+	while (slots < max_pairs * 2)
+		slots <<= 1;
+
+	p = g_malloc0(sizeof(struct yahoo_packet_index) +
+	              max_pairs * sizeof(struct yahoo_pair) +
+	              max_pairs * sizeof(GSList) +
+	              slots * sizeof(struct yahoo_key_slot) +
+	              max_pairs * sizeof(guint));
+
+	index = (struct yahoo_packet_index *)p;
+	p += sizeof(struct yahoo_packet_index);
+	index->pairs = (struct yahoo_pair *)p;
+	p += max_pairs * sizeof(struct yahoo_pair);
+	index->links = (GSList *)p;
+	p += max_pairs * sizeof(GSList);
+	index->slots = (struct yahoo_key_slot *)p;
+	p += slots * sizeof(struct yahoo_key_slot);
+	index->next = (guint *)p;
+	index->mask = slots - 1;
+
+	return index;
+}
+
+static struct yahoo_key_slot *
+yahoo_packet_index_slot(struct yahoo_packet_index *index, int key)
+{
+	guint i = (guint)key & index->mask;
+
+	/* There are always at least twice as many slots as pairs, so this
+	 * finds either the key or an empty slot. */
+	while (index->slots[i].first && index->slots[i].key != key)
+		i = (i + 1) & index->mask;
+
+	return &index->slots[i];
+}
+
+static void
+yahoo_packet_index_add(struct yahoo_packet_index *index, int key, char *value)
+{
+	struct yahoo_key_slot *slot;
+	guint n = index->count++;
+
+	index->pairs[n].key = key;
+	index->pairs[n].value = value;
+	index->links[n].data = &index->pairs[n];
+	if (n > 0)
+		index->links[n - 1].next = &index->links[n];
+
+	slot = yahoo_packet_index_slot(index, key);
+	if (slot->first) {
+		index->next[slot->last - 1] = n + 1;
+	} else {
+		slot->key = key;
+		slot->first = n + 1;
+	}
+	slot->last = n + 1;
+}
+
 /*
  * 'len' is the value given to us by the server that is supposed to
  * be the length of 'data'.  But apparently there's a time when this
@@ -132,23 +219,41 @@ size_t yahoo_packet_length(struct yahoo_packet *pkt)
  * What does all this mean?  It means that we parse through the data
  * pulling out key/value pairs until we've parsed 'len' bytes, or until
  * we run into a null terminator, whichever comes first.
+ *
+ * The values aren't copied.  The first byte of the 0xc0 0x80 after each
+ * value is overwritten with a null terminator and the pair points at the
+ * value where it is, so 'data' must outlive the packet.
  */
-void yahoo_packet_read(struct yahoo_packet *pkt, const guchar *data, int len)
+void yahoo_packet_read(struct yahoo_packet *pkt, guchar *data, int len)
 {
 	int pos = 0;
 	char key[64];
 	const guchar *delimiter;
 	gboolean accept;
 	guint x;
-	struct yahoo_pair *pair;
+	guint delimiters = 0;
+	int k;
+
+	/* Every pair ends its key and its value with a delimiter, so this
+	 * is an upper bound on the number of pairs. */
+	for (pos = 0; pos + 1 < len; pos++) {
+		if (data[pos] == 0xc0 && data[pos + 1] == 0x80) {
+			delimiters++;
+			pos++;
+		}
+	}
+
+	if (delimiters < 2)
+		return;
+
+	pkt->index = yahoo_packet_index_new(delimiters / 2);
+	pos = 0;
 
 	while (pos + 1 < len)
 	{
 		if (data[pos] == '\0')
 			break;
 
-		pair = g_new0(struct yahoo_pair, 1);
-
 		x = 0;
 		while (pos + 1 < len) {
 			if (data[pos] == 0xc0 && data[pos + 1] == 0x80)
@@ -165,7 +270,7 @@ void yahoo_packet_read(struct yahoo_packet *pkt, const guchar *data, int len)
 		}
 		key[x] = 0;
 		pos += 2;
-		pair->key = strtol(key, NULL, 10);
+		k = strtol(key, NULL, 10);
 		accept = x; /* if x is 0 there was no key, so don't accept it */
 
 		if (pos + 1 > len) {
@@ -174,27 +279,27 @@ void yahoo_packet_read(struct yahoo_packet *pkt, const guchar *data, int len)
 		}
 
 		if (accept) {
+			char *value;
+
 			delimiter = (const guchar *)g_strstr_len((const char *)&data[pos], len - pos, "\xc0\x80");
 			if (delimiter == NULL)
 			{
 				/* Malformed packet! (It doesn't end in 0xc0 0x80) */
-				g_free(pair);
 				pos = len;
 				continue;
 			}
 			x = delimiter - data;
-			pair->value = g_strndup((const gchar *)&data[pos], x - pos);
+			data[x] = '\0';
+			value = (char *)&data[pos];
+			yahoo_packet_index_add(pkt->index, k, value);
 			pos = x;
-			pkt->hash = g_slist_prepend(pkt->hash, pair);
 
 			if (purple_debug_is_verbose() || g_getenv("PURPLE_YAHOO_DEBUG")) {
 				char *esc;
-				esc = g_strescape(pair->value, NULL);
-				purple_debug_misc("yahoo", "Key: %d  \tValue: %s\n", pair->key, esc);
+				esc = g_strescape(value, NULL);
+				purple_debug_misc("yahoo", "Key: %d  \tValue: %s\n", k, esc);
 				g_free(esc);
 			}
-		} else {
-			g_free(pair);
 		}
 		pos += 2;
 
@@ -205,15 +310,77 @@ void yahoo_packet_read(struct yahoo_packet *pkt, const guchar *data, int len)
 			pos++;
 	}
 
-	/*
-	 * Originally this function used g_slist_append().  I changed
-	 * it to use g_slist_prepend() for improved performance.
-	 * Ideally the Yahoo! protocol code would be indifferent to the
-	 * order of the key/value pairs, but I don't know if this is
-	 * the case for all incoming messages.  To be on the safe side
-	 * we reverse the list.
-	 */
-	pkt->hash = g_slist_reverse(pkt->hash);
+	/* The links are chained in the order the pairs were received. */
+	if (pkt->index->count > 0)
+		pkt->hash = pkt->index->links;
+}
+
+struct yahoo_pair *yahoo_packet_find(struct yahoo_packet *pkt, int key)
+{
+	struct yahoo_pair *found = NULL;
+	GSList *l;
+
+	if (pkt->index) {
+		struct yahoo_key_slot *slot = yahoo_packet_index_slot(pkt->index, key);
+		return slot->first ? &pkt->index->pairs[slot->first - 1] : NULL;
+	}
+
+	/* Packets we are building aren't indexed, and their pairs are kept
+	 * newest first, so the first pair added is the last one listed. */
+	for (l = pkt->hash; l; l = l->next) {
+		struct yahoo_pair *pair = l->data;
+		if (pair->key == key)
+			found = pair;
+	}
+
+	return found;
+}
+
+struct yahoo_pair *yahoo_packet_find_next(struct yahoo_packet *pkt, struct yahoo_pair *pair)
+{
+	struct yahoo_pair *found = NULL;
+	GSList *l;
+
+	g_return_val_if_fail(pair != NULL, NULL);
+
+	if (pkt->index) {
+		guint next = pkt->index->next[pair - pkt->index->pairs];
+		return next ? &pkt->index->pairs[next - 1] : NULL;
+	}
+
+	/* The pair added after this one is listed before it. */
+	for (l = pkt->hash; l && l->data != pair; l = l->next) {
+		struct yahoo_pair *other = l->data;
+		if (other->key == pair->key)
+			found = other;
+	}
+
+	return l ? found : NULL;
+}
+
+const char *yahoo_packet_get_first(struct yahoo_packet *pkt, int key)
+{
+	struct yahoo_pair *pair = yahoo_packet_find(pkt, key);
+
+	return pair ? pair->value : NULL;
+}
+
+const char *yahoo_packet_get_last(struct yahoo_packet *pkt, int key)
+{
+	GSList *l;
+
+	if (pkt->index) {
+		struct yahoo_key_slot *slot = yahoo_packet_index_slot(pkt->index, key);
+		return slot->first ? pkt->index->pairs[slot->last - 1].value : NULL;
+	}
+
+	for (l = pkt->hash; l; l = l->next) {
+		struct yahoo_pair *pair = l->data;
+		if (pair->key == key)
+			return pair->value;
+	}
+
+	return NULL;
 }
 
 void yahoo_packet_write(struct yahoo_packet *pkt, guchar *data)
@@ -221,8 +388,8 @@ void yahoo_packet_write(struct yahoo_packet *pkt, guchar *data)
 	GSList *l;
 	int pos = 0;
 
-	/* This is only called from one place, and the list is
-	 * always backwards */
+	/* The list is newest first.  It's put back that way afterwards,
+	 * which yahoo_packet_find() relies on. */
 
 	l = pkt->hash = g_slist_reverse(pkt->hash);
 
@@ -243,6 +410,8 @@ void yahoo_packet_write(struct yahoo_packet *pkt, guchar *data)
 
 		l = l->next;
 	}
+
+	pkt->hash = g_slist_reverse(pkt->hash);
 }
 
 void yahoo_packet_dump(guchar *data, int len)
@@ -393,6 +562,14 @@ int yahoo_packet_send_and_free(struct yahoo_packet *pkt, YahooData *yd)
 
 void yahoo_packet_free(struct yahoo_packet *pkt)
 {
+	if (pkt->index) {
+		/* The pairs and their links live in the index and the values
+		 * belong to the buffer the packet was read from. */
+		g_free(pkt->index);
+		g_free(pkt);
+		return;
+	}
+
 	while (pkt->hash) {
 		struct yahoo_pair *pair = pkt->hash->data;
 		g_free(pair->value);
@@ -119,11 +119,22 @@ struct yahoo_pair {
 	char *value;
 };
 
+struct yahoo_packet_index;
+
+/*
+ * Packets read with yahoo_packet_read() don't own their values: each
+ * pair->value points into the buffer the packet was read from, so that
+ * buffer has to stay around until the packet is freed.  Such packets also
+ * carry an index, so looking a key up with yahoo_packet_get_first() and
+ * friends doesn't walk the whole list.  pkt->hash still lists every pair in
+ * the order it was received, but it must not be modified.
+ */
 struct yahoo_packet {
 	guint16 service;
 	gint32 status;
 	guint32 id;
 	GSList *hash;
+	struct yahoo_packet_index *index;
 };
 
 #define YAHOO_WEBMESSENGER_PROTO_VER 0x0065
@@ -139,10 +150,26 @@ void yahoo_packet_hash_int(struct yahoo_packet *pkt, int key, int value);
 int yahoo_packet_send(struct yahoo_packet *pkt, YahooData *yd);
 int yahoo_packet_send_and_free(struct yahoo_packet *pkt, YahooData *yd);
 size_t yahoo_packet_build(struct yahoo_packet *pkt, int pad, gboolean wm, guchar **buf);
-void yahoo_packet_read(struct yahoo_packet *pkt, const guchar *data, int len);
+void yahoo_packet_read(struct yahoo_packet *pkt, guchar *data, int len);
 void yahoo_packet_write(struct yahoo_packet *pkt, guchar *data);
 void yahoo_packet_dump(guchar *data, int len);
 size_t yahoo_packet_length(struct yahoo_packet *pkt);
 void yahoo_packet_free(struct yahoo_packet *pkt);
 
+/*
+ * Returns the pair with the given key that came first in the packet, or was
+ * added first to a packet being built, or NULL.  yahoo_packet_find_next() returns the following pair with the same
+ * key, so every value of a repeated key can be visited in order.
+ */
+struct yahoo_pair *yahoo_packet_find(struct yahoo_packet *pkt, int key);
+struct yahoo_pair *yahoo_packet_find_next(struct yahoo_packet *pkt, struct yahoo_pair *pair);
+
+/*
+ * Returns the first or the last value sent for the given key, or NULL if
+ * the packet doesn't have it.  Most handlers used to loop over pkt->hash
+ * and keep overwriting their copy, which is yahoo_packet_get_last().
+ */
+const char *yahoo_packet_get_first(struct yahoo_packet *pkt, int key);
+const char *yahoo_packet_get_last(struct yahoo_packet *pkt, int key);
+
 #endif /* _YAHOO_PACKET_H_ */
@@ -464,15 +464,13 @@ void yahoo_process_chat_online(PurpleConnection *gc, struct yahoo_packet *pkt)
 void yahoo_process_chat_logout(PurpleConnection *gc, struct yahoo_packet *pkt)
 {
 	YahooData *yd = purple_connection_get_protocol_data(gc);
-	GSList *l;
+	struct yahoo_pair *pair;
 
-	for (l = pkt->hash; l; l = l->next) {
-		struct yahoo_pair *pair = l->data;
-
-		if (pair->key == 1)
-			if (g_ascii_strcasecmp(pair->value,
-					purple_connection_get_display_name(gc)))
-				return;
+	for (pair = yahoo_packet_find(pkt, 1); pair;
+			pair = yahoo_packet_find_next(pkt, pair)) {
+		if (g_ascii_strcasecmp(pair->value,
+				purple_connection_get_display_name(gc)))
+			return;
 	}
 
 	if (pkt->status == 1) {
@@ -654,24 +652,18 @@ void yahoo_process_chat_join(PurpleConnection *gc, struct yahoo_packet *pkt)
 
 void yahoo_process_chat_exit(PurpleConnection *gc, struct yahoo_packet *pkt)
 {
-	char *who = NULL;
+	const char *who;
+	const char *value;
 	char *room = NULL;
-	GSList *l;
 
-	for (l = pkt->hash; l; l = l->next) {
-		struct yahoo_pair *pair = l->data;
+	if ((value = yahoo_packet_get_last(pkt, 104)))
+		room = yahoo_string_decode(gc, value, TRUE);
 
-		if (pair->key == 104) {
-			g_free(room);
-			room = yahoo_string_decode(gc, pair->value, TRUE);
-		} else if (pair->key == 109) {
-			if (g_utf8_validate(pair->value, -1, NULL)) {
-				who = pair->value;
-			} else {
-				purple_debug_warning("yahoo", "yahoo_process_chat_exit "
-						"got non-UTF-8 string for key %d\n", pair->key);
-			}
-		}
+	who = yahoo_packet_get_last(pkt, 109);
+	if (who && !g_utf8_validate(who, -1, NULL)) {
+		purple_debug_warning("yahoo", "yahoo_process_chat_exit "
+				"got non-UTF-8 string for key %d\n", 109);
+		who = NULL;
 	}
 
 	if (who && room) {
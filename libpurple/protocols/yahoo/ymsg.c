@@ -1097,34 +1097,30 @@ static void yahoo_process_message(PurpleConnection *gc, struct yahoo_packet *pkt
 	g_slist_free(list);
 }
 
-static void yahoo_process_sysmessage(PurpleConnection *gc, struct yahoo_packet *pkt)
+/* Returns the last value for key, or NULL if it isn't valid UTF-8. */
+static const char *
+yahoo_packet_get_utf8(struct yahoo_packet *pkt, int key, const char *handler)
 {
-	GSList *l = pkt->hash;
-	char *prim, *me = NULL, *msg = NULL;
+	const char *value = yahoo_packet_get_last(pkt, key);
 
-	while (l) {
-		struct yahoo_pair *pair = l->data;
+	if (value && !g_utf8_validate(value, -1, NULL)) {
+		purple_debug_warning("yahoo", "%s got non-UTF-8 string for key %d\n",
+				handler, key);
+		return NULL;
+	}
 
-		if (pair->key == 5) {
-			if (g_utf8_validate(pair->value, -1, NULL)) {
-				me = pair->value;
-			} else {
-				purple_debug_warning("yahoo", "yahoo_process_sysmessage "
-						"got non-UTF-8 string for key %d\n", pair->key);
-			}
-		} else if (pair->key == 14) {
-			if (g_utf8_validate(pair->value, -1, NULL)) {
-				msg = pair->value;
-			} else {
-				purple_debug_warning("yahoo", "yahoo_process_sysmessage "
-						"got non-UTF-8 string for key %d\n", pair->key);
-			}
-		}
+	return value;
+}
 
-		l = l->next;
-	}
+static void yahoo_process_sysmessage(PurpleConnection *gc, struct yahoo_packet *pkt)
+{
+	char *prim;
+	const char *me, *msg;
+
+	me = yahoo_packet_get_utf8(pkt, 5, "yahoo_process_sysmessage");
+	msg = yahoo_packet_get_utf8(pkt, 14, "yahoo_process_sysmessage");
 
-	if (!msg || !g_utf8_validate(msg, -1, NULL))
+	if (!msg)
 		return;
 
 	prim = g_strdup_printf(_("Yahoo! system message for %s:"),
@@ -1522,44 +1518,21 @@ static char *yahoo_decode(const char *text)
 static void yahoo_process_mail(PurpleConnection *gc, struct yahoo_packet *pkt)
 {
 	PurpleAccount *account = purple_connection_get_account(gc);
-	const char *who = NULL;
-	const char *email = NULL;
-	const char *subj = NULL;
+	const char *who;
+	const char *email;
+	const char *subj;
 	const char *yahoo_mail_url = YAHOO_MAIL_URL;
+	const char *value;
 	int count = 0;
-	GSList *l = pkt->hash;
 
 	if (!purple_account_get_check_mail(account))
 		return;
 
-	while (l) {
-		struct yahoo_pair *pair = l->data;
-		if (pair->key == 9) {
-			count = strtol(pair->value, NULL, 10);
-		} else if (pair->key == 43) {
-			if (g_utf8_validate(pair->value, -1, NULL)) {
-				who = pair->value;
-			} else {
-				purple_debug_warning("yahoo", "yahoo_process_mail "
-						"got non-UTF-8 string for key %d\n", pair->key);
-			}
-		} else if (pair->key == 42) {
-			if (g_utf8_validate(pair->value, -1, NULL)) {
-				email = pair->value;
-			} else {
-				purple_debug_warning("yahoo", "yahoo_process_mail "
-						"got non-UTF-8 string for key %d\n", pair->key);
-			}
-		} else if (pair->key == 18) {
-			if (g_utf8_validate(pair->value, -1, NULL)) {
-				subj = pair->value;
-			} else {
-				purple_debug_warning("yahoo", "yahoo_process_mail "
-						"got non-UTF-8 string for key %d\n", pair->key);
-			}
-		}
-		l = l->next;
-	}
+	if ((value = yahoo_packet_get_last(pkt, 9)))
+		count = strtol(value, NULL, 10);
+	who = yahoo_packet_get_utf8(pkt, 43, "yahoo_process_mail");
+	email = yahoo_packet_get_utf8(pkt, 42, "yahoo_process_mail");
+	subj = yahoo_packet_get_utf8(pkt, 18, "yahoo_process_mail");
 
 	if (who && subj && email && *email) {
 		char *dec_who = yahoo_decode(who);
@@ -1927,26 +1900,15 @@ static void yahoo_auth16_stage1(PurpleConnection *gc, const char *seed)
 
 static void yahoo_process_auth(PurpleConnection *gc, struct yahoo_packet *pkt)
 {
-	char *seed = NULL;
-	GSList *l = pkt->hash;
+	const char *seed;
+	const char *value;
 	int m = 0;
 	gchar *buf;
 
-	while (l) {
-		struct yahoo_pair *pair = l->data;
-		/* (pair->key == 1) -> sn */
-		if (pair->key == 94) {
-			if (g_utf8_validate(pair->value, -1, NULL)) {
-				seed = pair->value;
-			} else {
-				purple_debug_warning("yahoo", "yahoo_process_auth "
-						"got non-UTF-8 string for key %d\n", pair->key);
-			}
-		} else if (pair->key == 13) {
-			m = atoi(pair->value);
-		}
-		l = l->next;
-	}
+	/* (pair->key == 1) -> sn */
+	seed = yahoo_packet_get_utf8(pkt, 94, "yahoo_process_auth");
+	if ((value = yahoo_packet_get_last(pkt, 13)))
+		m = atoi(value);
 
 	if (seed) {
 		switch (m) {
@@ -2103,30 +2065,17 @@ yahoo_try_webmessenger_login(PurpleConnection *gc)
 
 static void yahoo_process_authresp(PurpleConnection *gc, struct yahoo_packet *pkt)
 {
-	GSList *l = pkt->hash;
 	int err = 0;
 	char *msg;
-	char *url = NULL;
+	const char *url;
+	const char *value;
 	char *fullmsg;
 	PurpleAccount *account = purple_connection_get_account(gc);
 	PurpleConnectionError reason = PURPLE_CONNECTION_ERROR_OTHER_ERROR;
 
-	while (l) {
-		struct yahoo_pair *pair = l->data;
-
-		if (pair->key == 66) {
-			err = strtol(pair->value, NULL, 10);
-		} else if (pair->key == 20) {
-			if (g_utf8_validate(pair->value, -1, NULL)) {
-				url = pair->value;
-			} else {
-				purple_debug_warning("yahoo", "yahoo_process_authresp "
-						"got non-UTF-8 string for key %d\n", pair->key);
-			}
-		}
-
-		l = l->next;
-	}
+	if ((value = yahoo_packet_get_last(pkt, 66)))
+		err = strtol(value, NULL, 10);
+	url = yahoo_packet_get_utf8(pkt, 20, "yahoo_process_authresp");
 
 	switch (err) {
 	case 0:
@@ -3058,6 +3007,7 @@ static void yahoo_pending(gpointer data, gint source, PurpleInputCondition cond)
 	YahooData *yd = purple_connection_get_protocol_data(gc);
 	char buf[1024];
 	int len;
+	int consumed = 0;
 
 	len = read(yd->fd, buf, sizeof(buf));
 
@@ -3083,31 +3033,35 @@ static void yahoo_pending(gpointer data, gint source, PurpleInputCondition cond)
 	memcpy(yd->rxqueue + yd->rxlen, buf, len);
 	yd->rxlen += len;
 
+	/*
+	 * Packets are parsed where they are in the queue, and their values
+	 * point into it, so the queue is only compacted once every complete
+	 * packet has been processed and freed.
+	 */
 	while (1) {
 		struct yahoo_packet *pkt;
+		guchar *data = yd->rxqueue + consumed;
+		int avail = yd->rxlen - consumed;
 		int pos = 0;
 		int pktlen;
 
-		if (yd->rxlen < YAHOO_PACKET_HDRLEN)
-			return;
+		if (avail < YAHOO_PACKET_HDRLEN)
+			break;
 
-		if (strncmp((char *)yd->rxqueue, "YMSG", MIN(4, yd->rxlen)) != 0) {
+		if (strncmp((char *)data, "YMSG", MIN(4, avail)) != 0) {
 			/* HEY! This isn't even a YMSG packet. What
 			 * are you trying to pull? */
 			guchar *start;
 
 			purple_debug_warning("yahoo", "Error in YMSG stream, got something not a YMSG packet!\n");
 
-			start = memchr(yd->rxqueue + 1, 'Y', yd->rxlen - 1);
+			start = memchr(data + 1, 'Y', avail - 1);
 			if (start) {
-				g_memmove(yd->rxqueue, start, yd->rxlen - (start - yd->rxqueue));
-				yd->rxlen -= start - yd->rxqueue;
+				consumed += start - data;
 				continue;
 			} else {
-				g_free(yd->rxqueue);
-				yd->rxqueue = NULL;
-				yd->rxlen = 0;
-				return;
+				consumed = yd->rxlen;
+				break;
 			}
 		}
 
@@ -3115,37 +3069,38 @@ static void yahoo_pending(gpointer data, gint source, PurpleInputCondition cond)
 		pos += 2;
 		pos += 2;
 
-		pktlen = yahoo_get16(yd->rxqueue + pos); pos += 2;
-		purple_debug_misc("yahoo", "%d bytes to read, rxlen is %d\n", pktlen, yd->rxlen);
+		pktlen = yahoo_get16(data + pos); pos += 2;
+		purple_debug_misc("yahoo", "%d bytes to read, rxlen is %d\n", pktlen, avail);
 
-		if (yd->rxlen < (YAHOO_PACKET_HDRLEN + pktlen))
-			return;
+		if (avail < (YAHOO_PACKET_HDRLEN + pktlen))
+			break;
 
-		yahoo_packet_dump(yd->rxqueue, YAHOO_PACKET_HDRLEN + pktlen);
+		yahoo_packet_dump(data, YAHOO_PACKET_HDRLEN + pktlen);
 
 		pkt = yahoo_packet_new(0, 0, 0);
 
-		pkt->service = yahoo_get16(yd->rxqueue + pos); pos += 2;
-		pkt->status = yahoo_get32(yd->rxqueue + pos); pos += 4;
+		pkt->service = yahoo_get16(data + pos); pos += 2;
+		pkt->status = yahoo_get32(data + pos); pos += 4;
 		purple_debug_misc("yahoo", "Yahoo Service: 0x%02x Status: %d\n",
 				   pkt->service, pkt->status);
-		pkt->id = yahoo_get32(yd->rxqueue + pos); pos += 4;
-
-		yahoo_packet_read(pkt, yd->rxqueue + pos, pktlen);
+		pkt->id = yahoo_get32(data + pos); pos += 4;
 
-		yd->rxlen -= YAHOO_PACKET_HDRLEN + pktlen;
-		if (yd->rxlen) {
-			guchar *tmp = g_memdup(yd->rxqueue + YAHOO_PACKET_HDRLEN + pktlen, yd->rxlen);
-			g_free(yd->rxqueue);
-			yd->rxqueue = tmp;
-		} else {
-			g_free(yd->rxqueue);
-			yd->rxqueue = NULL;
-		}
+		yahoo_packet_read(pkt, data + pos, pktlen);
 
 		yahoo_packet_process(gc, pkt);
 
 		yahoo_packet_free(pkt);
+
+		consumed += YAHOO_PACKET_HDRLEN + pktlen;
+	}
+
+	if (consumed == yd->rxlen) {
+		g_free(yd->rxqueue);
+		yd->rxqueue = NULL;
+		yd->rxlen = 0;
+	} else if (consumed > 0) {
+		g_memmove(yd->rxqueue, yd->rxqueue + consumed, yd->rxlen - consumed);
+		yd->rxlen -= consumed;
 	}
 }
 
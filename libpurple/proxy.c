@@ -58,6 +58,12 @@ struct _PurpleProxyConnectData {
 	PurpleProxyInfo *gpi;
 
 	GCancellable *cancellable;
+
+	/* Direct connections: the addresses not tried yet, the timer that
+	 * starts the next attempt, and how many attempts are running. */
+	GList *addresses;
+	guint race_timeout;
+	guint attempts;
 };
 
 static const char * const socks5errors[] = {
@@ -559,6 +565,10 @@ purple_proxy_connect_data_destroy(PurpleProxyConnectData *connect_data)
 		connect_data->cancellable = NULL;
 	}
 
+	if (connect_data->race_timeout > 0)
+		purple_timeout_remove(connect_data->race_timeout);
+
+	g_resolver_free_addresses(connect_data->addresses);
 	g_free(connect_data->host);
 	g_free(connect_data);
 }
@@ -765,6 +775,182 @@ connect_to_host_cb(GObject *source, GAsyncResult *res, gpointer user_data)
 	purple_proxy_connect_data_connected(connect_data);
 }
 
+/*
+ * Direct connections are made to the resolved addresses one at a time,
+ * but if an attempt hasn't succeeded after a short delay, the next address
+ * is tried alongside it, and the first connection to succeed wins.
+ * Alternating between IPv6 and IPv4 addresses means a broken IPv6 route
+ * only ever costs that delay rather than a full connect timeout.
+ */
+static void race_next_address(PurpleProxyConnectData *connect_data);
+
+static GList *
+race_sort_addresses(GList *addresses)
+{
+	GList *first = NULL, *second = NULL, *sorted = NULL, *l;
+	GSocketFamily family;
+
+	if (addresses == NULL)
+		return NULL;
+
+	/* Keep the resolver's preferred family first */
+	family = g_inet_address_get_family(addresses->data);
+	for (l = addresses; l != NULL; l = l->next) {
+		if (g_inet_address_get_family(l->data) == family)
+			first = g_list_prepend(first, l->data);
+		else
+			second = g_list_prepend(second, l->data);
+	}
+	g_list_free(addresses);
+
+	first = g_list_reverse(first);
+	second = g_list_reverse(second);
+
+	while (first != NULL || second != NULL) {
+		if (first != NULL) {
+			sorted = g_list_prepend(sorted, first->data);
+			first = g_list_delete_link(first, first);
+		}
+		if (second != NULL) {
+			sorted = g_list_prepend(sorted, second->data);
+			second = g_list_delete_link(second, second);
+		}
+	}
+
+	return g_list_reverse(sorted);
+}
+
+static gboolean
+race_timeout_cb(gpointer data)
+{
+	PurpleProxyConnectData *connect_data = data;
+
+	connect_data->race_timeout = 0;
+	race_next_address(connect_data);
+
+	return FALSE;
+}
+
+static void
+race_connect_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	PurpleProxyConnectData *connect_data = user_data;
+	GSocketConnection *conn;
+	GError *error = NULL;
+	GSocket *socket;
+
+	conn = g_socket_client_connect_finish(G_SOCKET_CLIENT(source),
+			res, &error);
+	if (conn == NULL) {
+		/* Ignore cancelled error as that signifies connect_data has
+		 * been freed, or another attempt already won
+		 */
+		if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+			g_clear_error(&error);
+			return;
+		}
+
+		connect_data->attempts--;
+
+		purple_debug_info("proxy", "Connection attempt to %s:%d "
+				"failed: %s\n", connect_data->host,
+				connect_data->port, error->message);
+		g_clear_error(&error);
+
+		if (connect_data->addresses != NULL) {
+			/* Don't wait for the delay to try the next one */
+			if (connect_data->race_timeout > 0) {
+				purple_timeout_remove(connect_data->race_timeout);
+				connect_data->race_timeout = 0;
+			}
+			race_next_address(connect_data);
+		} else if (connect_data->attempts == 0) {
+			purple_proxy_connect_data_disconnect(connect_data,
+					"Unable to connect to destination "
+					"host.\n");
+		}
+
+		return;
+	}
+
+	socket = g_socket_connection_get_socket(conn);
+	g_assert(socket != NULL);
+
+	/* See connect_to_host_cb() */
+	connect_data->fd = duplicate_fd(g_socket_get_fd(socket));
+	g_object_unref(conn);
+
+	/* This cancels the attempts that lost */
+	purple_proxy_connect_data_connected(connect_data);
+}
+
+static void
+race_next_address(PurpleProxyConnectData *connect_data)
+{
+	GInetAddress *address;
+	GSocketAddress *socket_address;
+	GSocketClient *client;
+	gchar *address_str;
+
+	address = connect_data->addresses->data;
+	connect_data->addresses = g_list_delete_link(connect_data->addresses,
+			connect_data->addresses);
+
+	address_str = g_inet_address_to_string(address);
+	purple_debug_info("proxy", "Attempting connection to %s (%s:%d)\n",
+			connect_data->host, address_str, connect_data->port);
+	g_free(address_str);
+
+	socket_address = g_inet_socket_address_new(address, connect_data->port);
+	g_object_unref(address);
+
+	client = g_socket_client_new();
+	g_socket_client_set_enable_proxy(client, FALSE);
+
+	connect_data->attempts++;
+	g_socket_client_connect_async(client,
+			G_SOCKET_CONNECTABLE(socket_address),
+			connect_data->cancellable, race_connect_cb, connect_data);
+	g_object_unref(client);
+	g_object_unref(socket_address);
+
+	if (connect_data->addresses != NULL) {
+		connect_data->race_timeout = purple_timeout_add(
+				purple_prefs_get_int("/purple/network/connection_race_delay"),
+				race_timeout_cb, connect_data);
+	}
+}
+
+static void
+race_lookup_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+	PurpleProxyConnectData *connect_data = user_data;
+	GList *addresses;
+	GError *error = NULL;
+
+	addresses = g_resolver_lookup_by_name_finish(G_RESOLVER(source),
+			res, &error);
+	if (addresses == NULL) {
+		/* Ignore cancelled error as that signifies connect_data has
+		 * been freed
+		 */
+		if (!g_error_matches(error, G_IO_ERROR,
+				G_IO_ERROR_CANCELLED)) {
+			purple_debug_error("proxy", "Unable to resolve "
+					"destination host: %s\n",
+					error->message);
+			purple_proxy_connect_data_disconnect(connect_data,
+					"Unable to resolve destination host.\n");
+		}
+
+		g_clear_error(&error);
+		return;
+	}
+
+	connect_data->addresses = race_sort_addresses(addresses);
+	race_next_address(connect_data);
+}
+
 PurpleProxyConnectData *
 purple_proxy_connect(void *handle, PurpleAccount *account,
 				   const char *host, int port,
@@ -796,6 +982,20 @@ purple_proxy_connect(void *handle, PurpleAccount *account,
 	}
 
 	connect_data->cancellable = g_cancellable_new();
+	handles = g_slist_prepend(handles, connect_data);
+
+	if (purple_proxy_info_get_proxy_type(connect_data->gpi) == PURPLE_PROXY_NONE) {
+		GResolver *dns = g_resolver_get_default();
+
+		g_object_unref(resolver);
+
+		g_resolver_lookup_by_name_async(dns, host,
+				connect_data->cancellable, race_lookup_cb,
+				connect_data);
+		g_object_unref(dns);
+
+		return connect_data;
+	}
 
 	client = g_socket_client_new();
 	g_socket_client_set_proxy_resolver(client, resolver);
@@ -809,8 +1009,6 @@ purple_proxy_connect(void *handle, PurpleAccount *account,
 			connect_data);
 	g_object_unref(client);
 
-	handles = g_slist_prepend(handles, connect_data);
-
 	return connect_data;
 }
 
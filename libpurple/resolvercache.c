@@ -0,0 +1,851 @@
+/* Purple is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ */
+#include "internal.h"
+#include "glibcompat.h"
+
+#include "resolvercache.h"
+
+#define DEFAULT_TTL 300
+#define DEFAULT_NEGATIVE_TTL 30
+
+/* How often lookups look for expired entries to throw away, in seconds */
+#define EXPIRE_INTERVAL 60
+
+#define PURPLE_RESOLVER_CACHE_GET_PRIVATE(obj) \
+	(G_TYPE_INSTANCE_GET_PRIVATE((obj), PURPLE_TYPE_RESOLVER_CACHE, PurpleResolverCachePrivate))
+
+/******************************************************************************
+ * Structs
+ *****************************************************************************/
+typedef enum {
+	PURPLE_RESOLVER_CACHE_BY_NAME,
+	PURPLE_RESOLVER_CACHE_SERVICE,
+} PurpleResolverCacheLookup;
+
+typedef struct {
+	/** The cache this entry belongs to. */
+	PurpleResolverCache *cache;
+
+	/** What kind of lookup this is the answer to. */
+	PurpleResolverCacheLookup lookup;
+
+	/** The host name, or the SRV record name. */
+	gchar *name;
+
+	/** The GResolverNameLookupFlags of a host name lookup. */
+	gint flags;
+
+	/** The key of this entry in the cache. */
+	gchar *key;
+
+	/** The addresses or SRV targets that were found. */
+	GList *results;
+
+	/** Why nothing was found, if that's the answer. */
+	GError *error;
+
+	/** When the answer must not be used anymore, or 0 if it must not be
+	 *  kept at all.  In monotonic time. */
+	gint64 expires;
+
+	/** When using the answer starts a lookup to refresh it. */
+	gint64 refresh;
+
+	/** TRUE while a lookup for this entry is running. */
+	gboolean pending;
+
+	/** TRUE if the cache was cleared while the lookup was running, and
+	 *  nobody but the lookup knows about the entry anymore. */
+	gboolean orphaned;
+
+	/** The GTasks waiting for the running lookup. */
+	GList *waiters;
+} PurpleResolverCacheEntry;
+
+typedef struct {
+	/** The resolver that does the actual lookups. */
+	GResolver *resolver;
+
+	/** The cached answers, by key. */
+	GHashTable *entries;
+
+	/** When the next lookup throws away expired entries. */
+	gint64 next_expire;
+
+	/** How many seconds to keep answers for. */
+	guint ttl;
+	guint negative_ttl;
+} PurpleResolverCachePrivate;
+
+/******************************************************************************
+ * Enums
+ *****************************************************************************/
+enum {
+	PROP_ZERO,
+	PROP_RESOLVER,
+	PROP_TTL,
+	PROP_NEGATIVE_TTL,
+	PROP_LAST,
+};
+
+/******************************************************************************
+ * Globals
+ *****************************************************************************/
+static GObjectClass *parent_class = NULL;
+static GParamSpec *properties[PROP_LAST];
+
+/******************************************************************************
+ * Entries
+ *****************************************************************************/
+static GList *
+purple_resolver_cache_copy_results(PurpleResolverCacheLookup lookup,
+                                   GList *results)
+{
+	if(lookup == PURPLE_RESOLVER_CACHE_SERVICE)
+		return g_list_copy_deep(results, (GCopyFunc)g_srv_target_copy, NULL);
+
+	return g_list_copy_deep(results, (GCopyFunc)g_object_ref, NULL);
+}
+
+static void
+purple_resolver_cache_free_results(PurpleResolverCacheLookup lookup,
+                                   GList *results)
+{
+	if(lookup == PURPLE_RESOLVER_CACHE_SERVICE)
+		g_resolver_free_targets(results);
+	else
+		g_resolver_free_addresses(results);
+}
+
+static void
+purple_resolver_cache_entry_free(PurpleResolverCacheEntry *entry) {
+	purple_resolver_cache_free_results(entry->lookup, entry->results);
+	g_clear_error(&entry->error);
+	g_free(entry->name);
+	g_free(entry->key);
+	g_free(entry);
+}
+
+static gboolean
+purple_resolver_cache_entry_is_fresh(PurpleResolverCacheEntry *entry,
+                                     gint64 now)
+{
+	return (entry->results != NULL || entry->error != NULL) &&
+	       entry->expires > now;
+}
+
+static PurpleResolverCacheEntry *
+purple_resolver_cache_get_entry(PurpleResolverCache *cache,
+                                PurpleResolverCacheLookup lookup,
+                                const gchar *name, gint flags)
+{
+	PurpleResolverCachePrivate *priv = PURPLE_RESOLVER_CACHE_GET_PRIVATE(cache);
+	PurpleResolverCacheEntry *entry;
+	gchar *lower, *key;
+
+	/* DNS names are case insensitive */
+	lower = g_ascii_strdown(name, -1);
+	key = g_strdup_printf("%d:%d:%s", lookup, flags, lower);
+	g_free(lower);
+
+	entry = g_hash_table_lookup(priv->entries, key);
+	if(entry != NULL) {
+		g_free(key);
+		return entry;
+	}
+
+	entry = g_new0(PurpleResolverCacheEntry, 1);
+	entry->cache = cache;
+	entry->lookup = lookup;
+	entry->name = g_strdup(name);
+	entry->flags = flags;
+	entry->key = key;
+	g_hash_table_insert(priv->entries, entry->key, entry);
+
+	return entry;
+}
+
+/*
+ * Answers are only replaced when their name is looked up again, so throw
+ * away the ones nobody asked for again before the table fills up with them.
+ */
+static void
+purple_resolver_cache_expire(PurpleResolverCache *cache, gint64 now) {
+	PurpleResolverCachePrivate *priv = PURPLE_RESOLVER_CACHE_GET_PRIVATE(cache);
+	GHashTableIter iter;
+	gpointer value;
+
+	if(now < priv->next_expire)
+		return;
+	priv->next_expire = now + (gint64)EXPIRE_INTERVAL * G_USEC_PER_SEC;
+
+	g_hash_table_iter_init(&iter, priv->entries);
+	while(g_hash_table_iter_next(&iter, NULL, &value)) {
+		PurpleResolverCacheEntry *entry = value;
+
+		if(!entry->pending && entry->expires <= now)
+			g_hash_table_iter_remove(&iter);
+	}
+}
+
+/* Takes ownership of results and error */
+static void
+purple_resolver_cache_entry_store(PurpleResolverCacheEntry *entry,
+                                  GList *results, GError *error)
+{
+	PurpleResolverCachePrivate *priv = PURPLE_RESOLVER_CACHE_GET_PRIVATE(entry->cache);
+	gint64 now = g_get_monotonic_time();
+	guint ttl;
+
+	if(results == NULL &&
+	   !g_error_matches(error, G_RESOLVER_ERROR, G_RESOLVER_ERROR_NOT_FOUND) &&
+	   purple_resolver_cache_entry_is_fresh(entry, now))
+	{
+		/* A refresh failed for some passing reason; the answer we have
+		 * is still better than none. */
+		g_error_free(error);
+		return;
+	}
+
+	purple_resolver_cache_free_results(entry->lookup, entry->results);
+	entry->results = NULL;
+	g_clear_error(&entry->error);
+
+	if(results != NULL) {
+		entry->results = results;
+		ttl = priv->ttl;
+	} else {
+		entry->error = error;
+		if(g_error_matches(error, G_RESOLVER_ERROR, G_RESOLVER_ERROR_NOT_FOUND))
+			ttl = priv->negative_ttl;
+		else
+			ttl = 0;
+	}
+
+	if(ttl > 0) {
+		entry->expires = now + (gint64)ttl * G_USEC_PER_SEC;
+		entry->refresh = now + (gint64)ttl * G_USEC_PER_SEC / 4 * 3;
+	} else {
+		entry->expires = entry->refresh = 0;
+	}
+}
+
+static void
+purple_resolver_cache_entry_return(PurpleResolverCacheEntry *entry,
+                                   GTask *task)
+{
+	if(entry->results == NULL) {
+		g_task_return_error(task, g_error_copy(entry->error));
+	} else if(entry->lookup == PURPLE_RESOLVER_CACHE_SERVICE) {
+		g_task_return_pointer(task,
+			purple_resolver_cache_copy_results(entry->lookup, entry->results),
+			(GDestroyNotify)g_resolver_free_targets);
+	} else {
+		g_task_return_pointer(task,
+			purple_resolver_cache_copy_results(entry->lookup, entry->results),
+			(GDestroyNotify)g_resolver_free_addresses);
+	}
+}
+
+/******************************************************************************
+ * Lookups
+ *****************************************************************************/
+static void
+purple_resolver_cache_lookup_cb(GObject *source, GAsyncResult *res,
+                                gpointer data)
+{
+	PurpleResolverCacheEntry *entry = data;
+	PurpleResolverCache *cache = entry->cache;
+	PurpleResolverCachePrivate *priv = PURPLE_RESOLVER_CACHE_GET_PRIVATE(cache);
+	GResolver *resolver = G_RESOLVER(source);
+	GList *results, *waiters, *l;
+	GError *error = NULL;
+
+	if(entry->lookup == PURPLE_RESOLVER_CACHE_SERVICE) {
+		results = G_RESOLVER_GET_CLASS(resolver)->lookup_service_finish(
+				resolver, res, &error);
+#if GLIB_CHECK_VERSION(2,60,0)
+	} else if(entry->flags != G_RESOLVER_NAME_LOOKUP_FLAGS_DEFAULT) {
+		results = g_resolver_lookup_by_name_with_flags_finish(resolver, res,
+				&error);
+#endif
+	} else {
+		results = g_resolver_lookup_by_name_finish(resolver, res, &error);
+	}
+
+	purple_resolver_cache_entry_store(entry, results, error);
+	entry->pending = FALSE;
+
+	waiters = entry->waiters;
+	entry->waiters = NULL;
+	for(l = waiters; l != NULL; l = l->next) {
+		GTask *task = l->data;
+
+		if(!g_task_return_error_if_cancelled(task))
+			purple_resolver_cache_entry_return(entry, task);
+
+		g_object_unref(task);
+	}
+	g_list_free(waiters);
+
+	if(entry->orphaned)
+		purple_resolver_cache_entry_free(entry);
+	else if(entry->expires == 0)
+		g_hash_table_remove(priv->entries, entry->key);
+
+	g_object_unref(cache);
+}
+
+/*
+ * Waiters aren't cancelled while the lookup runs, because the lookup is
+ * shared; a cancelled waiter just gets G_IO_ERROR_CANCELLED once it's done.
+ */
+static void
+purple_resolver_cache_entry_lookup(PurpleResolverCacheEntry *entry) {
+	PurpleResolverCachePrivate *priv = PURPLE_RESOLVER_CACHE_GET_PRIVATE(entry->cache);
+
+	entry->pending = TRUE;
+	g_object_ref(entry->cache);
+
+	if(entry->lookup == PURPLE_RESOLVER_CACHE_SERVICE) {
+		G_RESOLVER_GET_CLASS(priv->resolver)->lookup_service_async(
+				priv->resolver, entry->name, NULL,
+				purple_resolver_cache_lookup_cb, entry);
+#if GLIB_CHECK_VERSION(2,60,0)
+	} else if(entry->flags != G_RESOLVER_NAME_LOOKUP_FLAGS_DEFAULT) {
+		g_resolver_lookup_by_name_with_flags_async(priv->resolver,
+				entry->name, entry->flags, NULL,
+				purple_resolver_cache_lookup_cb, entry);
+#endif
+	} else {
+		g_resolver_lookup_by_name_async(priv->resolver, entry->name, NULL,
+				purple_resolver_cache_lookup_cb, entry);
+	}
+}
+
+/* Resolve names that are still in use again before they expire */
+static void
+purple_resolver_cache_entry_used(PurpleResolverCacheEntry *entry, gint64 now) {
+	if(!entry->pending && entry->results != NULL && now >= entry->refresh)
+		purple_resolver_cache_entry_lookup(entry);
+}
+
+static GList *
+purple_resolver_cache_lookup(PurpleResolverCache *cache,
+                             PurpleResolverCacheLookup lookup,
+                             const gchar *name, gint flags,
+                             GCancellable *cancellable, GError **error)
+{
+	PurpleResolverCachePrivate *priv = PURPLE_RESOLVER_CACHE_GET_PRIVATE(cache);
+	PurpleResolverCacheEntry *entry;
+	GList *results;
+	GError *lookup_error = NULL;
+	gint64 now = g_get_monotonic_time();
+
+	purple_resolver_cache_expire(cache, now);
+
+	entry = purple_resolver_cache_get_entry(cache, lookup, name, flags);
+	if(purple_resolver_cache_entry_is_fresh(entry, now)) {
+		purple_resolver_cache_entry_used(entry, now);
+
+		if(entry->results == NULL) {
+			g_propagate_error(error, g_error_copy(entry->error));
+			return NULL;
+		}
+
+		return purple_resolver_cache_copy_results(lookup, entry->results);
+	}
+
+	if(lookup == PURPLE_RESOLVER_CACHE_SERVICE) {
+		results = G_RESOLVER_GET_CLASS(priv->resolver)->lookup_service(
+				priv->resolver, name, cancellable, &lookup_error);
+#if GLIB_CHECK_VERSION(2,60,0)
+	} else if(flags != G_RESOLVER_NAME_LOOKUP_FLAGS_DEFAULT) {
+		results = g_resolver_lookup_by_name_with_flags(priv->resolver, name,
+				flags, cancellable, &lookup_error);
+#endif
+	} else {
+		results = g_resolver_lookup_by_name(priv->resolver, name, cancellable,
+				&lookup_error);
+	}
+
+	if(g_error_matches(lookup_error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		if(!entry->pending && entry->results == NULL && entry->error == NULL)
+			g_hash_table_remove(priv->entries, entry->key);
+
+		g_propagate_error(error, lookup_error);
+		return NULL;
+	}
+
+	/* An asynchronous lookup that is already running will store its own
+	 * answer. */
+	if(!entry->pending) {
+		purple_resolver_cache_entry_store(entry,
+				purple_resolver_cache_copy_results(lookup, results),
+				lookup_error ? g_error_copy(lookup_error) : NULL);
+
+		if(entry->expires == 0)
+			g_hash_table_remove(priv->entries, entry->key);
+	}
+
+	if(lookup_error != NULL)
+		g_propagate_error(error, lookup_error);
+
+	return results;
+}
+
+static void
+purple_resolver_cache_lookup_async(PurpleResolverCache *cache,
+                                   PurpleResolverCacheLookup lookup,
+                                   const gchar *name, gint flags,
+                                   GCancellable *cancellable,
+                                   GAsyncReadyCallback callback,
+                                   gpointer data, gpointer source_tag)
+{
+	PurpleResolverCacheEntry *entry;
+	GTask *task;
+	gint64 now = g_get_monotonic_time();
+
+	task = g_task_new(cache, cancellable, callback, data);
+	g_task_set_source_tag(task, source_tag);
+
+	purple_resolver_cache_expire(cache, now);
+
+	entry = purple_resolver_cache_get_entry(cache, lookup, name, flags);
+	if(purple_resolver_cache_entry_is_fresh(entry, now)) {
+		purple_resolver_cache_entry_return(entry, task);
+		g_object_unref(task);
+
+		purple_resolver_cache_entry_used(entry, now);
+		return;
+	}
+
+	/* Whoever asks while the name is being looked up gets the same
+	 * answer. */
+	entry->waiters = g_list_append(entry->waiters, task);
+	if(!entry->pending)
+		purple_resolver_cache_entry_lookup(entry);
+}
+
+static GList *
+purple_resolver_cache_lookup_finish(GAsyncResult *result, GError **error) {
+	return g_task_propagate_pointer(G_TASK(result), error);
+}
+
+/******************************************************************************
+ * Pass-through lookups
+ *****************************************************************************/
+static void
+purple_resolver_cache_by_address_cb(GObject *source, GAsyncResult *res,
+                                    gpointer data)
+{
+	GTask *task = data;
+	GError *error = NULL;
+	gchar *name;
+
+	name = g_resolver_lookup_by_address_finish(G_RESOLVER(source), res, &error);
+	if(name == NULL)
+		g_task_return_error(task, error);
+	else
+		g_task_return_pointer(task, name, g_free);
+
+	g_object_unref(task);
+}
+
+static void
+purple_resolver_cache_free_records(GList *records) {
+	g_list_free_full(records, (GDestroyNotify)g_variant_unref);
+}
+
+static void
+purple_resolver_cache_records_cb(GObject *source, GAsyncResult *res,
+                                 gpointer data)
+{
+	GTask *task = data;
+	GError *error = NULL;
+	GList *records;
+
+	records = g_resolver_lookup_records_finish(G_RESOLVER(source), res, &error);
+	if(error != NULL)
+		g_task_return_error(task, error);
+	else
+		g_task_return_pointer(task, records,
+				(GDestroyNotify)purple_resolver_cache_free_records);
+
+	g_object_unref(task);
+}
+
+/******************************************************************************
+ * GResolver Implementation
+ *****************************************************************************/
+static GList *
+purple_resolver_cache_lookup_by_name(GResolver *resolver, const gchar *hostname,
+                                     GCancellable *cancellable, GError **error)
+{
+	return purple_resolver_cache_lookup(PURPLE_RESOLVER_CACHE(resolver),
+			PURPLE_RESOLVER_CACHE_BY_NAME, hostname, 0, cancellable, error);
+}
+
+static void
+purple_resolver_cache_lookup_by_name_async(GResolver *resolver,
+                                           const gchar *hostname,
+                                           GCancellable *cancellable,
+                                           GAsyncReadyCallback callback,
+                                           gpointer data)
+{
+	purple_resolver_cache_lookup_async(PURPLE_RESOLVER_CACHE(resolver),
+			PURPLE_RESOLVER_CACHE_BY_NAME, hostname, 0, cancellable,
+			callback, data, purple_resolver_cache_lookup_by_name_async);
+}
+
+static GList *
+purple_resolver_cache_lookup_by_name_finish(GResolver *resolver,
+                                            GAsyncResult *result,
+                                            GError **error)
+{
+	return purple_resolver_cache_lookup_finish(result, error);
+}
+
+#if GLIB_CHECK_VERSION(2,60,0)
+static GList *
+purple_resolver_cache_lookup_by_name_with_flags(GResolver *resolver,
+                                                const gchar *hostname,
+                                                GResolverNameLookupFlags flags,
+                                                GCancellable *cancellable,
+                                                GError **error)
+{
+	return purple_resolver_cache_lookup(PURPLE_RESOLVER_CACHE(resolver),
+			PURPLE_RESOLVER_CACHE_BY_NAME, hostname, flags, cancellable,
+			error);
+}
+
+static void
+purple_resolver_cache_lookup_by_name_with_flags_async(GResolver *resolver,
+                                                      const gchar *hostname,
+                                                      GResolverNameLookupFlags flags,
+                                                      GCancellable *cancellable,
+                                                      GAsyncReadyCallback callback,
+                                                      gpointer data)
+{
+	purple_resolver_cache_lookup_async(PURPLE_RESOLVER_CACHE(resolver),
+			PURPLE_RESOLVER_CACHE_BY_NAME, hostname, flags, cancellable,
+			callback, data,
+			purple_resolver_cache_lookup_by_name_with_flags_async);
+}
+
+static GList *
+purple_resolver_cache_lookup_by_name_with_flags_finish(GResolver *resolver,
+                                                       GAsyncResult *result,
+                                                       GError **error)
+{
+	return purple_resolver_cache_lookup_finish(result, error);
+}
+#endif
+
+static GList *
+purple_resolver_cache_lookup_service(GResolver *resolver, const gchar *rrname,
+                                     GCancellable *cancellable, GError **error)
+{
+	return purple_resolver_cache_lookup(PURPLE_RESOLVER_CACHE(resolver),
+			PURPLE_RESOLVER_CACHE_SERVICE, rrname, 0, cancellable, error);
+}
+
+static void
+purple_resolver_cache_lookup_service_async(GResolver *resolver,
+                                           const gchar *rrname,
+                                           GCancellable *cancellable,
+                                           GAsyncReadyCallback callback,
+                                           gpointer data)
+{
+	purple_resolver_cache_lookup_async(PURPLE_RESOLVER_CACHE(resolver),
+			PURPLE_RESOLVER_CACHE_SERVICE, rrname, 0, cancellable,
+			callback, data, purple_resolver_cache_lookup_service_async);
+}
+
+static GList *
+purple_resolver_cache_lookup_service_finish(GResolver *resolver,
+                                            GAsyncResult *result,
+                                            GError **error)
+{
+	return purple_resolver_cache_lookup_finish(result, error);
+}
+
+static gchar *
+purple_resolver_cache_lookup_by_address(GResolver *resolver,
+                                        GInetAddress *address,
+                                        GCancellable *cancellable,
+                                        GError **error)
+{
+	PurpleResolverCachePrivate *priv = PURPLE_RESOLVER_CACHE_GET_PRIVATE(resolver);
+
+	return g_resolver_lookup_by_address(priv->resolver, address, cancellable,
+			error);
+}
+
+static void
+purple_resolver_cache_lookup_by_address_async(GResolver *resolver,
+                                              GInetAddress *address,
+                                              GCancellable *cancellable,
+                                              GAsyncReadyCallback callback,
+                                              gpointer data)
+{
+	PurpleResolverCachePrivate *priv = PURPLE_RESOLVER_CACHE_GET_PRIVATE(resolver);
+	GTask *task;
+
+	task = g_task_new(resolver, cancellable, callback, data);
+	g_task_set_source_tag(task, purple_resolver_cache_lookup_by_address_async);
+
+	g_resolver_lookup_by_address_async(priv->resolver, address, cancellable,
+			purple_resolver_cache_by_address_cb, task);
+}
+
+static gchar *
+purple_resolver_cache_lookup_by_address_finish(GResolver *resolver,
+                                               GAsyncResult *result,
+                                               GError **error)
+{
+	return g_task_propagate_pointer(G_TASK(result), error);
+}
+
+static GList *
+purple_resolver_cache_lookup_records(GResolver *resolver, const gchar *rrname,
+                                     GResolverRecordType record_type,
+                                     GCancellable *cancellable, GError **error)
+{
+	PurpleResolverCachePrivate *priv = PURPLE_RESOLVER_CACHE_GET_PRIVATE(resolver);
+
+	return g_resolver_lookup_records(priv->resolver, rrname, record_type,
+			cancellable, error);
+}
+
+static void
+purple_resolver_cache_lookup_records_async(GResolver *resolver,
+                                           const gchar *rrname,
+                                           GResolverRecordType record_type,
+                                           GCancellable *cancellable,
+                                           GAsyncReadyCallback callback,
+                                           gpointer data)
+{
+	PurpleResolverCachePrivate *priv = PURPLE_RESOLVER_CACHE_GET_PRIVATE(resolver);
+	GTask *task;
+
+	task = g_task_new(resolver, cancellable, callback, data);
+	g_task_set_source_tag(task, purple_resolver_cache_lookup_records_async);
+
+	g_resolver_lookup_records_async(priv->resolver, rrname, record_type,
+			cancellable, purple_resolver_cache_records_cb, task);
+}
+
+static GList *
+purple_resolver_cache_lookup_records_finish(GResolver *resolver,
+                                            GAsyncResult *result,
+                                            GError **error)
+{
+	return g_task_propagate_pointer(G_TASK(result), error);
+}
+
+/******************************************************************************
+ * Object Stuff
+ *****************************************************************************/
+static void
+purple_resolver_cache_init(GTypeInstance *instance, gpointer klass) {
+	PurpleResolverCachePrivate *priv = PURPLE_RESOLVER_CACHE_GET_PRIVATE(instance);
+
+	priv->entries = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+			(GDestroyNotify)purple_resolver_cache_entry_free);
+	priv->ttl = DEFAULT_TTL;
+	priv->negative_ttl = DEFAULT_NEGATIVE_TTL;
+}
+
+static void
+purple_resolver_cache_finalize(GObject *obj) {
+	PurpleResolverCachePrivate *priv = PURPLE_RESOLVER_CACHE_GET_PRIVATE(obj);
+
+	/* Running lookups hold a reference, so nothing is pending here */
+	g_hash_table_destroy(priv->entries);
+
+	if(priv->resolver != NULL)
+		g_object_unref(priv->resolver);
+
+	G_OBJECT_CLASS(parent_class)->finalize(obj);
+}
+
+static void
+purple_resolver_cache_get_property(GObject *obj, guint param_id,
+                                   GValue *value, GParamSpec *pspec)
+{
+	PurpleResolverCachePrivate *priv = PURPLE_RESOLVER_CACHE_GET_PRIVATE(obj);
+
+	switch(param_id) {
+		case PROP_RESOLVER:
+			g_value_set_object(value, priv->resolver);
+			break;
+		case PROP_TTL:
+			g_value_set_uint(value, priv->ttl);
+			break;
+		case PROP_NEGATIVE_TTL:
+			g_value_set_uint(value, priv->negative_ttl);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, param_id, pspec);
+			break;
+	}
+}
+
+static void
+purple_resolver_cache_set_property(GObject *obj, guint param_id,
+                                   const GValue *value, GParamSpec *pspec)
+{
+	PurpleResolverCachePrivate *priv = PURPLE_RESOLVER_CACHE_GET_PRIVATE(obj);
+
+	switch(param_id) {
+		case PROP_RESOLVER:
+			priv->resolver = g_value_dup_object(value);
+			break;
+		case PROP_TTL:
+			priv->ttl = g_value_get_uint(value);
+			break;
+		case PROP_NEGATIVE_TTL:
+			priv->negative_ttl = g_value_get_uint(value);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, param_id, pspec);
+			break;
+	}
+}
+
+static void
+purple_resolver_cache_class_init(PurpleResolverCacheClass *klass) {
+	GObjectClass *obj_class = G_OBJECT_CLASS(klass);
+	GResolverClass *resolver_class = G_RESOLVER_CLASS(klass);
+
+	parent_class = g_type_class_peek_parent(klass);
+
+	g_type_class_add_private(klass, sizeof(PurpleResolverCachePrivate));
+
+	obj_class->finalize = purple_resolver_cache_finalize;
+	obj_class->get_property = purple_resolver_cache_get_property;
+	obj_class->set_property = purple_resolver_cache_set_property;
+
+	resolver_class->lookup_by_name = purple_resolver_cache_lookup_by_name;
+	resolver_class->lookup_by_name_async = purple_resolver_cache_lookup_by_name_async;
+	resolver_class->lookup_by_name_finish = purple_resolver_cache_lookup_by_name_finish;
+#if GLIB_CHECK_VERSION(2,60,0)
+	resolver_class->lookup_by_name_with_flags = purple_resolver_cache_lookup_by_name_with_flags;
+	resolver_class->lookup_by_name_with_flags_async = purple_resolver_cache_lookup_by_name_with_flags_async;
+	resolver_class->lookup_by_name_with_flags_finish = purple_resolver_cache_lookup_by_name_with_flags_finish;
+#endif
+	resolver_class->lookup_by_address = purple_resolver_cache_lookup_by_address;
+	resolver_class->lookup_by_address_async = purple_resolver_cache_lookup_by_address_async;
+	resolver_class->lookup_by_address_finish = purple_resolver_cache_lookup_by_address_finish;
+	resolver_class->lookup_service = purple_resolver_cache_lookup_service;
+	resolver_class->lookup_service_async = purple_resolver_cache_lookup_service_async;
+	resolver_class->lookup_service_finish = purple_resolver_cache_lookup_service_finish;
+	resolver_class->lookup_records = purple_resolver_cache_lookup_records;
+	resolver_class->lookup_records_async = purple_resolver_cache_lookup_records_async;
+	resolver_class->lookup_records_finish = purple_resolver_cache_lookup_records_finish;
+
+	properties[PROP_RESOLVER] = g_param_spec_object("resolver", "resolver",
+		                   "The resolver that does the actual lookups",
+		                   G_TYPE_RESOLVER,
+		                   G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+		                   G_PARAM_STATIC_STRINGS);
+
+	properties[PROP_TTL] = g_param_spec_uint("ttl", "ttl",
+		                   "How many seconds to keep names that were found",
+		                   0, G_MAXUINT, DEFAULT_TTL,
+		                   G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+	properties[PROP_NEGATIVE_TTL] = g_param_spec_uint("negative-ttl",
+		                   "negative-ttl",
+		                   "How many seconds to keep names that don't exist",
+		                   0, G_MAXUINT, DEFAULT_NEGATIVE_TTL,
+		                   G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+	g_object_class_install_properties(obj_class, PROP_LAST, properties);
+}
+
+/******************************************************************************
+ * API
+ *****************************************************************************/
+GType
+purple_resolver_cache_get_type(void) {
+	static GType type = 0;
+
+	if(G_UNLIKELY(type == 0)) {
+		static const GTypeInfo info = {
+			.class_size = sizeof(PurpleResolverCacheClass),
+			.class_init = (GClassInitFunc)purple_resolver_cache_class_init,
+			.instance_size = sizeof(PurpleResolverCache),
+			.instance_init = purple_resolver_cache_init,
+		};
+
+		type = g_type_register_static(G_TYPE_RESOLVER,
+		                              "PurpleResolverCache",
+		                              &info, 0);
+	}
+
+	return type;
+}
+
+GResolver *
+purple_resolver_cache_new(GResolver *resolver) {
+	g_return_val_if_fail(G_IS_RESOLVER(resolver), NULL);
+
+	return g_object_new(PURPLE_TYPE_RESOLVER_CACHE,
+	                    "resolver", resolver,
+	                    NULL);
+}
+
+void
+purple_resolver_cache_set_ttl(PurpleResolverCache *cache, guint ttl,
+                              guint negative_ttl)
+{
+	g_return_if_fail(PURPLE_IS_RESOLVER_CACHE(cache));
+
+	g_object_set(cache,
+	             "ttl", ttl,
+	             "negative-ttl", negative_ttl,
+	             NULL);
+}
+
+static gboolean
+purple_resolver_cache_clear_entry(gpointer key, gpointer value, gpointer data) {
+	PurpleResolverCacheEntry *entry = value;
+
+	/* The running lookup frees it when it's done */
+	if(entry->pending)
+		entry->orphaned = TRUE;
+	else
+		purple_resolver_cache_entry_free(entry);
+
+	return TRUE;
+}
+
+void
+purple_resolver_cache_clear(PurpleResolverCache *cache) {
+	PurpleResolverCachePrivate *priv = NULL;
+
+	g_return_if_fail(PURPLE_IS_RESOLVER_CACHE(cache));
+
+	priv = PURPLE_RESOLVER_CACHE_GET_PRIVATE(cache);
+
+	g_hash_table_foreach_steal(priv->entries,
+			purple_resolver_cache_clear_entry, NULL);
+}
@@ -0,0 +1,108 @@
+/* Purple is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ */
+
+#ifndef PURPLE_RESOLVER_CACHE_H
+#define PURPLE_RESOLVER_CACHE_H
+/**
+ * SECTION:resolvercache
+ * @section_id: libpurple-resolvercache
+ * @short_description: <filename>resolvercache.h</filename>
+ * @title: Resolver Cache
+ *
+ * A resolver cache is a #GResolver that remembers the answers of another
+ * resolver.  libpurple installs one as the default resolver when the network
+ * subsystem starts, so every host name lookup made through GIO, whether
+ * directly or by a #GSocketClient, shares the same cache: accounts on the
+ * same server, HTTP requests and STUN lookups don't resolve the same names
+ * over and over.
+ *
+ * Host name and SRV lookups are cached.  Lookups for a name that is already
+ * being resolved wait for that answer instead of starting another.  A name
+ * that doesn't exist is remembered for a shorter time than one that does,
+ * and a name that is used near the end of its lifetime is resolved again in
+ * the background, so busy names never go stale.  Temporary failures are
+ * never cached.
+ */
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#define PURPLE_TYPE_RESOLVER_CACHE            (purple_resolver_cache_get_type())
+#define PURPLE_RESOLVER_CACHE(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj), PURPLE_TYPE_RESOLVER_CACHE, PurpleResolverCache))
+#define PURPLE_RESOLVER_CACHE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass), PURPLE_TYPE_RESOLVER_CACHE, PurpleResolverCacheClass))
+#define PURPLE_IS_RESOLVER_CACHE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj), PURPLE_TYPE_RESOLVER_CACHE))
+#define PURPLE_IS_RESOLVER_CACHE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass), PURPLE_TYPE_RESOLVER_CACHE))
+#define PURPLE_RESOLVER_CACHE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj), PURPLE_TYPE_RESOLVER_CACHE, PurpleResolverCacheClass))
+
+typedef struct _PurpleResolverCache           PurpleResolverCache;
+typedef struct _PurpleResolverCacheClass      PurpleResolverCacheClass;
+
+struct _PurpleResolverCache {
+	/*< private >*/
+	GResolver parent;
+};
+
+struct _PurpleResolverCacheClass {
+	/*< private >*/
+	GResolverClass parent;
+
+	void (*purple_reserved1)(void);
+	void (*purple_reserved2)(void);
+	void (*purple_reserved3)(void);
+	void (*purple_reserved4)(void);
+};
+
+G_BEGIN_DECLS
+
+GType purple_resolver_cache_get_type(void);
+
+/**
+ * purple_resolver_cache_new:
+ * @resolver: The resolver that does the actual lookups.
+ *
+ * Creates a new resolver cache in front of @resolver.
+ *
+ * Returns: The new resolver cache.
+ */
+GResolver *purple_resolver_cache_new(GResolver *resolver);
+
+/**
+ * purple_resolver_cache_set_ttl:
+ * @cache:        The resolver cache.
+ * @ttl:          How many seconds to remember names that were found.
+ * @negative_ttl: How many seconds to remember names that don't exist.
+ *
+ * Sets how long answers are kept.  The system resolver doesn't tell us the
+ * TTLs of the records it looked up, so these apply to every answer.
+ * Answers that are already cached keep their old lifetime.
+ */
+void purple_resolver_cache_set_ttl(PurpleResolverCache *cache, guint ttl, guint negative_ttl);
+
+/**
+ * purple_resolver_cache_clear:
+ * @cache: The resolver cache.
+ *
+ * Forgets every cached answer, for example because the network changed.
+ * Lookups that are in progress still complete.
+ */
+void purple_resolver_cache_clear(PurpleResolverCache *cache);
+
+G_END_DECLS
+
+#endif /* PURPLE_RESOLVER_CACHE_H */
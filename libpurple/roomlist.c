@@ -25,9 +25,16 @@
 #include "account.h"
 #include "connection.h"
 #include "debug.h"
+#include "eventloop.h"
 #include "roomlist.h"
 #include "server.h"
 
+/* How often, in milliseconds, and how many rooms at a time are handed to a
+ * UI that takes them in batches.  Big servers list tens of thousands of
+ * rooms in a few seconds, faster than a UI can show them. */
+#define ROOMLIST_BATCH_INTERVAL 250
+#define ROOMLIST_BATCH_SIZE     1000
+
 #define PURPLE_ROOMLIST_GET_PRIVATE(obj) \
 	(G_TYPE_INSTANCE_GET_PRIVATE((obj), PURPLE_TYPE_ROOMLIST, PurpleRoomlistPrivate))
 
@@ -39,9 +46,16 @@ typedef struct _PurpleRoomlistPrivate  PurpleRoomlistPrivate;
 struct _PurpleRoomlistPrivate {
 	PurpleAccount *account;  /* The account this list belongs to. */
 	GList *fields;           /* The fields.                       */
-	GList *rooms;            /* The list of rooms.                */
+	GPtrArray *rooms;        /* The list of rooms.                */
 	gboolean in_progress;    /* The listing is in progress.       */
 
+	gchar *filter;           /* Only rooms matching this are shown. */
+	gchar *folded_filter;    /* The casefolded filter.            */
+	GQueue pending;          /* Rooms the UI hasn't been given.   */
+	guint batch_timer;       /* Hands the pending rooms to the UI. */
+	gboolean done_pending;   /* The UI hasn't been told the listing
+	                            is done, because of pending rooms. */
+
 	/* TODO Remove this and use protocol-specific subclasses. */
 	gpointer proto_data;     /* Protocol private data.             */
 };
@@ -52,6 +66,7 @@ struct _PurpleRoomlistPrivate {
 struct _PurpleRoomlistRoom {
 	PurpleRoomlistRoomType type; /* The type of room. */
 	gchar *name; /* The name of the room. */
+	gchar *folded_name; /* The casefolded name, made on first use. */
 	GList *fields; /* Other fields. */
 	PurpleRoomlistRoom *parent; /* The parent room, or NULL. */
 	gboolean expanded_once; /* A flag the UI uses to avoid multiple expand protocol cbs. */
@@ -125,7 +140,10 @@ void purple_roomlist_set_in_progress(PurpleRoomlist *list, gboolean in_progress)
 
 	priv->in_progress = in_progress;
 
-	if (ops && ops->in_progress)
+	/* Wait until the UI has every room before saying we're done. */
+	priv->done_pending = (!in_progress && priv->batch_timer != 0);
+
+	if (!priv->done_pending && ops && ops->in_progress)
 		ops->in_progress(list, in_progress);
 
 	g_object_notify_by_pspec(G_OBJECT(list), properties[PROP_IN_PROGRESS]);
@@ -140,6 +158,73 @@ gboolean purple_roomlist_get_in_progress(PurpleRoomlist *list)
 	return priv->in_progress;
 }
 
+static gboolean
+purple_roomlist_room_matches(PurpleRoomlistPrivate *priv, PurpleRoomlistRoom *room)
+{
+	if (priv->folded_filter == NULL ||
+			(room->type & PURPLE_ROOMLIST_ROOMTYPE_CATEGORY))
+		return TRUE;
+
+	/* The filter may be changed many times over the same rooms. */
+	if (room->folded_name == NULL)
+		room->folded_name = g_utf8_casefold(room->name, -1);
+
+	return (strstr(room->folded_name, priv->folded_filter) != NULL);
+}
+
+static gboolean
+purple_roomlist_batch_cb(gpointer data)
+{
+	PurpleRoomlist *list = data;
+	PurpleRoomlistPrivate *priv = PURPLE_ROOMLIST_GET_PRIVATE(list);
+	GList *rooms = NULL;
+	int i;
+
+	for (i = 0; i < ROOMLIST_BATCH_SIZE && !g_queue_is_empty(&priv->pending); i++)
+		rooms = g_list_prepend(rooms, g_queue_pop_head(&priv->pending));
+	rooms = g_list_reverse(rooms);
+
+	if (rooms && ops && ops->add_rooms)
+		ops->add_rooms(list, rooms);
+	g_list_free(rooms);
+
+	if (!g_queue_is_empty(&priv->pending))
+		return TRUE;
+
+	priv->batch_timer = 0;
+
+	if (priv->done_pending) {
+		priv->done_pending = FALSE;
+		if (ops && ops->in_progress)
+			ops->in_progress(list, FALSE);
+	}
+
+	g_object_unref(list);
+
+	return FALSE;
+}
+
+/* Hands a room to the UI, right away or with the next batch. */
+static void
+purple_roomlist_room_show(PurpleRoomlist *list, PurpleRoomlistRoom *room)
+{
+	PurpleRoomlistPrivate *priv = PURPLE_ROOMLIST_GET_PRIVATE(list);
+
+	if (!ops || !ops->add_rooms) {
+		if (ops && ops->add_room)
+			ops->add_room(list, room);
+		return;
+	}
+
+	g_queue_push_tail(&priv->pending, room);
+
+	/* The timer holds a reference, so the UI gets every room even if the
+	 * protocol is done with the list. */
+	if (priv->batch_timer == 0)
+		priv->batch_timer = purple_timeout_add(ROOMLIST_BATCH_INTERVAL,
+				purple_roomlist_batch_cb, g_object_ref(list));
+}
+
 void purple_roomlist_room_add(PurpleRoomlist *list, PurpleRoomlistRoom *room)
 {
 	PurpleRoomlistPrivate *priv = PURPLE_ROOMLIST_GET_PRIVATE(list);
@@ -147,10 +232,61 @@ void purple_roomlist_room_add(PurpleRoomlist *list, PurpleRoomlistRoom *room)
 	g_return_if_fail(priv != NULL);
 	g_return_if_fail(room != NULL);
 
-	priv->rooms = g_list_append(priv->rooms, room);
+	if (priv->rooms == NULL)
+		priv->rooms = g_ptr_array_new();
+	g_ptr_array_add(priv->rooms, room);
 
-	if (ops && ops->add_room)
-		ops->add_room(list, room);
+	if (purple_roomlist_room_matches(priv, room))
+		purple_roomlist_room_show(list, room);
+}
+
+void purple_roomlist_set_filter(PurpleRoomlist *list, const gchar *filter)
+{
+	PurpleRoomlistPrivate *priv = PURPLE_ROOMLIST_GET_PRIVATE(list);
+	gchar *folded = NULL;
+	guint i;
+
+	g_return_if_fail(priv != NULL);
+
+	if (filter != NULL && *filter != '\0')
+		folded = g_utf8_casefold(filter, -1);
+
+	if (g_strcmp0(folded, priv->folded_filter) == 0) {
+		g_free(folded);
+		return;
+	}
+
+	g_free(priv->filter);
+	g_free(priv->folded_filter);
+	priv->filter = folded ? g_strdup(filter) : NULL;
+	priv->folded_filter = folded;
+
+	/* Without a way to take back what the UI was given, the new filter
+	 * only applies to rooms added from now on. */
+	if (priv->rooms == NULL || !ops || !ops->clear)
+		return;
+
+	/* Start over with the rooms matching the new filter.  If the listing
+	 * is done but the UI hasn't been told, that still happens once the
+	 * new batches are handed over. */
+	g_queue_clear(&priv->pending);
+	ops->clear(list);
+
+	for (i = 0; i < priv->rooms->len; i++) {
+		PurpleRoomlistRoom *room = g_ptr_array_index(priv->rooms, i);
+
+		if (purple_roomlist_room_matches(priv, room))
+			purple_roomlist_room_show(list, room);
+	}
+}
+
+const gchar *purple_roomlist_get_filter(PurpleRoomlist *list)
+{
+	PurpleRoomlistPrivate *priv = PURPLE_ROOMLIST_GET_PRIVATE(list);
+
+	g_return_val_if_fail(priv != NULL, NULL);
+
+	return priv->filter;
 }
 
 PurpleRoomlist *purple_roomlist_get_list(PurpleConnection *gc)
@@ -168,6 +304,34 @@ PurpleRoomlist *purple_roomlist_get_list(PurpleConnection *gc)
 	return NULL;
 }
 
+PurpleRoomlist *purple_roomlist_get_list_filtered(PurpleConnection *gc,
+		const gchar *filter)
+{
+	PurpleProtocol *protocol = NULL;
+	PurpleRoomlist *list;
+
+	g_return_val_if_fail(PURPLE_IS_CONNECTION(gc), NULL);
+	g_return_val_if_fail(PURPLE_CONNECTION_IS_CONNECTED(gc), NULL);
+
+	if (filter == NULL || *filter == '\0')
+		return purple_roomlist_get_list(gc);
+
+	protocol = purple_connection_get_protocol(gc);
+	if (!protocol)
+		return NULL;
+
+	if (PURPLE_PROTOCOL_IMPLEMENTS(protocol, ROOMLIST_IFACE, get_list_filtered))
+		list = purple_protocol_roomlist_iface_get_list_filtered(protocol, gc, filter);
+	else
+		list = purple_protocol_roomlist_iface_get_list(protocol, gc);
+
+	/* The server's idea of a match may be looser than ours. */
+	if (list != NULL)
+		purple_roomlist_set_filter(list, filter);
+
+	return list;
+}
+
 void purple_roomlist_cancel_get_list(PurpleRoomlist *list)
 {
 	PurpleRoomlistPrivate *priv = PURPLE_ROOMLIST_GET_PRIVATE(list);
@@ -176,12 +340,33 @@ void purple_roomlist_cancel_get_list(PurpleRoomlist *list)
 
 	g_return_if_fail(priv != NULL);
 
+	/* The UI doesn't want the rooms it hasn't been given yet. */
+	g_queue_clear(&priv->pending);
+	if (priv->batch_timer) {
+		purple_timeout_remove(priv->batch_timer);
+		priv->batch_timer = 0;
+
+		if (priv->done_pending) {
+			priv->done_pending = FALSE;
+			if (ops && ops->in_progress)
+				ops->in_progress(list, FALSE);
+		}
+
+		/* The timer's reference; the UI cancelling holds its own. */
+		g_object_unref(list);
+	}
+
+	/* The account may have gone offline since; there's nothing left for
+	 * the protocol to stop then. */
+	if (priv->account == NULL)
+		return;
 	gc = purple_account_get_connection(priv->account);
+	if (gc == NULL)
+		return;
 
 	g_return_if_fail(PURPLE_IS_CONNECTION(gc));
 
-	if(gc)
-		protocol = purple_connection_get_protocol(gc);
+	protocol = purple_connection_get_protocol(gc);
 
 	if(protocol)
 		purple_protocol_roomlist_iface_cancel(protocol, list);
@@ -317,18 +502,25 @@ purple_roomlist_finalize(GObject *object)
 {
 	PurpleRoomlist *list = PURPLE_ROOMLIST(object);
 	PurpleRoomlistPrivate *priv = PURPLE_ROOMLIST_GET_PRIVATE(list);
-	GList *l;
+	guint i;
 
 	purple_debug_misc("roomlist", "destroying list %p\n", list);
 
+	if (priv->batch_timer)
+		purple_timeout_remove(priv->batch_timer);
+	g_queue_clear(&priv->pending);
+
 	if (ops && ops->destroy)
 		ops->destroy(list);
 
-	for (l = priv->rooms; l; l = l->next) {
-		PurpleRoomlistRoom *r = l->data;
-		purple_roomlist_room_destroy(list, r);
+	if (priv->rooms != NULL) {
+		for (i = 0; i < priv->rooms->len; i++)
+			purple_roomlist_room_destroy(list, g_ptr_array_index(priv->rooms, i));
+		g_ptr_array_free(priv->rooms, TRUE);
 	}
-	g_list_free(priv->rooms);
+
+	g_free(priv->filter);
+	g_free(priv->folded_filter);
 
 	g_list_foreach(priv->fields, (GFunc)purple_roomlist_field_free, NULL);
 	g_list_free(priv->fields);
@@ -549,6 +741,7 @@ static void purple_roomlist_room_destroy(PurpleRoomlist *list, PurpleRoomlistRoo
 
 	g_list_free(r->fields);
 	g_free(r->name);
+	g_free(r->folded_name);
 	g_free(r);
 }
 
@@ -569,6 +762,7 @@ static void purple_roomlist_room_free(PurpleRoomlistRoom *r)
 
 	g_list_free(r->fields);
 	g_free(r->name);
+	g_free(r->folded_name);
 	g_free(r);
 }
 
@@ -97,6 +97,15 @@ typedef enum
  * @add_room:          Add a room to the list.
  * @in_progress:       Are we fetching stuff still?
  * @destroy:           We're destroying list.
+ * @add_rooms:         Add several rooms to the list at once. If this field is
+ *                     %NULL, libpurple will fall back to calling @add_room
+ *                     for each room as soon as it's added. Otherwise rooms
+ *                     are handed over a batch at a time, and @in_progress is
+ *                     only told the list is done once every room was added.
+ * @clear:             Remove every room the UI was given, because the filter
+ *                     changed.  The rooms matching the new filter are added
+ *                     again right after.  If this field is %NULL, a new
+ *                     filter only applies to the rooms added afterwards.
  *
  * The room list ops to be filled out by the UI.
  */
@@ -108,9 +117,10 @@ struct _PurpleRoomlistUiOps {
 	void (*in_progress)(PurpleRoomlist *list, gboolean flag);
 	void (*destroy)(PurpleRoomlist *list);
 
+	void (*add_rooms)(PurpleRoomlist *list, GList *rooms);
+	void (*clear)(PurpleRoomlist *list);
+
 	/*< private >*/
-	void (*_purple_reserved1)(void);
-	void (*_purple_reserved2)(void);
 	void (*_purple_reserved3)(void);
 	void (*_purple_reserved4)(void);
 };
@@ -232,10 +242,36 @@ gboolean purple_roomlist_get_in_progress(PurpleRoomlist *list);
  * @room: The room to add to the list. The GList of fields must be in the same
                order as was given in purple_roomlist_set_fields().
  *
- * Adds a room to the list of them.
+ * Adds a room to the list of them.  Rooms that don't match the filter of the
+ * list are kept, but not shown.
 */
 void purple_roomlist_room_add(PurpleRoomlist *list, PurpleRoomlistRoom *room);
 
+/**
+ * purple_roomlist_set_filter:
+ * @list:   The room list.
+ * @filter: Only rooms whose name contains this, ignoring case, are shown,
+ *          or %NULL to show every room.
+ *
+ * Sets the filter of a room list.  Categories are always shown.  If the UI
+ * implements the clear op, the rooms already in the list are filtered again
+ * and the matching ones handed to the UI, so the filter can follow what the
+ * user types.  Rooms the server never sent because the list was fetched with
+ * purple_roomlist_get_list_filtered() can't come back this way; get the list
+ * again for those.
+ */
+void purple_roomlist_set_filter(PurpleRoomlist *list, const gchar *filter);
+
+/**
+ * purple_roomlist_get_filter:
+ * @list: The room list.
+ *
+ * Returns the filter of a room list.
+ *
+ * Returns: The filter, or %NULL if every room is shown.
+ */
+const gchar *purple_roomlist_get_filter(PurpleRoomlist *list);
+
 /**
  * purple_roomlist_get_list:
  * @gc: The PurpleConnection to have get a list.
@@ -248,6 +284,22 @@ void purple_roomlist_room_add(PurpleRoomlist *list, PurpleRoomlistRoom *room);
  */
 PurpleRoomlist *purple_roomlist_get_list(PurpleConnection *gc);
 
+/**
+ * purple_roomlist_get_list_filtered:
+ * @gc:     The PurpleConnection to have get a list.
+ * @filter: Only list the rooms whose name contains this, or %NULL.
+ *
+ * Like purple_roomlist_get_list(), but only the rooms matching @filter are
+ * shown.  Protocols that can have the server do the filtering are asked to,
+ * so the rooms that don't match are never sent.  Otherwise the list is
+ * filtered as it arrives.  See purple_roomlist_set_filter().
+ *
+ * Returns: A PurpleRoomlist* or %NULL if the protocol
+ *         doesn't support that.
+ */
+PurpleRoomlist *purple_roomlist_get_list_filtered(PurpleConnection *gc,
+		const gchar *filter);
+
 /**
  * purple_roomlist_cancel_get_list:
  * @list: The room list to cancel a get_list on.
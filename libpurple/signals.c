@@ -52,6 +52,10 @@ typedef struct
 	size_t handler_count;
 
 	gulong next_handler_id;
+
+#ifdef HAVE_DBUS
+	PurpleDBusSignal *dbus_signal;
+#endif
 } PurpleSignalData;
 
 typedef struct
@@ -136,6 +140,10 @@ purple_signal_register(void *instance, const char *signal,
 		va_end(args);
 	}
 
+#ifdef HAVE_DBUS
+	signal_data->dbus_signal = purple_dbus_signal_lookup(signal);
+#endif
+
 	g_hash_table_insert(instance_data->signals,
 						g_strdup(signal), signal_data);
 
@@ -468,8 +476,8 @@ purple_signal_emit_vargs(void *instance, const char *signal, va_list args)
 	}
 
 #ifdef HAVE_DBUS
-	purple_dbus_signal_emit_purple(signal, signal_data->num_values,
-				   signal_data->value_types, args);
+	purple_dbus_signal_emit(signal_data->dbus_signal,
+				   signal_data->num_values, signal_data->value_types, args);
 #endif	/* HAVE_DBUS */
 
 }
@@ -519,10 +527,12 @@ purple_signal_emit_vargs_return_1(void *instance, const char *signal,
 	}
 
 #ifdef HAVE_DBUS
-	G_VA_COPY(tmp, args);
-	purple_dbus_signal_emit_purple(signal, signal_data->num_values,
-				   signal_data->value_types, tmp);
-	va_end(tmp);
+	if (purple_dbus_signal_is_wanted(signal_data->dbus_signal)) {
+		G_VA_COPY(tmp, args);
+		purple_dbus_signal_emit(signal_data->dbus_signal,
+					   signal_data->num_values, signal_data->value_types, tmp);
+		va_end(tmp);
+	}
 #endif	/* HAVE_DBUS */
 
 	for (l = signal_data->handlers; l != NULL; l = l_next)
@@ -30,6 +30,186 @@
 
 #define CONNECTION_CLOSE_TIMEOUT 15
 
+/* How long to offer a server the session from our last connection to it */
+#define SESSION_LIFETIME 3600
+
+/* How many servers to remember sessions for */
+#define MAX_SESSIONS 64
+
+typedef struct
+{
+	GTlsConnection *state;  /* An unconnected copy of the session state. */
+	gint64 stored;          /* When it was stored, in monotonic time. */
+} PurpleSslSession;
+
+/* "host:port" -> PurpleSslSession */
+static GHashTable *sessions = NULL;
+
+static guint handshakes_resumed = 0;
+static guint handshakes_full = 0;
+
+/**************************************************************************
+ * Session cache
+ **************************************************************************/
+
+static void
+ssl_session_free(gpointer data)
+{
+	PurpleSslSession *session = data;
+
+	g_object_unref(session->state);
+	g_free(session);
+}
+
+static gchar *
+ssl_session_key(PurpleSslConnection *gsc)
+{
+	return g_strdup_printf("%s:%d", gsc->host, gsc->port);
+}
+
+/*
+ * Offer the server the session from our last connection to it, so the
+ * handshake can skip the key exchange and certificate checks.
+ */
+static void
+ssl_session_resume(PurpleSslConnection *gsc, GTlsConnection *tls_conn)
+{
+#if GLIB_CHECK_VERSION(2,46,0)
+	PurpleSslSession *session;
+	gchar *key;
+
+	if (sessions == NULL || gsc->host == NULL)
+		return;
+
+	key = ssl_session_key(gsc);
+	session = g_hash_table_lookup(sessions, key);
+
+	if (session != NULL &&
+		g_get_monotonic_time() - session->stored > SESSION_LIFETIME * G_USEC_PER_SEC)
+	{
+		g_hash_table_remove(sessions, key);
+		session = NULL;
+	}
+
+	if (session != NULL) {
+		g_tls_client_connection_copy_session_state(
+				G_TLS_CLIENT_CONNECTION(tls_conn),
+				G_TLS_CLIENT_CONNECTION(session->state));
+		g_object_set_data(G_OBJECT(tls_conn), "purple-ssl-resumed",
+				GINT_TO_POINTER(TRUE));
+	}
+
+	g_free(key);
+#endif
+}
+
+#if GLIB_CHECK_VERSION(2,46,0)
+/*
+ * Copy the session state of a connection into one that isn't connected to
+ * anything, so the cache doesn't keep the socket and its buffers alive.
+ */
+static GTlsConnection *
+ssl_session_state_new(PurpleSslConnection *gsc)
+{
+	GInputStream *input;
+	GOutputStream *output;
+	GIOStream *stream;
+	GSocketConnectable *identity;
+	GIOStream *state;
+	GError *error = NULL;
+
+	input = g_memory_input_stream_new();
+	output = g_memory_output_stream_new_resizable();
+	stream = g_simple_io_stream_new(input, output);
+	g_object_unref(input);
+	g_object_unref(output);
+
+	identity = g_network_address_new(gsc->host, gsc->port);
+	state = g_tls_client_connection_new(stream, identity, &error);
+	g_object_unref(identity);
+	g_object_unref(stream);
+
+	if (state == NULL) {
+		purple_debug_warning("sslconn",
+				"Error creating TLS session state: %s\n",
+				error->message);
+		g_clear_error(&error);
+		return NULL;
+	}
+
+	g_tls_client_connection_copy_session_state(
+			G_TLS_CLIENT_CONNECTION(state),
+			G_TLS_CLIENT_CONNECTION(gsc->conn));
+
+	return G_TLS_CONNECTION(state);
+}
+#endif
+
+static void
+ssl_session_store(PurpleSslConnection *gsc)
+{
+#if GLIB_CHECK_VERSION(2,46,0)
+	PurpleSslSession *session;
+	GTlsConnection *state;
+#endif
+	gboolean resumed;
+
+	resumed = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(gsc->conn),
+			"purple-ssl-resumed"));
+	if (resumed)
+		handshakes_resumed++;
+	else
+		handshakes_full++;
+
+	purple_debug_info("sslconn", "%s handshake with %s:%d done "
+			"(%u resumed, %u full so far)\n",
+			resumed ? "Resumed" : "Full", gsc->host ? gsc->host : "",
+			gsc->port, handshakes_resumed, handshakes_full);
+
+#if GLIB_CHECK_VERSION(2,46,0)
+	if (sessions == NULL || gsc->host == NULL)
+		return;
+
+	state = ssl_session_state_new(gsc);
+	if (state == NULL)
+		return;
+
+	if (g_hash_table_size(sessions) >= MAX_SESSIONS) {
+		GHashTableIter iter;
+		gpointer key, value, oldest_key = NULL;
+		gint64 oldest = G_MAXINT64;
+
+		g_hash_table_iter_init(&iter, sessions);
+		while (g_hash_table_iter_next(&iter, &key, &value)) {
+			session = value;
+			if (session->stored < oldest) {
+				oldest = session->stored;
+				oldest_key = key;
+			}
+		}
+		g_hash_table_remove(sessions, oldest_key);
+	}
+
+	session = g_new0(PurpleSslSession, 1);
+	session->state = state;
+	session->stored = g_get_monotonic_time();
+	g_hash_table_replace(sessions, ssl_session_key(gsc), session);
+#endif
+}
+
+static void
+ssl_session_forget(PurpleSslConnection *gsc)
+{
+	gchar *key;
+
+	if (sessions == NULL || gsc->host == NULL)
+		return;
+
+	key = ssl_session_key(gsc);
+	g_hash_table_remove(sessions, key);
+	g_free(key);
+}
+
 static void
 emit_error(PurpleSslConnection *gsc, int error_code)
 {
@@ -48,7 +228,12 @@ tls_handshake_cb(GObject *source, GAsyncResult *res, gpointer user_data)
 		if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
 			/* Connection already closed/freed. Escape. */
 			return;
-		} else if (g_error_matches(error, G_TLS_ERROR,
+		}
+
+		/* Don't offer a session the server may have choked on again */
+		ssl_session_forget(gsc);
+
+		if (g_error_matches(error, G_TLS_ERROR,
 				G_TLS_ERROR_HANDSHAKE)) {
 			/* In Gio, a handshake error is because of the cert */
 			emit_error(gsc, PURPLE_SSL_CERTIFICATE_INVALID);
@@ -61,6 +246,8 @@ tls_handshake_cb(GObject *source, GAsyncResult *res, gpointer user_data)
 		return;
 	}
 
+	ssl_session_store(gsc);
+
 	gsc->connect_cb(gsc->connect_cb_data, gsc, PURPLE_INPUT_READ);
 }
 
@@ -105,6 +292,7 @@ tls_connect(PurpleSslConnection *gsc)
 	gsc->cancellable = g_cancellable_new();
 
 	purple_tls_certificate_attach_to_tls_connection(gsc->conn);
+	ssl_session_resume(gsc, gsc->conn);
 
 	g_tls_connection_handshake_async(gsc->conn, G_PRIORITY_DEFAULT,
 			gsc->cancellable, tls_handshake_cb, gsc);
@@ -404,3 +592,25 @@ purple_ssl_get_peer_certificates(PurpleSslConnection *gsc)
 	return certificate != NULL ? g_list_append(NULL, certificate) : NULL;
 }
 
+void
+purple_ssl_get_session_stats(guint *resumed, guint *full)
+{
+	if (resumed != NULL)
+		*resumed = handshakes_resumed;
+	if (full != NULL)
+		*full = handshakes_full;
+}
+
+void
+purple_ssl_init(void)
+{
+	sessions = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+			ssl_session_free);
+}
+
+void
+purple_ssl_uninit(void)
+{
+	g_hash_table_destroy(sessions);
+	sessions = NULL;
+}
@@ -239,6 +239,19 @@ size_t purple_ssl_write(PurpleSslConnection *gsc, const void *buffer, size_t len
  */
 GList * purple_ssl_get_peer_certificates(PurpleSslConnection *gsc);
 
+/**
+ * purple_ssl_get_session_stats:
+ * @resumed: Return location for the number of resumed handshakes, or %NULL.
+ * @full:    Return location for the number of full handshakes, or %NULL.
+ *
+ * Connections to a server we've recently connected to offer it the previous
+ * session, so the handshake can be abbreviated.  This counts the successful
+ * handshakes that offered a session and those that didn't.  GIO doesn't say
+ * whether the server accepted the session, so a server that turns it down
+ * still counts as resumed.
+ */
+void purple_ssl_get_session_stats(guint *resumed, guint *full);
+
 /**************************************************************************/
 /* Subsystem API                                                          */
 /**************************************************************************/
@@ -25,9 +25,11 @@
 #include "core.h"
 #include "dbus-maybe.h"
 #include "debug.h"
+#include "eventloop.h"
 #include "notify.h"
 #include "prefs.h"
 #include "status.h"
+#include "util.h"
 
 #define PURPLE_STATUS_GET_PRIVATE(obj) \
 	(G_TYPE_INSTANCE_GET_PRIVATE((obj), PURPLE_TYPE_STATUS, PurpleStatusPrivate))
@@ -550,6 +552,274 @@ notify_buddy_status_update(PurpleBuddy *buddy, PurplePresence *presence,
 	}
 }
 
+/**************************************************************************
+ * Buddy presence coalescing
+ *
+ * Protocols report presence one buddy at a time, and on a reconnect they
+ * often report the same buddy several times within a second.  When
+ * /purple/status/coalesce/window is set, the notifications for a buddy
+ * (the system log lines, the buddy list signals and the UI update) are held
+ * back until that buddy has been quiet for that many milliseconds, and are
+ * then sent once for the final state.  No buddy is held back for more than
+ * /purple/status/coalesce/max_delay milliseconds.  The presence itself is
+ * always updated right away; only the notifications wait.
+ **************************************************************************/
+typedef struct
+{
+	PurpleBuddy *buddy;
+
+	/* The status that was active before the first deferred log line. */
+	gboolean log_exclusive;
+	PurpleStatus *log_old_status;
+	/* Independent statuses that were toggled, in order. */
+	GList *log_independent;
+
+	/* The old status for purple_buddy_update_status(). */
+	gboolean status_changed;
+	PurpleStatus *old_status;
+
+	/* Whether the buddy was idle before the first idle change. */
+	gboolean idle_changed;
+	gboolean old_idle;
+
+	gint64 first_change;
+	gint64 last_change;
+	guint timer;
+} PurpleStatusCoalesce;
+
+static GHashTable *coalesce_pending = NULL;
+static guint coalesce_window = 0;
+static guint coalesce_max_delay = 0;
+static gboolean coalesce_flushing = FALSE;
+
+static void
+coalesce_free(PurpleStatusCoalesce *pending)
+{
+	if (pending->timer != 0)
+		purple_timeout_remove(pending->timer);
+
+	g_list_free(pending->log_independent);
+	g_free(pending);
+}
+
+static void
+coalesce_flush(PurpleStatusCoalesce *pending)
+{
+	PurpleBuddy *buddy = pending->buddy;
+	PurplePresence *presence = purple_buddy_get_presence(buddy);
+	GList *l;
+
+	g_hash_table_remove(coalesce_pending, buddy);
+
+	coalesce_flushing = TRUE;
+
+	if (pending->log_exclusive) {
+		PurpleStatus *new_status = purple_presence_get_active_status(presence);
+
+		/* Nothing to say if the buddy ended up where they started. */
+		if (new_status != pending->log_old_status)
+			notify_buddy_status_update(buddy, presence,
+					pending->log_old_status, new_status);
+	}
+
+	for (l = pending->log_independent; l != NULL; l = l->next)
+		notify_buddy_status_update(buddy, presence, NULL, l->data);
+
+	if (pending->status_changed)
+		purple_buddy_update_status(buddy, pending->old_status);
+
+	if (pending->idle_changed) {
+		PurplePresenceClass *klass = PURPLE_PRESENCE_GET_CLASS(presence);
+
+		if (klass->update_idle)
+			klass->update_idle(presence, pending->old_idle);
+	}
+
+	coalesce_flushing = FALSE;
+
+	coalesce_free(pending);
+}
+
+static gboolean
+coalesce_timeout_cb(gpointer data)
+{
+	PurpleStatusCoalesce *pending = data;
+	gint64 deadline, now;
+
+	pending->timer = 0;
+
+	deadline = MIN(pending->last_change + coalesce_window * G_GINT64_CONSTANT(1000),
+	               pending->first_change + coalesce_max_delay * G_GINT64_CONSTANT(1000));
+	now = g_get_monotonic_time();
+
+	if (now < deadline) {
+		/* The buddy changed again since the timer was set. */
+		pending->timer = purple_timeout_add((deadline - now + 999) / 1000,
+				coalesce_timeout_cb, pending);
+	} else {
+		coalesce_flush(pending);
+	}
+
+	return FALSE;
+}
+
+static gboolean
+coalesce_is_own_buddy(PurpleBuddy *buddy)
+{
+	PurpleAccount *account = purple_buddy_get_account(buddy);
+	gchar *own;
+	gboolean ret;
+
+	own = g_strdup(purple_normalize(account,
+			purple_account_get_username(account)));
+	ret = purple_strequal(own,
+			purple_normalize(account, purple_buddy_get_name(buddy)));
+	g_free(own);
+
+	return ret;
+}
+
+/*
+ * Returns the pending notifications for @buddy, or NULL if they should be
+ * sent right away.
+ */
+static PurpleStatusCoalesce *
+coalesce_get(PurpleBuddy *buddy)
+{
+	PurpleStatusCoalesce *pending;
+
+	if (coalesce_window == 0 || coalesce_flushing || coalesce_pending == NULL)
+		return NULL;
+
+	pending = g_hash_table_lookup(coalesce_pending, buddy);
+	if (pending == NULL) {
+		/* Our own status is never held back. */
+		if (coalesce_is_own_buddy(buddy))
+			return NULL;
+
+		pending = g_new0(PurpleStatusCoalesce, 1);
+		pending->buddy = buddy;
+		pending->first_change = g_get_monotonic_time();
+		pending->timer = purple_timeout_add(MIN(coalesce_window, coalesce_max_delay),
+				coalesce_timeout_cb, pending);
+		g_hash_table_insert(coalesce_pending, buddy, pending);
+	}
+
+	pending->last_change = g_get_monotonic_time();
+
+	return pending;
+}
+
+static gboolean
+coalesce_buddy_log(PurpleBuddy *buddy, PurpleStatus *old_status,
+		PurpleStatus *new_status)
+{
+	PurpleStatusCoalesce *pending = coalesce_get(buddy);
+
+	if (pending == NULL)
+		return FALSE;
+
+	if (purple_status_is_exclusive(new_status)) {
+		if (!pending->log_exclusive) {
+			pending->log_exclusive = TRUE;
+			pending->log_old_status = old_status;
+		}
+	} else if (!g_list_find(pending->log_independent, new_status)) {
+		pending->log_independent = g_list_append(pending->log_independent,
+				new_status);
+	}
+
+	return TRUE;
+}
+
+gboolean
+_purple_statuses_coalesce_buddy_status(PurpleBuddy *buddy,
+		PurpleStatus *old_status)
+{
+	PurpleStatusCoalesce *pending = coalesce_get(buddy);
+
+	if (pending == NULL)
+		return FALSE;
+
+	if (!pending->status_changed) {
+		pending->status_changed = TRUE;
+		pending->old_status = old_status;
+	}
+
+	/* Keep the contact's priority buddy right in the meantime. */
+	purple_contact_invalidate_priority_buddy(purple_buddy_get_contact(buddy));
+
+	return TRUE;
+}
+
+gboolean
+_purple_statuses_coalesce_buddy_idle(PurpleBuddy *buddy, gboolean old_idle)
+{
+	PurpleStatusCoalesce *pending = coalesce_get(buddy);
+
+	if (pending == NULL)
+		return FALSE;
+
+	if (!pending->idle_changed) {
+		pending->idle_changed = TRUE;
+		pending->old_idle = old_idle;
+	}
+
+	purple_contact_invalidate_priority_buddy(purple_buddy_get_contact(buddy));
+
+	return TRUE;
+}
+
+void
+_purple_statuses_flush_buddy(PurpleBuddy *buddy)
+{
+	PurpleStatusCoalesce *pending;
+
+	if (coalesce_pending == NULL)
+		return;
+
+	pending = g_hash_table_lookup(coalesce_pending, buddy);
+	if (pending != NULL)
+		coalesce_flush(pending);
+}
+
+void
+_purple_statuses_flush_account(PurpleAccount *account)
+{
+	GHashTableIter iter;
+	PurpleBuddy *buddy;
+	GList *buddies = NULL;
+
+	if (coalesce_pending == NULL)
+		return;
+
+	g_hash_table_iter_init(&iter, coalesce_pending);
+	while (g_hash_table_iter_next(&iter, (gpointer *)&buddy, NULL)) {
+		if (account == NULL || purple_buddy_get_account(buddy) == account)
+			buddies = g_list_prepend(buddies, buddy);
+	}
+
+	while (buddies != NULL) {
+		_purple_statuses_flush_buddy(buddies->data);
+		buddies = g_list_delete_link(buddies, buddies);
+	}
+}
+
+void
+_purple_statuses_forget_buddy(PurpleBuddy *buddy)
+{
+	PurpleStatusCoalesce *pending;
+
+	if (coalesce_pending == NULL)
+		return;
+
+	pending = g_hash_table_lookup(coalesce_pending, buddy);
+	if (pending != NULL) {
+		g_hash_table_remove(coalesce_pending, buddy);
+		coalesce_free(pending);
+	}
+}
+
 static void
 notify_status_update(PurplePresence *presence, PurpleStatus *old_status,
 					 PurpleStatus *new_status)
@@ -570,9 +840,12 @@ notify_status_update(PurplePresence *presence, PurpleStatus *old_status,
 	}
 	else if (PURPLE_IS_BUDDY_PRESENCE(presence))
 	{
-		notify_buddy_status_update(purple_buddy_presence_get_buddy(
-				PURPLE_BUDDY_PRESENCE(presence)), presence, old_status,
-				new_status);
+		PurpleBuddy *buddy = purple_buddy_presence_get_buddy(
+				PURPLE_BUDDY_PRESENCE(presence));
+
+		if (!coalesce_buddy_log(buddy, old_status, new_status))
+			notify_buddy_status_update(buddy, presence, old_status,
+					new_status);
 	}
 }
 
@@ -1297,6 +1570,18 @@ score_pref_changed_cb(const char *name, PurplePrefType type,
 	primitive_scores[index] = GPOINTER_TO_INT(value);
 }
 
+static void
+coalesce_pref_changed_cb(const char *name, PurplePrefType type,
+					  gconstpointer value, gpointer data)
+{
+	coalesce_window = MAX(purple_prefs_get_int("/purple/status/coalesce/window"), 0);
+	coalesce_max_delay = MAX(purple_prefs_get_int("/purple/status/coalesce/max_delay"), 0);
+
+	/* Don't keep anything waiting for a window that was turned off. */
+	if (coalesce_window == 0)
+		_purple_statuses_flush_account(NULL);
+}
+
 void *
 purple_statuses_get_handle(void) {
 	static int handle;
@@ -1362,10 +1647,33 @@ purple_statuses_init(void)
 	purple_prefs_trigger_callback("/purple/status/scores/idle");
 	purple_prefs_trigger_callback("/purple/status/scores/idle_time");
 	purple_prefs_trigger_callback("/purple/status/scores/offline_msg");
+
+	/* Presence notification coalescing, in milliseconds.  Off by default. */
+	purple_prefs_add_none("/purple/status/coalesce");
+	purple_prefs_add_int("/purple/status/coalesce/window", 0);
+	purple_prefs_add_int("/purple/status/coalesce/max_delay", 2000);
+
+	coalesce_pending = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	purple_prefs_connect_callback(handle, "/purple/status/coalesce/window",
+			coalesce_pref_changed_cb, NULL);
+	purple_prefs_connect_callback(handle, "/purple/status/coalesce/max_delay",
+			coalesce_pref_changed_cb, NULL);
+	purple_prefs_trigger_callback("/purple/status/coalesce/window");
 }
 
 void
 purple_statuses_uninit(void)
 {
+	GHashTableIter iter;
+	PurpleStatusCoalesce *pending;
+
+	/* The buddy list is gone by now, so there is nobody left to tell. */
+	g_hash_table_iter_init(&iter, coalesce_pending);
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&pending))
+		coalesce_free(pending);
+	g_hash_table_destroy(coalesce_pending);
+	coalesce_pending = NULL;
+
 	purple_prefs_disconnect_by_handle(purple_prefs_get_handle());
 }
@@ -0,0 +1,401 @@
+/*
+ * Purple
+ *
+ * Purple is the legal property of its developers, whose names are too
+ * numerous to list here. Please refer to the COPYRIGHT file distributed
+ * with this source distribution
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02111-1301 USA
+ */
+
+#include <glib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <purple.h>
+
+#define MSN_COMMANDS 20000
+#define FLAP_FRAMES 20000
+#define SEED 0x5eed
+
+/******************************************************************************
+ * Replayed traffic
+ *****************************************************************************/
+typedef struct {
+	GString *stream;
+	gsize offset;
+	GRand *rand;
+} TestReplay;
+
+/* Hands out the captured stream in chunks the size a socket read returns */
+static gsize
+test_replay_read(TestReplay *replay, gpointer buf, gsize len) {
+	gsize n = g_rand_int_range(replay->rand, 1, 1461);
+
+	n = MIN(n, len);
+	n = MIN(n, replay->stream->len - replay->offset);
+	memcpy(buf, replay->stream->str + replay->offset, n);
+	replay->offset += n;
+
+	return n;
+}
+
+static void
+test_replay_rewind(TestReplay *replay) {
+	replay->offset = 0;
+	g_rand_set_seed(replay->rand, SEED);
+}
+
+/* Presence lines with the odd message and its payload, like a notification
+ * server sends right after sign on */
+static GString *
+test_framing_buffer_msn_stream(void) {
+	GString *stream = g_string_new(NULL);
+	gchar payload[141];
+	gint i;
+
+	memset(payload, 'x', sizeof(payload) - 1);
+	payload[sizeof(payload) - 1] = '\0';
+
+	for(i = 0; i < MSN_COMMANDS; i++) {
+		if(i % 4 == 0) {
+			g_string_append_printf(stream, "MSG buddy%d@example.com "
+			                       "Buddy %" G_GSIZE_FORMAT "\r\n%s",
+			                       i, strlen(payload), payload);
+		} else {
+			g_string_append_printf(stream, "ILN %d NLN buddy%d@example.com "
+			                       "1 Buddy%%20%d 2789003324\r\n", i, i, i);
+		}
+	}
+
+	return stream;
+}
+
+/* FLAPs with SNAC sized payloads */
+static GString *
+test_framing_buffer_flap_stream(void) {
+	GString *stream = g_string_new(NULL);
+	GRand *rand = g_rand_new_with_seed(SEED);
+	gint i;
+
+	for(i = 0; i < FLAP_FRAMES; i++) {
+		guint16 len = g_rand_int_range(rand, 10, 600);
+		guint8 header[6] = { 0x2a, 0x02, i >> 8, i & 0xff, len >> 8, len & 0xff };
+		gint j;
+
+		g_string_append_len(stream, (const gchar *)header, 6);
+		for(j = 0; j < len; j++)
+			g_string_append_c(stream, j & 0xff);
+	}
+
+	g_rand_free(rand);
+
+	return stream;
+}
+
+/******************************************************************************
+ * MSN
+ *****************************************************************************/
+/* The way the MSN read path framed commands before the framing buffer */
+static guint
+test_framing_buffer_msn_legacy(TestReplay *replay) {
+	gchar *rx_buf = NULL;
+	gint rx_len = 0;
+	gsize payload_len = 0;
+	guint frames = 0;
+	gchar buf[8192];
+	gsize len;
+
+	while((len = test_replay_read(replay, buf, sizeof(buf) - 1)) > 0) {
+		gchar *cur, *end, *old_rx_buf;
+
+		buf[len] = '\0';
+		rx_buf = g_realloc(rx_buf, len + rx_len + 1);
+		memcpy(rx_buf + rx_len, buf, len + 1);
+		rx_len += len;
+
+		end = old_rx_buf = rx_buf;
+		do {
+			cur = end;
+			if(payload_len) {
+				if(payload_len > (gsize)rx_len)
+					break;
+				end += payload_len;
+				rx_len -= payload_len;
+				payload_len = 0;
+			} else {
+				end = strstr(cur, "\r\n");
+				if(end == NULL)
+					break;
+				*end = '\0';
+				end += 2;
+				rx_len -= end - cur;
+				if(g_str_has_prefix(cur, "MSG "))
+					payload_len = 140;
+			}
+			frames++;
+		} while(rx_len > 0);
+
+		rx_buf = (rx_len > 0) ? g_memdup(cur, rx_len) : NULL;
+		g_free(old_rx_buf);
+	}
+
+	g_free(rx_buf);
+
+	return frames;
+}
+
+/* The same as msn_servconn_process_data() */
+static guint
+test_framing_buffer_msn(TestReplay *replay) {
+	PurpleFramingBuffer *rx_buf = purple_framing_buffer_new(8192);
+	gsize payload_len = 0;
+	guint frames = 0;
+	gpointer buf;
+	gsize buflen, len;
+
+	buf = purple_framing_buffer_get_input(rx_buf, &buflen);
+	while((len = test_replay_read(replay, buf, buflen)) > 0) {
+		gssize cur_len;
+		gchar *cur;
+
+		purple_framing_buffer_mark_written(rx_buf, len);
+
+		while(TRUE) {
+			if(payload_len) {
+				if(purple_framing_buffer_peek(rx_buf, payload_len) == NULL)
+					break;
+				cur_len = payload_len;
+				payload_len = 0;
+			} else {
+				cur_len = purple_framing_buffer_find(rx_buf, "\r\n", 2);
+				if(cur_len < 0)
+					break;
+				cur = purple_framing_buffer_peek(rx_buf, cur_len + 2);
+				cur[cur_len] = '\0';
+				if(g_str_has_prefix(cur, "MSG "))
+					payload_len = 140;
+				cur_len += 2;
+			}
+
+			purple_framing_buffer_mark_read(rx_buf, cur_len);
+			frames++;
+		}
+
+		buf = purple_framing_buffer_get_input(rx_buf, &buflen);
+	}
+
+	g_assert_cmpuint(0, ==, purple_framing_buffer_get_used(rx_buf));
+	g_object_unref(rx_buf);
+
+	return frames;
+}
+
+/******************************************************************************
+ * OSCAR
+ *****************************************************************************/
+/* The way flap_connection_recv() read FLAPs before the framing buffer: the
+ * header, then a new buffer for each payload */
+static guint
+test_framing_buffer_flap_legacy(TestReplay *replay) {
+	guint8 header[6];
+	guint frames = 0;
+
+	while(test_replay_read(replay, header, 1) == 1) {
+		gsize header_received = 1;
+		guint8 *data;
+		gsize len, offset = 0;
+
+		while(header_received < 6)
+			header_received += test_replay_read(replay,
+					header + header_received, 6 - header_received);
+		g_assert_cmpuint(header[0], ==, 0x2a);
+
+		len = (header[4] << 8) | header[5];
+		data = g_new(guint8, len);
+		while(offset < len)
+			offset += test_replay_read(replay, data + offset, len - offset);
+
+		frames++;
+		g_free(data);
+	}
+
+	return frames;
+}
+
+/* The same as flap_connection_recv() */
+static guint
+test_framing_buffer_flap(TestReplay *replay) {
+	PurpleFramingBuffer *rx_buf = purple_framing_buffer_new(0);
+	guint frames = 0;
+	gpointer buf;
+	gsize buflen, len;
+	guint8 *header;
+
+	buf = purple_framing_buffer_get_input(rx_buf, &buflen);
+	while((len = test_replay_read(replay, buf, buflen)) > 0) {
+		purple_framing_buffer_mark_written(rx_buf, len);
+
+		while((header = purple_framing_buffer_peek(rx_buf, 6)) != NULL) {
+			guint16 payloadlen = (header[4] << 8) | header[5];
+
+			g_assert_cmpuint(header[0], ==, 0x2a);
+			header = purple_framing_buffer_peek(rx_buf, 6 + payloadlen);
+			if(header == NULL)
+				break;
+
+			g_assert_cmpuint(header[6 + payloadlen - 1], ==,
+			                 (payloadlen - 1) & 0xff);
+			purple_framing_buffer_mark_read(rx_buf, 6 + payloadlen);
+			frames++;
+		}
+
+		buf = purple_framing_buffer_get_input(rx_buf, &buflen);
+	}
+
+	g_assert_cmpuint(0, ==, purple_framing_buffer_get_used(rx_buf));
+	g_object_unref(rx_buf);
+
+	return frames;
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_framing_buffer_segments(void) {
+	PurpleFramingBuffer *buffer = purple_framing_buffer_new(4);
+	gchar out[32];
+	gchar *peeked;
+
+	purple_framing_buffer_append(buffer, "ABC\r", 4);
+	g_assert_cmpint(-1, ==, purple_framing_buffer_find(buffer, "\r\n", 2));
+
+	/* The delimiter and the frame straddle segments */
+	purple_framing_buffer_append(buffer, "\nDEFGHIJKLMNOP", 14);
+	g_assert_cmpuint(18, ==, purple_framing_buffer_get_used(buffer));
+	g_assert_cmpint(3, ==, purple_framing_buffer_find(buffer, "\r\n", 2));
+	g_assert_cmpint(15, ==, purple_framing_buffer_find(buffer, "NOP", 3));
+
+	peeked = purple_framing_buffer_peek(buffer, 12);
+	g_assert(peeked != NULL);
+	g_assert(strncmp(peeked, "ABC\r\nDEFGHIJ", 12) == 0);
+	g_assert(purple_framing_buffer_peek(buffer, 19) == NULL);
+
+	g_assert(purple_framing_buffer_mark_read(buffer, 5));
+	g_assert_cmpuint(5, ==, purple_framing_buffer_read(buffer, out, 5));
+	g_assert(strncmp(out, "DEFGH", 5) == 0);
+
+	purple_framing_buffer_append_owned(buffer, g_strdup("QRS"), 3, g_free);
+	g_assert_cmpuint(11, ==, purple_framing_buffer_get_used(buffer));
+	g_assert_cmpuint(11, ==, purple_framing_buffer_read(buffer, out, sizeof(out)));
+	g_assert(strncmp(out, "IJKLMNOPQRS", 11) == 0);
+	g_assert_cmpuint(0, ==, purple_framing_buffer_get_used(buffer));
+
+	purple_framing_buffer_append(buffer, "leftover", 8);
+	purple_framing_buffer_reset(buffer);
+	g_assert_cmpuint(0, ==, purple_framing_buffer_get_used(buffer));
+
+	g_object_unref(buffer);
+}
+
+static void
+test_framing_buffer_send(void) {
+	PurpleFramingBuffer *buffer = purple_framing_buffer_new(4);
+	gchar out[32];
+	int fds[2];
+
+	g_assert_cmpint(0, ==, pipe(fds));
+
+	purple_framing_buffer_append(buffer, "one ", 4);
+	purple_framing_buffer_append_owned(buffer, (gpointer)"two ", 4, NULL);
+	purple_framing_buffer_append(buffer, "three", 5);
+
+	g_assert_cmpint(13, ==, purple_framing_buffer_send(buffer, fds[1]));
+	g_assert_cmpuint(0, ==, purple_framing_buffer_get_used(buffer));
+	g_assert_cmpint(13, ==, read(fds[0], out, sizeof(out)));
+	g_assert(strncmp(out, "one two three", 13) == 0);
+
+	close(fds[0]);
+	close(fds[1]);
+	g_object_unref(buffer);
+}
+
+static void
+test_framing_buffer_replay(const gchar *name, GString *stream,
+                           guint (*legacy)(TestReplay *),
+                           guint (*framed)(TestReplay *), guint expected)
+{
+	TestReplay replay = { stream, 0, g_rand_new_with_seed(SEED) };
+	gdouble legacy_time, framed_time;
+	guint runs = g_test_perf() ? 20 : 1;
+	guint i;
+
+	g_test_timer_start();
+	for(i = 0; i < runs; i++) {
+		test_replay_rewind(&replay);
+		g_assert_cmpuint(expected, ==, legacy(&replay));
+	}
+	legacy_time = g_test_timer_elapsed() / runs;
+
+	g_test_timer_start();
+	for(i = 0; i < runs; i++) {
+		test_replay_rewind(&replay);
+		g_assert_cmpuint(expected, ==, framed(&replay));
+	}
+	framed_time = g_test_timer_elapsed() / runs;
+
+	g_test_message("%s: %" G_GSIZE_FORMAT " bytes, %u frames: "
+	               "%f seconds before, %f seconds with the framing buffer",
+	               name, stream->len, expected, legacy_time, framed_time);
+	g_test_minimized_result(framed_time, "%s replay in %f seconds",
+	                        name, framed_time);
+
+	g_rand_free(replay.rand);
+	g_string_free(stream, TRUE);
+}
+
+static void
+test_framing_buffer_replay_msn(void) {
+	/* Every fourth command has a payload, which is a frame of its own */
+	test_framing_buffer_replay("msn", test_framing_buffer_msn_stream(),
+	                           test_framing_buffer_msn_legacy,
+	                           test_framing_buffer_msn,
+	                           MSN_COMMANDS + MSN_COMMANDS / 4);
+}
+
+static void
+test_framing_buffer_replay_flap(void) {
+	test_framing_buffer_replay("oscar", test_framing_buffer_flap_stream(),
+	                           test_framing_buffer_flap_legacy,
+	                           test_framing_buffer_flap,
+	                           FLAP_FRAMES);
+}
+
+gint
+main(gint argc, gchar **argv) {
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/framingbuffer/segments",
+	                test_framing_buffer_segments);
+	g_test_add_func("/framingbuffer/send",
+	                test_framing_buffer_send);
+	g_test_add_func("/framingbuffer/replay/msn",
+	                test_framing_buffer_replay_msn);
+	g_test_add_func("/framingbuffer/replay/oscar",
+	                test_framing_buffer_replay_flap);
+
+	return g_test_run();
+}
@@ -0,0 +1,416 @@
+/*
+ * Purple
+ *
+ * Purple is the legal property of its developers, whose names are too
+ * numerous to list here. Please refer to the COPYRIGHT file distributed
+ * with this source distribution
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02111-1301 USA
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include <purple.h>
+
+/* The format is written out here rather than with the binary logger, which
+ * needs an account and a protocol to find where logs go.  See the comment
+ * above BINARY_LOG_MAGIC in log.c. */
+#define TEST_LOG_MAGIC "PLOG\001\0\0\0"
+#define TEST_LOG_INDEX_MAGIC "PLOGIDX\0"
+#define TEST_LOG_MAGIC_LEN 8
+
+#define TEST_RECORD_MESSAGE 0
+#define TEST_RECORD_INDEX   1
+
+#define TEST_LOG_TIME ((time_t)1400000000)
+
+static gchar *user_dir = NULL;
+
+static const struct {
+	gint offset;
+	PurpleMessageFlags flags;
+	const gchar *from;
+	const gchar *message;
+} test_messages[] = {
+	{ 0,   PURPLE_MESSAGE_RECV, "alice", "first" },
+	{ 60,  PURPLE_MESSAGE_SEND, "bob",   "second" },
+	{ 120, PURPLE_MESSAGE_RECV, "alice", "third" },
+};
+
+/******************************************************************************
+ * Writing logs
+ *****************************************************************************/
+static void
+test_log_append_uint32(GString *str, guint32 val) {
+	val = GUINT32_TO_LE(val);
+	g_string_append_len(str, (const gchar *)&val, sizeof(val));
+}
+
+static void
+test_log_append_uint64(GString *str, guint64 val) {
+	val = GUINT64_TO_LE(val);
+	g_string_append_len(str, (const gchar *)&val, sizeof(val));
+}
+
+static void
+test_log_append_message(GString *str, time_t time, PurpleMessageFlags flags,
+                        const gchar *from, const gchar *message)
+{
+	guint16 from_len = GUINT16_TO_LE(strlen(from));
+
+	test_log_append_uint32(str, 1 + 8 + 4 + 2 + strlen(from) + strlen(message));
+	g_string_append_c(str, TEST_RECORD_MESSAGE);
+	test_log_append_uint64(str, (guint64)(gint64)time);
+	test_log_append_uint32(str, flags);
+	g_string_append_len(str, (const gchar *)&from_len, sizeof(from_len));
+	g_string_append(str, from);
+	g_string_append(str, message);
+}
+
+static void
+test_log_append_index(GString *str, GArray *offsets, guint64 index_offset) {
+	guint i;
+
+	test_log_append_uint32(str, 1 + 8 + offsets->len * 8 + 8 +
+	                       TEST_LOG_MAGIC_LEN);
+	g_string_append_c(str, TEST_RECORD_INDEX);
+	test_log_append_uint64(str, offsets->len);
+	for(i = 0; i < offsets->len; i++)
+		test_log_append_uint64(str, g_array_index(offsets, guint64, i));
+	test_log_append_uint64(str, index_offset);
+	g_string_append_len(str, TEST_LOG_INDEX_MAGIC, TEST_LOG_MAGIC_LEN);
+}
+
+/* Writes the test messages, returning where each one starts. */
+static GString *
+test_log_new_contents(GArray **offsets) {
+	GString *str = g_string_new_len(TEST_LOG_MAGIC, TEST_LOG_MAGIC_LEN);
+	guint i;
+
+	*offsets = g_array_new(FALSE, FALSE, sizeof(guint64));
+
+	for(i = 0; i < G_N_ELEMENTS(test_messages); i++) {
+		guint64 offset = str->len;
+
+		g_array_append_val(*offsets, offset);
+		test_log_append_message(str, TEST_LOG_TIME + test_messages[i].offset,
+		                        test_messages[i].flags,
+		                        test_messages[i].from,
+		                        test_messages[i].message);
+	}
+
+	return str;
+}
+
+/******************************************************************************
+ * Reading logs
+ *****************************************************************************/
+typedef struct {
+	PurpleLog log;
+	PurpleLogCommonLoggerData data;
+	PurpleLogReader *reader;
+} TestLog;
+
+static void
+test_log_open(TestLog *test, GString *contents) {
+	GError *error = NULL;
+
+	memset(test, 0, sizeof(*test));
+
+	test->data.path = g_build_filename(user_dir, "test.plog", NULL);
+	g_file_set_contents(test->data.path, contents->str, contents->len,
+	                    &error);
+	g_assert_no_error(error);
+
+	test->log.type = PURPLE_LOG_IM;
+	test->log.name = (char *)"alice";
+	test->log.time = TEST_LOG_TIME;
+	test->log.logger = purple_log_logger_find("binary");
+	test->log.logger_data = &test->data;
+	g_assert(test->log.logger != NULL);
+
+	test->reader = purple_log_reader_new(&test->log);
+	g_assert(test->reader != NULL);
+}
+
+static void
+test_log_close(TestLog *test) {
+	purple_log_reader_free(test->reader);
+	g_unlink(test->data.path);
+	g_free(test->data.path);
+}
+
+/* Checks that the message at first in the log is the test message at
+ * expected, formatted the way the html logger writes it. */
+static void
+test_log_assert_message(TestLog *test, gsize first, guint expected) {
+	PurpleLogReadFlags flags = 0;
+	gchar *text, *line;
+
+	text = purple_log_reader_read(test->reader, first, 1, &flags);
+	g_assert(text != NULL);
+	g_assert_cmpint(PURPLE_LOG_READ_NO_NEWLINE, ==, flags);
+
+	line = g_strdup_printf("<b>%s:</b></font> %s<br/>\n",
+	                       test_messages[expected].from,
+	                       test_messages[expected].message);
+	g_assert(g_str_has_suffix(text, line));
+	g_free(line);
+
+	g_free(text);
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_log_binary_records(void) {
+	GArray *offsets;
+	GString *contents = test_log_new_contents(&offsets);
+	TestLog test;
+	gchar *text;
+	guint i;
+
+	test_log_append_index(contents, offsets, contents->len);
+	test_log_open(&test, contents);
+
+	g_assert_cmpuint(G_N_ELEMENTS(test_messages), ==,
+	                 purple_log_reader_get_count(test.reader));
+	for(i = 0; i < G_N_ELEMENTS(test_messages); i++)
+		test_log_assert_message(&test, i, i);
+
+	/* A page holds the messages in order. */
+	text = purple_log_reader_read(test.reader, 0, 10, NULL);
+	g_assert(strstr(text, "first<br/>") < strstr(text, "second<br/>"));
+	g_assert(strstr(text, "second<br/>") < strstr(text, "third<br/>"));
+	g_assert(strstr(text, "#16569E") != NULL);
+	g_free(text);
+	g_assert(purple_log_reader_read(test.reader, 3, 1, NULL) == NULL);
+
+	/* The record times are searched, not the text. */
+	g_assert_cmpuint(0, ==, purple_log_reader_find_time(test.reader,
+	                 TEST_LOG_TIME - 1));
+	g_assert_cmpuint(0, ==, purple_log_reader_find_time(test.reader,
+	                 TEST_LOG_TIME));
+	g_assert_cmpuint(1, ==, purple_log_reader_find_time(test.reader,
+	                 TEST_LOG_TIME + 1));
+	g_assert_cmpuint(2, ==, purple_log_reader_find_time(test.reader,
+	                 TEST_LOG_TIME + 120));
+	g_assert_cmpuint(3, ==, purple_log_reader_find_time(test.reader,
+	                 TEST_LOG_TIME + 121));
+
+	/* Reading the whole log gives the same messages. */
+	text = purple_log_read(&test.log, NULL);
+	g_assert(strstr(text, "<b>alice:</b></font> first<br/>") != NULL);
+	g_assert(strstr(text, "<b>bob:</b></font> second<br/>") != NULL);
+	g_assert(strstr(text, "<b>alice:</b></font> third<br/>") != NULL);
+	g_free(text);
+
+	test_log_close(&test);
+	g_array_free(offsets, TRUE);
+	g_string_free(contents, TRUE);
+}
+
+static void
+test_log_binary_index(void) {
+	GArray *offsets;
+	GString *contents = test_log_new_contents(&offsets);
+	TestLog test;
+
+	/* An index that leaves out the second message is believed, which
+	 * shows it was read instead of the records. */
+	g_array_remove_index(offsets, 1);
+	test_log_append_index(contents, offsets, contents->len);
+	test_log_open(&test, contents);
+
+	g_assert_cmpuint(2, ==, purple_log_reader_get_count(test.reader));
+	test_log_assert_message(&test, 0, 0);
+	test_log_assert_message(&test, 1, 2);
+
+	test_log_close(&test);
+	g_array_free(offsets, TRUE);
+	g_string_free(contents, TRUE);
+}
+
+static void
+test_log_binary_no_index(void) {
+	GArray *offsets;
+	GString *contents = test_log_new_contents(&offsets);
+	TestLog test;
+	guint i;
+
+	/* A log that was never closed is read record by record. */
+	test_log_open(&test, contents);
+
+	g_assert_cmpuint(G_N_ELEMENTS(test_messages), ==,
+	                 purple_log_reader_get_count(test.reader));
+	for(i = 0; i < G_N_ELEMENTS(test_messages); i++)
+		test_log_assert_message(&test, i, i);
+
+	test_log_close(&test);
+	g_array_free(offsets, TRUE);
+	g_string_free(contents, TRUE);
+}
+
+static void
+test_log_binary_truncated_index(void) {
+	GArray *offsets;
+	GString *contents = test_log_new_contents(&offsets);
+	gsize full, cut;
+	guint i;
+
+	g_array_remove_index(offsets, 1);
+	test_log_append_index(contents, offsets, contents->len);
+	full = contents->len;
+
+	/* Cut into the magic, the offset of the index, and its entries.  The
+	 * partial index is ignored and every record is found. */
+	for(cut = 4; cut <= 8 + 8 + 8; cut += 10) {
+		GString *partial = g_string_new_len(contents->str, full - cut);
+		TestLog test;
+
+		test_log_open(&test, partial);
+
+		g_assert_cmpuint(G_N_ELEMENTS(test_messages), ==,
+		                 purple_log_reader_get_count(test.reader));
+		for(i = 0; i < G_N_ELEMENTS(test_messages); i++)
+			test_log_assert_message(&test, i, i);
+
+		test_log_close(&test);
+		g_string_free(partial, TRUE);
+	}
+
+	g_array_free(offsets, TRUE);
+	g_string_free(contents, TRUE);
+}
+
+static void
+test_log_binary_bad_index(void) {
+	GArray *offsets;
+	GString *contents = test_log_new_contents(&offsets);
+	TestLog test;
+	guint64 second = g_array_index(offsets, guint64, 1);
+
+	/* The trailer points at a message instead of the index. */
+	test_log_append_index(contents, offsets, second);
+	test_log_open(&test, contents);
+	g_assert_cmpuint(G_N_ELEMENTS(test_messages), ==,
+	                 purple_log_reader_get_count(test.reader));
+	test_log_close(&test);
+
+	/* The index has its entries out of order. */
+	g_string_free(contents, TRUE);
+	g_array_free(offsets, TRUE);
+	contents = test_log_new_contents(&offsets);
+	g_array_index(offsets, guint64, 2) = g_array_index(offsets, guint64, 0);
+	test_log_append_index(contents, offsets, contents->len);
+	test_log_open(&test, contents);
+	g_assert_cmpuint(G_N_ELEMENTS(test_messages), ==,
+	                 purple_log_reader_get_count(test.reader));
+	test_log_assert_message(&test, 2, 2);
+	test_log_close(&test);
+
+	g_array_free(offsets, TRUE);
+	g_string_free(contents, TRUE);
+}
+
+static void
+test_log_binary_truncated_record(void) {
+	GArray *offsets;
+	GString *contents = test_log_new_contents(&offsets);
+	TestLog test;
+
+	/* The last message was cut short, so only the others are read. */
+	g_string_truncate(contents, contents->len - 3);
+	test_log_open(&test, contents);
+
+	g_assert_cmpuint(2, ==, purple_log_reader_get_count(test.reader));
+	test_log_assert_message(&test, 0, 0);
+	test_log_assert_message(&test, 1, 1);
+	g_assert_cmpuint(2, ==, purple_log_reader_find_time(test.reader,
+	                 TEST_LOG_TIME + 120));
+
+	test_log_close(&test);
+	g_array_free(offsets, TRUE);
+	g_string_free(contents, TRUE);
+}
+
+static void
+test_log_binary_bad_magic(void) {
+	GArray *offsets;
+	GString *contents = test_log_new_contents(&offsets);
+	TestLog test;
+	gchar *text;
+
+	contents->str[0] = 'X';
+	test_log_open(&test, contents);
+
+	g_assert_cmpuint(0, ==, purple_log_reader_get_count(test.reader));
+	g_assert(purple_log_reader_read(test.reader, 0, 1, NULL) == NULL);
+
+	text = purple_log_read(&test.log, NULL);
+	g_assert(strstr(text, test.data.path) != NULL);
+	g_free(text);
+
+	test_log_close(&test);
+	g_array_free(offsets, TRUE);
+	g_string_free(contents, TRUE);
+}
+
+gint
+main(gint argc, gchar **argv) {
+	gchar *prefs;
+	gint ret;
+
+	g_test_init(&argc, &argv, NULL);
+
+	/* The loggers keep their preferences in the user directory, so give
+	 * them an empty one. */
+	user_dir = g_dir_make_tmp("test_log_binary-XXXXXX", NULL);
+	g_assert(user_dir != NULL);
+	purple_util_set_user_dir(user_dir);
+	purple_signals_init();
+	purple_prefs_init();
+	purple_log_init();
+
+	g_test_add_func("/log/binary/records",
+	                test_log_binary_records);
+	g_test_add_func("/log/binary/index",
+	                test_log_binary_index);
+	g_test_add_func("/log/binary/no-index",
+	                test_log_binary_no_index);
+	g_test_add_func("/log/binary/truncated-index",
+	                test_log_binary_truncated_index);
+	g_test_add_func("/log/binary/bad-index",
+	                test_log_binary_bad_index);
+	g_test_add_func("/log/binary/truncated-record",
+	                test_log_binary_truncated_record);
+	g_test_add_func("/log/binary/bad-magic",
+	                test_log_binary_bad_magic);
+
+	ret = g_test_run();
+
+	purple_log_uninit();
+
+	prefs = g_build_filename(user_dir, "prefs.xml", NULL);
+	g_unlink(prefs);
+	g_free(prefs);
+	g_rmdir(user_dir);
+	g_free(user_dir);
+
+	return ret;
+}
@@ -0,0 +1,350 @@
+/*
+ * Purple is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02111-1301 USA
+ */
+
+#include <config.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#include <purple.h>
+#include "media-gst.h"
+
+#ifdef HAVE_MEDIA_APPLICATION
+#include <gst/app/app.h>
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static PurpleEventLoopUiOps test_media_appdata_eventloop = {
+	g_timeout_add,
+	g_source_remove,
+	NULL,
+	NULL,
+	NULL,
+	g_timeout_add_seconds,
+
+	/* padding */
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+
+/* A media without a backend, which is all the application data path needs. */
+static PurpleMedia *test_media_appdata_media = NULL;
+
+static void
+test_media_appdata_freed(gpointer data) {
+	*(gboolean *)data = TRUE;
+}
+
+/* Bytes that record when their data is freed. */
+static GBytes *
+test_media_appdata_bytes_new(const gchar *text, gboolean *freed) {
+	*freed = FALSE;
+
+	return g_bytes_new_with_free_func(text, strlen(text),
+	                                  test_media_appdata_freed, freed);
+}
+
+static void
+test_media_appdata_assert_bytes(GBytes *bytes, GBytes *expected) {
+	gconstpointer data;
+	gsize size;
+
+	g_assert(bytes != NULL);
+
+	/* Nothing between the sender and the receiver copied the data. */
+	data = g_bytes_get_data(bytes, &size);
+	g_assert(data == g_bytes_get_data(expected, NULL));
+	g_assert_cmpuint(size, ==, g_bytes_get_size(expected));
+	g_assert(g_bytes_equal(bytes, expected));
+}
+
+static GstAppSrc *
+test_media_appdata_appsrc_new(void) {
+	GstElement *appsrc = gst_element_factory_make("appsrc", NULL);
+	GstCaps *caps = gst_caps_new_empty_simple("application/octet-stream");
+
+	g_assert(appsrc != NULL);
+	gst_app_src_set_caps(GST_APP_SRC(appsrc), caps);
+	gst_caps_unref(caps);
+
+	return GST_APP_SRC(appsrc);
+}
+
+static GstAppSink *
+test_media_appdata_appsink_new(void) {
+	GstElement *appsink = gst_element_factory_make("appsink", NULL);
+
+	g_assert(appsink != NULL);
+	g_object_set(appsink, "sync", FALSE, "enable-last-sample", FALSE, NULL);
+
+	return GST_APP_SINK(appsink);
+}
+
+static void
+test_media_appdata_play(GstElement *pipeline, GstElement *src,
+                        GstElement *sink)
+{
+	g_assert(gst_element_link(src, sink));
+	g_assert_cmpint(GST_STATE_CHANGE_FAILURE, !=,
+	                gst_element_set_state(pipeline, GST_STATE_PLAYING));
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_media_appdata_wrap(void) {
+	GBytes *bytes, *view;
+	GstBuffer *buffer;
+	gconstpointer data;
+	gboolean freed;
+	gsize size;
+
+	bytes = test_media_appdata_bytes_new("hello world", &freed);
+	data = g_bytes_get_data(bytes, NULL);
+
+	buffer = purple_media_gst_buffer_new_from_bytes(bytes);
+	g_assert_cmpuint(11, ==, gst_buffer_get_size(buffer));
+	g_assert(gst_buffer_memcmp(buffer, 0, "hello world", 11) == 0);
+
+	/* The buffer holds a reference of its own on the bytes. */
+	g_bytes_unref(bytes);
+	g_assert(!freed);
+
+	/* The buffer and the views share the data of the original bytes. */
+	view = purple_media_gst_buffer_get_bytes(buffer, 0);
+	g_assert(g_bytes_get_data(view, &size) == data);
+	g_assert_cmpuint(11, ==, size);
+	g_bytes_unref(view);
+
+	view = purple_media_gst_buffer_get_bytes(buffer, 6);
+	g_assert(g_bytes_get_data(view, &size) == (const guint8 *)data + 6);
+	g_assert_cmpuint(5, ==, size);
+
+	/* The view outlives the buffer, and the data lives as long as it. */
+	gst_buffer_unref(buffer);
+	g_assert(!freed);
+	g_assert(strncmp(g_bytes_get_data(view, NULL), "world", 5) == 0);
+	g_bytes_unref(view);
+	g_assert(freed);
+
+	/* An offset at the end of the buffer gives an empty view. */
+	bytes = test_media_appdata_bytes_new("hello", &freed);
+	buffer = purple_media_gst_buffer_new_from_bytes(bytes);
+	view = purple_media_gst_buffer_get_bytes(buffer, 5);
+	g_assert_cmpuint(0, ==, g_bytes_get_size(view));
+	g_bytes_unref(view);
+	gst_buffer_unref(buffer);
+	g_bytes_unref(bytes);
+	g_assert(freed);
+
+	bytes = g_bytes_new(NULL, 0);
+	buffer = purple_media_gst_buffer_new_from_bytes(bytes);
+	g_assert_cmpuint(0, ==, gst_buffer_get_size(buffer));
+	gst_buffer_unref(buffer);
+	g_bytes_unref(bytes);
+}
+
+static void
+test_media_appdata_pipeline(void) {
+	const gchar *packets[] = { "first", "second packet", "third", NULL };
+	GstElement *pipeline, *queue;
+	GstAppSrc *appsrc;
+	GstAppSink *appsink;
+	GstSample *sample;
+	GBytes *sent, *received;
+	gboolean freed;
+	gint i;
+
+	pipeline = gst_pipeline_new(NULL);
+	appsrc = test_media_appdata_appsrc_new();
+	queue = gst_element_factory_make("queue", NULL);
+	appsink = test_media_appdata_appsink_new();
+	gst_bin_add_many(GST_BIN(pipeline), GST_ELEMENT(appsrc), queue,
+	                 GST_ELEMENT(appsink), NULL);
+	g_assert(gst_element_link(GST_ELEMENT(appsrc), queue));
+	test_media_appdata_play(pipeline, queue, GST_ELEMENT(appsink));
+
+	for(i = 0; packets[i] != NULL; i++) {
+		sent = test_media_appdata_bytes_new(packets[i], &freed);
+		g_assert_cmpint(GST_FLOW_OK, ==, gst_app_src_push_buffer(appsrc,
+		                purple_media_gst_buffer_new_from_bytes(sent)));
+
+		sample = gst_app_sink_pull_sample(appsink);
+		g_assert(sample != NULL);
+		received = purple_media_gst_buffer_get_bytes(
+			gst_sample_get_buffer(sample), 0);
+		gst_sample_unref(sample);
+
+		test_media_appdata_assert_bytes(received, sent);
+
+		/* Whatever is left of the pipeline's references goes with the
+		 * received view. */
+		g_bytes_unref(sent);
+		g_assert(!freed);
+		g_bytes_unref(received);
+		g_assert(freed);
+	}
+
+	gst_element_set_state(pipeline, GST_STATE_NULL);
+	gst_object_unref(pipeline);
+}
+
+static void
+test_media_appdata_manager_send(void) {
+	PurpleMediaManager *manager = purple_media_manager_get();
+	PurpleMedia *media = test_media_appdata_media;
+	GstElement *pipeline, *appsrc;
+	GstAppSink *appsink;
+	GstSample *sample;
+	GBytes *sent, *received;
+	gboolean freed;
+
+	pipeline = purple_media_manager_get_pipeline(manager);
+	appsrc = purple_media_manager_get_element(manager,
+		PURPLE_MEDIA_SEND_APPLICATION, media, "send", "buddy");
+	g_assert(appsrc != NULL);
+
+	appsink = test_media_appdata_appsink_new();
+	gst_bin_add(GST_BIN(pipeline), GST_ELEMENT(appsink));
+	test_media_appdata_play(pipeline, appsrc, GST_ELEMENT(appsink));
+
+	sent = test_media_appdata_bytes_new("hello buddy", &freed);
+
+	/* Nothing is sent until the session is connected. */
+	g_assert_cmpint(-1, ==, purple_media_manager_send_application_data_bytes(
+		manager, media, "send", "buddy", sent, FALSE));
+	g_assert(!freed);
+
+	g_signal_emit_by_name(media, "candidate-pair-established",
+	                      "send", "buddy", NULL, NULL);
+
+	g_assert_cmpint(11, ==, purple_media_manager_send_application_data_bytes(
+		manager, media, "send", "buddy", sent, FALSE));
+
+	sample = gst_app_sink_pull_sample(appsink);
+	g_assert(sample != NULL);
+	received = purple_media_gst_buffer_get_bytes(
+		gst_sample_get_buffer(sample), 0);
+	gst_sample_unref(sample);
+
+	test_media_appdata_assert_bytes(received, sent);
+
+	g_bytes_unref(sent);
+	g_assert(!freed);
+	g_bytes_unref(received);
+	g_assert(freed);
+
+	gst_element_set_state(pipeline, GST_STATE_NULL);
+	gst_element_unlink(appsrc, GST_ELEMENT(appsink));
+	gst_bin_remove(GST_BIN(pipeline), GST_ELEMENT(appsink));
+	gst_object_unref(appsrc);
+}
+
+static void
+test_media_appdata_manager_receive(void) {
+	PurpleMediaManager *manager = purple_media_manager_get();
+	PurpleMedia *media = test_media_appdata_media;
+	GstElement *pipeline, *appsink;
+	GstAppSrc *appsrc;
+	GBytes *sent, *received;
+	gboolean freed;
+
+	appsink = purple_media_manager_get_element(manager,
+		PURPLE_MEDIA_RECV_APPLICATION, media, "receive", "buddy");
+	g_assert(appsink != NULL);
+
+	pipeline = gst_pipeline_new(NULL);
+	appsrc = test_media_appdata_appsrc_new();
+	gst_bin_add_many(GST_BIN(pipeline), GST_ELEMENT(appsrc), appsink, NULL);
+	test_media_appdata_play(pipeline, GST_ELEMENT(appsrc), appsink);
+
+	/* Nothing has arrived yet. */
+	g_assert(purple_media_manager_receive_application_data_bytes(manager,
+		media, "receive", "buddy", FALSE) == NULL);
+
+	sent = test_media_appdata_bytes_new("hello you", &freed);
+	g_assert_cmpint(GST_FLOW_OK, ==, gst_app_src_push_buffer(appsrc,
+	                purple_media_gst_buffer_new_from_bytes(sent)));
+
+	received = purple_media_manager_receive_application_data_bytes(manager,
+		media, "receive", "buddy", TRUE);
+	test_media_appdata_assert_bytes(received, sent);
+
+	/* The whole sample was handed out at once. */
+	g_assert(purple_media_manager_receive_application_data_bytes(manager,
+		media, "receive", "buddy", FALSE) == NULL);
+
+	g_bytes_unref(sent);
+	g_assert(!freed);
+	g_bytes_unref(received);
+	g_assert(freed);
+
+	gst_element_set_state(pipeline, GST_STATE_NULL);
+	gst_object_unref(pipeline);
+}
+#endif /* HAVE_MEDIA_APPLICATION */
+
+gint
+main(gint argc, gchar **argv) {
+#ifdef HAVE_MEDIA_APPLICATION
+	gchar *user_dir;
+	gint ret;
+#endif
+
+	g_test_init(&argc, &argv, NULL);
+
+#ifdef HAVE_MEDIA_APPLICATION
+	gst_init(&argc, &argv);
+
+	/* The media manager keeps its preferences and element configuration in
+	 * the user directory, so give it an empty one. */
+	user_dir = g_dir_make_tmp("test_media_appdata-XXXXXX", NULL);
+	g_assert(user_dir != NULL);
+	purple_util_set_user_dir(user_dir);
+	purple_eventloop_set_ui_ops(&test_media_appdata_eventloop);
+	purple_prefs_init();
+
+	test_media_appdata_media = g_object_new(PURPLE_TYPE_MEDIA,
+		"manager", purple_media_manager_get(), NULL);
+
+	g_test_add_func("/media/appdata/wrap",
+	                test_media_appdata_wrap);
+	g_test_add_func("/media/appdata/pipeline",
+	                test_media_appdata_pipeline);
+	g_test_add_func("/media/appdata/manager/send",
+	                test_media_appdata_manager_send);
+	g_test_add_func("/media/appdata/manager/receive",
+	                test_media_appdata_manager_receive);
+
+	ret = g_test_run();
+
+	g_rmdir(user_dir);
+	g_free(user_dir);
+
+	return ret;
+#else
+	return g_test_run();
+#endif
+}
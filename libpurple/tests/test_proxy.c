@@ -0,0 +1,363 @@
+/*
+ * Purple
+ *
+ * Purple is the legal property of its developers, whose names are too
+ * numerous to list here. Please refer to the COPYRIGHT file distributed
+ * with this source distribution
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02111-1301 USA
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <purple.h>
+
+/******************************************************************************
+ * Stub resolver
+ *
+ * Answers every name with the addresses in test_proxy_addresses, in that
+ * order.
+ *****************************************************************************/
+typedef struct {
+	GResolver parent;
+} TestStubResolver;
+
+typedef struct {
+	GResolverClass parent;
+} TestStubResolverClass;
+
+GType test_stub_resolver_get_type(void);
+
+G_DEFINE_TYPE(TestStubResolver, test_stub_resolver, G_TYPE_RESOLVER)
+
+static const gchar * const *test_proxy_addresses = NULL;
+
+static void
+test_stub_resolver_lookup_by_name_async(GResolver *resolver,
+                                        const gchar *hostname,
+                                        GCancellable *cancellable,
+                                        GAsyncReadyCallback callback,
+                                        gpointer data)
+{
+	GTask *task = g_task_new(resolver, cancellable, callback, data);
+	GList *addresses = NULL;
+	gint i;
+
+	for(i = 0; test_proxy_addresses[i] != NULL; i++) {
+		addresses = g_list_append(addresses,
+			g_inet_address_new_from_string(test_proxy_addresses[i]));
+	}
+
+	g_task_return_pointer(task, addresses,
+	                      (GDestroyNotify)g_resolver_free_addresses);
+	g_object_unref(task);
+}
+
+static GList *
+test_stub_resolver_lookup_by_name_finish(GResolver *resolver,
+                                         GAsyncResult *result, GError **error)
+{
+	return g_task_propagate_pointer(G_TASK(result), error);
+}
+
+static void
+test_stub_resolver_init(TestStubResolver *resolver) {
+}
+
+static void
+test_stub_resolver_class_init(TestStubResolverClass *klass) {
+	GResolverClass *resolver_class = G_RESOLVER_CLASS(klass);
+
+	resolver_class->lookup_by_name_async = test_stub_resolver_lookup_by_name_async;
+	resolver_class->lookup_by_name_finish = test_stub_resolver_lookup_by_name_finish;
+}
+
+/******************************************************************************
+ * UI ops
+ *****************************************************************************/
+static PurpleEventLoopUiOps test_proxy_eventloop = {
+	g_timeout_add,
+	g_source_remove,
+	NULL,
+	NULL,
+	NULL,
+	g_timeout_add_seconds,
+
+	/* padding */
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+
+/* The addresses connections were attempted to, in order.  proxy.c only
+ * says so in its debug output. */
+static GPtrArray *attempts = NULL;
+
+static void
+test_proxy_debug_print(PurpleDebugLevel level, const char *category,
+                       const char *arg_s)
+{
+	const gchar *start, *end;
+
+	if(attempts == NULL || !purple_strequal(category, "proxy") ||
+	   !g_str_has_prefix(arg_s, "Attempting connection to "))
+		return;
+
+	/* "Attempting connection to host (address:port)" */
+	start = strchr(arg_s, '(');
+	end = strrchr(arg_s, ':');
+	if(start == NULL || end == NULL || end < start)
+		return;
+
+	g_ptr_array_add(attempts, g_strndup(start + 1, end - start - 1));
+}
+
+static gboolean
+test_proxy_debug_is_enabled(PurpleDebugLevel level, const char *category) {
+	return TRUE;
+}
+
+static PurpleDebugUiOps test_proxy_debug = {
+	test_proxy_debug_print,
+	test_proxy_debug_is_enabled,
+
+	/* padding */
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+typedef struct {
+	guint calls;
+	gint fd;
+	gchar *error;
+} TestProxyResult;
+
+static void
+test_proxy_connect_cb(gpointer data, gint source, const gchar *error_message) {
+	TestProxyResult *result = data;
+
+	result->calls++;
+	result->fd = source;
+	result->error = g_strdup(error_message);
+}
+
+/* Listens on address, on port if it isn't 0, and returns the port. */
+static guint16
+test_proxy_listen(GSocketListener *listener, const gchar *address,
+                  guint16 port)
+{
+	GInetAddress *inet = g_inet_address_new_from_string(address);
+	GSocketAddress *requested = g_inet_socket_address_new(inet, port);
+	GSocketAddress *effective = NULL;
+	GError *error = NULL;
+
+	g_socket_listener_add_address(listener, requested, G_SOCKET_TYPE_STREAM,
+	                              G_SOCKET_PROTOCOL_TCP, NULL, &effective,
+	                              &error);
+	g_assert_no_error(error);
+
+	port = g_inet_socket_address_get_port(G_INET_SOCKET_ADDRESS(effective));
+
+	g_object_unref(effective);
+	g_object_unref(requested);
+	g_object_unref(inet);
+
+	return port;
+}
+
+static void
+test_proxy_wait(TestProxyResult *result) {
+	while(result->calls == 0)
+		g_main_context_iteration(NULL, TRUE);
+}
+
+static gboolean
+test_proxy_quit_cb(gpointer data) {
+	g_main_loop_quit(data);
+
+	return FALSE;
+}
+
+/* Runs the main loop for a while, for any late callbacks. */
+static void
+test_proxy_settle(void) {
+	GMainLoop *loop = g_main_loop_new(NULL, FALSE);
+
+	g_timeout_add(500, test_proxy_quit_cb, loop);
+	g_main_loop_run(loop);
+	g_main_loop_unref(loop);
+}
+
+static void
+test_proxy_result_clear(TestProxyResult *result) {
+	if(result->fd >= 0)
+		close(result->fd);
+	g_free(result->error);
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_proxy_race_order(void) {
+	const gchar * const addresses[] = {
+		"127.0.0.1", "127.0.0.2", "127.0.0.3", "::1", NULL
+	};
+	const gchar * const expected[] = {
+		"127.0.0.1", "::1", "127.0.0.2", "127.0.0.3"
+	};
+	GSocketListener *listener = g_socket_listener_new();
+	TestProxyResult result = { 0, -1, NULL };
+	guint16 port;
+	guint i;
+
+	/* Only the last address accepts, so every other attempt is refused
+	 * and the next one starts right away. */
+	port = test_proxy_listen(listener, "127.0.0.3", 0);
+	test_proxy_addresses = addresses;
+	purple_prefs_set_int("/purple/network/connection_race_delay", 60000);
+	attempts = g_ptr_array_new_with_free_func(g_free);
+
+	g_assert(purple_proxy_connect(NULL, NULL, "example.test", port,
+	                              test_proxy_connect_cb, &result) != NULL);
+	test_proxy_wait(&result);
+
+	/* The families are interleaved, keeping the resolver's order within
+	 * each one and the first address's family first. */
+	g_assert_cmpuint(G_N_ELEMENTS(expected), ==, attempts->len);
+	for(i = 0; i < attempts->len; i++)
+		g_assert_cmpstr(expected[i], ==, g_ptr_array_index(attempts, i));
+
+	g_assert_cmpuint(1, ==, result.calls);
+	g_assert_cmpstr(NULL, ==, result.error);
+	g_assert_cmpint(0, <=, result.fd);
+
+	test_proxy_result_clear(&result);
+	g_ptr_array_free(attempts, TRUE);
+	attempts = NULL;
+	g_object_unref(listener);
+}
+
+static void
+test_proxy_race_one_winner(void) {
+	const gchar * const addresses[] = { "127.0.0.1", "127.0.0.2", NULL };
+	GSocketListener *listener = g_socket_listener_new();
+	TestProxyResult result = { 0, -1, NULL };
+	guint16 port;
+
+	/* Both addresses accept, and the second attempt starts without
+	 * waiting for the first. */
+	port = test_proxy_listen(listener, "127.0.0.1", 0);
+	test_proxy_listen(listener, "127.0.0.2", port);
+	test_proxy_addresses = addresses;
+	purple_prefs_set_int("/purple/network/connection_race_delay", 0);
+	attempts = g_ptr_array_new_with_free_func(g_free);
+
+	g_assert(purple_proxy_connect(NULL, NULL, "example.test", port,
+	                              test_proxy_connect_cb, &result) != NULL);
+	test_proxy_wait(&result);
+	test_proxy_settle();
+
+	/* Whichever connected first won, and the other was dropped rather
+	 * than reported too. */
+	g_assert_cmpuint(1, <=, attempts->len);
+	g_assert_cmpuint(2, >=, attempts->len);
+	g_assert_cmpuint(1, ==, result.calls);
+	g_assert_cmpstr(NULL, ==, result.error);
+	g_assert_cmpint(0, <=, result.fd);
+
+	test_proxy_result_clear(&result);
+	g_ptr_array_free(attempts, TRUE);
+	attempts = NULL;
+	g_object_unref(listener);
+}
+
+static void
+test_proxy_race_all_fail(void) {
+	const gchar * const addresses[] = { "127.0.0.1", "::1", NULL };
+	GSocketListener *listener = g_socket_listener_new();
+	TestProxyResult result = { 0, -1, NULL };
+	guint16 port;
+
+	/* Find a port, then stop listening on it. */
+	port = test_proxy_listen(listener, "127.0.0.1", 0);
+	g_object_unref(listener);
+	test_proxy_addresses = addresses;
+	purple_prefs_set_int("/purple/network/connection_race_delay", 60000);
+
+	g_assert(purple_proxy_connect(NULL, NULL, "example.test", port,
+	                              test_proxy_connect_cb, &result) != NULL);
+	test_proxy_wait(&result);
+	test_proxy_settle();
+
+	/* The caller hears about it once, after the last attempt failed. */
+	g_assert_cmpuint(1, ==, result.calls);
+	g_assert_cmpstr(NULL, !=, result.error);
+	g_assert_cmpint(-1, ==, result.fd);
+
+	test_proxy_result_clear(&result);
+}
+
+gint
+main(gint argc, gchar **argv) {
+	GResolver *resolver;
+	gchar *user_dir, *prefs;
+	gint ret;
+
+	g_test_init(&argc, &argv, NULL);
+
+	/* The preferences live in the user directory, so give them an empty
+	 * one. */
+	user_dir = g_dir_make_tmp("test_proxy-XXXXXX", NULL);
+	g_assert(user_dir != NULL);
+	purple_util_set_user_dir(user_dir);
+	purple_eventloop_set_ui_ops(&test_proxy_eventloop);
+	purple_debug_set_ui_ops(&test_proxy_debug);
+	purple_prefs_init();
+	purple_prefs_add_none("/purple/network");
+	purple_prefs_add_int("/purple/network/connection_race_delay", 250);
+	purple_proxy_init();
+
+	resolver = g_object_new(test_stub_resolver_get_type(), NULL);
+	g_resolver_set_default(resolver);
+	g_object_unref(resolver);
+
+	g_test_add_func("/proxy/race/order",
+	                test_proxy_race_order);
+	g_test_add_func("/proxy/race/one-winner",
+	                test_proxy_race_one_winner);
+	g_test_add_func("/proxy/race/all-fail",
+	                test_proxy_race_all_fail);
+
+	ret = g_test_run();
+
+	prefs = g_build_filename(user_dir, "prefs.xml", NULL);
+	g_unlink(prefs);
+	g_free(prefs);
+	g_rmdir(user_dir);
+	g_free(user_dir);
+
+	return ret;
+}
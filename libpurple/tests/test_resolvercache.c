@@ -0,0 +1,376 @@
+/*
+ * Purple
+ *
+ * Purple is the legal property of its developers, whose names are too
+ * numerous to list here. Please refer to the COPYRIGHT file distributed
+ * with this source distribution
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02111-1301 USA
+ */
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <purple.h>
+
+/******************************************************************************
+ * Stub resolver
+ *
+ * Knows "example.test" (one IPv6 and one IPv4 address) and its SRV record,
+ * says names starting with "missing" don't exist, fails temporarily for
+ * names starting with "flaky", and counts how often it was asked.
+ *****************************************************************************/
+typedef struct {
+	GResolver parent;
+
+	guint lookups;
+} TestStubResolver;
+
+typedef struct {
+	GResolverClass parent;
+} TestStubResolverClass;
+
+GType test_stub_resolver_get_type(void);
+
+G_DEFINE_TYPE(TestStubResolver, test_stub_resolver, G_TYPE_RESOLVER)
+
+static GList *
+test_stub_resolver_answer(const gchar *hostname, GError **error) {
+	GList *addresses = NULL;
+
+	if(g_str_has_prefix(hostname, "missing")) {
+		g_set_error(error, G_RESOLVER_ERROR, G_RESOLVER_ERROR_NOT_FOUND,
+		            "%s not found", hostname);
+		return NULL;
+	}
+
+	if(g_str_has_prefix(hostname, "flaky")) {
+		g_set_error(error, G_RESOLVER_ERROR,
+		            G_RESOLVER_ERROR_TEMPORARY_FAILURE,
+		            "%s timed out", hostname);
+		return NULL;
+	}
+
+	addresses = g_list_append(addresses, g_inet_address_new_from_string("::1"));
+	addresses = g_list_append(addresses,
+	                          g_inet_address_new_from_string("127.0.0.1"));
+
+	return addresses;
+}
+
+static GList *
+test_stub_resolver_lookup_by_name(GResolver *resolver, const gchar *hostname,
+                                  GCancellable *cancellable, GError **error)
+{
+	((TestStubResolver *)resolver)->lookups++;
+
+	return test_stub_resolver_answer(hostname, error);
+}
+
+static void
+test_stub_resolver_lookup_by_name_async(GResolver *resolver,
+                                        const gchar *hostname,
+                                        GCancellable *cancellable,
+                                        GAsyncReadyCallback callback,
+                                        gpointer data)
+{
+	GTask *task = g_task_new(resolver, cancellable, callback, data);
+	GError *error = NULL;
+	GList *addresses;
+
+	((TestStubResolver *)resolver)->lookups++;
+
+	addresses = test_stub_resolver_answer(hostname, &error);
+	if(addresses == NULL)
+		g_task_return_error(task, error);
+	else
+		g_task_return_pointer(task, addresses,
+		                      (GDestroyNotify)g_resolver_free_addresses);
+
+	g_object_unref(task);
+}
+
+static GList *
+test_stub_resolver_lookup_finish(GResolver *resolver, GAsyncResult *result,
+                                 GError **error)
+{
+	return g_task_propagate_pointer(G_TASK(result), error);
+}
+
+static void
+test_stub_resolver_lookup_service_async(GResolver *resolver,
+                                        const gchar *rrname,
+                                        GCancellable *cancellable,
+                                        GAsyncReadyCallback callback,
+                                        gpointer data)
+{
+	GTask *task = g_task_new(resolver, cancellable, callback, data);
+	GList *targets;
+
+	((TestStubResolver *)resolver)->lookups++;
+
+	g_assert_cmpstr(rrname, ==, "_stun._udp.example.test");
+	targets = g_list_append(NULL,
+	                        g_srv_target_new("stun.example.test", 3478, 0, 0));
+	g_task_return_pointer(task, targets,
+	                      (GDestroyNotify)g_resolver_free_targets);
+
+	g_object_unref(task);
+}
+
+static void
+test_stub_resolver_init(TestStubResolver *resolver) {
+}
+
+static void
+test_stub_resolver_class_init(TestStubResolverClass *klass) {
+	GResolverClass *resolver_class = G_RESOLVER_CLASS(klass);
+
+	resolver_class->lookup_by_name = test_stub_resolver_lookup_by_name;
+	resolver_class->lookup_by_name_async = test_stub_resolver_lookup_by_name_async;
+	resolver_class->lookup_by_name_finish = test_stub_resolver_lookup_finish;
+	resolver_class->lookup_service_async = test_stub_resolver_lookup_service_async;
+	resolver_class->lookup_service_finish = test_stub_resolver_lookup_finish;
+}
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+typedef struct {
+	guint pending;
+	guint found;
+	GError *error;
+} TestLookups;
+
+static void
+test_resolver_cache_lookup_cb(GObject *source, GAsyncResult *res,
+                              gpointer data)
+{
+	TestLookups *lookups = data;
+	GError *error = NULL;
+	GList *addresses;
+
+	addresses = g_resolver_lookup_by_name_finish(G_RESOLVER(source), res,
+	                                             &error);
+	if(addresses != NULL) {
+		g_assert_cmpuint(g_list_length(addresses), ==, 2);
+		lookups->found++;
+		g_resolver_free_addresses(addresses);
+	} else {
+		g_clear_error(&lookups->error);
+		lookups->error = error;
+	}
+
+	lookups->pending--;
+}
+
+static void
+test_resolver_cache_lookup(GResolver *cache, const gchar *hostname,
+                           TestLookups *lookups)
+{
+	lookups->pending++;
+	g_resolver_lookup_by_name_async(cache, hostname, NULL,
+	                                test_resolver_cache_lookup_cb, lookups);
+}
+
+static void
+test_resolver_cache_wait(TestLookups *lookups) {
+	while(lookups->pending > 0)
+		g_main_context_iteration(NULL, TRUE);
+}
+
+static void
+test_resolver_cache_drain(void) {
+	while(g_main_context_iteration(NULL, FALSE))
+		;
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_resolver_cache_coalesce(void) {
+	TestStubResolver *stub = g_object_new(test_stub_resolver_get_type(), NULL);
+	GResolver *cache = purple_resolver_cache_new(G_RESOLVER(stub));
+	TestLookups lookups = { 0, };
+	GList *addresses;
+
+	/* Everyone asking at once shares one lookup, whatever the case */
+	test_resolver_cache_lookup(cache, "example.test", &lookups);
+	test_resolver_cache_lookup(cache, "example.test", &lookups);
+	test_resolver_cache_lookup(cache, "EXAMPLE.test", &lookups);
+	test_resolver_cache_wait(&lookups);
+	g_assert_cmpuint(lookups.found, ==, 3);
+	g_assert_cmpuint(stub->lookups, ==, 1);
+
+	/* Later lookups are answered from the cache, asynchronous or not */
+	test_resolver_cache_lookup(cache, "example.test", &lookups);
+	test_resolver_cache_wait(&lookups);
+	g_assert_cmpuint(lookups.found, ==, 4);
+
+	addresses = g_resolver_lookup_by_name(cache, "example.test", NULL, NULL);
+	g_assert_cmpuint(g_list_length(addresses), ==, 2);
+	g_resolver_free_addresses(addresses);
+	g_assert_cmpuint(stub->lookups, ==, 1);
+
+	/* IP addresses never reach the resolver */
+	addresses = g_resolver_lookup_by_name(cache, "192.0.2.1", NULL, NULL);
+	g_assert_cmpuint(g_list_length(addresses), ==, 1);
+	g_resolver_free_addresses(addresses);
+	g_assert_cmpuint(stub->lookups, ==, 1);
+
+	g_object_unref(cache);
+	g_object_unref(stub);
+}
+
+static void
+test_resolver_cache_negative(void) {
+	TestStubResolver *stub = g_object_new(test_stub_resolver_get_type(), NULL);
+	GResolver *cache = purple_resolver_cache_new(G_RESOLVER(stub));
+	TestLookups lookups = { 0, };
+
+	/* Names that don't exist are remembered... */
+	test_resolver_cache_lookup(cache, "missing.test", &lookups);
+	test_resolver_cache_wait(&lookups);
+	g_assert_error(lookups.error, G_RESOLVER_ERROR, G_RESOLVER_ERROR_NOT_FOUND);
+
+	test_resolver_cache_lookup(cache, "missing.test", &lookups);
+	test_resolver_cache_wait(&lookups);
+	g_assert_error(lookups.error, G_RESOLVER_ERROR, G_RESOLVER_ERROR_NOT_FOUND);
+	g_assert_cmpuint(stub->lookups, ==, 1);
+
+	/* ...but temporary failures are not */
+	test_resolver_cache_lookup(cache, "flaky.test", &lookups);
+	test_resolver_cache_wait(&lookups);
+	g_assert_error(lookups.error, G_RESOLVER_ERROR,
+	               G_RESOLVER_ERROR_TEMPORARY_FAILURE);
+
+	test_resolver_cache_lookup(cache, "flaky.test", &lookups);
+	test_resolver_cache_wait(&lookups);
+	g_assert_cmpuint(stub->lookups, ==, 3);
+
+	g_clear_error(&lookups.error);
+	g_assert_cmpuint(lookups.found, ==, 0);
+
+	g_object_unref(cache);
+	g_object_unref(stub);
+}
+
+static void
+test_resolver_cache_expiry(void) {
+	TestStubResolver *stub = g_object_new(test_stub_resolver_get_type(), NULL);
+	GResolver *cache = purple_resolver_cache_new(G_RESOLVER(stub));
+	TestLookups lookups = { 0, };
+
+	purple_resolver_cache_set_ttl(PURPLE_RESOLVER_CACHE(cache), 1, 1);
+
+	test_resolver_cache_lookup(cache, "example.test", &lookups);
+	test_resolver_cache_wait(&lookups);
+	g_assert_cmpuint(stub->lookups, ==, 1);
+
+	/* Using a name near the end of its lifetime answers from the cache
+	 * right away, and resolves it again in the background */
+	g_usleep(G_USEC_PER_SEC * 8 / 10);
+	test_resolver_cache_lookup(cache, "example.test", &lookups);
+	test_resolver_cache_wait(&lookups);
+	test_resolver_cache_drain();
+	g_assert_cmpuint(lookups.found, ==, 2);
+	g_assert_cmpuint(stub->lookups, ==, 2);
+
+	/* The refreshed answer is good for another second */
+	g_usleep(G_USEC_PER_SEC / 2);
+	test_resolver_cache_lookup(cache, "example.test", &lookups);
+	test_resolver_cache_wait(&lookups);
+	g_assert_cmpuint(stub->lookups, ==, 2);
+
+	/* Clearing the cache forgets everything */
+	purple_resolver_cache_clear(PURPLE_RESOLVER_CACHE(cache));
+	test_resolver_cache_lookup(cache, "example.test", &lookups);
+	test_resolver_cache_wait(&lookups);
+	g_assert_cmpuint(stub->lookups, ==, 3);
+
+	/* Including the answers of lookups still running */
+	test_resolver_cache_lookup(cache, "missing.test", &lookups);
+	purple_resolver_cache_clear(PURPLE_RESOLVER_CACHE(cache));
+	test_resolver_cache_wait(&lookups);
+	g_assert_error(lookups.error, G_RESOLVER_ERROR, G_RESOLVER_ERROR_NOT_FOUND);
+	test_resolver_cache_lookup(cache, "missing.test", &lookups);
+	test_resolver_cache_wait(&lookups);
+	g_assert_cmpuint(stub->lookups, ==, 5);
+
+	g_clear_error(&lookups.error);
+	g_object_unref(cache);
+	g_object_unref(stub);
+}
+
+static void
+test_resolver_cache_service_cb(GObject *source, GAsyncResult *res,
+                               gpointer data)
+{
+	guint *pending = data;
+	GList *targets;
+
+	targets = g_resolver_lookup_service_finish(G_RESOLVER(source), res, NULL);
+	g_assert_cmpuint(g_list_length(targets), ==, 1);
+	g_assert_cmpstr(g_srv_target_get_hostname(targets->data), ==,
+	                "stun.example.test");
+	g_assert_cmpuint(g_srv_target_get_port(targets->data), ==, 3478);
+	g_resolver_free_targets(targets);
+
+	(*pending)--;
+}
+
+static void
+test_resolver_cache_service(void) {
+	TestStubResolver *stub = g_object_new(test_stub_resolver_get_type(), NULL);
+	GResolver *cache = purple_resolver_cache_new(G_RESOLVER(stub));
+	guint pending = 2, i;
+
+	for(i = 0; i < 2; i++) {
+		g_resolver_lookup_service_async(cache, "stun", "udp", "example.test",
+		                                NULL, test_resolver_cache_service_cb,
+		                                &pending);
+	}
+	while(pending > 0)
+		g_main_context_iteration(NULL, TRUE);
+	g_assert_cmpuint(stub->lookups, ==, 1);
+
+	pending = 1;
+	g_resolver_lookup_service_async(cache, "stun", "udp", "example.test",
+	                                NULL, test_resolver_cache_service_cb,
+	                                &pending);
+	while(pending > 0)
+		g_main_context_iteration(NULL, TRUE);
+	g_assert_cmpuint(stub->lookups, ==, 1);
+
+	g_object_unref(cache);
+	g_object_unref(stub);
+}
+
+gint
+main(gint argc, gchar **argv) {
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/resolvercache/coalesce",
+	                test_resolver_cache_coalesce);
+	g_test_add_func("/resolvercache/negative",
+	                test_resolver_cache_negative);
+	g_test_add_func("/resolvercache/expiry",
+	                test_resolver_cache_expiry);
+	g_test_add_func("/resolvercache/service",
+	                test_resolver_cache_service);
+
+	return g_test_run();
+}
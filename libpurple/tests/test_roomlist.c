@@ -0,0 +1,330 @@
+/*
+ * Purple
+ *
+ * Purple is the legal property of its developers, whose names are too
+ * numerous to list here. Please refer to the COPYRIGHT file distributed
+ * with this source distribution
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02111-1301 USA
+ */
+
+#include <glib.h>
+
+#include <purple.h>
+
+/* More than two batches' worth */
+#define ROOMS 2500
+
+/* What the UI has been told, in order */
+static GPtrArray *given = NULL;
+static gboolean done = FALSE;
+static guint given_when_done = 0;
+static guint batches = 0;
+static guint clears = 0;
+static GMainLoop *loop = NULL;
+
+/******************************************************************************
+ * UI ops
+ *****************************************************************************/
+static void
+test_roomlist_add_room(PurpleRoomlist *list, PurpleRoomlistRoom *room) {
+	/* Only a new filter gives rooms again once the listing is done. */
+	g_assert(!done || clears > 0);
+
+	g_ptr_array_add(given, room);
+}
+
+static void
+test_roomlist_add_rooms(PurpleRoomlist *list, GList *rooms) {
+	g_assert(rooms != NULL);
+	g_assert(!done || clears > 0);
+
+	batches++;
+	for(; rooms != NULL; rooms = rooms->next)
+		g_ptr_array_add(given, rooms->data);
+}
+
+static void
+test_roomlist_in_progress(PurpleRoomlist *list, gboolean flag) {
+	if(flag)
+		return;
+
+	g_assert(!done);
+	done = TRUE;
+	given_when_done = given->len;
+
+	if(loop != NULL)
+		g_main_loop_quit(loop);
+}
+
+static void
+test_roomlist_clear(PurpleRoomlist *list) {
+	clears++;
+	g_ptr_array_set_size(given, 0);
+}
+
+static PurpleRoomlistUiOps test_roomlist_ui_ops = {
+	NULL,
+	NULL,
+	NULL,
+	test_roomlist_add_room,
+	test_roomlist_in_progress,
+	NULL,
+	NULL,
+	test_roomlist_clear,
+	NULL,
+	NULL
+};
+
+static PurpleEventLoopUiOps test_roomlist_eventloop = {
+	g_timeout_add,
+	g_source_remove,
+	NULL,
+	NULL,
+	NULL,
+	g_timeout_add_seconds,
+
+	/* padding */
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static PurpleRoomlist *
+test_roomlist_new(gboolean batched) {
+	test_roomlist_ui_ops.add_rooms = batched ? test_roomlist_add_rooms : NULL;
+	purple_roomlist_set_ui_ops(&test_roomlist_ui_ops);
+
+	given = g_ptr_array_new();
+	done = FALSE;
+	given_when_done = 0;
+	batches = 0;
+	clears = 0;
+
+	return g_object_new(PURPLE_TYPE_ROOMLIST, NULL);
+}
+
+/* Adds the rooms, returning them in the order they were added. */
+static GPtrArray *
+test_roomlist_add(PurpleRoomlist *list, guint count) {
+	GPtrArray *rooms = g_ptr_array_new();
+	guint i;
+
+	purple_roomlist_set_in_progress(list, TRUE);
+
+	for(i = 0; i < count; i++) {
+		gchar *name = g_strdup_printf("room%u", i);
+		PurpleRoomlistRoom *room;
+
+		room = purple_roomlist_room_new(PURPLE_ROOMLIST_ROOMTYPE_ROOM,
+		                                name, NULL);
+		purple_roomlist_room_add(list, room);
+		g_ptr_array_add(rooms, room);
+		g_free(name);
+	}
+
+	purple_roomlist_set_in_progress(list, FALSE);
+
+	return rooms;
+}
+
+static void
+test_roomlist_assert_given(GPtrArray *rooms) {
+	guint i;
+
+	g_assert_cmpuint(rooms->len, ==, given->len);
+	for(i = 0; i < rooms->len; i++)
+		g_assert(g_ptr_array_index(rooms, i) == g_ptr_array_index(given, i));
+}
+
+/* Returns the rooms whose name starts with prefix, in order. */
+static GPtrArray *
+test_roomlist_matching(GPtrArray *rooms, const gchar *prefix) {
+	GPtrArray *matching = g_ptr_array_new();
+	guint i;
+
+	for(i = 0; i < rooms->len; i++) {
+		PurpleRoomlistRoom *room = g_ptr_array_index(rooms, i);
+
+		if(g_str_has_prefix(purple_roomlist_room_get_name(room), prefix))
+			g_ptr_array_add(matching, room);
+	}
+
+	return matching;
+}
+
+static gboolean
+test_roomlist_quit_cb(gpointer data) {
+	g_main_loop_quit(loop);
+
+	return FALSE;
+}
+
+static void
+test_roomlist_free(PurpleRoomlist *list, GPtrArray *rooms) {
+	g_object_unref(list);
+	g_ptr_array_free(rooms, TRUE);
+	g_ptr_array_free(given, TRUE);
+	given = NULL;
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_roomlist_unbatched(void) {
+	PurpleRoomlist *list = test_roomlist_new(FALSE);
+	GPtrArray *rooms = test_roomlist_add(list, ROOMS);
+
+	/* Without add_rooms, each room is given as it's added. */
+	g_assert(done);
+	g_assert_cmpuint(ROOMS, ==, given_when_done);
+	test_roomlist_assert_given(rooms);
+
+	test_roomlist_free(list, rooms);
+}
+
+static void
+test_roomlist_batched(void) {
+	PurpleRoomlist *list = test_roomlist_new(TRUE);
+	GPtrArray *rooms = test_roomlist_add(list, ROOMS);
+
+	/* The protocol is done, but the UI hasn't been given anything. */
+	g_assert(!purple_roomlist_get_in_progress(list));
+	g_assert(!done);
+	g_assert_cmpuint(0, ==, given->len);
+
+	loop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(loop);
+	g_main_loop_unref(loop);
+	loop = NULL;
+
+	/* The UI heard the listing was done only after it had every room. */
+	g_assert(done);
+	g_assert_cmpuint(ROOMS, ==, given_when_done);
+	test_roomlist_assert_given(rooms);
+
+	test_roomlist_free(list, rooms);
+}
+
+static void
+test_roomlist_batched_filter(void) {
+	PurpleRoomlist *list = test_roomlist_new(TRUE);
+	GPtrArray *rooms, *matching;
+
+	purple_roomlist_set_filter(list, "ROOM1");
+	rooms = test_roomlist_add(list, ROOMS);
+
+	loop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(loop);
+	g_main_loop_unref(loop);
+	loop = NULL;
+
+	/* Only the matching rooms were given, still in order. */
+	matching = test_roomlist_matching(rooms, "room1");
+
+	g_assert(done);
+	g_assert_cmpuint(matching->len, ==, given_when_done);
+	test_roomlist_assert_given(matching);
+
+	g_ptr_array_free(matching, TRUE);
+	test_roomlist_free(list, rooms);
+}
+
+static void
+test_roomlist_filter_change(void) {
+	PurpleRoomlist *list = test_roomlist_new(FALSE);
+	GPtrArray *rooms = test_roomlist_add(list, ROOMS);
+	GPtrArray *matching;
+
+	/* Narrowing the filter takes back every room and gives the matching
+	 * ones again, in the order they were added. */
+	purple_roomlist_set_filter(list, "Room2");
+	g_assert_cmpuint(1, ==, clears);
+	matching = test_roomlist_matching(rooms, "room2");
+	test_roomlist_assert_given(matching);
+	g_ptr_array_free(matching, TRUE);
+
+	/* The rooms that didn't match were kept for a wider filter. */
+	purple_roomlist_set_filter(list, "room");
+	g_assert_cmpuint(2, ==, clears);
+	test_roomlist_assert_given(rooms);
+
+	/* The same filter again changes nothing. */
+	purple_roomlist_set_filter(list, "ROOM");
+	g_assert_cmpuint(2, ==, clears);
+
+	purple_roomlist_set_filter(list, NULL);
+	g_assert_cmpuint(3, ==, clears);
+	test_roomlist_assert_given(rooms);
+
+	test_roomlist_free(list, rooms);
+}
+
+static void
+test_roomlist_batched_cancel(void) {
+	PurpleRoomlist *list = test_roomlist_new(TRUE);
+	GPtrArray *rooms = test_roomlist_add(list, ROOMS);
+	guint given_at_cancel;
+
+	/* Wait for the first batch only. */
+	while(batches == 0)
+		g_main_context_iteration(NULL, TRUE);
+	g_assert_cmpuint(1, ==, batches);
+	g_assert_cmpuint(ROOMS, >, given->len);
+	g_assert(!done);
+
+	/* The protocol was done before the UI cancelled, so the UI is told
+	 * that now, once. */
+	purple_roomlist_cancel_get_list(list);
+	g_assert(done);
+	given_at_cancel = given->len;
+
+	/* Give the batch timer more than enough time to fire again. */
+	loop = g_main_loop_new(NULL, FALSE);
+	g_timeout_add(1000, test_roomlist_quit_cb, NULL);
+	g_main_loop_run(loop);
+	g_main_loop_unref(loop);
+	loop = NULL;
+
+	g_assert_cmpuint(1, ==, batches);
+	g_assert_cmpuint(given_at_cancel, ==, given->len);
+
+	test_roomlist_free(list, rooms);
+}
+
+gint
+main(gint argc, gchar **argv) {
+	g_test_init(&argc, &argv, NULL);
+
+	purple_eventloop_set_ui_ops(&test_roomlist_eventloop);
+
+	g_test_add_func("/roomlist/unbatched",
+	                test_roomlist_unbatched);
+	g_test_add_func("/roomlist/batched",
+	                test_roomlist_batched);
+	g_test_add_func("/roomlist/batched/filter",
+	                test_roomlist_batched_filter);
+	g_test_add_func("/roomlist/batched/cancel",
+	                test_roomlist_batched_cancel);
+	g_test_add_func("/roomlist/filter/change",
+	                test_roomlist_filter_change);
+
+	return g_test_run();
+}
@@ -0,0 +1,315 @@
+/*
+ * Purple
+ *
+ * Purple is the legal property of its developers, whose names are too
+ * numerous to list here. Please refer to the COPYRIGHT file distributed
+ * with this source distribution
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02111-1301 USA
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include "spellchk-dict.h"
+
+/* The synthetic dictionary and corpus for the replay */
+#define REPLAY_ROWS 2000
+#define REPLAY_WORDS 10000
+#define SEED 0x5bd1e995
+
+static void
+test_spellchk_dict_assert_word(SpellchkDict *dict, const gchar *word,
+                               const gchar *expected)
+{
+	gchar *good = spellchk_dict_substitute_word(dict, word);
+
+	g_assert_cmpstr(expected, ==, good);
+	g_free(good);
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_spellchk_dict_word_case_insensitive(void) {
+	SpellchkDict *dict = spellchk_dict_new();
+
+	spellchk_dict_add(dict, "teh", "the", TRUE, FALSE);
+
+	/* A lowercase replacement takes the case of the word it replaces. */
+	test_spellchk_dict_assert_word(dict, "teh", "the");
+	test_spellchk_dict_assert_word(dict, "Teh", "The");
+	test_spellchk_dict_assert_word(dict, "TEH", "THE");
+	test_spellchk_dict_assert_word(dict, "tEh", "the");
+
+	test_spellchk_dict_assert_word(dict, "tehs", NULL);
+	test_spellchk_dict_assert_word(dict, "", NULL);
+	test_spellchk_dict_assert_word(dict, NULL, NULL);
+
+	spellchk_dict_free(dict);
+}
+
+static void
+test_spellchk_dict_word_case_sensitive(void) {
+	SpellchkDict *dict = spellchk_dict_new();
+
+	spellchk_dict_add(dict, "IM", "instant message", TRUE, TRUE);
+	spellchk_dict_add(dict, "pidgin", "Pidgin", TRUE, TRUE);
+
+	test_spellchk_dict_assert_word(dict, "IM", "instant message");
+	test_spellchk_dict_assert_word(dict, "im", NULL);
+	test_spellchk_dict_assert_word(dict, "Im", NULL);
+
+	/* The replacement is used as it was written. */
+	test_spellchk_dict_assert_word(dict, "pidgin", "Pidgin");
+	test_spellchk_dict_assert_word(dict, "PIDGIN", NULL);
+
+	spellchk_dict_free(dict);
+}
+
+static void
+test_spellchk_dict_word_folded(void) {
+	SpellchkDict *dict = spellchk_dict_new();
+
+	/* Mixed case words are compared casefolded, and aren't adapted. */
+	spellchk_dict_add(dict, "Straße", "street", TRUE, FALSE);
+	spellchk_dict_add(dict, "aNd", "And", TRUE, FALSE);
+
+	test_spellchk_dict_assert_word(dict, "Straße", "street");
+	test_spellchk_dict_assert_word(dict, "STRASSE", "street");
+	test_spellchk_dict_assert_word(dict, "strasse", "street");
+
+	test_spellchk_dict_assert_word(dict, "and", "And");
+	test_spellchk_dict_assert_word(dict, "AND", "And");
+
+	spellchk_dict_free(dict);
+}
+
+static void
+test_spellchk_dict_word_first_row(void) {
+	SpellchkDict *dict = spellchk_dict_new();
+
+	spellchk_dict_add(dict, "recieve", "receive", TRUE, FALSE);
+	spellchk_dict_add(dict, "recieve", "RECEIVE", TRUE, FALSE);
+	spellchk_dict_add(dict, "Ok", "OK", TRUE, TRUE);
+	spellchk_dict_add(dict, "ok", "okay", TRUE, FALSE);
+	spellchk_dict_add(dict, "", "nothing", TRUE, FALSE);
+	spellchk_dict_add(dict, "thx", NULL, TRUE, FALSE);
+	spellchk_dict_add(dict, "thx", "thanks", TRUE, FALSE);
+
+	test_spellchk_dict_assert_word(dict, "recieve", "receive");
+
+	/* Each table has a match, and the row closer to the top wins. */
+	test_spellchk_dict_assert_word(dict, "Ok", "OK");
+	test_spellchk_dict_assert_word(dict, "ok", "okay");
+	test_spellchk_dict_assert_word(dict, "OK", "OKAY");
+
+	/* Rows without a replacement are skipped. */
+	test_spellchk_dict_assert_word(dict, "", NULL);
+	test_spellchk_dict_assert_word(dict, "thx", "thanks");
+
+	spellchk_dict_free(dict);
+}
+
+static void
+test_spellchk_dict_phrase(void) {
+	SpellchkDict *dict = spellchk_dict_new();
+	const gchar *good = NULL;
+
+	g_assert(spellchk_dict_find_phrase(dict, "c u later", &good) == NULL);
+
+	spellchk_dict_add(dict, "teh", "the", TRUE, FALSE);
+	spellchk_dict_add(dict, "c u", "see you", FALSE, FALSE);
+	spellchk_dict_add(dict, "(c)", "©", FALSE, FALSE);
+
+	g_assert_cmpstr("c u", ==,
+	                spellchk_dict_find_phrase(dict, "ok c u later", &good));
+	g_assert_cmpstr("see you", ==, good);
+	g_assert_cmpstr("(c)", ==,
+	                spellchk_dict_find_phrase(dict, "Pidgin (c)", &good));
+	g_assert_cmpstr("©", ==, good);
+
+	/* Whole words aren't phrases, and phrases aren't whole words. */
+	g_assert(spellchk_dict_find_phrase(dict, "teh end", NULL) == NULL);
+	test_spellchk_dict_assert_word(dict, "c u", NULL);
+	g_assert(spellchk_dict_find_phrase(dict, NULL, NULL) == NULL);
+
+	spellchk_dict_free(dict);
+}
+
+static void
+test_spellchk_dict_phrase_suffix(void) {
+	SpellchkDict *dict = spellchk_dict_new();
+	const gchar *good = NULL;
+
+	/* The longer phrase ends where the shorter one does, but the shorter
+	 * one is closer to the top. */
+	spellchk_dict_add(dict, "bc", "first", FALSE, FALSE);
+	spellchk_dict_add(dict, "abc", "second", FALSE, FALSE);
+
+	g_assert_cmpstr("bc", ==, spellchk_dict_find_phrase(dict, "xabc", &good));
+	g_assert_cmpstr("first", ==, good);
+
+	spellchk_dict_free(dict);
+
+	dict = spellchk_dict_new();
+	spellchk_dict_add(dict, "abc", "first", FALSE, FALSE);
+	spellchk_dict_add(dict, "bc", "second", FALSE, FALSE);
+
+	g_assert_cmpstr("abc", ==, spellchk_dict_find_phrase(dict, "xabc", &good));
+	g_assert_cmpstr("first", ==, good);
+
+	spellchk_dict_free(dict);
+}
+
+/******************************************************************************
+ * Replay
+ *
+ * Looks up a synthetic corpus in a large synthetic list, once the way the
+ * plugin used to, by comparing every word with every row, and once with the
+ * dictionary.
+ *****************************************************************************/
+typedef struct {
+	gchar *bad;
+	gchar *folded;
+	gchar *good;
+	gboolean case_sensitive;
+} TestRow;
+
+static guint
+test_spellchk_dict_legacy(TestRow *rows, gchar **corpus) {
+	guint hits = 0;
+	guint i, j;
+
+	for(i = 0; corpus[i] != NULL; i++) {
+		gchar *folded = g_utf8_casefold(corpus[i], -1);
+
+		for(j = 0; j < REPLAY_ROWS; j++) {
+			if(rows[j].case_sensitive ?
+			   strcmp(corpus[i], rows[j].bad) == 0 :
+			   strcmp(folded, rows[j].folded) == 0)
+			{
+				hits++;
+				break;
+			}
+		}
+
+		g_free(folded);
+	}
+
+	return hits;
+}
+
+static guint
+test_spellchk_dict_lookup(SpellchkDict *dict, gchar **corpus) {
+	guint hits = 0;
+	guint i;
+
+	for(i = 0; corpus[i] != NULL; i++) {
+		gchar *good = spellchk_dict_substitute_word(dict, corpus[i]);
+
+		if(good != NULL) {
+			hits++;
+			g_free(good);
+		}
+	}
+
+	return hits;
+}
+
+static void
+test_spellchk_dict_replay(void) {
+	TestRow *rows = g_new0(TestRow, REPLAY_ROWS);
+	gchar **corpus = g_new0(gchar *, REPLAY_WORDS + 1);
+	GRand *rand = g_rand_new_with_seed(SEED);
+	SpellchkDict *dict = spellchk_dict_new();
+	gdouble legacy_time, dict_time;
+	guint runs = g_test_perf() ? 20 : 1;
+	guint expected, i;
+
+	for(i = 0; i < REPLAY_ROWS; i++) {
+		rows[i].bad = g_strdup_printf("mispel%u", i);
+		rows[i].folded = g_utf8_casefold(rows[i].bad, -1);
+		rows[i].good = g_strdup_printf("misspell%u", i);
+		rows[i].case_sensitive = (i % 10 == 0);
+		spellchk_dict_add(dict, rows[i].bad, rows[i].good, TRUE,
+		                  rows[i].case_sensitive);
+	}
+
+	/* About half the words are in the list, some of them capitalized, the
+	 * way a misspelling at the start of a sentence would be. */
+	for(i = 0; i < REPLAY_WORDS; i++) {
+		guint row = g_rand_int_range(rand, 0, REPLAY_ROWS * 2);
+
+		if(row >= REPLAY_ROWS)
+			corpus[i] = g_strdup_printf("word%u", row);
+		else if(g_rand_int_range(rand, 0, 4) == 0)
+			corpus[i] = g_strdup_printf("Mispel%u", row);
+		else
+			corpus[i] = g_strdup(rows[row].bad);
+	}
+
+	expected = test_spellchk_dict_legacy(rows, corpus);
+	g_assert_cmpuint(0, <, expected);
+
+	g_test_timer_start();
+	for(i = 0; i < runs; i++)
+		g_assert_cmpuint(expected, ==, test_spellchk_dict_legacy(rows, corpus));
+	legacy_time = g_test_timer_elapsed() / runs;
+
+	g_test_timer_start();
+	for(i = 0; i < runs; i++)
+		g_assert_cmpuint(expected, ==, test_spellchk_dict_lookup(dict, corpus));
+	dict_time = g_test_timer_elapsed() / runs;
+
+	g_test_message("%u rows, %u words, %u replaced: "
+	               "%f seconds before, %f seconds with the dictionary",
+	               REPLAY_ROWS, REPLAY_WORDS, expected, legacy_time, dict_time);
+	g_test_minimized_result(dict_time, "substitute_word replay in %f seconds",
+	                        dict_time);
+
+	for(i = 0; i < REPLAY_ROWS; i++) {
+		g_free(rows[i].bad);
+		g_free(rows[i].folded);
+		g_free(rows[i].good);
+	}
+	g_free(rows);
+	g_strfreev(corpus);
+	g_rand_free(rand);
+	spellchk_dict_free(dict);
+}
+
+gint
+main(gint argc, gchar **argv) {
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/spellchk/dict/word/case-insensitive",
+	                test_spellchk_dict_word_case_insensitive);
+	g_test_add_func("/spellchk/dict/word/case-sensitive",
+	                test_spellchk_dict_word_case_sensitive);
+	g_test_add_func("/spellchk/dict/word/folded",
+	                test_spellchk_dict_word_folded);
+	g_test_add_func("/spellchk/dict/word/first-row",
+	                test_spellchk_dict_word_first_row);
+	g_test_add_func("/spellchk/dict/phrase",
+	                test_spellchk_dict_phrase);
+	g_test_add_func("/spellchk/dict/phrase/suffix",
+	                test_spellchk_dict_phrase_suffix);
+	g_test_add_func("/spellchk/dict/replay",
+	                test_spellchk_dict_replay);
+
+	return g_test_run();
+}
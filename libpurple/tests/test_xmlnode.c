@@ -1,5 +1,6 @@
 #include <glib.h>
 
+#include "../memstat.h"
 #include "../xmlnode.h"
 
 /*
@@ -111,6 +112,43 @@ test_strip_prefixes(void) {
 	purple_xmlnode_free(xml);
 }
 
+static void
+test_xmlnode_memstat(void) {
+	const char *xml_doc = "<iq type='result' id='1'>"
+		"<query xmlns='jabber:iq:roster'>"
+			"<item jid='buddy@example.com' name='Buddy'><group>Friends</group></item>"
+		"</query>"
+	"</iq>";
+	PurpleXmlNode *xml, *copy;
+	gssize count, bytes;
+
+	/* Without accounting, every counter reads zero. */
+	if (!purple_memstat_is_enabled())
+		return;
+
+	count = purple_memstat_get_count(PURPLE_MEMSTAT_XMLNODES);
+	bytes = purple_memstat_get_bytes(PURPLE_MEMSTAT_XMLNODES);
+
+	xml = purple_xmlnode_from_str(xml_doc, -1);
+	g_assert_nonnull(xml);
+	purple_xmlnode_set_attrib(xml, "to", "me@example.com");
+	purple_xmlnode_insert_data(purple_xmlnode_new_child(xml, "status"),
+	                           "Away", -1);
+	copy = purple_xmlnode_copy(xml);
+
+	g_assert_cmpint(purple_memstat_get_count(PURPLE_MEMSTAT_XMLNODES), >, count);
+	g_assert_cmpint(purple_memstat_get_bytes(PURPLE_MEMSTAT_XMLNODES), >, bytes);
+
+	/* Replacing an attribute frees the old one. */
+	purple_xmlnode_set_attrib(copy, "to", "you@example.com");
+
+	purple_xmlnode_free(xml);
+	purple_xmlnode_free(copy);
+
+	g_assert_cmpint(purple_memstat_get_count(PURPLE_MEMSTAT_XMLNODES), ==, count);
+	g_assert_cmpint(purple_memstat_get_bytes(PURPLE_MEMSTAT_XMLNODES), ==, bytes);
+}
+
 gint
 main(gint argc, gchar **argv) {
 	g_test_init(&argc, &argv, NULL);
@@ -121,6 +159,8 @@ main(gint argc, gchar **argv) {
 	                test_xmlnode_prefixes);
 	g_test_add_func("/xmlnode/strip_prefixes",
 	                test_strip_prefixes);
+	g_test_add_func("/xmlnode/memstat",
+	                test_xmlnode_memstat);
 
 	return g_test_run();
 }
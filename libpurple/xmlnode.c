@@ -42,6 +42,19 @@
 # define NEWLINE_S "\n"
 #endif
 
+#ifdef ENABLE_MEMSTAT
+/* Attributes keep their value as a string, without a data_sz. */
+static gsize
+xmlnode_data_size(const PurpleXmlNode *node)
+{
+	if (node->data_sz > 0)
+		return node->data_sz;
+	if (node->data != NULL)
+		return strlen(node->data) + 1;
+	return 0;
+}
+#endif
+
 static PurpleXmlNode*
 new_node(const char *name, PurpleXmlNodeType type)
 {
@@ -50,6 +63,8 @@ new_node(const char *name, PurpleXmlNodeType type)
 	node->name = g_strdup(name);
 	node->type = type;
 
+	PURPLE_MEMSTAT_ALLOC(PURPLE_MEMSTAT_XMLNODES, sizeof(PurpleXmlNode));
+
 //	PURPLE_DBUS_REGISTER_POINTER(node, PurpleXmlNode);
 
 	return node;
@@ -124,6 +139,7 @@ purple_xmlnode_insert_data(PurpleXmlNode *node, const char *data, gssize size)
 
 	child->data = g_memdup(data, real_size);
 	child->data_sz = real_size;
+	PURPLE_MEMSTAT_RESIZE(PURPLE_MEMSTAT_XMLNODES, xmlnode_data_size(child));
 
 	purple_xmlnode_insert_child(node, child);
 }
@@ -212,6 +228,8 @@ purple_xmlnode_set_attrib_full(PurpleXmlNode *node, const char *attr, const char
 	attrib_node = new_node(attr, PURPLE_XMLNODE_TYPE_ATTRIB);
 
 	attrib_node->data = g_strdup(value);
+	PURPLE_MEMSTAT_RESIZE(PURPLE_MEMSTAT_XMLNODES,
+			xmlnode_data_size(attrib_node));
 	attrib_node->xmlns = g_strdup(xmlns);
 	attrib_node->prefix = g_strdup(prefix);
 
@@ -407,6 +425,8 @@ purple_xmlnode_free(PurpleXmlNode *node)
 	}
 
 	/* now dispose of ourselves */
+	PURPLE_MEMSTAT_FREE(PURPLE_MEMSTAT_XMLNODES,
+			sizeof(PurpleXmlNode) + xmlnode_data_size(node));
 	g_free(node->name);
 	g_free(node->data);
 	g_free(node->xmlns);
@@ -917,6 +937,7 @@ purple_xmlnode_copy(const PurpleXmlNode *src)
 		} else {
 			ret->data = g_strdup(src->data);
 		}
+		PURPLE_MEMSTAT_RESIZE(PURPLE_MEMSTAT_XMLNODES, xmlnode_data_size(ret));
 	}
 	ret->prefix = g_strdup(src->prefix);
 	if (src->namespace_map) {
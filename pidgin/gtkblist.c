@@ -122,12 +122,25 @@ typedef struct
 
 	guint select_notebook_page_timeout;
 
-
+	/* Nodes whose rows need to be recomputed on the next flush; used as a
+	 * set, keyed by PurpleBlistNode.
+	 */
+	GHashTable *dirty_nodes;
+	guint flush_timeout;
+
+	/* Counters for the debug window's Statistics button. */
+	guint64 updates_requested;
+	guint64 updates_performed;
+	guint64 group_updates_deferred;
+	guint64 flushes;
 } PidginBuddyListPrivate;
 
 #define PIDGIN_BUDDY_LIST_GET_PRIVATE(list) \
 	((PidginBuddyListPrivate *)((list)->priv))
 
+/* How often queued node updates are flushed to the tree store (~30 fps). */
+#define PIDGIN_BLIST_FLUSH_INTERVAL 33
+
 #define PIDGIN_WINDOW_ICONIFIED(x) \
 	(gdk_window_get_state(gtk_widget_get_window(GTK_WIDGET(x))) & \
 	GDK_WINDOW_STATE_ICONIFIED)
@@ -155,6 +168,11 @@ static GtkActionGroup *sort_action_group = NULL;
 
 static PidginBuddyList *gtkblist = NULL;
 
+/* While a flush is running, group updates triggered by the buddies, contacts
+ * and chats being updated are collected here and performed once at the end.
+ */
+static GHashTable *deferred_groups = NULL;
+
 static GList *groups_tree(void);
 static gboolean pidgin_blist_refresh_timer(PurpleBuddyList *list);
 static void pidgin_blist_update_buddy(PurpleBuddyList *list, PurpleBlistNode *node, gboolean status_change);
@@ -4874,8 +4892,11 @@ static void pidgin_blist_new_list(PurpleBuddyList *blist)
 {
 	PidginBuddyList *gtkblist;
 
+	PidginBuddyListPrivate *priv;
+
 	gtkblist = g_new0(PidginBuddyList, 1);
-	gtkblist->priv = g_new0(PidginBuddyListPrivate, 1);
+	gtkblist->priv = priv = g_new0(PidginBuddyListPrivate, 1);
+	priv->dirty_nodes = g_hash_table_new(g_direct_hash, g_direct_equal);
 
 	blist->ui_data = gtkblist;
 }
@@ -6207,6 +6228,13 @@ static void pidgin_blist_remove(PurpleBuddyList *list, PurpleBlistNode *node)
 
 	purple_request_close_with_handle(node);
 
+	if (gtkblist) {
+		PidginBuddyListPrivate *priv = PIDGIN_BUDDY_LIST_GET_PRIVATE(gtkblist);
+		g_hash_table_remove(priv->dirty_nodes, node);
+	}
+	if (deferred_groups)
+		g_hash_table_remove(deferred_groups, node);
+
 	pidgin_blist_hide_node(list, node, TRUE);
 
 	if(node->parent)
@@ -6376,6 +6404,25 @@ static void pidgin_blist_update_group(PurpleBuddyList *list,
 	else
 		return;
 
+	if (deferred_groups != NULL && node != gnode) {
+		GtkTreeIter iter;
+
+		/* A group that isn't in the tree yet has to be inserted right away,
+		 * since its children need its row to attach to.  Otherwise remember
+		 * the group, preferring a displayable buddy as the node to update
+		 * it with, since that can keep an otherwise empty group visible.
+		 */
+		if (get_iter_from_node(gnode, &iter)) {
+			PurpleBlistNode *prev = g_hash_table_lookup(deferred_groups, gnode);
+
+			if (prev == NULL || !PURPLE_IS_BUDDY(prev) ||
+			    !buddy_is_displayable((PurpleBuddy *)prev))
+				g_hash_table_insert(deferred_groups, gnode, node);
+			PIDGIN_BUDDY_LIST_GET_PRIVATE(gtkblist)->group_updates_deferred++;
+			return;
+		}
+	}
+
 	group = (PurpleGroup*)gnode;
 
 	show_offline = purple_prefs_get_bool(PIDGIN_PREFS_ROOT "/blist/show_offline_buddies");
@@ -6853,11 +6900,17 @@ static void pidgin_blist_update_chat(PurpleBuddyList *list, PurpleBlistNode *nod
 
 static void pidgin_blist_update(PurpleBuddyList *list, PurpleBlistNode *node)
 {
+	PidginBuddyListPrivate *priv;
+
 	if (list)
 		gtkblist = PIDGIN_BLIST(list);
 	if(!gtkblist || !gtkblist->treeview || !node)
 		return;
 
+	priv = PIDGIN_BUDDY_LIST_GET_PRIVATE(gtkblist);
+	g_hash_table_remove(priv->dirty_nodes, node);
+	priv->updates_performed++;
+
 	if (purple_blist_node_get_ui_data(node) == NULL)
 		pidgin_blist_new_node(node);
 
@@ -6871,6 +6924,95 @@ static void pidgin_blist_update(PurpleBuddyList *list, PurpleBlistNode *node)
 		pidgin_blist_update_chat(list, node);
 }
 
+static gboolean
+pidgin_blist_flush_updates(gpointer data)
+{
+	PurpleBuddyList *list = purple_blist_get_buddy_list();
+	PidginBuddyListPrivate *priv;
+	GHashTable *dirty;
+	GHashTableIter iter;
+	gpointer node, update_node;
+
+	if (!gtkblist)
+		return FALSE;
+
+	priv = PIDGIN_BUDDY_LIST_GET_PRIVATE(gtkblist);
+	priv->flush_timeout = 0;
+	priv->flushes++;
+
+	/* Anything queued while we're flushing waits for the next frame. */
+	dirty = priv->dirty_nodes;
+	priv->dirty_nodes = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	deferred_groups = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	g_hash_table_iter_init(&iter, dirty);
+	while (g_hash_table_iter_next(&iter, &node, NULL)) {
+		if (PURPLE_IS_GROUP(node))
+			g_hash_table_insert(deferred_groups, node, node);
+		else
+			pidgin_blist_update(list, node);
+	}
+	g_hash_table_destroy(dirty);
+
+	dirty = deferred_groups;
+	deferred_groups = NULL;
+
+	g_hash_table_iter_init(&iter, dirty);
+	while (g_hash_table_iter_next(&iter, &node, &update_node)) {
+		if (update_node == node)
+			pidgin_blist_update(list, node);
+		else
+			pidgin_blist_update_group(list, update_node);
+	}
+	g_hash_table_destroy(dirty);
+
+	return FALSE;
+}
+
+/* The UI op for node updates.  libpurple tends to report the same node
+ * several times in a row (e.g. status, idle and icon changes during a
+ * sign-on burst), so mark it dirty and redraw everything at most once per
+ * frame.
+ */
+static void pidgin_blist_queue_update(PurpleBuddyList *list, PurpleBlistNode *node)
+{
+	PidginBuddyListPrivate *priv;
+
+	if (list)
+		gtkblist = PIDGIN_BLIST(list);
+	if(!gtkblist || !gtkblist->treeview || !node)
+		return;
+
+	priv = PIDGIN_BUDDY_LIST_GET_PRIVATE(gtkblist);
+	priv->updates_requested++;
+
+	g_hash_table_add(priv->dirty_nodes, node);
+
+	if (priv->flush_timeout == 0)
+		priv->flush_timeout = purple_timeout_add(PIDGIN_BLIST_FLUSH_INTERVAL,
+				pidgin_blist_flush_updates, NULL);
+}
+
+static void
+pidgin_blist_statistics_cb(void)
+{
+	PidginBuddyListPrivate *priv;
+
+	if (!gtkblist)
+		return;
+
+	priv = PIDGIN_BUDDY_LIST_GET_PRIVATE(gtkblist);
+
+	purple_debug_info("gtkblist", "Node updates: %" G_GUINT64_FORMAT
+			" requested, %" G_GUINT64_FORMAT " performed in %"
+			G_GUINT64_FORMAT " flushes, %" G_GUINT64_FORMAT
+			" group updates deferred, %u pending\n",
+			priv->updates_requested, priv->updates_performed,
+			priv->flushes, priv->group_updates_deferred,
+			g_hash_table_size(priv->dirty_nodes));
+}
+
 static void pidgin_blist_destroy(PurpleBuddyList *list)
 {
 	PidginBuddyListPrivate *priv;
@@ -6908,6 +7050,9 @@ static void pidgin_blist_destroy(PurpleBuddyList *list)
 		g_object_unref(priv->current_theme);
 	if (priv->select_notebook_page_timeout)
 		purple_timeout_remove(priv->select_notebook_page_timeout);
+	if (priv->flush_timeout)
+		purple_timeout_remove(priv->flush_timeout);
+	g_hash_table_destroy(priv->dirty_nodes);
 	g_free(priv);
 
 	g_free(gtkblist);
@@ -7412,7 +7557,7 @@ static PurpleBlistUiOps blist_ui_ops =
 	pidgin_blist_new_list,
 	pidgin_blist_new_node,
 	pidgin_blist_show,
-	pidgin_blist_update,
+	pidgin_blist_queue_update,
 	pidgin_blist_remove,
 	pidgin_blist_destroy,
 	pidgin_blist_set_visible,
@@ -7594,6 +7739,9 @@ void pidgin_blist_init(void)
 	purple_signal_connect_priority(purple_connections_get_handle(), "autojoin",
 	                               gtk_blist_handle, PURPLE_CALLBACK(autojoin_cb),
 	                               NULL, PURPLE_SIGNAL_PRIORITY_HIGHEST);
+
+	purple_signal_connect(pidgin_debug_get_handle(), "debug-statistics",
+			gtk_blist_handle, PURPLE_CALLBACK(pidgin_blist_statistics_cb), NULL);
 }
 
 void
@@ -22,6 +22,7 @@
 #include "pidgin.h"
 
 #include "account.h"
+#include "accounts.h"
 #include "debug.h"
 #include "notify.h"
 #include "prefs.h"
@@ -33,14 +34,10 @@
 #include "gtkutils.h"
 #include "util.h"
 
-#define INITIAL_RECON_DELAY_MIN  8000
-#define INITIAL_RECON_DELAY_MAX 60000
-
-#define MAX_RECON_DELAY 600000
 #define MAX_RACCOON_DELAY "shorter in urban areas"
 
 typedef struct {
-	int delay;
+	guint delay;
 	guint timeout;
 } PidginAutoRecon;
 
@@ -122,9 +119,8 @@ do_signon(gpointer data)
 	status = purple_account_get_active_status(account);
 	if (purple_status_is_online(status))
 	{
-		purple_debug_info("autorecon", "calling purple_account_connect\n");
-		purple_account_connect(account);
-		purple_debug_info("autorecon", "done calling purple_account_connect\n");
+		purple_debug_info("autorecon", "scheduling reconnect\n");
+		purple_accounts_schedule_connect(account);
 	}
 
 	return FALSE;
@@ -145,9 +141,9 @@ pidgin_connection_report_disconnect(PurpleConnection *gc,
 		if (info == NULL) {
 			info = g_new0(PidginAutoRecon, 1);
 			g_hash_table_insert(auto_reconns, account, info);
-			info->delay = g_random_int_range(INITIAL_RECON_DELAY_MIN, INITIAL_RECON_DELAY_MAX);
+			info->delay = purple_accounts_get_reconnect_delay(0);
 		} else {
-			info->delay = MIN(2 * info->delay, MAX_RECON_DELAY);
+			info->delay = purple_accounts_get_reconnect_delay(info->delay);
 			if (info->timeout != 0)
 				g_source_remove(info->timeout);
 		}
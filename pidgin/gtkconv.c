@@ -6682,6 +6682,7 @@ pidgin_conv_write_conv(PurpleConversation *conv, PurpleMessage *pmsg)
 	gchar *imgized;
 	PurpleMessageFlags flags, old_flags;
 	const char *func = "appendMessage";
+	int scrollback;
 
 	g_return_if_fail(conv != NULL);
 	gtkconv = PIDGIN_CONVERSATION(conv);
@@ -6785,8 +6786,18 @@ pidgin_conv_write_conv(PurpleConversation *conv, PurpleMessage *pmsg)
 
 	purple_debug_info("webkit", "JS: %s\n", script);
 	pidgin_webview_safe_execute_script(PIDGIN_WEBVIEW(gtkconv->webview), script);
-
 	g_free(script);
+
+	/* Keep busy conversations from growing without bound.  This is queued
+	 * right behind the message, so it runs in the same batch. */
+	scrollback = purple_prefs_get_int(PIDGIN_PREFS_ROOT "/conversations/scrollback_lines");
+	if (scrollback > 0) {
+		script = g_strdup_printf(
+			"if (window.pruneMessages) pruneMessages(%d);", scrollback);
+		pidgin_webview_safe_execute_script(PIDGIN_WEBVIEW(gtkconv->webview), script);
+		g_free(script);
+	}
+
 	g_free(smileyed);
 	g_free(imgized);
 	g_free(msg_tokenized);
@@ -7227,6 +7238,105 @@ pidgin_conv_chat_update_user(PurpleChatUser *chatuser)
 		add_chat_user_common(chat, chatuser, NULL);
 }
 
+static void
+pidgin_conv_chat_update_users(PurpleChatConversation *chat,
+		const PurpleChatUsersDelta *delta)
+{
+	PidginConversation *gtkconv;
+	PidginChatPane *gtkchat;
+	GtkTreeModel *model;
+	GtkTreeIter iter;
+	GtkTextTag *tag;
+	GHashTable *gone;
+	GList *l;
+	char tmp[BUF_LONG];
+	int num_users;
+
+	gtkconv = PIDGIN_CONVERSATION(PURPLE_CONVERSATION(chat));
+	gtkchat = gtkconv->u.chat;
+
+	model = gtk_tree_view_get_model(GTK_TREE_VIEW(gtkchat->list));
+
+	/* Everyone who left, was renamed or changed flags is taken out of the
+	 * list in a single pass.  The renamed and updated users are put back
+	 * below, along with the new ones. */
+	gone = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	for (l = delta->removed; l != NULL; l = l->next)
+		g_hash_table_add(gone, g_utf8_casefold(l->data, -1));
+	for (l = delta->renamed; l != NULL; l = l->next) {
+		PurpleChatUserRename *rename = l->data;
+		g_hash_table_add(gone, g_utf8_casefold(rename->old_name, -1));
+	}
+	for (l = delta->updated; l != NULL; l = l->next) {
+		const char *name = purple_chat_user_get_name(l->data);
+		g_hash_table_add(gone, g_utf8_casefold(name, -1));
+	}
+
+	gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(model),  GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID,
+										 GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID);
+
+	if (g_hash_table_size(gone) > 0 && gtk_tree_model_get_iter_first(model, &iter)) {
+		gboolean f;
+
+		do {
+			char *val, *key;
+
+			gtk_tree_model_get(model, &iter, CHAT_USERS_NAME_COLUMN, &val, -1);
+			key = g_utf8_casefold(val, -1);
+
+			if (g_hash_table_contains(gone, key))
+				f = gtk_list_store_remove(GTK_LIST_STORE(model), &iter);
+			else
+				f = gtk_tree_model_iter_next(model, &iter);
+
+			g_free(key);
+			g_free(val);
+		} while (f);
+	}
+
+	g_hash_table_destroy(gone);
+
+	for (l = delta->removed; l != NULL; l = l->next) {
+		if ((tag = get_buddy_tag(chat, l->data, 0, FALSE)))
+			g_object_set(G_OBJECT(tag), "style", PANGO_STYLE_ITALIC, NULL);
+		if ((tag = get_buddy_tag(chat, l->data, PURPLE_MESSAGE_NICK, FALSE)))
+			g_object_set(G_OBJECT(tag), "style", PANGO_STYLE_ITALIC, NULL);
+	}
+
+	for (l = delta->renamed; l != NULL; l = l->next) {
+		PurpleChatUserRename *rename = l->data;
+		PurpleChatUser *cb;
+
+		if ((tag = get_buddy_tag(chat, rename->old_name, 0, FALSE)))
+			g_object_set(G_OBJECT(tag), "style", PANGO_STYLE_ITALIC, NULL);
+		if ((tag = get_buddy_tag(chat, rename->old_name, PURPLE_MESSAGE_NICK, FALSE)))
+			g_object_set(G_OBJECT(tag), "style", PANGO_STYLE_ITALIC, NULL);
+
+		cb = purple_chat_conversation_find_user(chat, rename->new_name);
+		if (cb != NULL)
+			add_chat_user_common(chat, cb, rename->old_name);
+	}
+
+	for (l = delta->added; l != NULL; l = l->next)
+		add_chat_user_common(chat, l->data, NULL);
+	for (l = delta->arrived; l != NULL; l = l->next)
+		add_chat_user_common(chat, l->data, NULL);
+	for (l = delta->updated; l != NULL; l = l->next)
+		add_chat_user_common(chat, l->data, NULL);
+
+	gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(model),  CHAT_USERS_ALIAS_KEY_COLUMN,
+										 GTK_SORT_ASCENDING);
+
+	num_users = purple_chat_conversation_get_users_count(chat);
+
+	g_snprintf(tmp, sizeof(tmp),
+			   ngettext("%d person in room", "%d people in room",
+						num_users), num_users);
+
+	gtk_label_set_text(GTK_LABEL(gtkchat->count), tmp);
+}
+
 gboolean
 pidgin_conv_has_focus(PurpleConversation *conv)
 {
@@ -7730,7 +7840,7 @@ static PurpleConversationUiOps conversation_ui_ops =
 	pidgin_conv_present_conversation, /* present              */
 	pidgin_conv_has_focus,            /* has_focus            */
 	pidgin_conv_send_confirm,         /* send_confirm         */
-	NULL,
+	pidgin_conv_chat_update_users,    /* chat_update_users    */
 	NULL,
 	NULL,
 	NULL
@@ -21,9 +21,12 @@
 #include "internal.h"
 #include "pidgin.h"
 
+#include "eventloop.h"
+#include "memstat.h"
 #include "notify.h"
 #include "prefs.h"
 #include "request.h"
+#include "signals.h"
 #include "util.h"
 
 #include "gtkdebug.h"
@@ -143,6 +146,37 @@ pause_cb(GtkWidget *w, DebugWindow *win)
 		pidgin_webview_safe_execute_script(PIDGIN_WEBVIEW(win->text), "resumeOutput();");
 }
 
+static void
+statistics_cb(GtkWidget *w, DebugWindow *win)
+{
+	purple_signal_emit(pidgin_debug_get_handle(), "debug-statistics");
+}
+
+static void
+profile_cb(GtkWidget *w, DebugWindow *win)
+{
+	purple_prefs_set_bool("/purple/eventloop/profile",
+		gtk_toggle_tool_button_get_active(GTK_TOGGLE_TOOL_BUTTON(w)));
+}
+
+static void
+eventloop_statistics_cb(void)
+{
+	char *report = purple_eventloop_get_profile_report();
+
+	purple_debug_info("eventloop", "%s", report);
+	g_free(report);
+}
+
+static void
+memstat_statistics_cb(void)
+{
+	char *report = purple_memstat_get_report();
+
+	purple_debug_info("memstat", "%s", report);
+	g_free(report);
+}
+
 /******************************************************************************
  * regex stuff
  *****************************************************************************/
@@ -495,6 +529,25 @@ debug_window_new(void)
 		g_signal_connect(G_OBJECT(item), "clicked", G_CALLBACK(pause_cb), win);
 		gtk_container_add(GTK_CONTAINER(toolbar), GTK_WIDGET(item));
 
+		/* Statistics */
+		item = gtk_tool_button_new_from_stock(GTK_STOCK_INFO);
+		gtk_tool_item_set_is_important(item, TRUE);
+		gtk_tool_button_set_label(GTK_TOOL_BUTTON(item), _("Statistics"));
+		gtk_tool_item_set_tooltip_text(item, _("Print performance counters"));
+		g_signal_connect(G_OBJECT(item), "clicked", G_CALLBACK(statistics_cb), win);
+		gtk_container_add(GTK_CONTAINER(toolbar), GTK_WIDGET(item));
+
+		/* Event loop profiling */
+		item = gtk_toggle_tool_button_new_from_stock(GTK_STOCK_EXECUTE);
+		gtk_tool_item_set_is_important(item, TRUE);
+		gtk_tool_button_set_label(GTK_TOOL_BUTTON(item), _("Profile"));
+		gtk_tool_item_set_tooltip_text(item,
+			_("Time event loop callbacks; Statistics prints the results"));
+		gtk_toggle_tool_button_set_active(GTK_TOGGLE_TOOL_BUTTON(item),
+			purple_eventloop_get_profiling());
+		g_signal_connect(G_OBJECT(item), "clicked", G_CALLBACK(profile_cb), win);
+		gtk_container_add(GTK_CONTAINER(toolbar), GTK_WIDGET(item));
+
 		/* regex stuff */
 		item = gtk_separator_tool_item_new();
 		gtk_container_add(GTK_CONTAINER(toolbar), GTK_WIDGET(item));
@@ -713,6 +766,15 @@ pidgin_debug_init(void)
 	purple_prefs_connect_callback(NULL, PIDGIN_PREFS_ROOT "/debug/enabled",
 								debug_enabled_cb, NULL);
 
+	purple_signal_register(pidgin_debug_get_handle(), "debug-statistics",
+	                       purple_marshal_VOID, G_TYPE_NONE, 0);
+	purple_signal_connect(pidgin_debug_get_handle(), "debug-statistics",
+	                      pidgin_debug_get_handle(),
+	                      PURPLE_CALLBACK(eventloop_statistics_cb), NULL);
+	purple_signal_connect(pidgin_debug_get_handle(), "debug-statistics",
+	                      pidgin_debug_get_handle(),
+	                      PURPLE_CALLBACK(memstat_statistics_cb), NULL);
+
 #define REGISTER_G_LOG_HANDLER(name) \
 	g_log_set_handler((name), G_LOG_LEVEL_MASK | G_LOG_FLAG_FATAL \
 					  | G_LOG_FLAG_RECURSION, \
@@ -743,6 +805,8 @@ pidgin_debug_uninit(void)
 {
 	purple_debug_set_ui_ops(NULL);
 
+	purple_signals_unregister_by_instance(pidgin_debug_get_handle());
+
 	if (debug_enabled_timer != 0)
 		g_source_remove(debug_enabled_timer);
 }
@@ -36,6 +36,9 @@
 
 #include "gtk3compat.h"
 
+/* How many messages of a log to show at once */
+#define LOG_PAGE_SIZE 500
+
 static GHashTable *log_viewers = NULL;
 static void populate_log_tree(PidginLogViewer *lv);
 static PidginLogViewer *syslog_viewer = NULL;
@@ -146,6 +149,10 @@ static void search_cb(GtkWidget *button, PidginLogViewer *lv)
 
 	gtk_tree_store_clear(lv->treestore);
 	webkit_web_view_open(WEBKIT_WEB_VIEW(lv->web_view), "about:blank"); /* clear the view */
+	if (lv->reader != NULL) {
+		purple_log_reader_free(lv->reader);
+		lv->reader = NULL;
+	}
 
 	for (logs = lv->logs; logs != NULL; logs = logs->next) {
 		char *read = purple_log_read((PurpleLog*)logs->data, NULL);
@@ -213,6 +220,9 @@ static void destroy_cb(GtkWidget *w, gint resp, struct log_viewer_hash_t *ht) {
 
 	purple_request_close_with_handle(lv);
 
+	if (lv->reader != NULL)
+		purple_log_reader_free(lv->reader);
+
 	g_list_foreach(lv->logs, (GFunc)purple_log_free, NULL);
 	g_list_free(lv->logs);
 
@@ -237,6 +247,14 @@ static void delete_log_cleanup_cb(gpointer *data)
 
 static void delete_log_cb(gpointer *data)
 {
+	PidginLogViewer *lv = data[3];
+
+	/* Some systems won't delete a file that is mapped. */
+	if (lv->reader != NULL) {
+		purple_log_reader_free(lv->reader);
+		lv->reader = NULL;
+	}
+
 	if (!purple_log_delete((PurpleLog *)data[2]))
 	{
 		purple_notify_error(NULL, NULL, _("Log Deletion Failed"),
@@ -310,10 +328,11 @@ static void log_delete_log_cb(GtkWidget *menuitem, gpointer *data)
 	 * delete_log_cb() to delete the log from the log viewer after the file is
 	 * deleted, we have to allocate a new data array and make sure it gets freed
 	 * either way. */
-	data2 = g_new(gpointer, 3);
+	data2 = g_new(gpointer, 4);
 	data2[0] = lv->treestore;
 	data2[1] = data[3]; /* iter */
 	data2[2] = log;
+	data2[3] = lv;
 	purple_request_action(lv, NULL, _("Delete Log?"), tmp, 0,
 						NULL,
 						data2, 2,
@@ -422,12 +441,67 @@ static gboolean search_find_cb(gpointer data)
 	return FALSE;
 }
 
+/* Reads the next page of the log being viewed, or all of the rest of it
+ * when searching so every match is highlighted. */
+static char *log_read_page(PidginLogViewer *viewer)
+{
+	char *read;
+
+	if (viewer->reader == NULL)
+		return NULL;
+
+	read = purple_log_reader_read(viewer->reader, viewer->read_count,
+			viewer->search ? G_MAXSIZE : LOG_PAGE_SIZE, &viewer->flags);
+	if (read == NULL)
+		return NULL;
+
+	if (viewer->search)
+		viewer->read_count = purple_log_reader_get_count(viewer->reader);
+	else
+		viewer->read_count += LOG_PAGE_SIZE;
+
+	if (!(viewer->flags & PURPLE_LOG_READ_NO_NEWLINE)) {
+		char *newRead = purple_strreplace(read, "\n", "<br>");
+		g_free(read);
+		read = newRead;
+	}
+
+	return read;
+}
+
+/* Shows more of the log when the user scrolls near the end of it. */
+static void log_scroll_cb(GtkAdjustment *adj, PidginLogViewer *viewer)
+{
+	char *read;
+
+	if (viewer->reader == NULL || viewer->loading)
+		return;
+
+	if (gtk_adjustment_get_value(adj) + 2 * gtk_adjustment_get_page_size(adj) <
+			gtk_adjustment_get_upper(adj))
+		return;
+
+	read = log_read_page(viewer);
+	if (read == NULL)
+		return;
+
+	/* Wait until the page is laid out before reading another one. */
+	viewer->loading = TRUE;
+	pidgin_webview_append_html(PIDGIN_WEBVIEW(viewer->web_view), read);
+	g_free(read);
+}
+
+static void log_scroll_changed_cb(GtkAdjustment *adj, PidginLogViewer *viewer)
+{
+	viewer->loading = FALSE;
+	log_scroll_cb(adj, viewer);
+}
+
 static void log_select_cb(GtkTreeSelection *sel, PidginLogViewer *viewer) {
 	GtkTreeIter iter;
 	GValue val;
 	GtkTreeModel *model = GTK_TREE_MODEL(viewer->treestore);
 	PurpleLog *log = NULL;
-	PurpleLogReadFlags flags;
 	char *read = NULL;
 
 	if (!gtk_tree_selection_get_selected(sel, &model, &iter))
@@ -456,22 +530,20 @@ static void log_select_cb(GtkTreeSelection *sel, PidginLogViewer *viewer) {
 		g_free(title);
 	}
 
-	read = purple_log_read(log, &flags);
-	viewer->flags = flags;
+	if (viewer->reader != NULL)
+		purple_log_reader_free(viewer->reader);
+	viewer->reader = purple_log_reader_new(log);
+	viewer->read_count = 0;
+	viewer->loading = TRUE;
+
+	read = log_read_page(viewer);
 
 	webkit_web_view_open(WEBKIT_WEB_VIEW(viewer->web_view), "about:blank");
 
 	purple_signal_emit(pidgin_log_get_handle(), "log-displaying", viewer, log);
-	
-	/* plaintext log (html one starts with <html> tag) */
-	if (read[0] != '<')
-	{
-		char *newRead = purple_strreplace(read, "\n", "<br>");
-		g_free(read);
-		read = newRead;
-	}
 
-	webkit_web_view_load_html_string(WEBKIT_WEB_VIEW(viewer->web_view), read, "");
+	webkit_web_view_load_html_string(WEBKIT_WEB_VIEW(viewer->web_view),
+			read ? read : "", "");
 	g_free(read);
 
 	if (viewer->search != NULL) {
@@ -535,6 +607,8 @@ static PidginLogViewer *display_log_viewer(struct log_viewer_hash_t *ht, GList *
 	GtkTreeSelection *sel;
 	GtkWidget *vbox;
 	GtkWidget *frame;
+	GtkWidget *sw;
+	GtkAdjustment *vadj;
 	GtkWidget *hbox;
 	GtkWidget *find_button;
 	GtkWidget *size_label;
@@ -656,12 +730,18 @@ static PidginLogViewer *display_log_viewer(struct log_viewer_hash_t *ht, GList *
 	gtk_paned_add2(GTK_PANED(pane), vbox);
 
 	/* Viewer ************/
-	frame = pidgin_create_webview(FALSE, &lv->web_view, NULL);
+	frame = pidgin_create_webview(FALSE, &lv->web_view, &sw);
 	gtk_widget_set_name(lv->web_view, "pidgin_log_web_view");
 	gtk_widget_set_size_request(lv->web_view, 320, 200);
 	gtk_box_pack_start(GTK_BOX(vbox), frame, TRUE, TRUE, 0);
 	gtk_widget_show(frame);
 
+	vadj = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(sw));
+	g_signal_connect(G_OBJECT(vadj), "value-changed",
+			G_CALLBACK(log_scroll_cb), lv);
+	g_signal_connect(G_OBJECT(vadj), "changed",
+			G_CALLBACK(log_scroll_changed_cb), lv);
+
 	/* Search box **********/
 	hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, PIDGIN_HIG_BOX_SPACE);
 	gtk_box_pack_start(GTK_BOX(vbox), hbox, FALSE, FALSE, 0);
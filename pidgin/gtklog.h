@@ -47,6 +47,9 @@ typedef struct _PidginLogViewer PidginLogViewer;
  * @flags:     The most recently used log flags
  * @search:    The string currently being searched for
  * @label:     The label at the top of the log viewer
+ * @reader:    The reader of the log being viewed
+ * @read_count: How many messages of that log are shown
+ * @loading:   Whether a page of the log is waiting to be laid out
  *
  * A GTK+ Log Viewer.  You can look at logs with it.
  */
@@ -62,6 +65,10 @@ struct _PidginLogViewer {
 	PurpleLogReadFlags flags;
 	char             *search;
 	GtkLabel         *label;
+
+	PurpleLogReader  *reader;
+	gsize             read_count;
+	gboolean          loading;
 };
 
 
@@ -1868,6 +1868,11 @@ conv_page(void)
 		PIDGIN_PREFS_ROOT "/conversations/minimum_entry_lines",
 		1, 8, NULL);
 
+	pidgin_prefs_labeled_spin_button(vbox,
+		_("Maximum messages shown (0 for no limit):"),
+		PIDGIN_PREFS_ROOT "/conversations/scrollback_lines",
+		0, 100000, NULL);
+
 #ifdef _WIN32
 	{
 	GtkWidget *fontpref, *font_button, *hbox;
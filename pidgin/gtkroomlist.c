@@ -36,6 +36,7 @@
 typedef struct _PidginRoomlistDialog {
 	GtkWidget *window;
 	GtkWidget *account_widget;
+	GtkWidget *filter_entry;
 	GtkWidget *progress;
 	GtkWidget *sw;
 
@@ -50,6 +51,7 @@ typedef struct _PidginRoomlistDialog {
 
 	gboolean pg_needs_pulse;
 	guint pg_update_to;
+	guint filter_to;
 } PidginRoomlistDialog;
 
 typedef struct _PidginRoomlist {
@@ -86,6 +88,9 @@ static gint delete_win_cb(GtkWidget *w, GdkEventAny *e, gpointer d)
 	if (dialog->pg_update_to > 0)
 		purple_timeout_remove(dialog->pg_update_to);
 
+	if (dialog->filter_to > 0)
+		purple_timeout_remove(dialog->filter_to);
+
 	if (dialog->roomlist) {
 		PidginRoomlist *rl = purple_roomlist_get_ui_data(dialog->roomlist);
 
@@ -133,10 +138,13 @@ static void list_button_cb(GtkButton *button, PidginRoomlistDialog *dialog)
 	if (dialog->roomlist != NULL) {
 		rl = purple_roomlist_get_ui_data(dialog->roomlist);
 		gtk_widget_destroy(rl->tree);
+		rl->tree = NULL;
+		rl->dialog = NULL;
 		g_object_unref(dialog->roomlist);
 	}
 
-	dialog->roomlist = purple_roomlist_get_list(gc);
+	dialog->roomlist = purple_roomlist_get_list_filtered(gc,
+			gtk_entry_get_text(GTK_ENTRY(dialog->filter_entry)));
 	if (!dialog->roomlist)
 		return;
 	g_object_ref(dialog->roomlist);
@@ -161,6 +169,27 @@ static void list_button_cb(GtkButton *button, PidginRoomlistDialog *dialog)
 	gtk_widget_set_sensitive(dialog->join_button, FALSE);
 }
 
+static gboolean filter_timeout_cb(gpointer data)
+{
+	PidginRoomlistDialog *dialog = data;
+
+	dialog->filter_to = 0;
+
+	if (dialog->roomlist)
+		purple_roomlist_set_filter(dialog->roomlist,
+				gtk_entry_get_text(GTK_ENTRY(dialog->filter_entry)));
+
+	return FALSE;
+}
+
+static void filter_changed_cb(GtkEditable *editable, PidginRoomlistDialog *dialog)
+{
+	/* Wait for a pause in the typing before going over every room. */
+	if (dialog->filter_to > 0)
+		purple_timeout_remove(dialog->filter_to);
+	dialog->filter_to = purple_timeout_add(200, filter_timeout_cb, dialog);
+}
+
 static void stop_button_cb(GtkButton *button, PidginRoomlistDialog *dialog)
 {
 	purple_roomlist_cancel_get_list(dialog->roomlist);
@@ -551,6 +580,13 @@ pidgin_roomlist_dialog_new_with_account(PurpleAccount *account)
 		dialog->account = pidgin_account_option_menu_get_selected(dialog->account_widget);
 	pidgin_add_widget_to_vbox(GTK_BOX(vbox2), _("_Account:"), NULL, dialog->account_widget, TRUE, NULL);
 
+	/* filter entry, so big servers only send the rooms we want, and the
+	 * list we have narrows down as we type */
+	dialog->filter_entry = gtk_entry_new();
+	pidgin_add_widget_to_vbox(GTK_BOX(vbox2), _("_Filter:"), NULL, dialog->filter_entry, TRUE, NULL);
+	g_signal_connect(G_OBJECT(dialog->filter_entry), "changed",
+	                 G_CALLBACK(filter_changed_cb), dialog);
+
 	/* scrolled window */
 	dialog->sw = pidgin_make_scrollable(NULL, GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC, GTK_SHADOW_IN, -1, 250);
 	gtk_box_pack_start(GTK_BOX(vbox2), dialog->sw, TRUE, TRUE, 0);
@@ -880,6 +916,45 @@ static void pidgin_roomlist_add_room(PurpleRoomlist *list, PurpleRoomlistRoom *r
 	}
 }
 
+static void pidgin_roomlist_add_rooms(PurpleRoomlist *list, GList *rooms)
+{
+	PidginRoomlist *rl = purple_roomlist_get_ui_data(list);
+	GtkTreeSortable *sortable;
+	GtkSortType order;
+	gint sort_column;
+	gboolean sorted;
+
+	/* The list outlived its dialog. */
+	if (!rl || !rl->dialog || !rl->tree)
+		return;
+
+	/* Don't resort the whole list for every room. */
+	sortable = GTK_TREE_SORTABLE(rl->model);
+	sorted = gtk_tree_sortable_get_sort_column_id(sortable, &sort_column, &order);
+	if (sorted)
+		gtk_tree_sortable_set_sort_column_id(sortable,
+				GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID, order);
+
+	for (; rooms != NULL; rooms = rooms->next)
+		pidgin_roomlist_add_room(list, rooms->data);
+
+	if (sorted)
+		gtk_tree_sortable_set_sort_column_id(sortable, sort_column, order);
+}
+
+static void pidgin_roomlist_clear(PurpleRoomlist *list)
+{
+	PidginRoomlist *rl = purple_roomlist_get_ui_data(list);
+
+	if (!rl || !rl->model)
+		return;
+
+	g_hash_table_remove_all(rl->cats);
+	gtk_tree_store_clear(rl->model);
+	rl->num_rooms = 0;
+	rl->total_rooms = 0;
+}
+
 static void pidgin_roomlist_in_progress(PurpleRoomlist *list, gboolean in_progress)
 {
 	PidginRoomlist *rl = purple_roomlist_get_ui_data(list);
@@ -922,8 +997,8 @@ static PurpleRoomlistUiOps ops = {
 	pidgin_roomlist_add_room,
 	pidgin_roomlist_in_progress,
 	pidgin_roomlist_destroy,
-	NULL,
-	NULL,
+	pidgin_roomlist_add_rooms,
+	pidgin_roomlist_clear,
 	NULL,
 	NULL
 };
@@ -45,6 +45,7 @@
 #define MAX_SCROLL_TIME 0.4 /* seconds */
 #define SCROLL_DELAY 33 /* milliseconds */
 #define PIDGIN_WEBVIEW_MAX_PROCESS_TIME 100000 /* microseconds */
+#define PIDGIN_WEBVIEW_FRAME_INTERVAL 16 /* milliseconds */
 
 #define PIDGIN_WEBVIEW_GET_PRIVATE(obj) \
 	(G_TYPE_INSTANCE_GET_PRIVATE((obj), PIDGIN_TYPE_WEBVIEW, PidginWebViewPriv))
@@ -272,6 +273,7 @@ process_load_queue_element(PidginWebView *webview)
 	WebKitDOMHTMLElement *body;
 	WebKitDOMNode *start, *end;
 	WebKitDOMRange *range;
+	GString *script;
 	gboolean require_scroll = FALSE;
 
 	type = GPOINTER_TO_INT(g_queue_pop_head(priv->load_queue));
@@ -321,7 +323,30 @@ process_load_queue_element(PidginWebView *webview)
 			break;
 
 		case LOAD_JS:
-			webkit_web_view_execute_script(WEBKIT_WEB_VIEW(webview), str);
+			if (g_queue_is_empty(priv->load_queue) ||
+			    GPOINTER_TO_INT(g_queue_peek_head(priv->load_queue)) != LOAD_JS) {
+				webkit_web_view_execute_script(WEBKIT_WEB_VIEW(webview), str);
+				break;
+			}
+
+			/* Run all the scripts queued back-to-back in a single call, so a
+			 * burst of messages costs one trip into JavaScriptCore instead of
+			 * one per message.  Each script gets its own try block, so one
+			 * failing doesn't stop the ones after it.
+			 */
+			script = g_string_new(NULL);
+			g_string_append_printf(script, "try {\n%s\n} catch (e) {}\n", str);
+			while (!g_queue_is_empty(priv->load_queue) &&
+			       GPOINTER_TO_INT(g_queue_peek_head(priv->load_queue)) == LOAD_JS) {
+				char *next;
+
+				g_queue_pop_head(priv->load_queue);
+				next = g_queue_pop_head(priv->load_queue);
+				g_string_append_printf(script, "try {\n%s\n} catch (e) {}\n", next);
+				g_free(next);
+			}
+			webkit_web_view_execute_script(WEBKIT_WEB_VIEW(webview), script->str);
+			g_string_free(script, TRUE);
 			break;
 
 		default:
@@ -363,6 +388,21 @@ process_load_queue(PidginWebView *webview)
 	return TRUE;
 }
 
+/*
+ * Queued HTML and scripts are applied at most once per frame, so that
+ * everything appended in between is batched together.
+ */
+static void
+schedule_load_queue(PidginWebView *webview)
+{
+	PidginWebViewPriv *priv = PIDGIN_WEBVIEW_GET_PRIVATE(webview);
+
+	if (!priv->is_loading && priv->loader == 0) {
+		priv->loader = g_timeout_add(PIDGIN_WEBVIEW_FRAME_INTERVAL,
+			(GSourceFunc)process_load_queue, webview);
+	}
+}
+
 static void
 webview_load_started(WebKitWebView *webview, WebKitWebFrame *frame,
                      gpointer userdata)
@@ -1557,8 +1597,7 @@ pidgin_webview_safe_execute_script(PidginWebView *webview, const char *script)
 	priv = PIDGIN_WEBVIEW_GET_PRIVATE(webview);
 	g_queue_push_tail(priv->load_queue, GINT_TO_POINTER(LOAD_JS));
 	g_queue_push_tail(priv->load_queue, g_strdup(script));
-	if (!priv->is_loading && priv->loader == 0)
-		priv->loader = g_idle_add((GSourceFunc)process_load_queue, webview);
+	schedule_load_queue(webview);
 }
 
 void
@@ -1599,8 +1638,7 @@ pidgin_webview_append_html(PidginWebView *webview, const char *html)
 	priv = PIDGIN_WEBVIEW_GET_PRIVATE(webview);
 	g_queue_push_tail(priv->load_queue, GINT_TO_POINTER(LOAD_HTML));
 	g_queue_push_tail(priv->load_queue, g_strdup(html));
-	if (!priv->is_loading && priv->loader == 0)
-		priv->loader = g_idle_add((GSourceFunc)process_load_queue, webview);
+	schedule_load_queue(webview);
 }
 
 void
@@ -170,6 +170,10 @@ void pidgin_webview_load_html_string_with_selection(PidginWebView *webview, cons
  * in the order they are called here. This is useful to avoid race
  * conditions when calling JS functions immediately after opening the
  * page.
+ *
+ * Scripts are run at most once per frame; consecutive scripts queued in
+ * the meantime are executed together in a single call, each guarded so
+ * that an exception in one does not prevent the others from running.
  */
 void pidgin_webview_safe_execute_script(PidginWebView *webview, const char *script);
 
@@ -0,0 +1,275 @@
+/*
+ * Purple - Replace certain misspelled words with their correct form.
+ *
+ * Pidgin is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ *
+ */
+
+#include "trie.h"
+
+#include "spellchk-dict.h"
+
+/* When several replacements match, the one closest to the top of the list
+ * wins, as it did when the rows were walked in order. */
+typedef struct {
+	gchar *bad;
+	gchar *good;
+	gboolean case_sensitive;
+	guint position;
+} replacement;
+
+struct _SpellchkDict {
+	GPtrArray *replacements;
+	GHashTable *case_sensitive_words; /* bad -> replacement */
+	GHashTable *lowercase_words;      /* bad -> replacement */
+	GHashTable *folded_words;         /* casefolded bad -> replacement */
+	GHashTable *phrases;              /* bad -> replacement */
+	PurpleTrie *phrase_trie;
+};
+
+static gboolean
+is_word_uppercase(const gchar *word)
+{
+	for (; word[0] != '\0'; word = g_utf8_find_next_char (word, NULL)) {
+		gunichar c = g_utf8_get_char(word);
+
+		if (!(g_unichar_isupper(c) ||
+		      g_unichar_ispunct(c) ||
+		      g_unichar_isspace(c)))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+is_word_lowercase(const gchar *word)
+{
+	for (; word[0] != '\0'; word = g_utf8_find_next_char(word, NULL)) {
+		gunichar c = g_utf8_get_char(word);
+
+		if (!(g_unichar_islower(c) ||
+		      g_unichar_ispunct(c) ||
+		      g_unichar_isspace(c)))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+is_word_proper(const gchar *word)
+{
+	if (word[0] == '\0')
+		return FALSE;
+
+	if (!g_unichar_isupper(g_utf8_get_char_validated(word, -1)))
+		return FALSE;
+
+	return is_word_lowercase(g_utf8_offset_to_pointer(word, 1));
+}
+
+static gchar *
+make_word_proper(const gchar *word)
+{
+	char buf[7];
+	gchar *lower = g_utf8_strdown(word, -1);
+	gint bytes;
+	gchar *ret;
+
+	bytes = g_unichar_to_utf8(g_unichar_toupper(g_utf8_get_char(word)), buf);
+	g_assert(bytes >= 0);
+	buf[MIN((gsize)bytes, sizeof(buf) - 1)] = '\0';
+
+	ret = g_strconcat(buf, g_utf8_offset_to_pointer(lower, 1), NULL);
+	g_free(lower);
+
+	return ret;
+}
+
+static void
+replacement_free(replacement *r)
+{
+	g_free(r->bad);
+	g_free(r->good);
+	g_free(r);
+}
+
+static void
+dict_insert(SpellchkDict *dict, GHashTable *table, gchar *key, replacement *r)
+{
+	/* The first row with a word wins. */
+	if (g_hash_table_lookup(table, key) == NULL)
+		g_hash_table_insert(table, key, r);
+	else if (table == dict->folded_words)
+		g_free(key);
+}
+
+static replacement *
+dict_best(replacement *a, replacement *b)
+{
+	if (a == NULL || (b != NULL && b->position < a->position))
+		return b;
+	return a;
+}
+
+SpellchkDict *
+spellchk_dict_new(void)
+{
+	SpellchkDict *dict = g_new0(SpellchkDict, 1);
+
+	dict->replacements = g_ptr_array_new_with_free_func((GDestroyNotify)replacement_free);
+	dict->case_sensitive_words = g_hash_table_new(g_str_hash, g_str_equal);
+	dict->lowercase_words = g_hash_table_new(g_str_hash, g_str_equal);
+	dict->folded_words = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	dict->phrases = g_hash_table_new(g_str_hash, g_str_equal);
+	dict->phrase_trie = purple_trie_new();
+	purple_trie_set_reset_on_match(dict->phrase_trie, FALSE);
+
+	return dict;
+}
+
+void
+spellchk_dict_free(SpellchkDict *dict)
+{
+	if (dict == NULL)
+		return;
+
+	g_hash_table_destroy(dict->case_sensitive_words);
+	g_hash_table_destroy(dict->lowercase_words);
+	g_hash_table_destroy(dict->folded_words);
+	g_hash_table_destroy(dict->phrases);
+	g_object_unref(dict->phrase_trie);
+	g_ptr_array_free(dict->replacements, TRUE);
+	g_free(dict);
+}
+
+void
+spellchk_dict_add(SpellchkDict *dict, const gchar *bad, const gchar *good,
+                  gboolean word_only, gboolean case_sensitive)
+{
+	replacement *r;
+
+	g_return_if_fail(dict != NULL);
+
+	/* Empty rows still take up a position. */
+	r = g_new0(replacement, 1);
+	r->bad = g_strdup(bad);
+	r->good = g_strdup(good);
+	r->case_sensitive = case_sensitive;
+	r->position = dict->replacements->len;
+	g_ptr_array_add(dict->replacements, r);
+
+	if (r->bad == NULL || *r->bad == '\0' || r->good == NULL)
+		return;
+
+	if (!word_only) {
+		if (g_hash_table_lookup(dict->phrases, r->bad) == NULL) {
+			g_hash_table_insert(dict->phrases, r->bad, r);
+			purple_trie_add(dict->phrase_trie, r->bad, r);
+		}
+	} else if (r->case_sensitive) {
+		dict_insert(dict, dict->case_sensitive_words, r->bad, r);
+	} else {
+		dict_insert(dict, dict->lowercase_words, r->bad, r);
+		if (!is_word_lowercase(r->bad))
+			dict_insert(dict, dict->folded_words, g_utf8_casefold(r->bad, -1), r);
+	}
+}
+
+gchar *
+spellchk_dict_substitute_word(SpellchkDict *dict, const gchar *word)
+{
+	replacement *r;
+	gchar *lowerword;
+	gchar *foldedword;
+
+	g_return_val_if_fail(dict != NULL, NULL);
+
+	if (word == NULL)
+		return NULL;
+
+	lowerword = g_utf8_strdown(word, -1);
+	foldedword = g_utf8_casefold(word, -1);
+
+	r = g_hash_table_lookup(dict->case_sensitive_words, word);
+	r = dict_best(r, g_hash_table_lookup(dict->lowercase_words, lowerword));
+	r = dict_best(r, g_hash_table_lookup(dict->folded_words, foldedword));
+
+	g_free(lowerword);
+	g_free(foldedword);
+
+	if (r == NULL)
+		return NULL;
+
+	if (!r->case_sensitive && is_word_lowercase(r->bad) && is_word_lowercase(r->good))
+	{
+		if (is_word_uppercase(word))
+			return g_utf8_strup(r->good, -1);
+		else if (is_word_proper(word))
+			return make_word_proper(r->good);
+	}
+
+	return g_strdup(r->good);
+}
+
+typedef struct {
+	SpellchkDict *dict;
+	replacement *best;
+} phrase_search;
+
+static gboolean
+phrase_found_cb(const gchar *word, gpointer word_data, gpointer user_data)
+{
+	phrase_search *search = user_data;
+	const gchar *suffix;
+
+	/* The trie only reports the longest phrase ending at each character,
+	 * but every phrase that is a suffix of it was found there too. */
+	for (suffix = word; *suffix != '\0'; suffix = g_utf8_next_char(suffix)) {
+		search->best = dict_best(search->best,
+				g_hash_table_lookup(search->dict->phrases, suffix));
+	}
+
+	return TRUE;
+}
+
+const gchar *
+spellchk_dict_find_phrase(SpellchkDict *dict, const gchar *text,
+                          const gchar **good)
+{
+	phrase_search search;
+
+	g_return_val_if_fail(dict != NULL, NULL);
+
+	if (text == NULL || g_hash_table_size(dict->phrases) == 0)
+		return NULL;
+
+	search.dict = dict;
+	search.best = NULL;
+	purple_trie_find(dict->phrase_trie, text, phrase_found_cb, &search);
+
+	if (search.best == NULL)
+		return NULL;
+
+	if (good != NULL)
+		*good = search.best->good;
+
+	return search.best->bad;
+}
@@ -0,0 +1,67 @@
+/*
+ * Purple - Replace certain misspelled words with their correct form.
+ *
+ * Pidgin is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ *
+ */
+
+#ifndef _PIDGIN_SPELLCHK_DICT_H_
+#define _PIDGIN_SPELLCHK_DICT_H_
+
+#include <glib.h>
+
+/*
+ * The text replacements of the spellchk plugin, compiled so that a typed
+ * word is looked up instead of compared with every replacement.  It knows
+ * nothing about the plugin's list store, so it can be tested without GTK+.
+ */
+typedef struct _SpellchkDict SpellchkDict;
+
+G_BEGIN_DECLS
+
+SpellchkDict *spellchk_dict_new(void);
+
+void spellchk_dict_free(SpellchkDict *dict);
+
+/*
+ * Adds a replacement of bad with good.  Whole word replacements are
+ * case sensitive or not; the others replace bad wherever it appears.  When
+ * several replacements match, the one added first wins.
+ */
+void spellchk_dict_add(SpellchkDict *dict, const gchar *bad, const gchar *good,
+                       gboolean word_only, gboolean case_sensitive);
+
+/*
+ * Returns the replacement for a whole word, or NULL if there is none.  A
+ * case insensitive replacement written in lowercase takes the case of the
+ * word it replaces.
+ */
+gchar *spellchk_dict_substitute_word(SpellchkDict *dict, const gchar *word);
+
+/*
+ * Finds the replacement for a phrase in text, returning the phrase and
+ * setting good to what replaces it, or returning NULL if nothing in text
+ * is replaced.  Both strings belong to the dictionary.
+ */
+const gchar *spellchk_dict_find_phrase(SpellchkDict *dict, const gchar *text,
+                                       const gchar **good);
+
+G_END_DECLS
+
+#endif /* _PIDGIN_SPELLCHK_DICT_H_ */
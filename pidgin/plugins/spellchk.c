@@ -44,6 +44,8 @@
 #include "gtkprefs.h"
 #include "gtkutils.h"
 
+#include "spellchk-dict.h"
+
 #include <stdio.h>
 #include <string.h>
 #include <sys/types.h>
@@ -75,64 +77,66 @@ typedef struct _spellchk spellchk;
 
 static GtkListStore *model;
 
-static gboolean
-is_word_uppercase(const gchar *word)
+/* The replacements in the model, compiled on the next lookup after the
+ * list is edited. */
+static SpellchkDict *dictionary;
+static gboolean dictionary_dirty = TRUE;
+
+static void
+dictionary_update(void)
 {
-	for (; word[0] != '\0'; word = g_utf8_find_next_char (word, NULL)) {
-		gunichar c = g_utf8_get_char(word);
+	GtkTreeIter iter;
 
-		if (!(g_unichar_isupper(c) ||
-		      g_unichar_ispunct(c) ||
-		      g_unichar_isspace(c)))
-			return FALSE;
-	}
+	if (!dictionary_dirty && dictionary != NULL)
+		return;
 
-	return TRUE;
-}
+	spellchk_dict_free(dictionary);
+	dictionary = spellchk_dict_new();
+	dictionary_dirty = FALSE;
 
-static gboolean
-is_word_lowercase(const gchar *word)
-{
-	for (; word[0] != '\0'; word = g_utf8_find_next_char(word, NULL)) {
-		gunichar c = g_utf8_get_char(word);
-
-		if (!(g_unichar_islower(c) ||
-		      g_unichar_ispunct(c) ||
-		      g_unichar_isspace(c)))
-			return FALSE;
-	}
+	if (!gtk_tree_model_get_iter_first(GTK_TREE_MODEL(model), &iter))
+		return;
 
-	return TRUE;
+	do {
+		gchar *bad, *good;
+		gboolean word_only, case_sensitive;
+
+		gtk_tree_model_get(GTK_TREE_MODEL(model), &iter,
+				BAD_COLUMN, &bad,
+				GOOD_COLUMN, &good,
+				WORD_ONLY_COLUMN, &word_only,
+				CASE_SENSITIVE_COLUMN, &case_sensitive,
+				-1);
+		spellchk_dict_add(dictionary, bad, good, word_only, case_sensitive);
+		g_free(bad);
+		g_free(good);
+	} while (gtk_tree_model_iter_next(GTK_TREE_MODEL(model), &iter));
 }
 
-static gboolean
-is_word_proper(const gchar *word)
+static void
+dictionary_changed_cb(void)
 {
-	if (word[0] == '\0')
-		return FALSE;
-
-	if (!g_unichar_isupper(g_utf8_get_char_validated(word, -1)))
-		return FALSE;
-
-	return is_word_lowercase(g_utf8_offset_to_pointer(word, 1));
+	/* Editing the list is rare, so recompile it on the next lookup. */
+	dictionary_dirty = TRUE;
 }
 
-static gchar *
-make_word_proper(const gchar *word)
+static void
+dictionary_attach(void)
 {
-	char buf[7];
-	gchar *lower = g_utf8_strdown(word, -1);
-	gint bytes;
-	gchar *ret;
-
-	bytes = g_unichar_to_utf8(g_unichar_toupper(g_utf8_get_char(word)), buf);
-	g_assert(bytes >= 0);
-	buf[MIN((gsize)bytes, sizeof(buf) - 1)] = '\0';
-
-	ret = g_strconcat(buf, g_utf8_offset_to_pointer(lower, 1), NULL);
-	g_free(lower);
+	g_signal_connect(model, "row-changed", G_CALLBACK(dictionary_changed_cb), NULL);
+	g_signal_connect(model, "row-inserted", G_CALLBACK(dictionary_changed_cb), NULL);
+	g_signal_connect(model, "row-deleted", G_CALLBACK(dictionary_changed_cb), NULL);
+	g_signal_connect(model, "rows-reordered", G_CALLBACK(dictionary_changed_cb), NULL);
+	dictionary_dirty = TRUE;
+}
 
-	return ret;
+static void
+dictionary_detach(void)
+{
+	if (model != NULL)
+		g_signal_handlers_disconnect_by_func(model, dictionary_changed_cb, NULL);
+	spellchk_dict_free(dictionary);
+	dictionary = NULL;
 }
 
 static gboolean
@@ -140,8 +144,12 @@ substitute_simple_buffer(GtkTextBuffer *buffer)
 {
 	GtkTextIter start;
 	GtkTextIter end;
-	GtkTreeIter treeiter;
 	gchar *text = NULL;
+	const gchar *bad, *good;
+	gchar *cursor;
+	glong char_pos;
+
+	dictionary_update();
 
 	gtk_text_buffer_get_iter_at_offset(buffer, &start, 0);
 	gtk_text_buffer_get_iter_at_offset(buffer, &end, 0);
@@ -149,137 +157,35 @@ substitute_simple_buffer(GtkTextBuffer *buffer)
 
 	text = gtk_text_buffer_get_text(buffer, &start, &end, FALSE);
 
-	if (gtk_tree_model_get_iter_first(GTK_TREE_MODEL(model), &treeiter) && text) {
-		do {
-			GValue val1;
-			const gchar *bad;
-			gchar *cursor;
-			glong char_pos;
-
-			val1.g_type = 0;
-			gtk_tree_model_get_value(GTK_TREE_MODEL(model), &treeiter, WORD_ONLY_COLUMN, &val1);
-			if (g_value_get_boolean(&val1))
-			{
-				g_value_unset(&val1);
-				continue;
-			}
-			g_value_unset(&val1);
-
-			gtk_tree_model_get_value(GTK_TREE_MODEL(model), &treeiter, BAD_COLUMN, &val1);
-			bad = g_value_get_string(&val1);
-
-			/* using g_utf8_* to get /character/ offsets instead of byte offsets for buffer */
-			if ((cursor = g_strrstr(text, bad)))
-			{
-				GValue val2;
-				const gchar *good;
+	bad = spellchk_dict_find_phrase(dictionary, text, &good);
 
-				val2.g_type = 0;
-				gtk_tree_model_get_value(GTK_TREE_MODEL(model), &treeiter, GOOD_COLUMN, &val2);
-				good = g_value_get_string(&val2);
-
-				char_pos = g_utf8_pointer_to_offset(text, cursor);
-				gtk_text_buffer_get_iter_at_offset(buffer, &start, char_pos);
-				gtk_text_buffer_get_iter_at_offset(buffer, &end, char_pos + g_utf8_strlen(bad, -1));
-				gtk_text_buffer_delete(buffer, &start, &end);
-
-				gtk_text_buffer_get_iter_at_offset(buffer, &start, char_pos);
-				gtk_text_buffer_insert(buffer, &start, good, -1);
+	/* using g_utf8_* to get /character/ offsets instead of byte offsets for buffer */
+	if (bad == NULL || (cursor = g_strrstr(text, bad)) == NULL) {
+		g_free(text);
+		return FALSE;
+	}
 
-				g_value_unset(&val2);
-				g_free(text);
+	char_pos = g_utf8_pointer_to_offset(text, cursor);
+	gtk_text_buffer_get_iter_at_offset(buffer, &start, char_pos);
+	gtk_text_buffer_get_iter_at_offset(buffer, &end, char_pos + g_utf8_strlen(bad, -1));
+	gtk_text_buffer_delete(buffer, &start, &end);
 
-				g_value_unset(&val1);
-				return TRUE;
-			}
-
-			g_value_unset(&val1);
-		} while (gtk_tree_model_iter_next(GTK_TREE_MODEL(model), &treeiter));
-	}
+	gtk_text_buffer_get_iter_at_offset(buffer, &start, char_pos);
+	gtk_text_buffer_insert(buffer, &start, good, -1);
 
 	g_free(text);
-	return FALSE;
+	return TRUE;
 }
 
 static gchar *
 substitute_word(gchar *word)
 {
-	GtkTreeIter iter;
-	gchar *outword;
-	gchar *lowerword;
-	gchar *foldedword;
-
 	if (word == NULL)
 		return NULL;
 
-	lowerword = g_utf8_strdown(word, -1);
-	foldedword = g_utf8_casefold(word, -1);
-
-	if (gtk_tree_model_get_iter_first(GTK_TREE_MODEL(model), &iter)) {
-		do {
-			GValue val1;
-			gboolean case_sensitive;
-			const char *bad;
-			gchar *tmpbad = NULL;
-
-			val1.g_type = 0;
-			gtk_tree_model_get_value(GTK_TREE_MODEL(model), &iter, WORD_ONLY_COLUMN, &val1);
-			if (!g_value_get_boolean(&val1)) {
-				g_value_unset(&val1);
-				continue;
-			}
-			g_value_unset(&val1);
+	dictionary_update();
 
-			gtk_tree_model_get_value(GTK_TREE_MODEL(model), &iter, CASE_SENSITIVE_COLUMN, &val1);
-			case_sensitive = g_value_get_boolean(&val1);
-			g_value_unset(&val1);
-
-			gtk_tree_model_get_value(GTK_TREE_MODEL(model), &iter, BAD_COLUMN, &val1);
-			bad = g_value_get_string(&val1);
-
-			if ((case_sensitive && !strcmp(bad, word)) ||
-			    (!case_sensitive && (!strcmp(bad, lowerword) ||
-			                        (!is_word_lowercase(bad) &&
-			                         !strcmp((tmpbad = g_utf8_casefold(bad, -1)), foldedword)))))
-			{
-				GValue val2;
-				const char *good;
-
-				g_free(tmpbad);
-
-				val2.g_type = 0;
-				gtk_tree_model_get_value(GTK_TREE_MODEL(model), &iter, GOOD_COLUMN, &val2);
-				good = g_value_get_string(&val2);
-
-				if (!case_sensitive && is_word_lowercase(bad) && is_word_lowercase(good))
-				{
-					if (is_word_uppercase(word))
-						outword = g_utf8_strup(good, -1);
-					else if (is_word_proper(word))
-						outword = make_word_proper(good);
-					else
-						outword = g_strdup(good);
-				}
-				else
-					outword = g_strdup(good);
-
-				g_value_unset(&val1);
-				g_value_unset(&val2);
-
-				g_free(lowerword);
-				g_free(foldedword);
-				return outword;
-			}
-
-			g_value_unset(&val1);
-			g_free(tmpbad);
-
-		} while (gtk_tree_model_iter_next(GTK_TREE_MODEL(model), &iter));
-	}
-	g_free(lowerword);
-	g_free(foldedword);
-
-	return NULL;
+	return spellchk_dict_substitute_word(dictionary, word);
 }
 
 static void
@@ -1844,6 +1750,8 @@ static void load_conf(void)
 
 	gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(model),
 	                                     0, GTK_SORT_ASCENDING);
+
+	dictionary_attach();
 }
 
 static GtkWidget *tree;
@@ -2343,6 +2251,8 @@ plugin_unload(PurplePlugin *plugin, GError **error)
 		g_object_set_data(G_OBJECT(gtkconv->entry), SPELLCHK_OBJECT_KEY, NULL);
 	}
 
+	dictionary_detach();
+
 	return TRUE;
 }
 